@@ -0,0 +1,148 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.api.core.exception.UnavailableException
+import org.platanios.tensorflow.api.utilities.{Closeable, NativeHandleWrapper}
+import org.platanios.tensorflow.jni.{PermissionDeniedException, BufferedWritableFile => NativeBufferedWritableFile}
+
+import java.nio.ByteBuffer
+import java.nio.charset.StandardCharsets
+import java.nio.file.Path
+
+/** Writable file that performs write-behind buffering in the native library.
+  *
+  * Appended bytes are copied into a native buffer and the call returns immediately. Full buffers are written to the
+  * underlying file on a background thread, while appends continue on a second buffer. If the background thread falls
+  * behind, appends block until it catches up, and so memory usage is bounded by roughly twice the buffer size. Appends
+  * of at least the buffer size are not copied, but are instead written directly after any buffered data.
+  *
+  * Errors that occur while writing in the background are reported by the next call to any of the methods of this
+  * class (including `close()`), and all subsequent calls fail with the same error.
+  *
+  * '''IMPORTANT:''' `close()` needs to be called after being done with this object in order to write any remaining
+  * buffered data and release the associated native resources. This is not done automatically when the object is
+  * garbage collected, because closing may fail and the error would otherwise be lost.
+  *
+  * @param  nativeHandleWrapper Wrapper around a handle to the native file object.
+  * @param  closeFn             Function used to close the native file object (i.e., write buffered data and free
+  *                             relevant memory).
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class BufferedWritableFile private[BufferedWritableFile] (
+    private[this] val nativeHandleWrapper: NativeHandleWrapper,
+    override protected val closeFn: () => Unit
+) extends Closeable {
+  /** Native handle of this file. */
+  private[api] def nativeHandle: Long = nativeHandleWrapper.handle
+
+  @inline private[this] def checkNotClosed(): Unit = {
+    if (nativeHandle == 0)
+      throw UnavailableException("This file has already been closed.")
+  }
+
+  /** Appends `length` bytes of `bytes`, starting at `offset`, to the end of the file. */
+  @throws[UnavailableException]
+  def write(bytes: Array[Byte], offset: Int, length: Int): BufferedWritableFile = {
+    checkNotClosed()
+    NativeBufferedWritableFile.appendArray(nativeHandle, bytes, offset, length)
+    this
+  }
+
+  /** Appends `bytes` to the end of the file. */
+  @throws[UnavailableException]
+  def write(bytes: Array[Byte]): BufferedWritableFile = {
+    write(bytes, 0, bytes.length)
+  }
+
+  /** Appends the remaining bytes of `buffer` to the end of the file and advances the buffer's position to its limit.
+    * Direct buffers are copied straight from their memory by the native library. */
+  @throws[UnavailableException]
+  def write(buffer: ByteBuffer): BufferedWritableFile = {
+    checkNotClosed()
+    if (buffer.isDirect) {
+      NativeBufferedWritableFile.appendBuffer(nativeHandle, buffer, buffer.position(), buffer.remaining())
+    } else if (buffer.hasArray) {
+      NativeBufferedWritableFile.appendArray(
+        nativeHandle, buffer.array(), buffer.arrayOffset() + buffer.position(), buffer.remaining())
+    } else {
+      val bytes = new Array[Byte](buffer.remaining())
+      buffer.duplicate().get(bytes)
+      NativeBufferedWritableFile.appendArray(nativeHandle, bytes, 0, bytes.length)
+    }
+    buffer.position(buffer.limit())
+    this
+  }
+
+  /** Appends `content`, encoded using UTF-8, to the end of the file. */
+  @throws[UnavailableException]
+  def write(content: String): BufferedWritableFile = {
+    write(content.getBytes(StandardCharsets.UTF_8))
+  }
+
+  /** Waits until all the data appended so far has been written to the underlying file and flushes it. This only ensures
+    * that the data has made its way out of the process without any guarantees on whether it is written to disk. */
+  @throws[UnavailableException]
+  def flush(): BufferedWritableFile = {
+    checkNotClosed()
+    NativeBufferedWritableFile.flush(nativeHandle)
+    this
+  }
+
+  /** Waits until all the data appended so far has been written to the underlying file and syncs it to its storage.
+    * This acts as a barrier: once it returns, all previously appended data is durable. */
+  @throws[UnavailableException]
+  def sync(): BufferedWritableFile = {
+    checkNotClosed()
+    NativeBufferedWritableFile.sync(nativeHandle)
+    this
+  }
+}
+
+object BufferedWritableFile {
+  /** Opens the file located at `filePath` for buffered writing.
+    *
+    * @param  filePath   Path to the file.
+    * @param  mode       Mode in which to open the file. Must support writing.
+    * @param  bufferSize Size of each of the two native buffers, in bytes. Must be positive.
+    * @return Opened file.
+    * @throws IllegalArgumentException If `bufferSize` is not positive.
+    */
+  @throws[IllegalArgumentException]
+  def apply(
+      filePath: Path,
+      mode: FileIO.Mode = FileIO.WRITE,
+      bufferSize: Long = 1024 * 1024
+  ): BufferedWritableFile = {
+    require(bufferSize > 0, s"The buffer size must be positive, but it was $bufferSize.")
+    if (!mode.supportsWrite)
+      throw PermissionDeniedException("The specified file mode does not support writing.")
+    val nativeHandle = NativeBufferedWritableFile.newBufferedWritableFile(
+      filePath.toAbsolutePath.toString, mode.cValue, bufferSize)
+    val nativeHandleWrapper = NativeHandleWrapper(nativeHandle)
+    val closeFn = () => {
+      nativeHandleWrapper.Lock.synchronized {
+        if (nativeHandleWrapper.handle != 0) {
+          val handle = nativeHandleWrapper.handle
+          nativeHandleWrapper.handle = 0
+          NativeBufferedWritableFile.delete(handle)
+        }
+      }
+    }
+    new BufferedWritableFile(nativeHandleWrapper, closeFn)
+  }
+}
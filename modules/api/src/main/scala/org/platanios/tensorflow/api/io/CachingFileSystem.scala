@@ -0,0 +1,107 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.jni.{CachingFileSystem => NativeCachingFileSystem}
+
+import java.nio.file.Path
+
+/** File system that caches fixed-size blocks of the files of any other file system, in RAM and, optionally, in a spill
+  * directory on local disk (e.g., an SSD).
+  *
+  * Once registered, files can be read through the cache by prefixing their path with `<scheme>://` (e.g.,
+  * `cache:///mnt/data/train-0.tfrecord` for a file on a network mount, or `cache://hdfs://namenode/data/train-0` for a
+  * file on HDFS). This is useful when training for multiple epochs over data that is stored remotely, since all reads
+  * after the first epoch can then be served locally.
+  *
+  * Blocks are evicted from RAM in LRU order and written to the spill directory, which is itself bounded in size and
+  * evicts in LRU order. Only random access reads are cached. Files modified through the cache are invalidated
+  * immediately, while files modified by other means are detected the next time they are opened.
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+object CachingFileSystem {
+  /** Cache statistics.
+    *
+    * @param  ramHits        Number of block reads served from RAM.
+    * @param  spillHits      Number of block reads served from the spill directory.
+    * @param  misses         Number of block reads served from the underlying file system.
+    * @param  ramBytes       Number of bytes currently cached in RAM.
+    * @param  spillBytes     Number of bytes currently cached in the spill directory.
+    * @param  ramEvictions   Number of blocks evicted from RAM.
+    * @param  spillEvictions Number of blocks evicted from the spill directory.
+    */
+  case class Stats(
+      ramHits: Long,
+      spillHits: Long,
+      misses: Long,
+      ramBytes: Long,
+      spillBytes: Long,
+      ramEvictions: Long,
+      spillEvictions: Long
+  ) {
+    /** Total number of block reads. */
+    def numReads: Long = ramHits + spillHits + misses
+
+    /** Fraction of block reads served from RAM. */
+    def ramHitRatio: Double = if (numReads == 0) 0.0 else ramHits.toDouble / numReads
+
+    /** Fraction of block reads served from either RAM or the spill directory. */
+    def hitRatio: Double = if (numReads == 0) 0.0 else (ramHits + spillHits).toDouble / numReads
+  }
+
+  /** Registers a caching file system with TensorFlow under `scheme`. A file system can only be registered once for each
+    * scheme.
+    *
+    * @param  scheme         Scheme to register the file system under.
+    * @param  blockSize      Size of the cached blocks, in bytes.
+    * @param  maxBytes       Maximum number of bytes to cache in RAM.
+    * @param  spillDirectory Optional local directory to spill blocks evicted from RAM to. Each file system spills to its
+    *                        own, uniquely named subdirectory, and so the same directory can be shared by multiple file
+    *                        systems and processes. That subdirectory is removed by [[close]], or when the process
+    *                        exits normally.
+    * @param  maxSpillBytes  Maximum number of bytes to cache in the spill directory.
+    */
+  def register(
+      scheme: String = "cache",
+      blockSize: Long = 16L * 1024 * 1024,
+      maxBytes: Long = 4L * 1024 * 1024 * 1024,
+      spillDirectory: Option[Path] = None,
+      maxSpillBytes: Long = 64L * 1024 * 1024 * 1024
+  ): Unit = {
+    NativeCachingFileSystem.register(
+      scheme, blockSize, maxBytes, spillDirectory.map(_.toAbsolutePath.toString).getOrElse(""), maxSpillBytes)
+  }
+
+  /** Returns the statistics of the caching file system registered under `scheme`. */
+  def stats(scheme: String = "cache"): Stats = {
+    val stats = NativeCachingFileSystem.stats(scheme)
+    Stats(
+      stats.ramHits, stats.spillHits, stats.misses, stats.ramBytes, stats.spillBytes, stats.ramEvictions,
+      stats.spillEvictions)
+  }
+
+  /** Removes all cached blocks of the caching file system registered under `scheme`. */
+  def clear(scheme: String = "cache"): Unit = {
+    NativeCachingFileSystem.clear(scheme)
+  }
+
+  /** Deletes the spill directory of the caching file system registered under `scheme`, along with all blocks spilled to
+    * it. TensorFlow file systems cannot be unregistered, and so the file system remains usable afterwards, but only
+    * caches blocks in RAM. */
+  def close(scheme: String = "cache"): Unit = {
+    NativeCachingFileSystem.close(scheme)
+  }
+}
@@ -0,0 +1,139 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.api.core.exception.UnavailableException
+import org.platanios.tensorflow.api.tensors.Tensor
+import org.platanios.tensorflow.api.utilities.{Closeable, Disposer, NativeHandleWrapper}
+import org.platanios.tensorflow.jni.{CheckpointWriter => NativeCheckpointWriter}
+
+import java.nio.file.Path
+
+/** Helper class for writing checkpoint files asynchronously, without going through a graph-based saver.
+  *
+  * Tensors are added using `add` and are captured at that point in time (their buffers are shared with the provided
+  * tensors, and so no copies are made). Once `start` is called, the tensors are partitioned into shards that are
+  * written in parallel by a native thread pool, and then merged into a single tensor bundle stored at the provided
+  * prefix. The caller may keep training while the checkpoint is being written, poll for `progress`, and use `await` to
+  * block until the checkpoint has been fully written.
+  *
+  * Note that only tensors placed on the host (i.e., CPU) are supported.
+  *
+  * @param  nativeHandleWrapper Wrapper around a handle to the native checkpoint writer object.
+  * @param  closeFn             Function used to delete the native checkpoint writer object
+  *                             (i.e., free relevant memory).
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class CheckpointWriter private[CheckpointWriter] (
+    private[this] val nativeHandleWrapper: NativeHandleWrapper,
+    override protected val closeFn: () => Unit
+) extends Closeable {
+  /** Lock for the native handle. */
+  private[CheckpointWriter] def NativeHandleLock = nativeHandleWrapper.Lock
+
+  /** Native handle of this checkpoint writer. */
+  private[api] def nativeHandle: Long = nativeHandleWrapper.handle
+
+  /** Adds the provided named tensors to this checkpoint.
+    *
+    * @param  tensors Map from tensor name to tensor.
+    * @throws UnavailableException If this checkpoint writer object has already been disposed.
+    */
+  @throws[UnavailableException]
+  def add(tensors: Map[String, Tensor[_]]): Unit = {
+    if (nativeHandle == 0)
+      throw UnavailableException("This checkpoint writer has already been disposed.")
+    val (names, values) = tensors.toSeq.unzip
+    NativeCheckpointWriter.addTensors(nativeHandle, names.toArray, values.map(_.nativeHandle).toArray)
+  }
+
+  /** Starts writing the checkpoint in the background. No more tensors can be added after this method is called.
+    *
+    * @throws UnavailableException If this checkpoint writer object has already been disposed.
+    */
+  @throws[UnavailableException]
+  def start(): Unit = {
+    if (nativeHandle == 0)
+      throw UnavailableException("This checkpoint writer has already been disposed.")
+    NativeCheckpointWriter.start(nativeHandle)
+  }
+
+  /** Returns the current progress of this checkpoint writer.
+    *
+    * @throws UnavailableException If this checkpoint writer object has already been disposed.
+    */
+  @throws[UnavailableException]
+  def progress: CheckpointWriter.Progress = {
+    if (nativeHandle == 0)
+      throw UnavailableException("This checkpoint writer has already been disposed.")
+    val progress = NativeCheckpointWriter.progress(nativeHandle)
+    CheckpointWriter.Progress(
+      progress.numTensorsWritten, progress.numTensors, progress.numBytesWritten, progress.numBytes, progress.isDone)
+  }
+
+  /** Blocks until the checkpoint has been fully written and throws an exception if writing it failed.
+    *
+    * @throws UnavailableException If this checkpoint writer object has already been disposed.
+    */
+  @throws[UnavailableException]
+  def await(): Unit = {
+    if (nativeHandle == 0)
+      throw UnavailableException("This checkpoint writer has already been disposed.")
+    NativeCheckpointWriter.await(nativeHandle)
+  }
+}
+
+object CheckpointWriter {
+  /** Progress of a [[CheckpointWriter]].
+    *
+    * @param  numTensorsWritten Number of tensors that have been written so far.
+    * @param  numTensors        Total number of tensors in the checkpoint.
+    * @param  numBytesWritten   Number of bytes that have been written so far.
+    * @param  numBytes          Total number of bytes in the checkpoint.
+    * @param  isDone            Boolean value indicating whether the checkpoint has been fully written (or failed).
+    */
+  case class Progress(numTensorsWritten: Long, numTensors: Long, numBytesWritten: Long, numBytes: Long, isDone: Boolean)
+
+  /** Creates a new [[CheckpointWriter]] that writes a checkpoint at `checkpointPrefix`.
+    *
+    * @param  checkpointPrefix Checkpoint prefix (i.e., the same prefix that would be used by a saver).
+    * @param  numShards        Number of shards to write in parallel. Defaults to the number of available processors.
+    * @return Constructed checkpoint writer.
+    */
+  def apply(
+      checkpointPrefix: Path,
+      numShards: Int = Runtime.getRuntime.availableProcessors()
+  ): CheckpointWriter = {
+    require(numShards > 0, s"The number of shards ($numShards) must be positive.")
+    val nativeHandle = NativeCheckpointWriter.newCheckpointWriter(checkpointPrefix.toAbsolutePath.toString, numShards)
+    val nativeHandleWrapper = NativeHandleWrapper(nativeHandle)
+    val closeFn = () => {
+      nativeHandleWrapper.Lock.synchronized {
+        if (nativeHandleWrapper.handle != 0) {
+          NativeCheckpointWriter.delete(nativeHandleWrapper.handle)
+          nativeHandleWrapper.handle = 0
+        }
+      }
+    }
+    val checkpointWriter = new CheckpointWriter(nativeHandleWrapper, closeFn)
+    // Keep track of references in the Scala side and notify the native library when the checkpoint writer is not
+    // referenced anymore anywhere in the Scala side. This will let the native library free the allocated resources and
+    // prevent a potential memory leak.
+    Disposer.add(checkpointWriter, closeFn)
+    checkpointWriter
+  }
+}
@@ -36,3 +36,10 @@ case object ZLIBCompression extends CompressionType {
 case object GZIPCompression extends CompressionType {
   override val name: String = "GZIP"
 }
+
+/** Snappy compression. Files using this compression type consist of a stream of Snappy blocks, each prefixed by its
+  * compressed length. Note that this compression type is only supported by [[TFRecordReader]] and [[TFRecordWriter]],
+  * and not by the TensorFlow record dataset ops. */
+case object SnappyCompression extends CompressionType {
+  override val name: String = "SNAPPY"
+}
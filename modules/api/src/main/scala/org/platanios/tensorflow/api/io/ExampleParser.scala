@@ -0,0 +1,159 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.api.core.Shape
+import org.platanios.tensorflow.api.core.exception.{InvalidArgumentException, UnavailableException}
+import org.platanios.tensorflow.api.core.types.DataType
+import org.platanios.tensorflow.api.tensors.{SparseTensor, Tensor}
+import org.platanios.tensorflow.api.utilities.{Closeable, Disposer, NativeHandleWrapper}
+import org.platanios.tensorflow.jni.{ExampleParser => NativeExampleParser}
+
+/** Parses serialized `Example` protocol buffers directly into batches of dense and sparse feature tensors.
+  *
+  * Parsing is performed in the native library using the same fast parser used by the `ParseExample` op, and so no
+  * per-example work happens in the JVM. Records can either be provided as byte arrays, or be read directly from a
+  * [[TFRecordReader]], in which case reading and parsing a batch takes a single native call. Large batches are parsed
+  * in parallel using a native thread pool.
+  *
+  * @param  denseFeatures       Dense features to parse.
+  * @param  sparseFeatures      Sparse features to parse.
+  * @param  nativeHandleWrapper Wrapper around a handle to the native example parser object.
+  * @param  closeFn             Function used to delete the native example parser object (i.e., free relevant memory).
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class ExampleParser protected (
+    val denseFeatures: Seq[ExampleParser.DenseFeature],
+    val sparseFeatures: Seq[ExampleParser.SparseFeature],
+    private[this] val nativeHandleWrapper: NativeHandleWrapper,
+    override protected val closeFn: () => Unit
+) extends Closeable {
+  /** Native handle of this parser. */
+  private[api] def nativeHandle: Long = nativeHandleWrapper.handle
+
+  /** Reads up to `batchSize` records from `reader` and parses them.
+    *
+    * @param  reader    TF record reader to read from. Reading continues from where the reader's last read stopped.
+    * @param  batchSize Maximum number of records to read and parse. Must be positive.
+    * @return Parsed batch, or `None` if there are no more records to read.
+    * @throws InvalidArgumentException If `batchSize` is not positive.
+    * @throws UnavailableException     If this parser object has already been disposed.
+    */
+  @throws[InvalidArgumentException]
+  @throws[UnavailableException]
+  def parse(reader: TFRecordReader, batchSize: Int): Option[ExampleParser.ParsedBatch] = {
+    if (batchSize <= 0)
+      throw InvalidArgumentException(s"The batch size must be positive, but it was $batchSize.")
+    if (nativeHandle == 0)
+      throw UnavailableException("This example parser has already been disposed.")
+    Option(NativeExampleParser.parseRecords(nativeHandle, reader.nativeHandle, batchSize)).map(toParsedBatch)
+  }
+
+  /** Parses the provided serialized `Example` protocol buffers.
+    *
+    * @param  records Serialized `Example` protocol buffers.
+    * @return Parsed batch.
+    * @throws UnavailableException If this parser object has already been disposed.
+    */
+  @throws[UnavailableException]
+  def parse(records: Seq[Array[Byte]]): ExampleParser.ParsedBatch = {
+    if (nativeHandle == 0)
+      throw UnavailableException("This example parser has already been disposed.")
+    toParsedBatch(NativeExampleParser.parseSerialized(nativeHandle, records.toArray))
+  }
+
+  private[this] def toParsedBatch(handles: Array[Long]): ExampleParser.ParsedBatch = {
+    val tensors = handles.map(Tensor.fromNativeHandle[Any])
+    val numDense = denseFeatures.size
+    val numSparse = sparseFeatures.size
+    val dense = denseFeatures.map(_.key).zip(tensors.take(numDense)).toMap
+    val sparse = sparseFeatures.map(_.key).zipWithIndex.map {
+      case (key, i) =>
+        key -> SparseTensor[Any](
+          indices = tensors(numDense + i).asInstanceOf[Tensor[Long]],
+          values = tensors(numDense + numSparse + i),
+          denseShape = tensors(numDense + 2 * numSparse + i).asInstanceOf[Tensor[Long]])
+    }.toMap
+    ExampleParser.ParsedBatch(dense, sparse)
+  }
+}
+
+object ExampleParser {
+  /** Configuration for parsing a dense feature.
+    *
+    * @param  key          Feature key.
+    * @param  dataType     Feature data type. Must be `STRING`, `FLOAT32`, or `INT64`.
+    * @param  shape        Shape of the feature for a single example. If its first dimension is `-1`, the feature is
+    *                      treated as variable-length and padded (using `defaultValue`) to the longest length in each
+    *                      batch.
+    * @param  defaultValue Value to use for examples that are missing this feature. If `None`, the feature is required.
+    *                      It must have data type `dataType`, and it must be a scalar padding value for variable-length
+    *                      features, or have as many elements as `shape` otherwise.
+    */
+  case class DenseFeature(key: String, dataType: DataType[_], shape: Shape, defaultValue: Option[Tensor[_]] = None)
+
+  /** Configuration for parsing a variable-length feature into a sparse tensor.
+    *
+    * @param  key      Feature key.
+    * @param  dataType Feature data type. Must be `STRING`, `FLOAT32`, or `INT64`.
+    */
+  case class SparseFeature(key: String, dataType: DataType[_])
+
+  /** Batch of parsed examples.
+    *
+    * @param  dense  Map from feature key to the dense tensor containing that feature for all examples in the batch.
+    * @param  sparse Map from feature key to the sparse tensor containing that feature for all examples in the batch.
+    */
+  case class ParsedBatch(dense: Map[String, Tensor[_]], sparse: Map[String, SparseTensor[_]])
+
+  /** Creates a new example parser.
+    *
+    * @param  denseFeatures  Dense features to parse.
+    * @param  sparseFeatures Sparse features to parse.
+    * @param  numThreads     Number of threads used for parsing each batch.
+    * @return Newly constructed example parser.
+    */
+  def apply(
+      denseFeatures: Seq[DenseFeature] = Seq.empty,
+      sparseFeatures: Seq[SparseFeature] = Seq.empty,
+      numThreads: Int = Runtime.getRuntime.availableProcessors()
+  ): ExampleParser = {
+    val nativeHandle = NativeExampleParser.newExampleParser(
+      denseFeatures.map(_.key).toArray,
+      denseFeatures.map(_.dataType.cValue).toArray,
+      denseFeatures.map(_.shape.asArray.map(_.toLong)).toArray,
+      denseFeatures.map(_.defaultValue.map(_.nativeHandle).getOrElse(0L)).toArray,
+      sparseFeatures.map(_.key).toArray,
+      sparseFeatures.map(_.dataType.cValue).toArray,
+      numThreads)
+    val nativeHandleWrapper = NativeHandleWrapper(nativeHandle)
+    val closeFn = () => {
+      nativeHandleWrapper.Lock.synchronized {
+        if (nativeHandleWrapper.handle != 0) {
+          NativeExampleParser.delete(nativeHandleWrapper.handle)
+          nativeHandleWrapper.handle = 0
+        }
+      }
+    }
+    val parser = new ExampleParser(denseFeatures, sparseFeatures, nativeHandleWrapper, closeFn)
+    // Keep track of references in the Scala side and notify the native library when the parser is not referenced
+    // anymore anywhere in the Scala side. This will let the native library free the allocated resources and prevent a
+    // potential memory leak.
+    Disposer.add(parser, closeFn)
+    parser
+  }
+}
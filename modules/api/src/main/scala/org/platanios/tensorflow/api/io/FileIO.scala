@@ -20,6 +20,7 @@ import org.platanios.tensorflow.api.utilities.Closeable
 import org.platanios.tensorflow.jni
 import org.platanios.tensorflow.jni.{PermissionDeniedException, FileIO => NativeFileIO}
 
+import java.nio.{ByteBuffer, ReadOnlyBufferException}
 import java.nio.file._
 import java.util.UUID
 import java.util.concurrent.TimeUnit
@@ -106,6 +107,61 @@ case class FileIO(filePath: Path, mode: FileIO.Mode, readBufferSize: Long = 1024
     NativeFileIO.readLineAsStringFromBufferedInputStream(readBufferNativeHandle)
   }
 
+  /** Returns the contents of the file as a byte array, starting from current position in the file. Unlike `read`, this
+    * method performs no character encoding conversion and is thus suitable for binary data.
+    *
+    * @param  numBytes Number of bytes to read from the file. If equal to `-1` (the default) then the file is read up to
+    *                  its end.
+    * @return Read contents of the file, which may be shorter than `numBytes` if the end of the file is reached.
+    */
+  def readBytes(numBytes: Long = -1L): Array[Byte] = {
+    preReadCheck()
+    val n = if (numBytes == -1L) size - tell else numBytes
+    require(n <= Int.MaxValue, s"Cannot read $n bytes into a single array.")
+    val bytes = new Array[Byte](n.toInt)
+    val numRead = NativeFileIO.readFromBufferedInputStreamToArray(readBufferNativeHandle, bytes, 0, n.toInt)
+    if (numRead == bytes.length) bytes else java.util.Arrays.copyOf(bytes, numRead)
+  }
+
+  /** Reads up to `buffer.remaining` bytes from the file, starting from current position in the file, into `buffer`.
+    * The bytes are written at the buffer's current position, which is then advanced by the number of bytes read. For
+    * direct buffers, the bytes are copied straight into the buffer memory by the native library.
+    *
+    * @param  buffer Buffer to read into.
+    * @return Number of bytes read, which is `0` if the end of the file has been reached.
+    * @throws ReadOnlyBufferException If `buffer` is read-only.
+    */
+  @throws[ReadOnlyBufferException]
+  def read(buffer: ByteBuffer): Int = {
+    // Read-only direct buffers may be backed by read-only memory (e.g., memory-mapped files) that the native library
+    // would otherwise write into.
+    if (buffer.isReadOnly)
+      throw new ReadOnlyBufferException()
+    preReadCheck()
+    val numRead = {
+      if (buffer.isDirect) {
+        NativeFileIO.readFromBufferedInputStreamToBuffer(
+          readBufferNativeHandle, buffer, buffer.position(), buffer.remaining())
+      } else if (buffer.hasArray) {
+        NativeFileIO.readFromBufferedInputStreamToArray(
+          readBufferNativeHandle, buffer.array(), buffer.arrayOffset() + buffer.position(), buffer.remaining())
+      } else {
+        val bytes = readBytes(buffer.remaining())
+        buffer.duplicate().put(bytes)
+        bytes.length
+      }
+    }
+    buffer.position(buffer.position() + numRead)
+    numRead
+  }
+
+  /** Reads the next line from the file and returns it as a byte array (including the new-line character at the end), or
+    * `null` if the end of the file has been reached. */
+  def readLineBytes(): Array[Byte] = {
+    preReadCheck()
+    NativeFileIO.readLineAsBytesFromBufferedInputStream(readBufferNativeHandle)
+  }
+
   /** Reads all the lines from the file and returns them (including the new-line character at the end of each line). */
   def readLines(): Seq[String] = {
     preReadCheck()
@@ -464,6 +520,17 @@ object FileIO {
     content
   }
 
+  /** Reads the entire contents of the file located at `filePath` to a byte array and returns it. */
+  def readFileToBytes(filePath: Path): Array[Byte] = {
+    NativeFileIO.readFileToBytes(filePath.toAbsolutePath.toString)
+  }
+
+  /** Maps the file located at `filePath` in memory, in read-only mode. The returned region must be explicitly closed,
+    * in order to unmap the file. */
+  def mapReadOnly(filePath: Path): ReadOnlyMemoryRegion = {
+    ReadOnlyMemoryRegion(filePath)
+  }
+
   /** Writes the provided string to the file located at `filePath`. */
   def writeStringToFile(filePath: Path, content: String): Unit = {
     FileIO(filePath, WRITE).write(content).close()
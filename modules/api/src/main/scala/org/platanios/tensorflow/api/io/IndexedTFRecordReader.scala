@@ -0,0 +1,176 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.api.core.exception.UnavailableException
+import org.platanios.tensorflow.api.utilities.{Closeable, Disposer, NativeHandleWrapper}
+import org.platanios.tensorflow.jni.{RecordIndex => NativeRecordIndex}
+
+import com.typesafe.scalalogging.Logger
+import org.slf4j.LoggerFactory
+
+import java.nio.file.{Files, Path}
+
+import scala.util.Random
+
+/** TensorFlow record file reader that supports random access, using record index files.
+  *
+  * A record index file is a compact sidecar file that stores the offset and length of each record in a TF record file.
+  * It is built once, by scanning the record headers of the file (see `IndexedTFRecordReader.buildIndex`). Using the
+  * indexes, this reader treats a set of (uncompressed) TF record files as a single sequence of records that can be
+  * accessed by position. Reads of multiple records are sorted by file and offset and nearby records are coalesced into
+  * single reads, so that shuffled access patterns result in few, mostly sequential reads.
+  *
+  * This allows for true global (i.e., epoch-level) shuffling over all files, as well as resuming iteration from any
+  * position without re-reading the records that precede it.
+  *
+  * @param  filePaths           Paths to the TF record files being read.
+  * @param  nativeHandleWrapper Wrapper around a handle to the native indexed record reader object.
+  * @param  closeFn             Function used to delete the native indexed record reader object (i.e., free relevant
+  *                             memory).
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class IndexedTFRecordReader protected (
+    val filePaths: Seq[Path],
+    private[this] val nativeHandleWrapper: NativeHandleWrapper,
+    override protected val closeFn: () => Unit
+) extends Closeable {
+  /** Native handle of this reader. */
+  private[api] def nativeHandle: Long = nativeHandleWrapper.handle
+
+  /** Total number of records in all files of this reader. */
+  lazy val numRecords: Long = {
+    if (nativeHandle == 0)
+      throw UnavailableException("This indexed TF record reader has already been disposed.")
+    NativeRecordIndex.numRecords(nativeHandle)
+  }
+
+  /** Reads the record at position `index`. */
+  @throws[UnavailableException]
+  def read(index: Long): Array[Byte] = read(Seq(index)).head
+
+  /** Reads the records at the provided positions and returns them in the same order. */
+  @throws[UnavailableException]
+  def read(indices: Seq[Long]): Seq[Array[Byte]] = {
+    if (nativeHandle == 0)
+      throw UnavailableException("This indexed TF record reader has already been disposed.")
+    NativeRecordIndex.read(nativeHandle, indices.toArray)
+  }
+
+  /** Returns an iterator over the records of this reader.
+    *
+    * @param  shuffle       If `true`, the records are visited in a random order that is determined by `seed` and
+    *                       `epoch`. The order is the same every time the same seed and epoch are used.
+    * @param  seed          Seed used for shuffling.
+    * @param  epoch         Epoch number, which is combined with `seed`, so that each epoch uses a different order.
+    * @param  startPosition Position in the (possibly shuffled) order from which to start iterating. This can be used to
+    *                       resume iteration, without reading any of the records before that position.
+    * @param  batchSize     Number of records read by each native call.
+    * @return Iterator over the records.
+    */
+  def iterator(
+      shuffle: Boolean = false,
+      seed: Long = 0L,
+      epoch: Long = 0L,
+      startPosition: Long = 0L,
+      batchSize: Int = 256
+  ): Iterator[Array[Byte]] = {
+    require(numRecords <= Int.MaxValue || !shuffle, "Shuffling is only supported for up to 2^31 - 1 records.")
+    val order: Long => Long = {
+      if (shuffle) {
+        val permutation = IndexedTFRecordReader.permutation(numRecords.toInt, seed * 31 + epoch)
+        i => permutation(i.toInt).toLong
+      } else {
+        identity
+      }
+    }
+    Iterator.iterate(startPosition)(_ + batchSize)
+        .takeWhile(_ < numRecords)
+        .flatMap(start => read((start until math.min(start + batchSize, numRecords)).map(order)))
+  }
+}
+
+object IndexedTFRecordReader {
+  private[IndexedTFRecordReader] val logger: Logger = Logger(LoggerFactory.getLogger("Indexed TF Record Reader"))
+
+  /** Returns the default index file path for the TF record file located at `filePath`. */
+  def indexPath(filePath: Path): Path = filePath.resolveSibling(filePath.getFileName.toString + ".index")
+
+  /** Builds the record index for the (uncompressed) TF record file located at `filePath` and writes it to `indexPath`.
+    *
+    * @param  filePath  Path to the TF record file.
+    * @param  indexPath Path to the index file to write.
+    * @return Number of records in the TF record file.
+    */
+  def buildIndex(filePath: Path, indexPath: Path): Long = {
+    logger.info(s"Building record index for '${filePath.toAbsolutePath}'.")
+    NativeRecordIndex.buildIndex(filePath.toAbsolutePath.toString, indexPath.toAbsolutePath.toString)
+  }
+
+  /** Creates a new indexed TF record reader.
+    *
+    * @param  filePaths         Paths to the (uncompressed) TF record files being read.
+    * @param  buildMissingIndex If `true`, indexes that do not exist are built using `buildIndex`.
+    * @param  indexPathFn       Function that returns the index file path for each TF record file.
+    * @return Newly constructed indexed TF record reader.
+    */
+  def apply(
+      filePaths: Seq[Path],
+      buildMissingIndex: Boolean = true,
+      indexPathFn: Path => Path = indexPath
+  ): IndexedTFRecordReader = {
+    val indexPaths = filePaths.map(indexPathFn)
+    if (buildMissingIndex) {
+      filePaths.zip(indexPaths).foreach(p => {
+        if (!Files.exists(p._2))
+          buildIndex(p._1, p._2)
+      })
+    }
+    val nativeHandle = NativeRecordIndex.newIndexedRecordReader(
+      filePaths.map(_.toAbsolutePath.toString).toArray, indexPaths.map(_.toAbsolutePath.toString).toArray)
+    val nativeHandleWrapper = NativeHandleWrapper(nativeHandle)
+    val closeFn = () => {
+      nativeHandleWrapper.Lock.synchronized {
+        if (nativeHandleWrapper.handle != 0) {
+          NativeRecordIndex.delete(nativeHandleWrapper.handle)
+          nativeHandleWrapper.handle = 0
+        }
+      }
+    }
+    val reader = new IndexedTFRecordReader(filePaths, nativeHandleWrapper, closeFn)
+    // Keep track of references in the Scala side and notify the native library when the reader is not referenced
+    // anymore anywhere in the Scala side. This will let the native library free the allocated resources and prevent a
+    // potential memory leak.
+    Disposer.add(reader, closeFn)
+    reader
+  }
+
+  /** Returns a uniformly random permutation of `0 until n`, generated using a Fisher-Yates shuffle seeded with `seed`. */
+  private[IndexedTFRecordReader] def permutation(n: Int, seed: Long): Array[Int] = {
+    val random = new Random(seed)
+    val permutation = Array.range(0, n)
+    var i = n - 1
+    while (i > 0) {
+      val j = random.nextInt(i + 1)
+      val t = permutation(i)
+      permutation(i) = permutation(j)
+      permutation(j) = t
+      i -= 1
+    }
+    permutation
+  }
+}
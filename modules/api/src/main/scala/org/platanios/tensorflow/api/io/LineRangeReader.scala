@@ -0,0 +1,136 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.api.core.exception.{InvalidArgumentException, UnavailableException}
+import org.platanios.tensorflow.api.utilities.{Closeable, Disposer, NativeHandleWrapper}
+import org.platanios.tensorflow.jni.{FileIO => NativeFileIO}
+
+import java.nio.charset.{Charset, StandardCharsets}
+import java.nio.file.Path
+
+/** Reader that reads lines from a byte range of a file in batches, using a single native call per batch.
+  *
+  * A line is considered to belong to the byte range `[start, end)` if its first byte lies in that range. This means
+  * that multiple readers can be used to process disjoint ranges of the same file (e.g., obtained using
+  * `LineRangeReader.ranges`) in parallel, with each line being read by exactly one of them.
+  *
+  * @param  nativeHandleWrapper Wrapper around a handle to the native line reader object.
+  * @param  closeFn             Function used to delete the native line reader object (i.e., free relevant memory).
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class LineRangeReader private[LineRangeReader] (
+    private[this] val nativeHandleWrapper: NativeHandleWrapper,
+    override protected val closeFn: () => Unit
+) extends Closeable {
+  /** Native handle of this line reader. */
+  private[api] def nativeHandle: Long = nativeHandleWrapper.handle
+
+  /** Reads the next batch of lines, containing at most `maxLines` lines. Lines are read until either `maxLines` have
+    * been read, or the total number of bytes read is at least `maxBytes`.
+    *
+    * @param  maxLines Maximum number of lines to read.
+    * @param  maxBytes Number of bytes after which no more lines are read.
+    * @return Next batch of lines, or `None` if there are no more lines in the range of this reader.
+    * @throws UnavailableException     If this line reader object has already been disposed.
+    * @throws InvalidArgumentException If `maxLines` or `maxBytes` is not positive.
+    */
+  @throws[UnavailableException]
+  @throws[InvalidArgumentException]
+  def next(maxLines: Int = 1024, maxBytes: Int = 1024 * 1024): Option[LineRangeReader.LineBatch] = {
+    nativeHandleWrapper.Lock.synchronized {
+      if (nativeHandle == 0)
+        throw UnavailableException("This line reader has already been disposed.")
+      Option(NativeFileIO.readLineBatch(nativeHandle, maxLines, maxBytes))
+          .map(batch => LineRangeReader.LineBatch(batch.data, batch.offsets))
+    }
+  }
+
+  /** Returns an iterator over the batches of lines of this reader. */
+  def batchesIterator(maxLines: Int = 1024, maxBytes: Int = 1024 * 1024): Iterator[LineRangeReader.LineBatch] = {
+    Iterator.continually(next(maxLines, maxBytes)).takeWhile(_.isDefined).map(_.get)
+  }
+}
+
+object LineRangeReader {
+  /** Batch of lines, packed in a single byte array.
+    *
+    * @param  data    Packed line contents (not including the new-line characters).
+    * @param  offsets Line offsets in `data`. Line `i` spans `[offsets(i), offsets(i + 1))` and so this array contains one
+    *                 more element than the number of lines in this batch.
+    */
+  case class LineBatch(data: Array[Byte], offsets: Array[Int]) {
+    /** Number of lines in this batch. */
+    def numLines: Int = offsets.length - 1
+
+    /** Returns the `index`-th line of this batch as a byte array. */
+    def line(index: Int): Array[Byte] = java.util.Arrays.copyOfRange(data, offsets(index), offsets(index + 1))
+
+    /** Returns the `index`-th line of this batch as a string, decoded using `charset`. */
+    def lineAsString(index: Int, charset: Charset = StandardCharsets.UTF_8): String = {
+      new String(data, offsets(index), offsets(index + 1) - offsets(index), charset)
+    }
+
+    /** Returns all lines of this batch as strings, decoded using `charset`. */
+    def linesAsStrings(charset: Charset = StandardCharsets.UTF_8): Seq[String] = {
+      (0 until numLines).map(lineAsString(_, charset))
+    }
+  }
+
+  /** Creates a new [[LineRangeReader]] for the byte range `[start, end)` of the file located at `filePath`.
+    *
+    * @param  filePath   Path to the file.
+    * @param  start      Start of the byte range (inclusive).
+    * @param  end        End of the byte range (exclusive). If equal to `-1` (the default), the file is read up to its
+    *                    end.
+    * @param  bufferSize Buffer size used when reading from the file.
+    * @return Constructed line reader.
+    */
+  def apply(filePath: Path, start: Long = 0L, end: Long = -1L, bufferSize: Long = 1024 * 512): LineRangeReader = {
+    val nativeHandle = NativeFileIO.newLineRangeReader(filePath.toAbsolutePath.toString, start, end, bufferSize)
+    val nativeHandleWrapper = NativeHandleWrapper(nativeHandle)
+    val closeFn = () => {
+      nativeHandleWrapper.Lock.synchronized {
+        if (nativeHandleWrapper.handle != 0) {
+          NativeFileIO.deleteLineRangeReader(nativeHandleWrapper.handle)
+          nativeHandleWrapper.handle = 0
+        }
+      }
+    }
+    val lineRangeReader = new LineRangeReader(nativeHandleWrapper, closeFn)
+    // Keep track of references in the Scala side and notify the native library when the line reader is not referenced
+    // anymore anywhere in the Scala side. This will let the native library free the allocated resources and prevent a
+    // potential memory leak.
+    Disposer.add(lineRangeReader, closeFn)
+    lineRangeReader
+  }
+
+  /** Splits the file located at `filePath` into `numRanges` byte ranges of roughly equal size, which can be read
+    * independently (and in parallel) by separate [[LineRangeReader]]s. The ranges do not need to be aligned to line
+    * boundaries, as the readers take care of that.
+    *
+    * @param  filePath  Path to the file.
+    * @param  numRanges Number of ranges.
+    * @return Sequence of `(start, end)` byte ranges.
+    */
+  def ranges(filePath: Path, numRanges: Int): Seq[(Long, Long)] = {
+    require(numRanges > 0, s"The number of ranges ($numRanges) must be positive.")
+    val size = FileIO.fileStatistics(filePath).length
+    val boundaries = (0 to numRanges).map(i => size * i / numRanges)
+    boundaries.zip(boundaries.tail).filter(r => r._1 < r._2)
+  }
+}
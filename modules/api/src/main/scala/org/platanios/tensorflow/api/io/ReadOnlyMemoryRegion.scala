@@ -0,0 +1,95 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.api.core.exception.UnavailableException
+import org.platanios.tensorflow.api.utilities.{Closeable, NativeHandleWrapper}
+import org.platanios.tensorflow.jni.{FileIO => NativeFileIO}
+
+import java.nio.ByteBuffer
+import java.nio.file.Path
+
+/** Read-only memory-mapped view of a file, obtained through the TensorFlow file system layer.
+  *
+  * Contents of the file are exposed as direct byte buffers that point to the mapped memory, meaning that no copies are
+  * made when reading from them. Java byte buffers are limited to `Int.MaxValue` bytes and so larger files need to be
+  * accessed through multiple windows, using `buffer(offset, length)`.
+  *
+  * '''IMPORTANT:''' `close()` needs to be called after being done with this object in order to unmap the file. This
+  * is not done automatically when the object is garbage collected, because the buffers returned by this object may
+  * outlive it. Any buffers obtained from this region must not be used after it has been closed.
+  *
+  * @param  nativeHandleWrapper Wrapper around a handle to the native memory region object.
+  * @param  closeFn             Function used to delete the native memory region object (i.e., unmap the file).
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class ReadOnlyMemoryRegion private[ReadOnlyMemoryRegion] (
+    private[this] val nativeHandleWrapper: NativeHandleWrapper,
+    override protected val closeFn: () => Unit
+) extends Closeable {
+  /** Native handle of this memory region. */
+  private[api] def nativeHandle: Long = nativeHandleWrapper.handle
+
+  /** Length of this memory region, in bytes. */
+  lazy val length: Long = {
+    if (nativeHandle == 0)
+      throw UnavailableException("This memory region has already been unmapped.")
+    NativeFileIO.readOnlyMemoryRegionLength(nativeHandle)
+  }
+
+  /** Returns a read-only direct byte buffer over the whole memory region.
+    *
+    * @throws UnavailableException If this memory region has already been unmapped.
+    */
+  @throws[UnavailableException]
+  def buffer: ByteBuffer = {
+    require(length <= Int.MaxValue, s"The memory region is too large ($length bytes) to fit in a single buffer.")
+    buffer(0L, length.toInt)
+  }
+
+  /** Returns a read-only direct byte buffer over the window `[offset, offset + length)` of the memory region.
+    *
+    * @throws UnavailableException If this memory region has already been unmapped.
+    */
+  @throws[UnavailableException]
+  def buffer(offset: Long, length: Int): ByteBuffer = nativeHandleWrapper.Lock.synchronized {
+    if (nativeHandle == 0)
+      throw UnavailableException("This memory region has already been unmapped.")
+    NativeFileIO.readOnlyMemoryRegionBuffer(nativeHandle, offset, length).asReadOnlyBuffer()
+  }
+}
+
+object ReadOnlyMemoryRegion {
+  /** Maps the file located at `filePath` in memory, in read-only mode.
+    *
+    * @param  filePath Path to the file.
+    * @return Memory region for the mapped file.
+    */
+  def apply(filePath: Path): ReadOnlyMemoryRegion = {
+    val nativeHandle = NativeFileIO.newReadOnlyMemoryRegion(filePath.toAbsolutePath.toString)
+    val nativeHandleWrapper = NativeHandleWrapper(nativeHandle)
+    val closeFn = () => {
+      nativeHandleWrapper.Lock.synchronized {
+        if (nativeHandleWrapper.handle != 0) {
+          NativeFileIO.deleteReadOnlyMemoryRegion(nativeHandleWrapper.handle)
+          nativeHandleWrapper.handle = 0
+        }
+      }
+    }
+    new ReadOnlyMemoryRegion(nativeHandleWrapper, closeFn)
+  }
+}
@@ -15,51 +15,104 @@
 
 package org.platanios.tensorflow.api.io
 
-import java.io.BufferedOutputStream
-import java.nio.file.{Files, Path, StandardOpenOption}
+import org.platanios.tensorflow.api.core.exception.UnavailableException
+import org.platanios.tensorflow.api.utilities.{Closeable, Disposer, NativeHandleWrapper}
+import org.platanios.tensorflow.jni.{RecordWriter => NativeWriter}
 
-import org.platanios.tensorflow.api.utilities.{CRC32C, Coding}
 import org.tensorflow.example.Example
 
+import java.nio.file.{FileAlreadyExistsException, Files, Path}
+
 /** Helper used to write `Example` protocol buffers to TensorFlow record files.
   *
-  * @param  filePath TensorFlow record file path.
+  * Records are framed and compressed by the native library. Apart from the compression types supported by the
+  * TensorFlow record dataset ops, this writer also supports [[SnappyCompression]].
+  *
+  * '''IMPORTANT:''' `close()` needs to be called after being done with this writer in order to write any remaining
+  * buffered records and release the associated native resources. Writers that are garbage collected without having
+  * been closed are closed automatically, but any errors that occur while doing so are ignored.
+  *
+  * @param  filePath        TensorFlow record file path. The file must not already exist.
+  * @param  compressionType Compression type to use for the file.
   *
   * @author Emmanouil Antonios Platanios
   */
-class TFRecordWriter(val filePath: Path) {
-  protected var fileStream: BufferedOutputStream = {
-    new BufferedOutputStream(Files.newOutputStream(
-      filePath, StandardOpenOption.CREATE_NEW, StandardOpenOption.APPEND))
+class TFRecordWriter(val filePath: Path, val compressionType: CompressionType = NoCompression) extends Closeable {
+  private[this] val nativeHandleWrapper: NativeHandleWrapper = {
+    if (Files.exists(filePath))
+      throw new FileAlreadyExistsException(filePath.toString)
+    NativeHandleWrapper(NativeWriter.newRecordWriter(filePath.toAbsolutePath.toString, compressionType.name, false))
+  }
+
+  /** Lock for the native handle. */
+  private[TFRecordWriter] def NativeHandleLock = nativeHandleWrapper.Lock
+
+  /** Native handle of this writer. */
+  private[api] def nativeHandle: Long = nativeHandleWrapper.handle
+
+  /** Flushes and then closes the current TensorFlow records file. */
+  override protected val closeFn: () => Unit = TFRecordWriter.closeFn(nativeHandleWrapper)
+
+  // Keep track of references in the Scala side and notify the native library when the writer is not referenced
+  // anymore anywhere in the Scala side. This will let the native library free the allocated resources and prevent a
+  // potential memory leak.
+  Disposer.add(this, TFRecordWriter.disposeFn(nativeHandleWrapper))
+
+  @inline private[this] def checkNotClosed(): Unit = {
+    if (nativeHandle == 0)
+      throw UnavailableException("This TensorFlow records file writer has already been closed.")
   }
 
   /** Appends `example` to the TensorFlow records file. */
+  @throws[UnavailableException]
   def write(example: Example): Unit = {
-    val recordBytes = example.toByteArray
-    // Format of a single record:
-    //  uint64    length
-    //  uint32    masked crc of length
-    //  byte      data[length]
-    //  uint32    masked crc of data
-    val encLength = Coding.encodeFixedInt64(recordBytes.length)
-    val encLengthMaskedCrc = Coding.encodeFixedInt32(CRC32C.mask(CRC32C.value(encLength)))
-    val encDataMaskedCrc = Coding.encodeFixedInt32(CRC32C.mask(CRC32C.value(recordBytes)))
-    fileStream.write(encLength ++ encLengthMaskedCrc ++ recordBytes ++ encDataMaskedCrc)
+    write(example.toByteArray)
   }
 
-  /** Pushes outstanding examples to disk. */
-  def flush(): Unit = {
-    fileStream.flush()
+  /** Appends the serialized record `record` to the TensorFlow records file. */
+  @throws[UnavailableException]
+  def write(record: Array[Byte]): Unit = {
+    checkNotClosed()
+    NativeWriter.write(nativeHandle, record, 0, record.length)
   }
 
-  /** Calls `flush()` and then closes the current TensorFlow records file. */
-  def close(): Unit = {
-    fileStream.close()
+  /** Pushes outstanding examples to disk. */
+  @throws[UnavailableException]
+  def flush(): Unit = {
+    checkNotClosed()
+    NativeWriter.flush(nativeHandle)
   }
 }
 
 object TFRecordWriter {
-  def apply(filePath: Path): TFRecordWriter = {
-    new TFRecordWriter(filePath)
+  def apply(filePath: Path, compressionType: CompressionType = NoCompression): TFRecordWriter = {
+    new TFRecordWriter(filePath, compressionType)
+  }
+
+  /** Returns a function that flushes, closes, and deletes the native writer, and reports any errors that occur while
+    * flushing or closing it. */
+  private[TFRecordWriter] def closeFn(nativeHandleWrapper: NativeHandleWrapper): () => Unit = () => {
+    nativeHandleWrapper.Lock.synchronized {
+      if (nativeHandleWrapper.handle != 0) {
+        val handle = nativeHandleWrapper.handle
+        nativeHandleWrapper.handle = 0
+        try {
+          NativeWriter.close(handle)
+        } finally {
+          NativeWriter.delete(handle)
+        }
+      }
+    }
+  }
+
+  /** Returns a function that deletes the native writer. Deleting the writer also closes it, but ignores any errors, and
+    * so this function can be used by the [[Disposer]], which must never throw. */
+  private[TFRecordWriter] def disposeFn(nativeHandleWrapper: NativeHandleWrapper): () => Unit = () => {
+    nativeHandleWrapper.Lock.synchronized {
+      if (nativeHandleWrapper.handle != 0) {
+        NativeWriter.delete(nativeHandleWrapper.handle)
+        nativeHandleWrapper.handle = 0
+      }
+    }
   }
 }
@@ -0,0 +1,93 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.jni.{RandomReadBenchmarkResult, UringFileSystem => NativeUringFileSystem}
+
+/** Linux file system that serves random access reads of local files through `io_uring`.
+  *
+  * Once registered, local files can be accessed through this file system by using paths of the form
+  * `<scheme>:///path/to/file` anywhere a file path is accepted (e.g., in [[TFRecordReader]] or [[FileIO]]). Reads from
+  * all threads are submitted to a single shared queue and performed into buffers registered with the kernel. Large reads
+  * are split into multiple concurrently submitted requests, and so the device queue can be kept deep even when each
+  * caller issues one read at a time. All other operations (e.g., writes and directory listings) are delegated to the
+  * local file system.
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+object UringFileSystem {
+  /** Returns `true` if `io_uring` is supported by both the native library and the running kernel. */
+  def isSupported: Boolean = NativeUringFileSystem.isSupported
+
+  /** Registers the `io_uring` file system with TensorFlow under `scheme`. A file system can only be registered once for
+    * each scheme.
+    *
+    * @param  scheme     Scheme to register the file system under.
+    * @param  queueDepth Number of submission queue entries, which bounds the number of reads in flight.
+    * @param  numBuffers Number of buffers registered with the kernel, which also bounds the number of reads in flight.
+    * @param  bufferSize Size of each registered buffer, in bytes. Larger reads are split into multiple requests.
+    */
+  def register(
+      scheme: String = "uring",
+      queueDepth: Int = 128,
+      numBuffers: Int = 128,
+      bufferSize: Int = 128 * 1024
+  ): Unit = {
+    NativeUringFileSystem.register(scheme, queueDepth, numBuffers, bufferSize)
+  }
+
+  /** Result of a random read benchmark.
+    *
+    * @param  numReads Number of reads performed.
+    * @param  numBytes Number of bytes read.
+    * @param  seconds  Wall-clock duration of the benchmark, in seconds.
+    */
+  case class BenchmarkResult(numReads: Long, numBytes: Long, seconds: Double) {
+    /** Number of reads performed per second. */
+    def iops: Double = numReads / seconds
+
+    /** Number of bytes read per second. */
+    def bytesPerSecond: Double = numBytes / seconds
+
+    override def toString: String = {
+      f"$numReads%d reads in $seconds%.3f s ($iops%.0f IOPS, ${bytesPerSecond / (1024 * 1024)}%.1f MiB/s)"
+    }
+  }
+
+  /** Benchmarks random reads from the file at `path`, similar to `fio`'s `randread` workload. Each thread reads whole
+    * blocks at uniformly random block-aligned offsets, with one read outstanding at a time. The file is opened through
+    * TensorFlow, and so any two file systems can be compared by changing the scheme of `path` (e.g., `file:///data/x`
+    * against `uring:///data/x`). Note that page cache hits will inflate the results unless the file is much larger than
+    * the available memory.
+    *
+    * @param  path       Path to the file to read.
+    * @param  blockSize  Size of each read, in bytes.
+    * @param  numReads   Total number of reads to perform.
+    * @param  numThreads Number of threads issuing reads.
+    * @param  seed       Seed for the random offsets.
+    * @return Benchmark result.
+    */
+  def benchmarkRandomReads(
+      path: String,
+      blockSize: Int = 4096,
+      numReads: Long = 100000L,
+      numThreads: Int = 32,
+      seed: Long = 0L
+  ): BenchmarkResult = {
+    val result: RandomReadBenchmarkResult = NativeUringFileSystem.benchmarkRandomReads(
+      path, blockSize, numReads, numThreads, seed)
+    BenchmarkResult(result.numReads, result.numBytes, result.seconds)
+  }
+}
@@ -16,7 +16,7 @@
 package org.platanios.tensorflow.api.io.events
 
 import com.google.protobuf.ByteString
-import org.tensorflow.framework.TensorProto
+import org.tensorflow.framework.{Summary, TensorProto}
 
 /**
   * @author Emmanouil Antonios Platanios
@@ -71,3 +71,9 @@ case class TensorEventRecord(
     override val step: Long,
     override val value: TensorProto
 ) extends EventRecord[TensorProto]
+
+case class SummaryValueEventRecord(
+    override val wallTime: Double,
+    override val step: Long,
+    override val value: Summary.Value
+) extends EventRecord[Summary.Value]
@@ -0,0 +1,84 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io.events
+
+import org.platanios.tensorflow.jni.{EventScanner => NativeEventScanner}
+
+import org.tensorflow.framework.Summary
+
+import java.nio.file.Path
+
+/** Scans TensorFlow event files natively, returning only a down-sampled subset of the summary values they contain.
+  *
+  * Unlike the [[EventAccumulator]], which loads every event into the JVM and then filters and samples it, the scanner
+  * reads and parses the event files in the native library, filters summary values by tag and plugin, and applies
+  * per-tag reservoir sampling there. Only the surviving records are returned. Multiple runs are scanned in parallel.
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+object EventScanner {
+  /** Summary values of a single run that survived scanning.
+    *
+    * @param  path    Path of the run (i.e., an events file or a directory containing events files).
+    * @param  plugins Map from tag to the name of the plugin that tag belongs to. Values without plugin metadata are
+    *                 assigned to the `"scalars"`, `"images"`, `"audio"`, or `"histograms"` plugin, depending on their
+    *                 type.
+    * @param  scalars Map from tag to the sampled scalar (i.e., simple value) records for that tag.
+    * @param  values  Map from tag to the sampled records for that tag, for all non-scalar summary values.
+    */
+  case class ScannedRun(
+      path: Path,
+      plugins: Map[String, String],
+      scalars: Map[String, Seq[ScalarEventRecord]],
+      values: Map[String, Seq[SummaryValueEventRecord]])
+
+  /** Scans the provided runs.
+    *
+    * @param  runPaths          Paths of the runs to scan. Each path is either an events file or a directory containing
+    *                           events files.
+    * @param  tags              Tags to keep. If empty, all tags are kept.
+    * @param  plugins           Plugins whose tags to keep. If empty, tags of all plugins are kept.
+    * @param  reservoirSize     Maximum number of records to keep per tag. If `0`, all records are kept.
+    * @param  purgeOrphanedData Boolean value indicating whether to discard any events that were "orphaned" by a
+    *                           TensorFlow restart. Restarts are detected in the same way as by [[EventAccumulator]],
+    *                           which depends on the file version of the events files.
+    * @param  numThreads        Number of threads to use for scanning runs in parallel.
+    * @return Scanned runs, in the same order as `runPaths`.
+    */
+  def scan(
+      runPaths: Seq[Path],
+      tags: Set[String] = Set.empty,
+      plugins: Set[String] = Set.empty,
+      reservoirSize: Int = 1000,
+      purgeOrphanedData: Boolean = true,
+      numThreads: Int = Runtime.getRuntime.availableProcessors()
+  ): Seq[ScannedRun] = {
+    val scannedEvents = NativeEventScanner.scan(
+      runPaths.map(_.toAbsolutePath.toString).toArray, tags.toArray, plugins.toArray, reservoirSize,
+      purgeOrphanedData, numThreads)
+    runPaths.zip(scannedEvents).map {
+      case (path, events) =>
+        val (scalarIndices, valueIndices) = events.tagIndices.indices.partition(i => events.values(i) == null)
+        val scalars = scalarIndices.groupBy(i => events.tags(events.tagIndices(i))).mapValues(_.map(i => {
+          ScalarEventRecord(events.wallTimes(i), events.steps(i), events.simpleValues(i))
+        })).toMap
+        val values = valueIndices.groupBy(i => events.tags(events.tagIndices(i))).mapValues(_.map(i => {
+          SummaryValueEventRecord(events.wallTimes(i), events.steps(i), Summary.Value.parseFrom(events.values(i)))
+        })).toMap
+        ScannedRun(path, events.tags.zip(events.plugins).toMap, scalars, values)
+    }
+  }
+}
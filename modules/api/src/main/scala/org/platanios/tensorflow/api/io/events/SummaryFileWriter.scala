@@ -54,7 +54,7 @@ import scala.collection.mutable
   *
   * @param  workingDir     Directory in which to write the event file.
   * @param  graph          Graph to write to the event file when constructing the summary file writer.
-  * @param  queueCapacity  Maximum number of events pending to be written to disk before a call to `write()` blocks.
+  * @param  queueCapacity  Deprecated and unused.
   * @param  flushFrequency Specifies how often to flush the written events to disk (in seconds).
   * @param  filenameSuffix Filename suffix to use for the event file.
   *
@@ -196,7 +196,7 @@ object SummaryFileWriter {
     *
     * @param  workingDir     Directory in which to write the event file.
     * @param  graph          Graph to write to the event file when constructing the summary file writer.
-    * @param  queueCapacity  Maximum number of events pending to be written to disk before a call to `write()` blocks.
+    * @param  queueCapacity  Deprecated and unused.
     * @param  flushFrequency Specifies how often to flush the written events to disk (in seconds).
     * @param  filenameSuffix Filename suffix to use for the event file.
     * @return Constructed summary file writer.
@@ -0,0 +1,148 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.api.core.exception.{InvalidArgumentException, ResourceExhaustedException}
+import org.platanios.tensorflow.api.core.exception.UnavailableException
+import org.platanios.tensorflow.jni.PermissionDeniedException
+
+import org.junit.{Assume, Before, Rule, Test}
+import org.junit.rules.TemporaryFolder
+import org.scalatest.junit.JUnitSuite
+
+import java.nio.ByteBuffer
+import java.nio.charset.StandardCharsets
+import java.nio.file.{Files, Path, Paths}
+
+/**
+  * @author Emmanouil Antonios Platanios
+  */
+class BufferedWritableFileSuite extends JUnitSuite {
+  private[this] var _tempPath  : Path            = _
+  private[this] val _tempFolder: TemporaryFolder = new TemporaryFolder
+
+  @Rule def tempFolder: TemporaryFolder = _tempFolder
+
+  @Before def setUp(): Unit = {
+    _tempPath = tempFolder.newFolder().toPath
+  }
+
+  private[this] def bytes(size: Int, seed: Int): Array[Byte] = Array.tabulate[Byte](size)(i => (i * 31 + seed).toByte)
+
+  @Test def testRoundTrip(): Unit = {
+    val filePath = _tempPath.resolve("file")
+    // The appends are both smaller and larger than the buffer, so that some of them are buffered and some of them are
+    // written directly, and the order in which they reach the file must be preserved.
+    val arrays = Seq(10, 100, 64, 1, 1000, 63, 5000, 3).zipWithIndex.map(s => bytes(s._1, s._2))
+    val file = BufferedWritableFile(filePath, bufferSize = 64)
+    arrays.zipWithIndex.foreach {
+      case (array, i) if i % 3 == 0 =>
+        file.write(array)
+      case (array, i) if i % 3 == 1 =>
+        val buffer = ByteBuffer.allocateDirect(array.length + 2)
+        buffer.put(array).flip()
+        file.write(buffer)
+        assert(buffer.remaining() === 0)
+      case (array, _) =>
+        file.write(ByteBuffer.wrap(array))
+    }
+    file.write("done")
+    file.close()
+    val expected = arrays.flatMap(_.toSeq) ++ "done".getBytes(StandardCharsets.UTF_8).toSeq
+    assert(Files.readAllBytes(filePath).toSeq === expected)
+  }
+
+  @Test def testWriteArrayRegion(): Unit = {
+    val filePath = _tempPath.resolve("file")
+    val array = bytes(100, 0)
+    val file = BufferedWritableFile(filePath, bufferSize = 16)
+    file.write(array, 10, 20)
+    file.write(array, 50, 50)
+    file.close()
+    assert(Files.readAllBytes(filePath).toSeq === array.slice(10, 30).toSeq ++ array.slice(50, 100).toSeq)
+  }
+
+  @Test def testFlushedDataIsVisible(): Unit = {
+    val filePath = _tempPath.resolve("file")
+    val file = BufferedWritableFile(filePath, bufferSize = 1024)
+    file.write(bytes(100, 0))
+    file.flush()
+    assert(Files.readAllBytes(filePath).toSeq === bytes(100, 0).toSeq)
+    file.write(bytes(2000, 1))
+    file.sync()
+    assert(Files.readAllBytes(filePath).toSeq === bytes(100, 0).toSeq ++ bytes(2000, 1).toSeq)
+    file.close()
+  }
+
+  @Test def testAppendMode(): Unit = {
+    val filePath = _tempPath.resolve("file")
+    Files.write(filePath, bytes(10, 0))
+    val file = BufferedWritableFile(filePath, FileIO.APPEND, bufferSize = 64)
+    file.write(bytes(10, 1))
+    file.close()
+    assert(Files.readAllBytes(filePath).toSeq === bytes(10, 0).toSeq ++ bytes(10, 1).toSeq)
+  }
+
+  @Test def testInvalidArrayRegion(): Unit = {
+    val file = BufferedWritableFile(_tempPath.resolve("file"))
+    intercept[InvalidArgumentException](file.write(bytes(10, 0), 5, 10))
+    intercept[InvalidArgumentException](file.write(bytes(10, 0), -1, 5))
+    file.close()
+  }
+
+  @Test def testInvalidBufferSize(): Unit = {
+    intercept[IllegalArgumentException](BufferedWritableFile(_tempPath.resolve("file"), bufferSize = 0))
+    intercept[IllegalArgumentException](BufferedWritableFile(_tempPath.resolve("file"), bufferSize = -1))
+  }
+
+  @Test def testDeferredWriteError(): Unit = {
+    // Every write to `/dev/full` fails because the device is out of space.
+    val devFull = Paths.get("/dev/full")
+    Assume.assumeTrue("'/dev/full' is not available.", Files.isWritable(devFull))
+    val file = BufferedWritableFile(devFull, bufferSize = 8192)
+    // Appends smaller than the buffer only copy the data and so they cannot fail themselves. The error occurs on the
+    // background thread and is reported by a later append.
+    file.write(bytes(1000, 0))
+    val numAppends = (1 until 100).iterator.takeWhile(i => {
+      try {
+        file.write(bytes(1000, i))
+        true
+      } catch {
+        case _: ResourceExhaustedException => false
+      }
+    }).size
+    assert(numAppends < 99)
+    // All subsequent calls fail with the same error.
+    intercept[ResourceExhaustedException](file.write(bytes(10, 0)))
+    intercept[ResourceExhaustedException](file.flush())
+    intercept[ResourceExhaustedException](file.close())
+    intercept[UnavailableException](file.flush())
+  }
+
+  @Test def testReadOnlyMode(): Unit = {
+    intercept[PermissionDeniedException](BufferedWritableFile(_tempPath.resolve("file"), FileIO.READ))
+  }
+
+  @Test def testClosedFile(): Unit = {
+    val file = BufferedWritableFile(_tempPath.resolve("file"))
+    file.close()
+    intercept[UnavailableException](file.write(bytes(10, 0)))
+    intercept[UnavailableException](file.flush())
+    intercept[UnavailableException](file.sync())
+    // Closing a file more than once has no effect.
+    file.close()
+  }
+}
@@ -0,0 +1,225 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.api.core.exception.{AlreadyExistsException, InvalidArgumentException, NotFoundException}
+import org.platanios.tensorflow.jni.{FileIO => NativeFileIO}
+
+import org.junit.{Before, Rule, Test}
+import org.junit.rules.TemporaryFolder
+import org.scalatest.junit.JUnitSuite
+
+import java.nio.charset.StandardCharsets
+import java.nio.file.{Files, Path}
+
+/** Tests the caching file system. Each test registers its own file system, so that the cache statistics it checks are
+  * not affected by the other tests.
+  *
+  * Paths with a scheme cannot be represented using `java.nio.file.Path` (which collapses the slashes following the
+  * scheme), and so files are read through the native library directly, using string paths.
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class CachingFileSystemSuite extends JUnitSuite {
+  private[this] var _tempPath  : Path            = _
+  private[this] val _tempFolder: TemporaryFolder = new TemporaryFolder
+
+  @Rule def tempFolder: TemporaryFolder = _tempFolder
+
+  @Before def setUp(): Unit = {
+    _tempPath = tempFolder.newFolder().toPath
+  }
+
+  private[this] def cachePath(scheme: String, filePath: Path): String = s"$scheme://${filePath.toAbsolutePath}"
+
+  private[this] def writeFile(name: String, size: Int): (Path, Array[Byte]) = {
+    val filePath = _tempPath.resolve(name)
+    val contents = Array.tabulate[Byte](size)(i => (i * 131 + i / 256).toByte)
+    Files.write(filePath, contents)
+    (filePath, contents)
+  }
+
+  /** Returns the number of spilled blocks in `spillDirectory`, including the directories of all caches that use it. */
+  private[this] def numSpilledBlocks(spillDirectory: Path): Long = {
+    Files.walk(spillDirectory).filter(path => Files.isRegularFile(path)).count()
+  }
+
+  @Test def testRamHits(): Unit = {
+    val scheme = CachingFileSystemSuite.register(blockSize = 1024L, maxBytes = 1024L * 1024L)
+    val (filePath, contents) = writeFile("file", 4000)
+    assert(NativeFileIO.readFileToBytes(cachePath(scheme, filePath)).toSeq === contents.toSeq)
+    assert(CachingFileSystem.stats(scheme) === CachingFileSystem.Stats(0L, 0L, 4L, 4000L, 0L, 0L, 0L))
+    assert(NativeFileIO.readFileToBytes(cachePath(scheme, filePath)).toSeq === contents.toSeq)
+    val stats = CachingFileSystem.stats(scheme)
+    assert(stats === CachingFileSystem.Stats(4L, 0L, 4L, 4000L, 0L, 0L, 0L))
+    assert(stats.numReads === 8L)
+    assert(stats.ramHitRatio === 0.5)
+    assert(stats.hitRatio === 0.5)
+  }
+
+  @Test def testSpillHits(): Unit = {
+    val scheme = CachingFileSystemSuite.register(
+      blockSize = 1024L, maxBytes = 2048L, spillDirectory = Some(_tempPath.resolve("spill")))
+    val (filePath, contents) = writeFile("file", 4096)
+    assert(NativeFileIO.readFileToBytes(cachePath(scheme, filePath)).toSeq === contents.toSeq)
+    val firstStats = CachingFileSystem.stats(scheme)
+    assert(firstStats.misses === 4L)
+    assert(firstStats.ramBytes === 2048L)
+    assert(firstStats.ramEvictions === 2L)
+    assert(firstStats.spillBytes === 2048L)
+    // Reading the file again in order always finds the next block in the spill directory rather than in RAM.
+    assert(NativeFileIO.readFileToBytes(cachePath(scheme, filePath)).toSeq === contents.toSeq)
+    val secondStats = CachingFileSystem.stats(scheme)
+    assert(secondStats.misses === 4L)
+    assert(secondStats.spillHits === 4L)
+    assert(secondStats.ramBytes === 2048L)
+    assert(secondStats.spillBytes === 4096L)
+    assert(secondStats.spillEvictions === 0L)
+    assert(secondStats.hitRatio === 0.5)
+  }
+
+  @Test def testSpillEvictions(): Unit = {
+    val scheme = CachingFileSystemSuite.register(
+      blockSize = 1024L, maxBytes = 1024L, spillDirectory = Some(_tempPath.resolve("spill")), maxSpillBytes = 1024L)
+    val (filePath, contents) = writeFile("file", 4096)
+    assert(NativeFileIO.readFileToBytes(cachePath(scheme, filePath)).toSeq === contents.toSeq)
+    val stats = CachingFileSystem.stats(scheme)
+    assert(stats.ramBytes === 1024L)
+    assert(stats.ramEvictions === 3L)
+    assert(stats.spillBytes === 1024L)
+    assert(stats.spillEvictions === 2L)
+    assert(numSpilledBlocks(_tempPath.resolve("spill")) === 1L)
+  }
+
+  @Test def testSharedSpillDirectory(): Unit = {
+    val spillDirectory = _tempPath.resolve("spill")
+    val firstScheme = CachingFileSystemSuite.register(
+      blockSize = 1024L, maxBytes = 1024L, spillDirectory = Some(spillDirectory))
+    val secondScheme = CachingFileSystemSuite.register(
+      blockSize = 1024L, maxBytes = 1024L, spillDirectory = Some(spillDirectory))
+    val (firstPath, firstContents) = writeFile("first", 4096)
+    val (secondPath, secondContents) = writeFile("second", 4096)
+    secondContents.indices.foreach(i => secondContents(i) = (secondContents(i) ^ 0xff).toByte)
+    Files.write(secondPath, secondContents)
+    assert(NativeFileIO.readFileToBytes(cachePath(firstScheme, firstPath)).toSeq === firstContents.toSeq)
+    assert(NativeFileIO.readFileToBytes(cachePath(secondScheme, secondPath)).toSeq === secondContents.toSeq)
+    assert(Files.list(spillDirectory).count() === 2L)
+    assert(numSpilledBlocks(spillDirectory) === 6L)
+    // Each cache reads back its own spilled blocks, rather than the blocks the other cache spilled.
+    assert(NativeFileIO.readFileToBytes(cachePath(firstScheme, firstPath)).toSeq === firstContents.toSeq)
+    assert(NativeFileIO.readFileToBytes(cachePath(secondScheme, secondPath)).toSeq === secondContents.toSeq)
+    assert(CachingFileSystem.stats(firstScheme).spillHits === 4L)
+    assert(CachingFileSystem.stats(secondScheme).spillHits === 4L)
+    CachingFileSystem.clear(firstScheme)
+    assert(numSpilledBlocks(spillDirectory) === 4L)
+  }
+
+  @Test def testDisabledCache(): Unit = {
+    val scheme = CachingFileSystemSuite.register(blockSize = 1024L, maxBytes = 0L)
+    val (filePath, contents) = writeFile("file", 4000)
+    assert(NativeFileIO.readFileToBytes(cachePath(scheme, filePath)).toSeq === contents.toSeq)
+    assert(CachingFileSystem.stats(scheme).numReads === 0L)
+  }
+
+  @Test def testClear(): Unit = {
+    val scheme = CachingFileSystemSuite.register(
+      blockSize = 1024L, maxBytes = 1024L, spillDirectory = Some(_tempPath.resolve("spill")))
+    val (filePath, contents) = writeFile("file", 4000)
+    assert(NativeFileIO.readFileToBytes(cachePath(scheme, filePath)).toSeq === contents.toSeq)
+    CachingFileSystem.clear(scheme)
+    val stats = CachingFileSystem.stats(scheme)
+    assert(stats.ramBytes === 0L)
+    assert(stats.spillBytes === 0L)
+    assert(numSpilledBlocks(_tempPath.resolve("spill")) === 0L)
+    assert(NativeFileIO.readFileToBytes(cachePath(scheme, filePath)).toSeq === contents.toSeq)
+    assert(CachingFileSystem.stats(scheme).misses === 8L)
+  }
+
+  @Test def testClose(): Unit = {
+    val spillDirectory = _tempPath.resolve("spill")
+    val scheme = CachingFileSystemSuite.register(
+      blockSize = 1024L, maxBytes = 1024L, spillDirectory = Some(spillDirectory))
+    val (filePath, contents) = writeFile("file", 4096)
+    assert(NativeFileIO.readFileToBytes(cachePath(scheme, filePath)).toSeq === contents.toSeq)
+    assert(numSpilledBlocks(spillDirectory) === 3L)
+    CachingFileSystem.close(scheme)
+    assert(Files.list(spillDirectory).count() === 0L)
+    assert(CachingFileSystem.stats(scheme).spillBytes === 0L)
+    // The file system keeps caching blocks in RAM, but no longer spills them.
+    assert(NativeFileIO.readFileToBytes(cachePath(scheme, filePath)).toSeq === contents.toSeq)
+    val stats = CachingFileSystem.stats(scheme)
+    assert(stats.ramBytes === 1024L)
+    assert(stats.spillHits === 0L)
+    assert(stats.spillBytes === 0L)
+    assert(Files.list(spillDirectory).count() === 0L)
+  }
+
+  @Test def testInvalidation(): Unit = {
+    val scheme = CachingFileSystemSuite.register(blockSize = 1024L, maxBytes = 1024L * 1024L)
+    val (filePath, contents) = writeFile("file", 4000)
+    assert(NativeFileIO.readFileToBytes(cachePath(scheme, filePath)).toSeq === contents.toSeq)
+    // Files written through the cache are invalidated immediately.
+    NativeFileIO.writeStringToFile(cachePath(scheme, filePath), "modified")
+    assert(CachingFileSystem.stats(scheme).ramBytes === 0L)
+    val modified = "modified".getBytes(StandardCharsets.UTF_8)
+    assert(NativeFileIO.readFileToBytes(cachePath(scheme, filePath)).toSeq === modified.toSeq)
+    // Files modified by other means are detected when they are opened again.
+    Files.write(filePath, contents)
+    assert(NativeFileIO.readFileToBytes(cachePath(scheme, filePath)).toSeq === contents.toSeq)
+    assert(CachingFileSystem.stats(scheme).misses === 9L)
+  }
+
+  @Test def testMissingFile(): Unit = {
+    val scheme = CachingFileSystemSuite.register()
+    intercept[NotFoundException](NativeFileIO.readFileToBytes(cachePath(scheme, _tempPath.resolve("missing"))))
+  }
+
+  @Test def testInvalidArguments(): Unit = {
+    intercept[InvalidArgumentException](CachingFileSystem.register("cachetestinvalid", blockSize = 0L))
+    intercept[InvalidArgumentException](CachingFileSystem.register("cachetestinvalid", maxBytes = -1L))
+    intercept[InvalidArgumentException](CachingFileSystem.register("cachetestinvalid", maxSpillBytes = -1L))
+    // None of the registrations above succeeded.
+    intercept[InvalidArgumentException](CachingFileSystem.stats("cachetestinvalid"))
+    intercept[InvalidArgumentException](CachingFileSystem.clear("cachetestinvalid"))
+    intercept[InvalidArgumentException](CachingFileSystem.close("cachetestinvalid"))
+  }
+
+  @Test def testRegisterTwice(): Unit = {
+    val spillDirectory = _tempPath.resolve("spill")
+    val scheme = CachingFileSystemSuite.register(spillDirectory = Some(spillDirectory))
+    intercept[AlreadyExistsException](CachingFileSystem.register(scheme, spillDirectory = Some(spillDirectory)))
+    // The spill directory created for the failed registration is removed.
+    assert(Files.list(spillDirectory).count() === 1L)
+  }
+}
+
+object CachingFileSystemSuite {
+  private[this] var numSchemes: Int = 0
+
+  /** Registers a caching file system under a new scheme and returns that scheme. File systems cannot be unregistered
+    * and so tests cannot share a scheme without also sharing the cache statistics. */
+  def register(
+      blockSize: Long = 1024L,
+      maxBytes: Long = 1024L * 1024L,
+      spillDirectory: Option[Path] = None,
+      maxSpillBytes: Long = 1024L * 1024L
+  ): String = synchronized {
+    numSchemes += 1
+    val scheme = s"cachetest$numSchemes"
+    CachingFileSystem.register(scheme, blockSize, maxBytes, spillDirectory, maxSpillBytes)
+    scheme
+  }
+}
@@ -0,0 +1,116 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.api.core.exception.{FailedPreconditionException, UnavailableException}
+import org.platanios.tensorflow.api.core.types._
+import org.platanios.tensorflow.api.implicits.Implicits._
+import org.platanios.tensorflow.api.tensors.Tensor
+
+import org.junit.{Before, Rule, Test}
+import org.junit.rules.TemporaryFolder
+import org.scalatest.junit.JUnitSuite
+
+import java.nio.file.Path
+
+/**
+  * @author Emmanouil Antonios Platanios
+  */
+class CheckpointWriterSuite extends JUnitSuite {
+  private[this] var _tempPath  : Path            = _
+  private[this] val _tempFolder: TemporaryFolder = new TemporaryFolder
+
+  @Rule def tempFolder: TemporaryFolder = _tempFolder
+
+  @Before def setUp(): Unit = {
+    _tempPath = tempFolder.newFolder().toPath
+  }
+
+  private[this] val floatTensors: Map[String, Tensor[Float]] = (0 until 5).map(i => {
+    s"layer$i/weights" -> Tensor((0 until 100 * (i + 1)).map(j => (i * j).toFloat: Tensor[Float]): _*)
+  }).toMap
+
+  private[this] val longTensors: Map[String, Tensor[Long]] = Map(
+    "global_step" -> (42L: Tensor[Long]),
+    "counts" -> Tensor(Tensor(1L, 2L), Tensor(3L, 4L)))
+
+  private[this] def writeCheckpoint(prefix: Path, numShards: Int): CheckpointWriter.Progress = {
+    val writer = CheckpointWriter(prefix, numShards)
+    writer.add(floatTensors)
+    writer.add(longTensors)
+    writer.start()
+    writer.await()
+    val progress = writer.progress
+    writer.close()
+    progress
+  }
+
+  private[this] def assertRoundTrip(prefix: Path): Unit = {
+    val reader = CheckpointReader(prefix)
+    floatTensors.foreach {
+      case (name, tensor) => assert(reader.getTensor[Float](name).contains(tensor))
+    }
+    longTensors.foreach {
+      case (name, tensor) => assert(reader.getTensor[Long](name).contains(tensor))
+    }
+    assert(!reader.hasTensor("missing"))
+    reader.close()
+  }
+
+  @Test def testRoundTripWithOneShard(): Unit = {
+    val prefix = _tempPath.resolve("model.ckpt")
+    val progress = writeCheckpoint(prefix, numShards = 1)
+    assert(progress.isDone)
+    assert(progress.numTensors === floatTensors.size + longTensors.size)
+    assert(progress.numTensorsWritten === progress.numTensors)
+    assert(progress.numBytesWritten === progress.numBytes)
+    assertRoundTrip(prefix)
+  }
+
+  @Test def testRoundTripWithMoreShardsThanTensors(): Unit = {
+    val prefix = _tempPath.resolve("model.ckpt")
+    writeCheckpoint(prefix, numShards = 16)
+    assertRoundTrip(prefix)
+  }
+
+  @Test def testAddAfterStart(): Unit = {
+    val writer = CheckpointWriter(_tempPath.resolve("model.ckpt"), numShards = 2)
+    writer.add(longTensors)
+    writer.start()
+    intercept[FailedPreconditionException](writer.add(floatTensors))
+    intercept[FailedPreconditionException](writer.start())
+    writer.await()
+    writer.close()
+  }
+
+  @Test def testAwaitBeforeStart(): Unit = {
+    val writer = CheckpointWriter(_tempPath.resolve("model.ckpt"))
+    intercept[FailedPreconditionException](writer.await())
+    writer.close()
+  }
+
+  @Test def testDisposedWriter(): Unit = {
+    val writer = CheckpointWriter(_tempPath.resolve("model.ckpt"))
+    writer.close()
+    intercept[UnavailableException](writer.add(longTensors))
+    intercept[UnavailableException](writer.start())
+    intercept[UnavailableException](writer.progress)
+  }
+
+  @Test def testInvalidNumberOfShards(): Unit = {
+    intercept[IllegalArgumentException](CheckpointWriter(_tempPath.resolve("model.ckpt"), numShards = 0))
+  }
+}
@@ -0,0 +1,178 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.api.core.{Graph, Shape}
+import org.platanios.tensorflow.api.core.client.Session
+import org.platanios.tensorflow.api.core.exception.InvalidArgumentException
+import org.platanios.tensorflow.api.core.types._
+import org.platanios.tensorflow.api.implicits.Implicits._
+import org.platanios.tensorflow.api.ops.{Basic, Op, Parsing}
+import org.platanios.tensorflow.api.tensors.Tensor
+import org.platanios.tensorflow.api.utilities.using
+
+import com.google.protobuf.ByteString
+import org.junit.{Rule, Test}
+import org.junit.rules.TemporaryFolder
+import org.scalatest.junit.JUnitSuite
+import org.tensorflow.example.{BytesList, Example, Feature, Features, FloatList, Int64List}
+
+import java.nio.charset.StandardCharsets
+
+/**
+  * @author Emmanouil Antonios Platanios
+  */
+class ExampleParserSuite extends JUnitSuite {
+  private[this] val _tempFolder: TemporaryFolder = new TemporaryFolder
+
+  @Rule def tempFolder: TemporaryFolder = _tempFolder
+
+  private[this] def floatFeature(values: Float*): Feature = {
+    Feature.newBuilder().setFloatList(values.foldLeft(FloatList.newBuilder())(_.addValue(_))).build()
+  }
+
+  private[this] def int64Feature(values: Long*): Feature = {
+    Feature.newBuilder().setInt64List(values.foldLeft(Int64List.newBuilder())(_.addValue(_))).build()
+  }
+
+  private[this] def bytesFeature(values: String*): Feature = {
+    Feature.newBuilder().setBytesList(values.foldLeft(BytesList.newBuilder())(
+      (builder, value) => builder.addValue(ByteString.copyFromUtf8(value)))).build()
+  }
+
+  private[this] def example(features: (String, Feature)*): Example = {
+    Example.newBuilder().setFeatures(features.foldLeft(Features.newBuilder())(
+      (builder, feature) => builder.putFeature(feature._1, feature._2))).build()
+  }
+
+  // The last example is missing all features, so that the default values and the padding are used.
+  private[this] val examples: Seq[Example] = Seq(
+    example("a" -> floatFeature(2.0f, 8.0f), "ids" -> int64Feature(1L, 2L, 3L), "tokens" -> bytesFeature("x")),
+    example("ids" -> int64Feature(4L), "tokens" -> bytesFeature("y", "z")),
+    example("a" -> floatFeature(0.5f, 32.0f)),
+    example())
+
+  private[this] val denseFeatures: Seq[ExampleParser.DenseFeature] = Seq(
+    ExampleParser.DenseFeature("a", FLOAT32, Shape(2), Some(Tensor(4.0f, 16.0f))),
+    ExampleParser.DenseFeature("ids", INT64, Shape(-1), Some(-1L: Tensor[Long])))
+
+  private[this] val sparseFeatures: Seq[ExampleParser.SparseFeature] = Seq(
+    ExampleParser.SparseFeature("tokens", STRING))
+
+  /** Parses `examples` using the `ParseExample` op, with the same features as `denseFeatures` (apart from the
+    * variable-length one) and `sparseFeatures`. */
+  private[this] def parseExampleOp(
+      examples: Seq[Example]
+  ): (Tensor[Float], Tensor[Long], Tensor[String], Tensor[Long]) = {
+    using(Graph()) { graph =>
+      Op.createWith(graph) {
+        // String tensors store the bytes of each string using the ISO-8859-1 encoding.
+        val serialized = Basic.constant(Tensor(examples.map(e => {
+          Tensor.fill[String](Shape())(new String(e.toByteArray, StandardCharsets.ISO_8859_1))
+        }): _*))
+        val (a, tokens) = Parsing.parseExample(
+          serialized,
+          (Parsing.FixedLengthFeature[Float]("a", Shape(2), Some(Tensor(4.0f, 16.0f))),
+              Parsing.VariableLengthFeature[String]("tokens", STRING)))
+        val session = Session()
+        val parsedA = session.run(fetches = a)
+        val parsedTokens = session.run(fetches = tokens)
+        (parsedA, parsedTokens.indices, parsedTokens.values, parsedTokens.denseShape)
+      }
+    }
+  }
+
+  private[this] def assertMatchesParseExampleOp(batch: ExampleParser.ParsedBatch, examples: Seq[Example]): Unit = {
+    val (a, tokensIndices, tokensValues, tokensShape) = parseExampleOp(examples)
+    assert(batch.dense("a") == a)
+    assert(batch.sparse("tokens").indices == tokensIndices)
+    assert(batch.sparse("tokens").values == tokensValues)
+    assert(batch.sparse("tokens").denseShape == tokensShape)
+  }
+
+  @Test def testParseSerializedMatchesParseExampleOp(): Unit = {
+    val parser = ExampleParser(denseFeatures, sparseFeatures)
+    val batch = parser.parse(examples.map(_.toByteArray))
+    assert(batch.dense("a") == Tensor(
+      Tensor(2.0f, 8.0f), Tensor(4.0f, 16.0f), Tensor(0.5f, 32.0f), Tensor(4.0f, 16.0f)))
+    assertMatchesParseExampleOp(batch, examples)
+    parser.close()
+  }
+
+  @Test def testVariableLengthDenseFeatureIsPadded(): Unit = {
+    val parser = ExampleParser(denseFeatures, sparseFeatures)
+    val batch = parser.parse(examples.map(_.toByteArray))
+    assert(batch.dense("ids") == Tensor(
+      Tensor(1L, 2L, 3L), Tensor(4L, -1L, -1L), Tensor(-1L, -1L, -1L), Tensor(-1L, -1L, -1L)))
+    parser.close()
+  }
+
+  @Test def testParseRecordsMatchesParseExampleOp(): Unit = {
+    val filePath = tempFolder.newFolder().toPath.resolve("examples")
+    val writer = TFRecordWriter(filePath)
+    examples.foreach(e => writer.write(e))
+    writer.close()
+    val reader = TFRecordReader(filePath)
+    val parser = ExampleParser(denseFeatures, sparseFeatures)
+    val firstBatch = parser.parse(reader, batchSize = 3)
+    assert(firstBatch.isDefined)
+    assertMatchesParseExampleOp(firstBatch.get, examples.take(3))
+    val secondBatch = parser.parse(reader, batchSize = 3)
+    assert(secondBatch.isDefined)
+    assertMatchesParseExampleOp(secondBatch.get, examples.drop(3))
+    assert(parser.parse(reader, batchSize = 3).isEmpty)
+    parser.close()
+    reader.close()
+  }
+
+  @Test def testInvalidBatchSize(): Unit = {
+    val filePath = tempFolder.newFolder().toPath.resolve("examples")
+    val writer = TFRecordWriter(filePath)
+    examples.foreach(e => writer.write(e))
+    writer.close()
+    val reader = TFRecordReader(filePath)
+    val parser = ExampleParser(denseFeatures, sparseFeatures)
+    intercept[InvalidArgumentException](parser.parse(reader, batchSize = 0))
+    intercept[InvalidArgumentException](parser.parse(reader, batchSize = -1))
+    // No records are consumed by the failed calls.
+    val batch = parser.parse(reader, batchSize = examples.size)
+    assert(batch.isDefined)
+    assertMatchesParseExampleOp(batch.get, examples)
+    parser.close()
+    reader.close()
+  }
+
+  @Test def testMissingRequiredFeature(): Unit = {
+    val parser = ExampleParser(Seq(ExampleParser.DenseFeature("a", FLOAT32, Shape(2))))
+    assert(parser.parse(examples.take(1).map(_.toByteArray)).dense("a") == Tensor(Tensor(2.0f, 8.0f)))
+    intercept[InvalidArgumentException](parser.parse(examples.map(_.toByteArray)))
+    parser.close()
+  }
+
+  @Test def testUnsupportedFeatureTypes(): Unit = {
+    intercept[InvalidArgumentException](ExampleParser(Seq(ExampleParser.DenseFeature("a", INT32, Shape(2)))))
+    intercept[InvalidArgumentException](ExampleParser(sparseFeatures = Seq(ExampleParser.SparseFeature("ids", FLOAT64))))
+  }
+
+  @Test def testInvalidDefaultValues(): Unit = {
+    intercept[InvalidArgumentException](ExampleParser(Seq(
+      ExampleParser.DenseFeature("a", FLOAT32, Shape(2), Some(Tensor(4L, 16L))))))
+    intercept[InvalidArgumentException](ExampleParser(Seq(
+      ExampleParser.DenseFeature("a", FLOAT32, Shape(2), Some(Tensor(4.0f, 16.0f, 64.0f))))))
+    intercept[InvalidArgumentException](ExampleParser(Seq(
+      ExampleParser.DenseFeature("ids", INT64, Shape(-1), Some(Tensor(-1L, -1L))))))
+  }
+}
@@ -0,0 +1,173 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.api.core.exception.{InvalidArgumentException, NotFoundException, UnavailableException}
+import org.platanios.tensorflow.jni.PermissionDeniedException
+
+import org.junit.{Before, Rule, Test}
+import org.junit.rules.TemporaryFolder
+import org.scalatest.junit.JUnitSuite
+
+import java.nio.{ByteBuffer, ReadOnlyBufferException}
+import java.nio.file.{Files, Path}
+
+/**
+  * @author Emmanouil Antonios Platanios
+  */
+class FileIOSuite extends JUnitSuite {
+  private[this] var _tempPath  : Path            = _
+  private[this] val _tempFolder: TemporaryFolder = new TemporaryFolder
+
+  @Rule def tempFolder: TemporaryFolder = _tempFolder
+
+  @Before def setUp(): Unit = {
+    _tempPath = tempFolder.newFolder().toPath
+  }
+
+  /** Bytes that cover all byte values, including ones that are not valid UTF-8, with new-line characters in between. */
+  private[this] val contents: Array[Byte] = {
+    Array.tabulate[Byte](3 * 256 + 5)(i => if (i % 100 == 99) '\n'.toByte else i.toByte)
+  }
+
+  private[this] def writeContents(): Path = {
+    val filePath = _tempPath.resolve("contents")
+    Files.write(filePath, contents)
+    filePath
+  }
+
+  @Test def testReadBytes(): Unit = {
+    val file = FileIO(writeContents(), FileIO.READ, readBufferSize = 64)
+    assert(file.readBytes(10).toSeq === contents.take(10).toSeq)
+    assert(file.readBytes().toSeq === contents.drop(10).toSeq)
+    // Reads at the end of the file return no bytes.
+    assert(file.readBytes(10).isEmpty)
+    file.close()
+  }
+
+  @Test def testReadIntoBuffers(): Unit = {
+    val filePath = writeContents()
+    Seq(ByteBuffer.allocate(100), ByteBuffer.allocateDirect(100)).foreach(buffer => {
+      val file = FileIO(filePath, FileIO.READ, readBufferSize = 64)
+      val result = new java.io.ByteArrayOutputStream()
+      var numRead = file.read(buffer)
+      while (numRead > 0) {
+        assert(buffer.position() === numRead)
+        buffer.flip()
+        val bytes = new Array[Byte](buffer.remaining())
+        buffer.get(bytes)
+        result.write(bytes)
+        buffer.clear()
+        numRead = file.read(buffer)
+      }
+      assert(result.toByteArray.toSeq === contents.toSeq)
+      file.close()
+    })
+  }
+
+  @Test def testDirectBufferReadsKeepTheFilePosition(): Unit = {
+    val file = FileIO(writeContents(), FileIO.READ, readBufferSize = 64)
+    val small = ByteBuffer.allocateDirect(10)
+    val large = ByteBuffer.allocateDirect(200)
+    // Small reads go through the read buffer and large ones bypass it, and so interleaving them checks that the read
+    // buffer is dropped after every large read.
+    assert(file.readBytes(5).toSeq === contents.take(5).toSeq)
+    assert(file.read(large) === 200)
+    assert(file.tell === 205)
+    assert(file.read(small) === 10)
+    assert(file.readBytes(3).toSeq === contents.slice(215, 218).toSeq)
+    large.clear()
+    assert(file.read(large) === 200)
+    large.flip()
+    val bytes = new Array[Byte](200)
+    large.get(bytes)
+    assert(bytes.toSeq === contents.slice(218, 418).toSeq)
+    small.flip()
+    val smallBytes = new Array[Byte](10)
+    small.get(smallBytes)
+    assert(smallBytes.toSeq === contents.slice(205, 215).toSeq)
+    file.seek(700)
+    large.clear()
+    assert(file.read(large) === contents.length - 700)
+    assert(file.tell === contents.length)
+    large.clear()
+    assert(file.read(large) === 0)
+    file.close()
+  }
+
+  @Test def testReadIntoReadOnlyBuffer(): Unit = {
+    val filePath = writeContents()
+    val file = FileIO(filePath, FileIO.READ, readBufferSize = 64)
+    val region = FileIO.mapReadOnly(filePath)
+    Seq(ByteBuffer.allocate(100).asReadOnlyBuffer(), region.buffer).foreach(buffer => {
+      intercept[ReadOnlyBufferException](file.read(buffer))
+      assert(buffer.position() === 0)
+    })
+    // Nothing was read from the file.
+    assert(file.tell === 0L)
+    region.close()
+    file.close()
+  }
+
+  @Test def testReadLineBytes(): Unit = {
+    val file = FileIO(writeContents(), FileIO.READ, readBufferSize = 64)
+    val lines = Iterator.continually(file.readLineBytes()).takeWhile(_ != null).toSeq
+    assert(lines.map(_.length).sum === contents.length)
+    assert(lines.flatMap(_.toSeq) === contents.toSeq)
+    assert(lines.init.forall(_.last == '\n'.toByte))
+    file.close()
+  }
+
+  @Test def testReadFileToBytes(): Unit = {
+    assert(FileIO.readFileToBytes(writeContents()).toSeq === contents.toSeq)
+  }
+
+  @Test def testReadFromWriteOnlyFile(): Unit = {
+    val file = FileIO(_tempPath.resolve("file"), FileIO.WRITE)
+    intercept[PermissionDeniedException](file.readBytes())
+    file.close()
+  }
+
+  @Test def testMemoryRegion(): Unit = {
+    val region = FileIO.mapReadOnly(writeContents())
+    assert(region.length === contents.length)
+    val buffer = region.buffer
+    assert(buffer.isDirect && buffer.isReadOnly)
+    val bytes = new Array[Byte](buffer.remaining())
+    buffer.get(bytes)
+    assert(bytes.toSeq === contents.toSeq)
+    val window = region.buffer(300L, 10)
+    assert((0 until 10).map(window.get) === contents.slice(300, 310).toSeq)
+    region.close()
+  }
+
+  @Test def testMemoryRegionInvalidWindow(): Unit = {
+    val region = FileIO.mapReadOnly(writeContents())
+    intercept[InvalidArgumentException](region.buffer(-1L, 10))
+    intercept[InvalidArgumentException](region.buffer(contents.length - 5L, 10))
+    region.close()
+  }
+
+  @Test def testUnmappedMemoryRegion(): Unit = {
+    val region = FileIO.mapReadOnly(writeContents())
+    region.close()
+    intercept[UnavailableException](region.buffer(0L, 10))
+  }
+
+  @Test def testMemoryRegionOfMissingFile(): Unit = {
+    intercept[NotFoundException](FileIO.mapReadOnly(_tempPath.resolve("missing")))
+  }
+}
@@ -0,0 +1,109 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.junit.{Before, Rule, Test}
+import org.junit.rules.TemporaryFolder
+import org.scalatest.junit.JUnitSuite
+
+import java.nio.file.{Files, Path}
+
+/**
+  * @author Emmanouil Antonios Platanios
+  */
+class IndexedTFRecordReaderSuite extends JUnitSuite {
+  private[this] var _tempPath  : Path            = _
+  private[this] val _tempFolder: TemporaryFolder = new TemporaryFolder
+
+  @Rule def tempFolder: TemporaryFolder = _tempFolder
+
+  @Before def setUp(): Unit = {
+    _tempPath = tempFolder.newFolder().toPath
+  }
+
+  private[this] def record(index: Int): String = s"record-$index-" + "x" * (index % 7)
+
+  /** Writes the records `records` to a new TF record file named `filename` and returns its path. */
+  private[this] def writeRecords(filename: String, records: Range): Path = {
+    val filePath = _tempPath.resolve(filename)
+    val writer = TFRecordWriter(filePath)
+    records.foreach(i => writer.write(record(i).getBytes))
+    writer.close()
+    filePath
+  }
+
+  private[this] def readAll(iterator: Iterator[Array[Byte]]): Seq[String] = iterator.map(new String(_)).toSeq
+
+  @Test def testBuildIndex(): Unit = {
+    val filePath = writeRecords("a", 0 until 10)
+    val indexPath = IndexedTFRecordReader.indexPath(filePath)
+    assert(IndexedTFRecordReader.buildIndex(filePath, indexPath) === 10L)
+    assert(Files.exists(indexPath))
+  }
+
+  @Test def testEmptyFile(): Unit = {
+    val filePath = writeRecords("a", 0 until 0)
+    val reader = IndexedTFRecordReader(Seq(filePath))
+    assert(reader.numRecords === 0L)
+    assert(readAll(reader.iterator()) === Seq.empty[String])
+    reader.close()
+  }
+
+  @Test def testRandomAccessAcrossFiles(): Unit = {
+    val filePaths = Seq(writeRecords("a", 0 until 5), writeRecords("b", 5 until 12))
+    val reader = IndexedTFRecordReader(filePaths)
+    assert(filePaths.forall(p => Files.exists(IndexedTFRecordReader.indexPath(p))))
+    assert(reader.numRecords === 12L)
+    assert(new String(reader.read(7L)) === record(7))
+    val indices = Seq(11L, 0L, 6L, 4L, 5L, 0L)
+    assert(reader.read(indices).map(new String(_)) === indices.map(i => record(i.toInt)))
+    reader.close()
+  }
+
+  @Test def testSequentialIteration(): Unit = {
+    val reader = IndexedTFRecordReader(Seq(writeRecords("a", 0 until 10), writeRecords("b", 10 until 25)))
+    assert(readAll(reader.iterator(batchSize = 4)) === (0 until 25).map(record))
+    reader.close()
+  }
+
+  @Test def testShuffledIteration(): Unit = {
+    val reader = IndexedTFRecordReader(Seq(writeRecords("a", 0 until 10), writeRecords("b", 10 until 25)))
+    val epoch0 = readAll(reader.iterator(shuffle = true, seed = 42L, batchSize = 4))
+    assert(epoch0.sorted === (0 until 25).map(record).sorted)
+    assert(epoch0 !== (0 until 25).map(record))
+    assert(readAll(reader.iterator(shuffle = true, seed = 42L, batchSize = 8)) === epoch0)
+    assert(readAll(reader.iterator(shuffle = true, seed = 42L, epoch = 1L)) !== epoch0)
+    reader.close()
+  }
+
+  @Test def testResumeFromPosition(): Unit = {
+    val reader = IndexedTFRecordReader(Seq(writeRecords("a", 0 until 10), writeRecords("b", 10 until 25)))
+    val epoch = readAll(reader.iterator(shuffle = true, seed = 7L, batchSize = 4))
+    assert(readAll(reader.iterator(shuffle = true, seed = 7L, startPosition = 13L, batchSize = 4)) === epoch.drop(13))
+    assert(readAll(reader.iterator(startPosition = 25L)) === Seq.empty[String])
+    reader.close()
+  }
+
+  @Test def testExistingIndexIsReused(): Unit = {
+    val filePath = writeRecords("a", 0 until 3)
+    val indexPath = _tempPath.resolve("custom.index")
+    IndexedTFRecordReader.buildIndex(filePath, indexPath)
+    val reader = IndexedTFRecordReader(Seq(filePath), buildMissingIndex = false, indexPathFn = _ => indexPath)
+    assert(readAll(reader.iterator()) === (0 until 3).map(record))
+    assert(!Files.exists(IndexedTFRecordReader.indexPath(filePath)))
+    reader.close()
+  }
+}
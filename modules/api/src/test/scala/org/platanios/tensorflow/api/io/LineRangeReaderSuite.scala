@@ -0,0 +1,108 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.api.core.exception.{InvalidArgumentException, UnavailableException}
+
+import org.junit.{Before, Rule, Test}
+import org.junit.rules.TemporaryFolder
+import org.scalatest.junit.JUnitSuite
+
+import java.nio.charset.StandardCharsets
+import java.nio.file.{Files, Path}
+
+/**
+  * @author Emmanouil Antonios Platanios
+  */
+class LineRangeReaderSuite extends JUnitSuite {
+  private[this] var _tempPath  : Path            = _
+  private[this] val _tempFolder: TemporaryFolder = new TemporaryFolder
+
+  @Rule def tempFolder: TemporaryFolder = _tempFolder
+
+  @Before def setUp(): Unit = {
+    _tempPath = tempFolder.newFolder().toPath
+  }
+
+  // Lines of varying lengths, including empty ones and a last line without a trailing new-line character.
+  private[this] val lines: Seq[String] = (0 until 500).map(i => if (i % 7 == 0) "" else s"line-$i-" + "x" * (i % 50))
+
+  private[this] def writeLines(): Path = {
+    val filePath = _tempPath.resolve("lines.txt")
+    Files.write(filePath, lines.mkString("\n").getBytes(StandardCharsets.UTF_8))
+    filePath
+  }
+
+  private[this] def readLines(reader: LineRangeReader, maxLines: Int, maxBytes: Int): Seq[String] = {
+    reader.batchesIterator(maxLines, maxBytes).flatMap(_.linesAsStrings()).toSeq
+  }
+
+  @Test def testReadWholeFile(): Unit = {
+    val reader = LineRangeReader(writeLines(), bufferSize = 64)
+    assert(readLines(reader, maxLines = 16, maxBytes = 1024 * 1024) === lines)
+    // The reader keeps returning no batches once it reaches the end of its range.
+    assert(reader.next().isEmpty)
+    reader.close()
+  }
+
+  @Test def testBatchLimits(): Unit = {
+    val reader = LineRangeReader(writeLines())
+    val batches = reader.batchesIterator(maxLines = 16, maxBytes = 128).toSeq
+    assert(batches.forall(b => b.numLines >= 1 && b.numLines <= 16))
+    // Lines are only added to a batch while it holds less than the maximum number of bytes.
+    assert(batches.forall(b => b.offsets(b.numLines - 1) < 128))
+    assert(batches.flatMap(_.linesAsStrings()) === lines)
+    reader.close()
+  }
+
+  @Test def testRangesReadEveryLineOnce(): Unit = {
+    val filePath = writeLines()
+    Seq(1, 2, 3, 7, 64).foreach(numRanges => {
+      val ranges = LineRangeReader.ranges(filePath, numRanges)
+      assert(ranges.head._1 === 0L)
+      assert(ranges.last._2 === Files.size(filePath))
+      val rangeLines = ranges.flatMap {
+        case (start, end) =>
+          val reader = LineRangeReader(filePath, start, end, bufferSize = 64)
+          val result = readLines(reader, maxLines = 10, maxBytes = 256)
+          reader.close()
+          result
+      }
+      assert(rangeLines === lines)
+    })
+  }
+
+  @Test def testEmptyRange(): Unit = {
+    val reader = LineRangeReader(writeLines(), start = 10L, end = 10L)
+    assert(reader.next().isEmpty)
+    reader.close()
+  }
+
+  @Test def testNonPositiveBatchLimits(): Unit = {
+    val reader = LineRangeReader(writeLines())
+    intercept[InvalidArgumentException](reader.next(maxLines = 0))
+    intercept[InvalidArgumentException](reader.next(maxBytes = -1))
+    // Invalid arguments do not consume any lines.
+    assert(reader.next(maxLines = 1).map(_.linesAsStrings()) === Some(lines.take(1)))
+    reader.close()
+  }
+
+  @Test def testDisposedReader(): Unit = {
+    val reader = LineRangeReader(writeLines())
+    reader.close()
+    intercept[UnavailableException](reader.next())
+  }
+}
@@ -0,0 +1,164 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.api.core.exception.{DataLossException, UnavailableException}
+import org.platanios.tensorflow.jni.{RecordReader => NativeReader}
+
+import com.google.protobuf.ByteString
+import org.junit.{Before, Rule, Test}
+import org.junit.rules.TemporaryFolder
+import org.scalatest.junit.JUnitSuite
+import org.tensorflow.example.{BytesList, Example, Feature, Features, Int64List}
+
+import java.nio.file.{FileAlreadyExistsException, Files, Path, StandardOpenOption}
+
+import scala.util.Random
+
+/**
+  * @author Emmanouil Antonios Platanios
+  */
+class TFRecordWriterSuite extends JUnitSuite {
+  private[this] var _tempPath  : Path            = _
+  private[this] val _tempFolder: TemporaryFolder = new TemporaryFolder
+
+  @Rule def tempFolder: TemporaryFolder = _tempFolder
+
+  @Before def setUp(): Unit = {
+    _tempPath = tempFolder.newFolder().toPath
+  }
+
+  private[this] def example(index: Long, payload: Array[Byte]): Example = {
+    Example.newBuilder().setFeatures(Features.newBuilder()
+        .putFeature("index", Feature.newBuilder().setInt64List(Int64List.newBuilder().addValue(index)).build())
+        .putFeature("payload", Feature.newBuilder().setBytesList(
+          BytesList.newBuilder().addValue(ByteString.copyFrom(payload))).build())).build()
+  }
+
+  /** Returns examples with payloads of varying sizes, including one that spans multiple Snappy blocks. */
+  private[this] def examples(): Seq[Example] = {
+    val random = new Random(1234)
+    val sizes = Seq(0, 1, 100, 4096, 3 * 256 * 1024 + 17, 10)
+    sizes.zipWithIndex.map {
+      case (size, i) =>
+        // Half of every payload is repetitive, so that it is actually compressed.
+        val payload = Array.tabulate[Byte](size)(j => if (j % 2 == 0) (j % 7).toByte else random.nextInt().toByte)
+        example(i.toLong, payload)
+    }
+  }
+
+  private[this] def roundTrip(compressionType: CompressionType): Unit = {
+    val filePath = _tempPath.resolve(s"examples-${compressionType.name}")
+    val written = examples()
+    val writer = TFRecordWriter(filePath, compressionType)
+    written.foreach(e => writer.write(e))
+    writer.close()
+    val reader = TFRecordReader(filePath, compressionType)
+    assert(reader.load().toSeq === written)
+    reader.close()
+  }
+
+  @Test def testRoundTripWithoutCompression(): Unit = roundTrip(NoCompression)
+  @Test def testRoundTripWithZLIBCompression(): Unit = roundTrip(ZLIBCompression)
+  @Test def testRoundTripWithGZIPCompression(): Unit = roundTrip(GZIPCompression)
+  @Test def testRoundTripWithSnappyCompression(): Unit = roundTrip(SnappyCompression)
+
+  @Test def testSnappyCompressionReducesSize(): Unit = {
+    val uncompressedPath = _tempPath.resolve("uncompressed")
+    val compressedPath = _tempPath.resolve("compressed")
+    Seq(uncompressedPath -> NoCompression, compressedPath -> SnappyCompression).foreach {
+      case (filePath, compressionType) =>
+        val writer = TFRecordWriter(filePath, compressionType)
+        (0 until 100).foreach(i => writer.write(example(i.toLong, Array.fill[Byte](1000)(i.toByte))))
+        writer.close()
+    }
+    assert(Files.size(compressedPath) < Files.size(uncompressedPath))
+  }
+
+  @Test def testFlushedRecordsAreReadable(): Unit = {
+    val filePath = _tempPath.resolve("examples")
+    val written = examples()
+    val writer = TFRecordWriter(filePath, SnappyCompression)
+    written.take(3).foreach(e => writer.write(e))
+    writer.flush()
+    val reader = TFRecordReader(filePath, SnappyCompression)
+    assert(reader.load().toSeq === written.take(3))
+    reader.close()
+    writer.close()
+  }
+
+  @Test def testTruncatedSnappyRecordIsReadOnRetry(): Unit = {
+    val writtenPath = _tempPath.resolve("written")
+    val written = examples().take(3)
+    val writer = TFRecordWriter(writtenPath, SnappyCompression)
+    written.take(2).foreach(e => writer.write(e))
+    writer.flush()
+    val flushedSize = Files.size(writtenPath).toInt
+    writer.write(written(2))
+    writer.close()
+    // The file is truncated in the middle of the Snappy block that contains the last record.
+    val bytes = Files.readAllBytes(writtenPath)
+    val truncatedSize = flushedSize + (bytes.length - flushedSize) / 2
+    val filePath = _tempPath.resolve("examples")
+    Files.write(filePath, bytes.take(truncatedSize))
+    val reader = TFRecordReader(filePath, SnappyCompression)
+    val iterator = reader.load()
+    assert(iterator.next() === written(0))
+    assert(iterator.next() === written(1))
+    assert(!iterator.hasNext)
+    assert(!iterator.hasNext)
+    Files.write(filePath, bytes.drop(truncatedSize), StandardOpenOption.APPEND)
+    assert(iterator.hasNext)
+    assert(iterator.next() === written(2))
+    assert(!iterator.hasNext)
+    reader.close()
+  }
+
+  @Test def testCorruptedSnappyRecordIsNotReportedAsEndOfFile(): Unit = {
+    val filePath = _tempPath.resolve("examples")
+    val written = examples().take(2)
+    val writer = TFRecordWriter(filePath, SnappyCompression)
+    writer.write(written(0))
+    writer.flush()
+    writer.write(written(1))
+    writer.close()
+    // The last byte of the file belongs to the checksum of the last record.
+    val bytes = Files.readAllBytes(filePath)
+    bytes(bytes.length - 1) = (bytes(bytes.length - 1) ^ 0xff).toByte
+    Files.write(filePath, bytes)
+    val reader = TFRecordReader(filePath, SnappyCompression)
+    assert(Example.parseFrom(NativeReader.recordReaderWrapperReadNext(reader.nativeHandle)) === written(0))
+    // The corruption is reported again on every retry, even though the file does not change in between.
+    intercept[DataLossException](NativeReader.recordReaderWrapperReadNext(reader.nativeHandle))
+    intercept[DataLossException](NativeReader.recordReaderWrapperReadNext(reader.nativeHandle))
+    reader.close()
+  }
+
+  @Test def testClosedWriter(): Unit = {
+    val writer = TFRecordWriter(_tempPath.resolve("examples"), SnappyCompression)
+    writer.close()
+    intercept[UnavailableException](writer.write(examples().head))
+    intercept[UnavailableException](writer.flush())
+    // Closing a writer more than once has no effect.
+    writer.close()
+  }
+
+  @Test def testExistingFile(): Unit = {
+    val filePath = _tempPath.resolve("examples")
+    Files.createFile(filePath)
+    intercept[FileAlreadyExistsException](TFRecordWriter(filePath, SnappyCompression))
+  }
+}
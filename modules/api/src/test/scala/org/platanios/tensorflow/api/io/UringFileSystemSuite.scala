@@ -0,0 +1,113 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io
+
+import org.platanios.tensorflow.api.core.exception.{AlreadyExistsException, InvalidArgumentException, NotFoundException}
+import org.platanios.tensorflow.jni.{FileIO => NativeFileIO}
+
+import org.junit.{Assume, Before, Rule, Test}
+import org.junit.rules.TemporaryFolder
+import org.scalatest.junit.JUnitSuite
+
+import java.nio.file.{Files, Path}
+
+import scala.concurrent.{Await, Future}
+import scala.concurrent.ExecutionContext.Implicits.global
+import scala.concurrent.duration.Duration
+
+/** Tests the `io_uring` file system. The tests are skipped on platforms that do not support `io_uring`.
+  *
+  * Paths with a scheme cannot be represented using `java.nio.file.Path` (which collapses the slashes following the
+  * scheme), and so files are read through the native library directly, using string paths.
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class UringFileSystemSuite extends JUnitSuite {
+  private[this] var _tempPath  : Path            = _
+  private[this] val _tempFolder: TemporaryFolder = new TemporaryFolder
+
+  @Rule def tempFolder: TemporaryFolder = _tempFolder
+
+  @Before def setUp(): Unit = {
+    Assume.assumeTrue(UringFileSystem.isSupported)
+    _tempPath = tempFolder.newFolder().toPath
+    UringFileSystemSuite.register()
+  }
+
+  private[this] def uringPath(filePath: Path): String = s"${UringFileSystemSuite.scheme}://${filePath.toAbsolutePath}"
+
+  private[this] def writeFile(name: String, size: Int): (Path, Array[Byte]) = {
+    val filePath = _tempPath.resolve(name)
+    val contents = Array.tabulate[Byte](size)(i => (i * 131 + i / 256).toByte)
+    Files.write(filePath, contents)
+    (filePath, contents)
+  }
+
+  @Test def testReadFiles(): Unit = {
+    // The sizes cover reads that fit in one buffer and reads that are split into more requests than there are buffers.
+    Seq(1, 4095, 4096, 4097, 100000).foreach(size => {
+      val (filePath, contents) = writeFile(s"file-$size", size)
+      assert(NativeFileIO.readFileToBytes(uringPath(filePath)).toSeq === contents.toSeq)
+    })
+  }
+
+  @Test def testConcurrentReads(): Unit = {
+    val files = (0 until 8).map(i => writeFile(s"file-$i", 10000 + 1000 * i))
+    val reads = files.map {
+      case (filePath, contents) => Future(NativeFileIO.readFileToBytes(uringPath(filePath)).toSeq == contents.toSeq)
+    }
+    assert(Await.result(Future.sequence(reads), Duration.Inf).forall(identity))
+  }
+
+  @Test def testBenchmarkRandomReads(): Unit = {
+    val (filePath, _) = writeFile("file", 64 * 1024)
+    val result = UringFileSystem.benchmarkRandomReads(uringPath(filePath), blockSize = 4096, numReads = 1000L)
+    assert(result.numReads === 1000L)
+    assert(result.numBytes === 4096L * 1000L)
+  }
+
+  @Test def testMissingFile(): Unit = {
+    intercept[NotFoundException](NativeFileIO.readFileToBytes(uringPath(_tempPath.resolve("missing"))))
+  }
+
+  @Test def testInvalidArguments(): Unit = {
+    intercept[InvalidArgumentException](UringFileSystem.register("uringtestinvalid", queueDepth = 0))
+    intercept[InvalidArgumentException](UringFileSystem.register("uringtestinvalid", bufferSize = -1))
+    val (filePath, _) = writeFile("file", 1024)
+    intercept[InvalidArgumentException](UringFileSystem.benchmarkRandomReads(uringPath(filePath), blockSize = 0))
+    // The block size must not exceed the file size.
+    intercept[InvalidArgumentException](UringFileSystem.benchmarkRandomReads(uringPath(filePath), blockSize = 4096))
+  }
+
+  @Test def testRegisterTwice(): Unit = {
+    intercept[AlreadyExistsException](UringFileSystem.register(UringFileSystemSuite.scheme))
+  }
+}
+
+object UringFileSystemSuite {
+  val scheme: String = "uringtest"
+
+  private[this] var registered: Boolean = false
+
+  /** Registers the file system once for all tests, with small buffers, so that most reads are split into multiple
+    * requests that wait for buffers to become available. */
+  def register(): Unit = synchronized {
+    if (!registered) {
+      UringFileSystem.register(scheme, queueDepth = 4, numBuffers = 4, bufferSize = 4096)
+      registered = true
+    }
+  }
+}
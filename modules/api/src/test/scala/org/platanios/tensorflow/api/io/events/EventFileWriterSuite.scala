@@ -0,0 +1,102 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io.events
+
+import org.junit.{Before, Rule, Test}
+import org.junit.rules.TemporaryFolder
+import org.scalatest.junit.JUnitSuite
+import org.tensorflow.util.Event
+
+import java.nio.file.Path
+
+/**
+  * @author Emmanouil Antonios Platanios
+  */
+class EventFileWriterSuite extends JUnitSuite {
+  private[this] var _tempPath  : Path            = _
+  private[this] val _tempFolder: TemporaryFolder = new TemporaryFolder
+
+  @Rule def tempFolder: TemporaryFolder = _tempFolder
+
+  @Before def setUp(): Unit = {
+    _tempPath = tempFolder.newFolder().toPath
+  }
+
+  private[this] def event(step: Long): Event = {
+    Event.newBuilder().setWallTime(1440183447.0 + step).setStep(step).build()
+  }
+
+  /** Returns the steps of the events stored in `filePath`, excluding the file version event. */
+  private[this] def readSteps(filePath: Path): Seq[Long] = {
+    EventFileReader(filePath).load().filter(_.getFileVersion.isEmpty).map(_.getStep).toSeq
+  }
+
+  /** Waits for up to `timeoutMillis` milliseconds until the events stored in `filePath` have steps `steps`. */
+  private[this] def awaitSteps(filePath: Path, steps: Seq[Long], timeoutMillis: Long = 10000L): Seq[Long] = {
+    val deadline = System.currentTimeMillis() + timeoutMillis
+    var readStepsValue = readSteps(filePath)
+    while (readStepsValue != steps && System.currentTimeMillis() < deadline) {
+      Thread.sleep(100)
+      readStepsValue = readSteps(filePath)
+    }
+    readStepsValue
+  }
+
+  @Test def testFileVersionEvent(): Unit = {
+    val writer = EventFileWriter(_tempPath)
+    writer.flush()
+    val events = EventFileReader(writer.filePath).load().toSeq
+    assert(events.size === 1)
+    assert(events.head.getFileVersion.startsWith("brain.Event:"))
+    writer.close()
+  }
+
+  @Test def testEventsAreVisibleAfterPeriodicFlush(): Unit = {
+    val writer = EventFileWriter(_tempPath, flushFrequency = 1)
+    writer.write(event(1L))
+    writer.write(Seq(event(2L), event(3L)))
+    // No explicit flush happens here and so the events can only become visible through the periodic flush.
+    assert(awaitSteps(writer.filePath, Seq(1L, 2L, 3L)) === Seq(1L, 2L, 3L))
+    writer.write(event(4L))
+    assert(awaitSteps(writer.filePath, Seq(1L, 2L, 3L, 4L)) === Seq(1L, 2L, 3L, 4L))
+    writer.close()
+  }
+
+  @Test def testEventsAreVisibleAfterExplicitFlush(): Unit = {
+    val writer = EventFileWriter(_tempPath, flushFrequency = 3600)
+    (0L until 25L).foreach(step => writer.write(event(step)))
+    writer.flush()
+    assert(readSteps(writer.filePath) === (0L until 25L))
+    writer.close()
+  }
+
+  @Test def testCloseAndReopen(): Unit = {
+    val writer = EventFileWriter(_tempPath, flushFrequency = 3600)
+    writer.write(event(1L))
+    val firstFilePath = writer.filePath
+    writer.close()
+    assert(writer.closed)
+    assert(readSteps(firstFilePath) === Seq(1L))
+    // Writes to a closed writer are ignored.
+    writer.write(event(2L))
+    writer.reopen()
+    assert(!writer.closed)
+    writer.write(event(3L))
+    writer.flush()
+    assert(readSteps(writer.filePath) === Seq(3L))
+    writer.close()
+  }
+}
@@ -0,0 +1,150 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.api.io.events
+
+import org.platanios.tensorflow.api.core.exception.NotFoundException
+
+import org.junit.{Before, Rule, Test}
+import org.junit.rules.TemporaryFolder
+import org.scalatest.junit.JUnitSuite
+import org.tensorflow.framework.{HistogramProto, Summary}
+import org.tensorflow.util.{Event, SessionLog}
+
+import java.nio.file.Path
+
+/**
+  * @author Emmanouil Antonios Platanios
+  */
+class EventScannerSuite extends JUnitSuite {
+  private[this] var _tempPath  : Path            = _
+  private[this] val _tempFolder: TemporaryFolder = new TemporaryFolder
+
+  @Rule def tempFolder: TemporaryFolder = _tempFolder
+
+  @Before def setUp(): Unit = {
+    _tempPath = tempFolder.newFolder().toPath
+  }
+
+  private[this] def loss(step: Long): Float = 1.0f / (step + 1)
+
+  private[this] def summaryEvent(step: Long): Event = {
+    val histogram = HistogramProto.newBuilder().setMin(0.0).setMax(step.toDouble).setNum(2.0).setSum(step.toDouble)
+    Event.newBuilder().setWallTime(1440183447.0 + step).setStep(step).setSummary(Summary.newBuilder()
+        .addValue(Summary.Value.newBuilder().setTag("loss").setSimpleValue(loss(step)))
+        .addValue(Summary.Value.newBuilder().setTag("accuracy").setSimpleValue(step / 100.0f))
+        .addValue(Summary.Value.newBuilder().setTag("weights").setHisto(histogram))).build()
+  }
+
+  private[this] def restartEvent(step: Long): Event = {
+    Event.newBuilder().setWallTime(1440183447.0 + step).setStep(step)
+        .setSessionLog(SessionLog.newBuilder().setStatus(SessionLog.SessionStatus.START)).build()
+  }
+
+  /** Writes `events` to a new events file in the directory `runName` and returns the path of that directory. */
+  private[this] def writeRun(runName: String, events: Seq[Event]): Path = {
+    val runPath = _tempPath.resolve(runName)
+    val writer = EventFileWriter(runPath)
+    writer.write(events)
+    writer.close()
+    runPath
+  }
+
+  @Test def testScanAllRecords(): Unit = {
+    val runPath = writeRun("run", (0L until 100L).map(summaryEvent))
+    val Seq(run) = EventScanner.scan(Seq(runPath), reservoirSize = 0)
+    assert(run.path === runPath)
+    assert(run.plugins === Map("loss" -> "scalars", "accuracy" -> "scalars", "weights" -> "histograms"))
+    assert(run.scalars.keySet === Set("loss", "accuracy"))
+    assert(run.scalars("loss").map(_.step) === (0L until 100L))
+    assert(run.scalars("loss").map(_.value) === (0L until 100L).map(loss))
+    assert(run.scalars("loss").map(_.wallTime) === (0L until 100L).map(1440183447.0 + _))
+    assert(run.values.keySet === Set("weights"))
+    assert(run.values("weights").map(_.value.getHisto.getMax) === (0L until 100L).map(_.toDouble))
+  }
+
+  @Test def testTagAndPluginFilters(): Unit = {
+    val runPath = writeRun("run", (0L until 10L).map(summaryEvent))
+    val Seq(tagRun) = EventScanner.scan(Seq(runPath), tags = Set("loss"))
+    assert(tagRun.plugins === Map("loss" -> "scalars"))
+    assert(tagRun.scalars.keySet === Set("loss"))
+    assert(tagRun.values.isEmpty)
+    val Seq(pluginRun) = EventScanner.scan(Seq(runPath), plugins = Set("histograms"))
+    assert(pluginRun.plugins === Map("weights" -> "histograms"))
+    assert(pluginRun.scalars.isEmpty)
+    assert(pluginRun.values("weights").size === 10)
+  }
+
+  @Test def testReservoirSampling(): Unit = {
+    val runPath = writeRun("run", (0L until 1000L).map(summaryEvent))
+    val Seq(run) = EventScanner.scan(Seq(runPath), reservoirSize = 10)
+    (run.scalars.values ++ run.values.values).foreach(records => {
+      val steps = records.map(_.step)
+      assert(steps.size === 10)
+      // The most recent record is always kept and the sampled records stay in the order in which they were written.
+      assert(steps.last === 999L)
+      assert(steps === steps.sorted)
+    })
+  }
+
+  @Test def testPurgeOrphanedData(): Unit = {
+    val events = (0L until 50L).map(summaryEvent) ++ Seq(restartEvent(30L)) ++ (30L until 40L).map(summaryEvent)
+    val runPath = writeRun("run", events)
+    val Seq(purgedRun) = EventScanner.scan(Seq(runPath), reservoirSize = 0)
+    assert(purgedRun.scalars("loss").map(_.step) === (0L until 40L))
+    val Seq(run) = EventScanner.scan(Seq(runPath), reservoirSize = 0, purgeOrphanedData = false)
+    assert(run.scalars("loss").map(_.step) === (0L until 50L) ++ (30L until 40L))
+  }
+
+  private[this] def fileVersionEvent(version: String): Event = {
+    Event.newBuilder().setWallTime(1440183447.0).setFileVersion(version).build()
+  }
+
+  /** Checks that the scanner keeps the same loss steps for the run in `runPath` as `EventAccumulator` does. */
+  private[this] def assertSameStepsAsEventAccumulator(runPath: Path): Seq[Long] = {
+    val Seq(run) = EventScanner.scan(Seq(runPath), reservoirSize = 0)
+    val accumulator = EventAccumulator(runPath, sizeGuidance = Map(ScalarEventType -> 0)).reload()
+    val steps = run.scalars("loss").map(_.step)
+    assert(steps === accumulator.scalars("loss").map(_.step))
+    steps
+  }
+
+  @Test def testPurgeOrphanedDataMatchesEventAccumulator(): Unit = {
+    val outOfOrder = (0L until 50L).map(summaryEvent) ++ (30L until 40L).map(summaryEvent)
+    val restarted = (0L until 50L).map(summaryEvent) ++ Seq(restartEvent(30L)) ++ (30L until 40L).map(summaryEvent)
+    // Files with version 2 or later (which the events file writer produces) only purge data after restart events.
+    val outOfOrderRun = writeRun("out-of-order", outOfOrder)
+    assert(assertSameStepsAsEventAccumulator(outOfOrderRun) === (0L until 50L) ++ (30L until 40L))
+    val restartedRun = writeRun("restarted", restarted)
+    assert(assertSameStepsAsEventAccumulator(restartedRun) === (0L until 40L))
+    // Older files purge data when they encounter out-of-order steps instead.
+    val oldOutOfOrderRun = writeRun("old-out-of-order", fileVersionEvent("brain.Event:1") +: outOfOrder)
+    assert(assertSameStepsAsEventAccumulator(oldOutOfOrderRun) === (0L until 40L))
+    val oldRestartedRun = writeRun("old-restarted", fileVersionEvent("brain.Event:1") +: restarted)
+    assertSameStepsAsEventAccumulator(oldRestartedRun)
+  }
+
+  @Test def testMultipleRunsInParallel(): Unit = {
+    val runPaths = (0 until 4).map(i => writeRun(s"run$i", (0L until 10L * (i + 1)).map(summaryEvent)))
+    val runs = EventScanner.scan(runPaths, reservoirSize = 0, numThreads = 3)
+    assert(runs.map(_.path) === runPaths)
+    assert(runs.map(_.scalars("loss").size) === Seq(10, 20, 30, 40))
+  }
+
+  @Test def testMissingRun(): Unit = {
+    val runPath = writeRun("run", (0L until 10L).map(summaryEvent))
+    intercept[NotFoundException](EventScanner.scan(Seq(runPath, _tempPath.resolve("missing"))))
+  }
+}
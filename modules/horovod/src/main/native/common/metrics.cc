@@ -0,0 +1,99 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "metrics.h"
+
+namespace horovod {
+namespace common {
+
+double AggregateMetrics::bandwidth() const {
+  return execution_time > 0 ? bytes / execution_time : 0.0;
+}
+
+double AggregateMetrics::fusion_buffer_utilization() const {
+  return fusion_capacity > 0 ? (double)fused_bytes / fusion_capacity : 0.0;
+}
+
+void Metrics::RecordTensor(const std::string& tensor_name, int64_t num_bytes,
+                           bool reduced, double queueing_time,
+                           double negotiation_time, double execution_time) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto& tensor = tensors_[tensor_name];
+  tensor.operations++;
+  tensor.bytes += num_bytes;
+  tensor.queueing_time += queueing_time;
+  tensor.negotiation_time += negotiation_time;
+  tensor.execution_time += execution_time;
+
+  aggregate_.tensor_operations++;
+  aggregate_.bytes += num_bytes;
+  if (reduced) {
+    aggregate_.bytes_reduced += num_bytes;
+  }
+  aggregate_.queueing_time += queueing_time;
+  aggregate_.negotiation_time += negotiation_time;
+}
+
+void Metrics::RecordOperation(int64_t num_bytes, double execution_time,
+                              int64_t fusion_threshold) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  aggregate_.operations++;
+  aggregate_.execution_time += execution_time;
+  if (fusion_threshold > 0) {
+    aggregate_.fused_operations++;
+    aggregate_.fused_bytes += num_bytes;
+    aggregate_.fusion_capacity += fusion_threshold;
+  }
+}
+
+void Metrics::RecordStall(const std::string& tensor_name) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  tensors_[tensor_name].stall_events++;
+  aggregate_.stall_events++;
+}
+
+void Metrics::RecordCacheHits(int64_t num_tensors) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  aggregate_.cached_tensor_operations += num_tensors;
+}
+
+AggregateMetrics Metrics::aggregate() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return aggregate_;
+}
+
+bool Metrics::tensor(const std::string& tensor_name,
+                     TensorMetrics& metrics) const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = tensors_.find(tensor_name);
+  if (it == tensors_.end()) {
+    return false;
+  }
+  metrics = it->second;
+  return true;
+}
+
+std::vector<std::string> Metrics::tensor_names() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  std::vector<std::string> names;
+  names.reserve(tensors_.size());
+  for (auto& tensor : tensors_) {
+    names.push_back(tensor.first);
+  }
+  return names;
+}
+
+} // namespace common
+} // namespace horovod
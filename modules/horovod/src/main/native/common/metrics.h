@@ -0,0 +1,124 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_METRICS_H
+#define HOROVOD_METRICS_H
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace horovod {
+namespace common {
+
+// Metrics of the collective operations performed on one tensor. Times are in
+// seconds, and they are summed over all operations.
+struct TensorMetrics {
+  // Number of operations performed on the tensor.
+  int64_t operations = 0;
+
+  // Size of the tensor, summed over all operations.
+  int64_t bytes = 0;
+
+  // Time between enqueueing the tensor and the background thread picking up
+  // its request.
+  double queueing_time = 0.0;
+
+  // Time between the background thread picking up the request and the start
+  // of the operation, i.e., the time until all ranks were ready.
+  double negotiation_time = 0.0;
+
+  // Time spent performing the operations. Tensors that are fused are assigned
+  // the time of the whole fused operation.
+  double execution_time = 0.0;
+
+  // Number of times the coordinator reported the tensor as stalled.
+  int64_t stall_events = 0;
+};
+
+// Metrics of all collective operations performed by this rank.
+struct AggregateMetrics {
+  // Totals over all tensors (see TensorMetrics). `bytes_reduced` only
+  // includes allreduced tensors.
+  int64_t tensor_operations = 0;
+  int64_t bytes = 0;
+  int64_t bytes_reduced = 0;
+  double queueing_time = 0.0;
+  double negotiation_time = 0.0;
+  int64_t stall_events = 0;
+
+  // Number of tensor operations whose responses were taken from the response
+  // cache, without negotiating them through the coordinator.
+  int64_t cached_tensor_operations = 0;
+
+  // Number of operations performed, including fused operations, which cover
+  // multiple tensors, and time spent performing them.
+  int64_t operations = 0;
+  double execution_time = 0.0;
+
+  // Number of operations performed through the fusion buffer, bytes that
+  // they fused, and fusion thresholds in effect when they were performed.
+  int64_t fused_operations = 0;
+  int64_t fused_bytes = 0;
+  int64_t fusion_capacity = 0;
+
+  // Bytes of tensors processed per second of execution time.
+  double bandwidth() const;
+
+  // Average fraction of the fusion threshold used by fused operations.
+  double fusion_buffer_utilization() const;
+};
+
+// Accumulates the metrics of the collective operations performed by this
+// rank. Metrics are recorded by the background thread and can be read by any
+// thread.
+class Metrics {
+public:
+  // Records an operation on one tensor of `num_bytes` bytes. Operations that
+  // cover multiple tensors record every tensor, followed by the operation.
+  void RecordTensor(const std::string& tensor_name, int64_t num_bytes,
+                    bool reduced, double queueing_time,
+                    double negotiation_time, double execution_time);
+
+  // Records an operation on `num_bytes` bytes. If it was performed through
+  // the fusion buffer, `fusion_threshold` is the fusion threshold in effect,
+  // and otherwise it is zero.
+  void RecordOperation(int64_t num_bytes, double execution_time,
+                       int64_t fusion_threshold);
+
+  void RecordStall(const std::string& tensor_name);
+
+  // Records that the responses of `num_tensors` tensors were taken from the
+  // response cache.
+  void RecordCacheHits(int64_t num_tensors);
+
+  AggregateMetrics aggregate() const;
+
+  // Returns false if no operations or stalls were recorded for the tensor.
+  bool tensor(const std::string& tensor_name, TensorMetrics& metrics) const;
+
+  std::vector<std::string> tensor_names() const;
+
+private:
+  mutable std::mutex mutex_;
+  AggregateMetrics aggregate_;
+  std::unordered_map<std::string, TensorMetrics> tensors_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_METRICS_H
@@ -50,6 +50,12 @@ const std::string& MPIDataType_Name(MPIDataType value) {
   case HOROVOD_BOOL:
     static const std::string bool_("bool");
     return bool_;
+  case HOROVOD_FLOAT16:
+    static const std::string float16("float16");
+    return float16;
+  case HOROVOD_BFLOAT16:
+    static const std::string bfloat16("bfloat16");
+    return bfloat16;
   default:
     static const std::string unknown("<unknown>");
     return unknown;
@@ -67,6 +73,9 @@ const std::string& MPIRequest::RequestType_Name(RequestType value) {
   case RequestType::BROADCAST:
     static const std::string broadcast("BROADCAST");
     return broadcast;
+  case RequestType::ALLTOALL:
+    static const std::string alltoall("ALLTOALL");
+    return alltoall;
   default:
     static const std::string unknown("<unknown>");
     return unknown;
@@ -113,6 +122,18 @@ void MPIRequest::add_tensor_shape(int64_t value) {
   tensor_shape_.push_back(value);
 }
 
+const std::vector<int64_t>& MPIRequest::splits() const { return splits_; }
+
+void MPIRequest::set_splits(const std::vector<int64_t>& value) {
+  splits_ = value;
+}
+
+void MPIRequest::add_splits(int64_t value) { splits_.push_back(value); }
+
+float MPIRequest::top_k_ratio() const { return top_k_ratio_; }
+
+void MPIRequest::set_top_k_ratio(float value) { top_k_ratio_ = value; }
+
 namespace {
 
 void MPIRequest_ParseFromWire(MPIRequest& request,
@@ -125,21 +146,31 @@ void MPIRequest_ParseFromWire(MPIRequest& request,
   request.set_device(obj->device());
   request.set_tensor_shape(std::vector<int64_t>(obj->tensor_shape()->begin(),
                                                 obj->tensor_shape()->end()));
+  if (obj->splits() != nullptr) {
+    request.set_splits(std::vector<int64_t>(obj->splits()->begin(),
+                                            obj->splits()->end()));
+  }
+  request.set_top_k_ratio(obj->top_k_ratio());
 }
 
 void MPIRequest_SerializeToWire(const MPIRequest& request,
                                 flatbuffers::FlatBufferBuilder& builder,
                                 flatbuffers::Offset<wire::MPIRequest>& obj) {
+  // Strings and vectors must be created before the table that refers to them.
+  auto tensor_name = builder.CreateString(request.tensor_name());
+  auto tensor_shape = builder.CreateVector(request.tensor_shape());
+  auto splits = builder.CreateVector(request.splits());
   wire::MPIRequestBuilder request_builder(builder);
   request_builder.add_request_rank(request.request_rank());
   request_builder.add_request_type(
       (wire::MPIRequestType)request.request_type());
   request_builder.add_tensor_type((wire::MPIDataType)request.tensor_type());
-  request_builder.add_tensor_name(builder.CreateString(request.tensor_name()));
+  request_builder.add_tensor_name(tensor_name);
   request_builder.add_root_rank(request.root_rank());
   request_builder.add_device(request.device());
-  request_builder.add_tensor_shape(
-      builder.CreateVector(request.tensor_shape()));
+  request_builder.add_tensor_shape(tensor_shape);
+  request_builder.add_splits(splits);
+  request_builder.add_top_k_ratio(request.top_k_ratio());
   obj = request_builder.Finish();
 }
 
@@ -235,6 +266,9 @@ const std::string& MPIResponse::ResponseType_Name(ResponseType value) {
   case ResponseType::SHUTDOWN:
     static const std::string shutdown("SHUTDOWN");
     return shutdown;
+  case ResponseType::ALLTOALL:
+    static const std::string alltoall("ALLTOALL");
+    return alltoall;
   default:
     static const std::string unknown("<unknown>");
     return unknown;
@@ -32,7 +32,9 @@ enum MPIDataType {
   HOROVOD_INT64 = 5,
   HOROVOD_FLOAT32 = 6,
   HOROVOD_FLOAT64 = 7,
-  HOROVOD_BOOL = 8
+  HOROVOD_BOOL = 8,
+  HOROVOD_FLOAT16 = 9,
+  HOROVOD_BFLOAT16 = 10
 };
 
 const std::string& MPIDataType_Name(MPIDataType value);
@@ -42,7 +44,12 @@ const std::string& MPIDataType_Name(MPIDataType value);
 // the rank wants to do and the tensor that it wants to apply the operation to.
 class MPIRequest {
 public:
-  enum RequestType { ALLREDUCE = 0, ALLGATHER = 1, BROADCAST = 2 };
+  enum RequestType {
+    ALLREDUCE = 0,
+    ALLGATHER = 1,
+    BROADCAST = 2,
+    ALLTOALL = 3
+  };
 
   static const std::string& RequestType_Name(RequestType value);
 
@@ -71,6 +78,18 @@ public:
   void set_tensor_shape(const std::vector<int64_t>& value);
   void add_tensor_shape(int64_t value);
 
+  // Empty unless request_type is ALLTOALL.
+  // The number of rows of the tensor sent to each rank, indexed by the rank.
+  const std::vector<int64_t>& splits() const;
+  void set_splits(const std::vector<int64_t>& value);
+  void add_splits(int64_t value);
+
+  // Zero unless request_type is ALLREDUCE.
+  // The fraction of the elements of the tensor with the largest magnitudes
+  // that are sent, or zero if the allreduce is dense.
+  float top_k_ratio() const;
+  void set_top_k_ratio(float value);
+
   static void ParseFromString(MPIRequest& request, const std::string& input);
   static void SerializeToString(MPIRequest& request, std::string& output);
 
@@ -82,6 +101,8 @@ private:
   int32_t device_;
   std::string tensor_name_;
   std::vector<int64_t> tensor_shape_;
+  std::vector<int64_t> splits_;
+  float top_k_ratio_ = 0.0f;
 };
 
 class MPIRequestList {
@@ -117,7 +138,8 @@ public:
     BROADCAST = 2,
     ERROR = 3,
     DONE = 4,
-    SHUTDOWN = 5
+    SHUTDOWN = 5,
+    ALLTOALL = 6
   };
 
   static const std::string& ResponseType_Name(ResponseType value);
@@ -138,9 +160,12 @@ public:
   void set_devices(const std::vector<int32_t>& value);
   void add_devices(int32_t value);
 
-  // Empty unless response_type is ALLGATHER.
-  // These tensor sizes are the dimension zero sizes of all the input matrices,
-  // indexed by the rank.
+  // Empty unless response_type is ALLGATHER or ALLTOALL.
+  // For allgather, these tensor sizes are the dimension zero sizes of all the
+  // input matrices, indexed by the rank. For alltoall, they are the number of
+  // rows sent by each rank to each rank, indexed by the sending rank and then
+  // by the receiving rank. If the response covers multiple tensors, the sizes
+  // of each tensor follow the sizes of the previous one.
   const std::vector<int64_t>& tensor_sizes() const;
   void set_tensor_sizes(const std::vector<int64_t>& value);
   void add_tensor_sizes(int64_t value);
@@ -14,9 +14,14 @@
 // limitations under the License.
 // =============================================================================
 
+#include <algorithm>
 #include <assert.h>
 #include <atomic>
+#include <cmath>
+#include <condition_variable>
 #include <cstring>
+#include <functional>
+#include <limits>
 #include <queue>
 #include <sstream>
 #include <thread>
@@ -32,10 +37,16 @@
 
 #define OMPI_SKIP_MPICXX
 #include "hashes.h"
+#include "metrics.h"
 #include "mpi.h"
 #include "mpi_message.h"
 #include "operations.h"
+#include "parameter_manager.h"
+#include "reduction.h"
+#include "response_cache.h"
+#include "thread_pool.h"
 #include "timeline.h"
+#include "transport.h"
 
 /*
  * Allreduce, Allgather and Broadcast Ops.
@@ -57,10 +68,29 @@
  *      - HorovodBroadcast:
  *          Perform a broadcast on a Tensor, broadcasting Tensor
  *          value from root rank to all other ranks.
+ *      - HorovodAlltoall:
+ *          Perform an alltoall on a Tensor, sending splits of the tensor along
+ *          the first dimension to every rank and returning the concatenation
+ *          of the splits received from all ranks.
+ *
+ * Allreduce can optionally sparsify float tensors that reside in host memory,
+ * in which case every rank only sends a fraction of the elements of its tensor
+ * with the largest magnitudes and keeps the rest as a residual that is added
+ * to the tensor the next time it is reduced (see TopKAllreduce).
+ *
+ * Collective operations can also be performed among a subset of the ranks,
+ * called a process set, which negotiates them independently of the ranks that
+ * do not belong to it (see ProcessSet).
+ *
+ * If HOROVOD_TRANSPORT is set to "shm" or "tcp", the collective operations and
+ * the negotiation between ranks go through a Transport instead of MPI, for
+ * jobs that run without an MPI launcher. Operations are then limited to
+ * tensors that reside in host memory.
  *
  * Additionally, this library provides C APIs to initialize Horovod and query
- * rank, local rank and world size.  These are used in Python directly through
- * ctypes.
+ * rank, local rank and world size, as well as the metrics of the operations
+ * performed by this rank (see Metrics).  These are used in Python directly
+ * through ctypes.
  */
 
 namespace horovod {
@@ -85,6 +115,11 @@ typedef struct {
   std::shared_ptr<ReadyEvent> ready_event;
   // GPU to do reduction on, or CPU_DEVICE_ID in case of CPU.
   int device;
+  // Fraction of the elements that are sent for sparsified allreduce
+  // operations, or zero.
+  float top_k_ratio = 0.0f;
+  // Time point when the tensor was enqueued.
+  std::chrono::steady_clock::time_point enqueue_time;
   // A callback to call with the status.
   StatusCallback callback;
 } TensorTableEntry;
@@ -98,6 +133,64 @@ typedef std::unordered_map<
     std::tuple<std::vector<MPIRequest>, std::chrono::steady_clock::time_point>>
     MessageTable;
 
+// A subset of the ranks, which negotiates and performs collective operations
+// among its own ranks only (see BackgroundThreadLoop). Process set zero
+// contains all ranks, and the rest are created when Horovod is initialized.
+// The ranks of the process set are numbered from zero, in the order of their
+// global ranks, and the request ranks and root ranks of the MPI messages of a
+// process set refer to these numbers. Rank zero of the process set is its
+// coordinator.
+struct ProcessSet {
+  int32_t id = 0;
+
+  // Global ranks of the process set, in increasing order.
+  std::vector<int> ranks;
+
+  // Communicator containing the ranks of the process set, and rank of this
+  // rank within it. The communicator is MPI_COMM_NULL and the rank is -1 if
+  // this rank does not belong to the process set.
+  MPI_Comm comm = MPI_COMM_NULL;
+  int rank = -1;
+  int size = 0;
+
+  // Tensors waiting to be allreduced or allgathered, and queue of MPI requests
+  // waiting to be sent to the coordinator. Both must be accessed under the
+  // global mutex.
+  TensorTable tensor_table;
+  std::queue<MPIRequest> message_queue;
+
+  // Only exists on the coordinator. Maintains a count of how many ranks are
+  // ready to allreduce every tensor (keyed by tensor name) and time point when
+  // tensor started allreduce op.
+  std::unique_ptr<MessageTable> message_table;
+
+  // Time point when coordinator last checked for stalled tensors.
+  std::chrono::steady_clock::time_point last_stall_check;
+
+  // Cache of the responses constructed by the coordinator for previously
+  // negotiated tensors. Identical on all ranks of the process set.
+  ResponseCache response_cache;
+
+  // Requests for cached tensors that are waiting for the remaining ranks to
+  // also request them, keyed by tensor name.
+  std::unordered_map<std::string, MPIRequest> cached_requests;
+
+  // Requests that are being negotiated through the coordinator, keyed by
+  // tensor name. They are used to populate the response cache once their
+  // responses are received.
+  std::unordered_map<std::string, MPIRequest> negotiated_requests;
+
+  // Values of the sparsified tensors that have not been sent yet, keyed by
+  // tensor name (see TopKAllreduce). Only used by the background thread.
+  std::unordered_map<std::string, std::vector<uint8_t>> top_k_residuals;
+
+  // Time points when the background thread picked up the requests of the
+  // tensors that are being negotiated, keyed by tensor name. Only used by the
+  // background thread.
+  std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+      negotiation_starts;
+};
+
 // The global state required for the MPI ops.
 //
 // MPI is a library that stores a lot of global per-program state and often
@@ -112,11 +205,18 @@ struct HorovodGlobalState {
   // A mutex that needs to be used whenever MPI operations are done.
   std::mutex mutex;
 
-  // Tensors waiting to be allreduced or allgathered.
-  TensorTable tensor_table;
+  // Process sets, indexed by ID. They are created by the background thread
+  // before initialization_done is set, and never change afterwards.
+  std::vector<std::unique_ptr<ProcessSet>> process_sets;
 
-  // Queue of MPI requests waiting to be sent to the coordinator node.
-  std::queue<MPIRequest> message_queue;
+  // Global ranks of the process sets that were requested when Horovod was
+  // initialized, in addition to process set zero.
+  std::vector<std::vector<int>> requested_process_sets;
+
+  // Condition variable used to wake up the background thread as soon as new
+  // requests are added to the message queue of any process set, or when
+  // shutting down. It must be used together with the mutex above.
+  std::condition_variable message_queue_cv;
 
   // Background thread running MPI communication.
   std::thread background_thread;
@@ -124,24 +224,32 @@ struct HorovodGlobalState {
   // Whether the background thread should shutdown.
   bool shut_down = false;
 
-  // Only exists on the coordinator node (rank zero). Maintains a count of
-  // how many nodes are ready to allreduce every tensor (keyed by tensor
-  // name) and time point when tensor started allreduce op.
-  std::unique_ptr<MessageTable> message_table;
+  // Maximum time between the starts of two consecutive ticks of the
+  // background loop. Ticks start earlier than that if new requests are
+  // enqueued while the loop is idle (see BackgroundThreadLoop).
+  std::chrono::microseconds cycle_time = std::chrono::milliseconds(5);
 
-  // Time point when coordinator last checked for stalled tensors.
-  std::chrono::steady_clock::time_point last_stall_check;
+  // Time point when the current tick of the background loop started.
+  std::chrono::steady_clock::time_point last_cycle_start;
 
   // Timeline writer.
   Timeline timeline;
 
+  // Performance metrics of the operations performed by this rank.
+  Metrics metrics;
+
   // Threshold for Tensor Fusion.  All tensors that occupy memory beyond this
   // threshold will be fused.
   int64_t tensor_fusion_threshold = 64 * 1024 * 1024;
 
+  // Size of the Tensor Fusion buffers, which is the initial fusion threshold.
+  // The threshold may be lowered afterwards by the parameter manager.
+  int64_t fusion_buffer_size = 64 * 1024 * 1024;
+
   // Memory buffers for Tensor Fusion.  They are keyed off device ID and
-  // framework, and all are allocated tensor_fusion_threshold bytes if
-  // initialized.
+  // framework, and all are allocated fusion_buffer_size bytes if
+  // initialized. They are shared by all process sets, since the background
+  // thread performs one operation at a time.
   std::unordered_map<std::tuple<int, Framework>,
                      std::shared_ptr<PersistentBuffer>>
       tensor_fusion_buffers;
@@ -157,6 +265,55 @@ struct HorovodGlobalState {
   int local_size = 1;
   bool mpi_threads_supported = false;
 
+  // Transport through which the ranks communicate when Horovod runs without
+  // MPI, or null when using MPI.
+  std::unique_ptr<Transport> transport;
+
+  // Communicator containing the ranks that run on the same node as this rank,
+  // and communicator containing the ranks that have the same local rank as
+  // this rank (i.e., one rank per node).
+  MPI_Comm local_comm = MPI_COMM_NULL;
+  MPI_Comm cross_comm = MPI_COMM_NULL;
+
+  // Whether allreduce operations on CPU tensors should be performed
+  // hierarchically (see HierarchicalAllreduce). This is only possible if all
+  // nodes run the same number of ranks.
+  bool hierarchical_allreduce = false;
+
+  // Thread pool used to parallelize memory copies and local reductions of
+  // tensors that reside in host memory.
+  std::unique_ptr<ThreadPool> thread_pool;
+
+  // Size of the chunks in which CPU fusion buffers are allreduced, so that
+  // copying tensors in and out of the fusion buffer overlaps with the
+  // communication (see PipelinedFusedAllreduce).
+  int64_t fusion_chunk_size = 16 * 1024 * 1024;
+
+  // Memory window shared by all ranks of this node, and pointers to the part
+  // of it that belongs to each local rank, which are used to allreduce CPU
+  // tensors through shared memory (see SharedMemoryAllreduce). The window is
+  // null if shared memory allreduce is disabled.
+  MPI_Win shared_window = MPI_WIN_NULL;
+  std::vector<uint8_t*> shared_buffers;
+  int64_t shared_buffer_size = 0;
+
+  // MPI datatypes and sum operations for the 16-bit floating-point types,
+  // which MPI does not support natively. The operations are implemented using
+  // SumInto, and so they can only be applied to buffers in host memory.
+  MPI_Datatype mpi_float16_t = MPI_DATATYPE_NULL;
+  MPI_Datatype mpi_bfloat16_t = MPI_DATATYPE_NULL;
+  MPI_Op mpi_float16_sum = MPI_OP_NULL;
+  MPI_Op mpi_bfloat16_sum = MPI_OP_NULL;
+
+  // Type to which float32 tensors that reside in host memory are compressed
+  // while being allreduced, or HOROVOD_FLOAT32 if compression is disabled
+  // (see CompressAllreduce).
+  MPIDataType compression_type = HOROVOD_FLOAT32;
+
+  // Autotuning of the fusion threshold, cycle time and hierarchical allreduce
+  // (see SynchronizeParameters).
+  ParameterManager parameter_manager;
+
 // The CUDA stream used for data transfers and within-allreduce operations.
 // A naive implementation would use the TensorFlow StreamExecutor CUDA
 // stream. However, the allreduce and allgather require doing memory copies
@@ -190,7 +347,11 @@ struct HorovodGlobalState {
     // call. If a thread is still joinable (not detached or complete) its
     // destructor cannot be called.
     if (background_thread.joinable()) {
-      shut_down = true;
+      {
+        std::lock_guard<std::mutex> guard(mutex);
+        shut_down = true;
+      }
+      message_queue_cv.notify_all();
       background_thread.join();
     }
   }
@@ -204,10 +365,14 @@ static HorovodGlobalState horovod_global;
 
 // A tag used for all coordinator messaging.
 #define TAG_NOTIFY 1
+#define TAG_CLOCK 2
 
 // Stall-check warning time
 #define STALL_WARNING_TIME std::chrono::seconds(60)
 
+// Time after which transport operations fail if other ranks make no progress.
+#define DEFAULT_TRANSPORT_TIMEOUT_SECONDS 300
+
 static const Status NOT_INITIALIZED_ERROR = Status::PreconditionError(
     "Horovod has not been initialized; use hvd.init().");
 
@@ -328,11 +493,13 @@ MPIResponse ConstructMPIResponse(std::unique_ptr<MessageTable>& message_table,
     }
   }
 
-  // If we are doing an allgather, make sure all but the first dimension are
-  // the same. The first dimension may be different and the output tensor is
-  // the sum of the first dimension. Collect the sizes by rank.
+  // If we are doing an allgather or an alltoall, make sure all but the first
+  // dimension are the same. The first dimension may be different and the
+  // output tensor is the sum of the first dimension. Collect the sizes by
+  // rank.
   std::vector<int64_t> tensor_sizes(requests.size());
-  if (message_type == MPIRequest::ALLGATHER) {
+  if (message_type == MPIRequest::ALLGATHER ||
+      message_type == MPIRequest::ALLTOALL) {
     TensorShape tensor_shape;
     for (auto it = requests[0].tensor_shape().begin();
          it != requests[0].tensor_shape().end(); it++) {
@@ -391,6 +558,43 @@ MPIResponse ConstructMPIResponse(std::unique_ptr<MessageTable>& message_table,
     }
   }
 
+  // If we are doing an alltoall, check that every rank splits its tensor into
+  // one split per rank, whose sizes add up to its first dimension. Collect the
+  // splits by sending rank, and then by receiving rank.
+  std::vector<int64_t> splits;
+  if (message_type == MPIRequest::ALLTOALL) {
+    auto size = requests.size();
+    splits.resize(size * size);
+    for (unsigned int i = 0; i < requests.size(); i++) {
+      if (error) {
+        break;
+      }
+
+      auto& request_splits = requests[i].splits();
+      auto rank = requests[i].request_rank();
+      int64_t total_size = 0;
+      bool negative = false;
+      for (auto split : request_splits) {
+        total_size += split;
+        negative = negative || split < 0;
+      }
+      if (request_splits.size() != size || negative ||
+          total_size != tensor_sizes[rank]) {
+        error = true;
+        error_message_stream
+            << "Invalid " << MPIRequest::RequestType_Name(message_type)
+            << " splits: Rank " << rank << " specified "
+            << request_splits.size() << " splits adding up to " << total_size
+            << " for a tensor with first dimension " << tensor_sizes[rank]
+            << ", but there are " << size
+            << " ranks and splits must be non-negative.";
+        break;
+      }
+      std::copy(request_splits.begin(), request_splits.end(),
+                splits.begin() + rank * size);
+    }
+  }
+
   // If we are doing a broadcast, check that all root ranks are identical.
   if (message_type == MPIRequest::BROADCAST) {
     int first_root_rank = requests[0].root_rank();
@@ -410,6 +614,36 @@ MPIResponse ConstructMPIResponse(std::unique_ptr<MessageTable>& message_table,
         break;
       }
     }
+    if (!error &&
+        (first_root_rank < 0 || first_root_rank >= (int)requests.size())) {
+      error = true;
+      error_message_stream
+          << "Invalid " << MPIRequest::RequestType_Name(message_type)
+          << " root rank " << first_root_rank << ": There are "
+          << requests.size() << " ranks.";
+    }
+  }
+
+  // If we are doing an allreduce, check that all ranks sparsify the tensor in
+  // the same way.
+  if (message_type == MPIRequest::ALLREDUCE) {
+    float first_top_k_ratio = requests[0].top_k_ratio();
+    for (unsigned int i = 1; i < requests.size(); i++) {
+      if (error) {
+        break;
+      }
+
+      float this_top_k_ratio = requests[i].top_k_ratio();
+      if (first_top_k_ratio != this_top_k_ratio) {
+        error = true;
+        error_message_stream
+            << "Mismatched " << MPIRequest::RequestType_Name(message_type)
+            << " top-k ratios: One rank specified top-k ratio "
+            << first_top_k_ratio << ", but another rank specified top-k ratio "
+            << this_top_k_ratio << ".";
+        break;
+      }
+    }
   }
 
   bool first_device_is_cpu = requests[0].device() == CPU_DEVICE_ID;
@@ -430,6 +664,29 @@ MPIResponse ConstructMPIResponse(std::unique_ptr<MessageTable>& message_table,
       break;
     }
   }
+
+  // The 16-bit floating-point types are summed by Horovod itself, which can
+  // only access host memory, unless NCCL can be used to sum them.
+  if (!error && message_type == MPIRequest::ALLREDUCE && !first_device_is_cpu) {
+    auto dtype = requests[0].tensor_type();
+    bool supported = dtype != HOROVOD_FLOAT16 && dtype != HOROVOD_BFLOAT16;
+#if HAVE_NCCL
+    supported = supported || dtype == HOROVOD_FLOAT16;
+#endif
+    if (!supported) {
+      error = true;
+      error_message_stream
+          << MPIRequest::RequestType_Name(message_type)
+          << " is not supported for GPU tensors of type "
+          << MPIDataType_Name(dtype) << ".";
+    }
+  }
+  // Transports can only access host memory.
+  if (!error && !first_device_is_cpu && horovod_global.transport != nullptr) {
+    error = true;
+    error_message_stream << MPIRequest::RequestType_Name(message_type)
+                         << " of GPU tensors requires MPI.";
+  }
   std::vector<int32_t> devices(requests.size());
   for (auto it = requests.begin(); it != requests.end(); it++) {
     devices[it->request_rank()] = it->device();
@@ -450,6 +707,9 @@ MPIResponse ConstructMPIResponse(std::unique_ptr<MessageTable>& message_table,
     response.set_response_type(MPIResponse::ALLREDUCE);
   } else if (message_type == MPIRequest::BROADCAST) {
     response.set_response_type(MPIResponse::BROADCAST);
+  } else if (message_type == MPIRequest::ALLTOALL) {
+    response.set_response_type(MPIResponse::ALLTOALL);
+    response.set_tensor_sizes(splits);
   }
   response.set_devices(devices);
 
@@ -460,8 +720,8 @@ MPIResponse ConstructMPIResponse(std::unique_ptr<MessageTable>& message_table,
   return response;
 }
 
-MPI_Datatype GetMPIDataType(const std::shared_ptr<Tensor> tensor) {
-  switch (tensor->dtype()) {
+MPI_Datatype GetMPIDataType(MPIDataType dtype) {
+  switch (dtype) {
   case HOROVOD_UINT8:
     return MPI_UINT8_T;
   case HOROVOD_INT8:
@@ -480,12 +740,136 @@ MPI_Datatype GetMPIDataType(const std::shared_ptr<Tensor> tensor) {
     return MPI_DOUBLE;
   case HOROVOD_BOOL:
     return MPI_C_BOOL;
+  case HOROVOD_FLOAT16:
+    return horovod_global.mpi_float16_t;
+  case HOROVOD_BFLOAT16:
+    return horovod_global.mpi_bfloat16_t;
   default:
-    throw std::logic_error("Type " + MPIDataType_Name(tensor->dtype()) +
+    throw std::logic_error("Type " + MPIDataType_Name(dtype) +
                            " is not supported in MPI mode.");
   }
 }
 
+MPI_Datatype GetMPIDataType(const std::shared_ptr<Tensor> tensor) {
+  return GetMPIDataType(tensor->dtype());
+}
+
+// Returns the MPI operation that sums values of type `dtype`.
+MPI_Op GetMPISumOp(MPIDataType dtype) {
+  switch (dtype) {
+  case HOROVOD_FLOAT16:
+    return horovod_global.mpi_float16_sum;
+  case HOROVOD_BFLOAT16:
+    return horovod_global.mpi_bfloat16_sum;
+  default:
+    return MPI_SUM;
+  }
+}
+
+void Float16Sum(void* invec, void* inoutvec, int* len, MPI_Datatype*) {
+  SumInto(HOROVOD_FLOAT16, inoutvec, invec, *len);
+}
+
+void BFloat16Sum(void* invec, void* inoutvec, int* len, MPI_Datatype*) {
+  SumInto(HOROVOD_BFLOAT16, inoutvec, invec, *len);
+}
+
+// The following collective operations go through the transport if there is
+// one, and through MPI otherwise, among the ranks of `comm`, which must be
+// MPI_COMM_WORLD when using a transport. Counts are numbers of elements of
+// type `dtype`, and all operations return MPI_SUCCESS if they succeeded.
+int TransportResult(bool success) {
+  return success ? MPI_SUCCESS : MPI_ERR_OTHER;
+}
+
+// Sums `sendbuf` across all ranks into `recvbuf`, which may be the same
+// buffer.
+int AllreduceBuffer(const void* sendbuf, void* recvbuf, int64_t num_elements,
+                    MPIDataType dtype, MPI_Comm comm) {
+  auto transport = horovod_global.transport.get();
+  if (transport == nullptr) {
+    return MPI_Allreduce(sendbuf == recvbuf ? MPI_IN_PLACE : sendbuf, recvbuf,
+                         (int)num_elements, GetMPIDataType(dtype),
+                         GetMPISumOp(dtype), comm);
+  }
+  if (sendbuf != recvbuf) {
+    std::memcpy(recvbuf, sendbuf, (size_t)(num_elements * DataTypeSize(dtype)));
+  }
+  return TransportResult(transport->Allreduce(recvbuf, num_elements, dtype));
+}
+
+// Gathers the blocks of all ranks in place. The block of rank r holds
+// `counts[r]` elements and follows the blocks of the previous ranks, and every
+// rank must have stored its own block at that position.
+int AllgathervBuffer(void* buffer, const std::vector<int64_t>& counts,
+                     MPIDataType dtype, MPI_Comm comm) {
+  auto transport = horovod_global.transport.get();
+  if (transport == nullptr) {
+    std::vector<int> recvcounts(counts.size());
+    std::vector<int> displacements(counts.size(), 0);
+    for (size_t r = 0; r < counts.size(); r++) {
+      recvcounts[r] = (int)counts[r];
+      if (r > 0) {
+        displacements[r] = displacements[r - 1] + recvcounts[r - 1];
+      }
+    }
+    return MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, buffer,
+                          recvcounts.data(), displacements.data(),
+                          GetMPIDataType(dtype), comm);
+  }
+  std::vector<int64_t> byte_counts(counts);
+  for (auto& count : byte_counts) {
+    count *= DataTypeSize(dtype);
+  }
+  return TransportResult(transport->Allgatherv(buffer, byte_counts));
+}
+
+int BroadcastBuffer(void* buffer, int64_t num_elements, MPIDataType dtype,
+                    int root_rank, MPI_Comm comm) {
+  auto transport = horovod_global.transport.get();
+  if (transport == nullptr) {
+    return MPI_Bcast(buffer, (int)num_elements, GetMPIDataType(dtype),
+                     root_rank, comm);
+  }
+  return TransportResult(transport->Broadcast(
+      buffer, num_elements * DataTypeSize(dtype), root_rank));
+}
+
+// Sends `sendcounts[r]` elements to every rank r and receives `recvcounts[r]`
+// elements from every rank r, stored back to back in `sendbuf` and `recvbuf`.
+int AlltoallvBuffer(const void* sendbuf, const std::vector<int64_t>& sendcounts,
+                    void* recvbuf, const std::vector<int64_t>& recvcounts,
+                    MPIDataType dtype, MPI_Comm comm) {
+  auto transport = horovod_global.transport.get();
+  int64_t element_size = DataTypeSize(dtype);
+  if (transport == nullptr) {
+    int size = (int)sendcounts.size();
+    std::vector<int> mpi_sendcounts(size);
+    std::vector<int> sdispls(size, 0);
+    std::vector<int> mpi_recvcounts(size);
+    std::vector<int> rdispls(size, 0);
+    for (int r = 0; r < size; r++) {
+      mpi_sendcounts[r] = (int)sendcounts[r];
+      mpi_recvcounts[r] = (int)recvcounts[r];
+      if (r > 0) {
+        sdispls[r] = sdispls[r - 1] + mpi_sendcounts[r - 1];
+        rdispls[r] = rdispls[r - 1] + mpi_recvcounts[r - 1];
+      }
+    }
+    return MPI_Alltoallv(sendbuf, mpi_sendcounts.data(), sdispls.data(),
+                         GetMPIDataType(dtype), recvbuf, mpi_recvcounts.data(),
+                         rdispls.data(), GetMPIDataType(dtype), comm);
+  }
+  std::vector<int64_t> send_bytes(sendcounts);
+  std::vector<int64_t> recv_bytes(recvcounts);
+  for (size_t r = 0; r < send_bytes.size(); r++) {
+    send_bytes[r] *= element_size;
+    recv_bytes[r] *= element_size;
+  }
+  return TransportResult(
+      transport->Alltoallv(sendbuf, send_bytes, recvbuf, recv_bytes));
+}
+
 #if HAVE_NCCL
 ncclDataType_t GetNCCLDataType(const std::shared_ptr<Tensor> tensor) {
   switch (tensor->dtype()) {
@@ -493,6 +877,8 @@ ncclDataType_t GetNCCLDataType(const std::shared_ptr<Tensor> tensor) {
     return ncclInt32;
   case HOROVOD_INT64:
     return ncclInt64;
+  case HOROVOD_FLOAT16:
+    return ncclFloat16;
   case HOROVOD_FLOAT32:
     return ncclFloat32;
   case HOROVOD_FLOAT64:
@@ -606,197 +992,960 @@ cudaError_t ReleaseCudaEvent(cudaEvent_t event) {
     }                                                                          \
   }
 
-// Process an MPIResponse by doing a reduction, a gather, a broadcast, or
-// raising an error.
-void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
-  std::vector<TensorTableEntry> entries;
-  {
-    // Lock on the tensor table.
-    std::lock_guard<std::mutex> guard(horovod_global.mutex);
+// Splits `num_elements` elements into `num_parts` contiguous parts, as evenly
+// as possible, and stores the number of elements of each part and the index
+// of its first element in `counts` and `displacements`, respectively.
+void SplitEvenly(int64_t num_elements, int num_parts, std::vector<int>& counts,
+                 std::vector<int>& displacements) {
+  counts.resize(num_parts);
+  displacements.resize(num_parts);
+  for (int i = 0; i < num_parts; i++) {
+    counts[i] = (int)(num_elements / num_parts +
+                      (i < num_elements % num_parts ? 1 : 0));
+    displacements[i] = i == 0 ? 0 : displacements[i - 1] + counts[i - 1];
+  }
+}
 
-    for (auto it = response.tensor_names().begin();
-         it != response.tensor_names().end(); it++) {
-      // We should never fail at finding this key in the tensor table.
-      auto name = *it;
-      auto iter = tensor_table.find(name);
-      assert(iter != tensor_table.end());
+// Performs an in-place sum allreduce of `buffer` in three steps, taking
+// advantage of the fact that ranks on the same node can communicate through
+// shared memory, which is much faster than the network between nodes:
+//
+//      1. A reduce-scatter within each node, after which every local rank
+//      holds the node-wide sum of a different segment of the buffer.
+//      2. An allreduce of each segment across nodes, among the ranks that
+//      have the same local rank.
+//      3. An allgather of the reduced segments within each node.
+//
+// As a result, every rank only sends 1 / local_size of the buffer over the
+// network, instead of the whole buffer. Each step is recorded as a separate
+// timeline activity of `entries`, unless `entries` is null. Returns
+// MPI_SUCCESS, or the error code of the first MPI call that failed.
+int HierarchicalAllreduce(void* buffer, int64_t num_elements,
+                          MPI_Datatype datatype, MPI_Op op,
+                          std::vector<TensorTableEntry>* entries) {
+  auto& timeline = horovod_global.timeline;
+  int local_rank = horovod_global.local_rank;
 
-      assert(response.response_type() == MPIResponse::ALLREDUCE ||
-             response.response_type() == MPIResponse::ALLGATHER ||
-             response.response_type() == MPIResponse::BROADCAST ||
-             response.response_type() == MPIResponse::ERROR);
+  int element_size;
+  int result = MPI_Type_size(datatype, &element_size);
+  if (result != MPI_SUCCESS) {
+    return result;
+  }
 
-      entries.push_back(iter->second);
+  // Split the buffer into one segment per local rank.
+  std::vector<int> counts;
+  std::vector<int> displacements;
+  SplitEvenly(num_elements, horovod_global.local_size, counts, displacements);
 
-      // Clear the tensor table of this tensor and its callbacks; the rest of
-      // this function takes care of it.
-      tensor_table.erase(iter);
-    }
+  if (entries != nullptr) {
+    ACTIVITY_START_ALL((*entries), timeline, "MPI_LOCAL_REDUCESCATTER")
+  }
+  result = MPI_Reduce_scatter(MPI_IN_PLACE, buffer, counts.data(), datatype,
+                              op, horovod_global.local_comm);
+  if (result != MPI_SUCCESS) {
+    return result;
   }
 
-  auto& timeline = horovod_global.timeline;
-  for (auto it = entries.begin(); it != entries.end(); it++) {
-    timeline.Start(it->tensor_name, response.response_type());
+  // The in-place reduce-scatter stores the reduced segment at the start of the
+  // buffer, but the in-place allgather expects it at its own displacement.
+  void* segment = (uint8_t*)buffer + (int64_t)displacements[local_rank] *
+                                         element_size;
+  if (segment != buffer) {
+    std::memmove(segment, buffer, (size_t)counts[local_rank] * element_size);
   }
+  if (entries != nullptr) {
+    ACTIVITY_END_ALL((*entries), timeline)
+    ACTIVITY_START_ALL((*entries), timeline, "MPI_CROSS_ALLREDUCE")
+  }
+  result = MPI_Allreduce(MPI_IN_PLACE, segment, counts[local_rank], datatype,
+                         op, horovod_global.cross_comm);
+  if (result != MPI_SUCCESS) {
+    return result;
+  }
+  if (entries != nullptr) {
+    ACTIVITY_END_ALL((*entries), timeline)
+    ACTIVITY_START_ALL((*entries), timeline, "MPI_LOCAL_ALLGATHER")
+  }
+  result = MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, buffer,
+                          counts.data(), displacements.data(), datatype,
+                          horovod_global.local_comm);
+  if (result != MPI_SUCCESS) {
+    return result;
+  }
+  if (entries != nullptr) {
+    ACTIVITY_END_ALL((*entries), timeline)
+  }
+  return MPI_SUCCESS;
+}
 
-  if (entries.size() > 1) {
-    auto first_entry = entries[0];
-    // Note: it is OK for different entries to come from different frameworks
-    // since buffer allocated here is guaranteed to survive at least till the
-    // end of this operation.
-    auto& buffer = horovod_global.tensor_fusion_buffers[std::make_tuple(
-        first_entry.device, first_entry.context->framework())];
-    if (buffer == nullptr) {
-      ACTIVITY_START_ALL(entries, timeline, "INIT_FUSION_BUFFER")
+// Minimum number of bytes copied or reduced by a single thread pool task.
+#define MIN_TASK_BLOCK_SIZE (1 << 20)
+
+// Returns the size of the blocks in which `num_bytes` bytes should be split
+// in order to be processed in parallel by the thread pool. The block size is
+// always a multiple of `element_size`.
+int64_t TaskBlockSize(int64_t num_bytes, int64_t element_size) {
+  int num_threads = horovod_global.thread_pool == nullptr
+                        ? 1
+                        : std::max(horovod_global.thread_pool->num_threads(), 1);
+  int64_t block_size = std::max((int64_t)MIN_TASK_BLOCK_SIZE,
+                                (num_bytes + num_threads - 1) / num_threads);
+  return (block_size + element_size - 1) / element_size * element_size;
+}
 
-      // Lazily allocate persistent buffer for Tensor Fusion and keep it
-      // forever per device.
-      Status status = first_entry.context->AllocatePersistent(
-          horovod_global.tensor_fusion_threshold, &buffer);
-      if (!status.ok()) {
-        for (auto it = entries.begin(); it != entries.end(); it++) {
-          timeline.End(it->tensor_name, nullptr);
-          it->callback(status);
+// Returns the offsets of the tensors of `entries` when packed back to back in
+// a fusion buffer, followed by the total size of the packed tensors.
+std::vector<int64_t>
+FusionBufferOffsets(const std::vector<TensorTableEntry>& entries) {
+  std::vector<int64_t> offsets(1, 0);
+  for (auto it = entries.begin(); it != entries.end(); it++) {
+    offsets.push_back(offsets.back() + it->tensor->size());
+  }
+  return offsets;
+}
+
+// Copies bytes [begin, end) of a fusion buffer from the input tensors of
+// `entries` to `buffer` (if `copy_in` is true), or from `buffer` to the output
+// tensors of `entries` (otherwise). `offsets` must have been computed using
+// FusionBufferOffsets. If `buffer_dtype` differs from the type of the tensors,
+// which must then be float32, the values are converted while being copied,
+// and `begin` and `end` still refer to the uncompressed fusion buffer. The
+// copy is split into blocks that are run as tasks of `group`, and so
+// `entries`, `offsets` and `buffer` must remain valid until the group is
+// waited on.
+void CopyFusionBuffer(TaskGroup& group,
+                      const std::vector<TensorTableEntry>& entries,
+                      const std::vector<int64_t>& offsets, uint8_t* buffer,
+                      MPIDataType buffer_dtype, int64_t begin, int64_t end,
+                      bool copy_in) {
+  auto dtype = entries[0].tensor->dtype();
+  bool convert = buffer_dtype != dtype;
+  int64_t element_size = DataTypeSize(dtype);
+  int64_t buffer_element_size = DataTypeSize(buffer_dtype);
+  int64_t block_size = TaskBlockSize(end - begin, element_size);
+  for (int64_t block_begin = begin; block_begin < end;
+       block_begin += block_size) {
+    int64_t block_end = std::min(end, block_begin + block_size);
+    group.Run([&entries, &offsets, buffer, buffer_dtype, convert, element_size,
+               buffer_element_size, block_begin, block_end, copy_in] {
+      // Find the last tensor that starts at or before the block.
+      size_t i = std::upper_bound(offsets.begin(), offsets.end(), block_begin) -
+                 offsets.begin() - 1;
+      for (int64_t position = block_begin; position < block_end; i++) {
+        int64_t tensor_end = std::min(block_end, offsets[i + 1]);
+        int64_t tensor_offset = position - offsets[i];
+        if (convert) {
+          uint8_t* buffer_position =
+              buffer + position / element_size * buffer_element_size;
+          int64_t num_elements = (tensor_end - position) / element_size;
+          if (copy_in) {
+            ConvertFromFloat(
+                buffer_dtype, buffer_position,
+                (const float*)((const uint8_t*)entries[i].tensor->data() +
+                               tensor_offset),
+                num_elements);
+          } else {
+            ConvertToFloat(
+                buffer_dtype,
+                (float*)((uint8_t*)entries[i].output->data() + tensor_offset),
+                buffer_position, num_elements);
+          }
+        } else if (copy_in) {
+          std::memcpy(buffer + position,
+                      (const uint8_t*)entries[i].tensor->data() + tensor_offset,
+                      (size_t)(tensor_end - position));
+        } else {
+          std::memcpy((uint8_t*)entries[i].output->data() + tensor_offset,
+                      buffer + position, (size_t)(tensor_end - position));
         }
-        return;
+        position = tensor_end;
       }
-
-      ACTIVITY_END_ALL(entries, timeline)
-    }
+    });
   }
+}
 
-  // On GPU data readiness is signalled by ready_event.
-  std::vector<TensorTableEntry> waiting_tensors;
+// Returns whether the float32 tensors of `entries` should be compressed to
+// compression_type while being allreduced. Compression is only applied to
+// tensors that reside in host memory and whose compressed values fit in the
+// fusion buffer, through which they are allreduced.
+bool CompressAllreduce(const std::vector<TensorTableEntry>& entries) {
+  auto compression_type = horovod_global.compression_type;
+  if (compression_type == HOROVOD_FLOAT32 ||
+      entries[0].tensor->dtype() != HOROVOD_FLOAT32 ||
+      entries[0].device != CPU_DEVICE_ID) {
+    return false;
+  }
+  int64_t num_elements = 0;
   for (auto it = entries.begin(); it != entries.end(); it++) {
-    if (it->ready_event != nullptr) {
-      timeline.ActivityStart(it->tensor_name, "WAIT_FOR_DATA");
-      waiting_tensors.push_back(*it);
-    }
+    num_elements += it->tensor->shape().num_elements();
   }
-  while (!waiting_tensors.empty()) {
-    for (auto it = waiting_tensors.begin(); it != waiting_tensors.end();) {
-      if (it->ready_event->Ready()) {
-        timeline.ActivityEnd(it->tensor_name);
-        timeline.ActivityStart(it->tensor_name, "WAIT_FOR_OTHER_TENSOR_DATA");
-        it = waiting_tensors.erase(it);
-      } else {
-        it++;
-      }
-    }
-    std::this_thread::sleep_for(std::chrono::nanoseconds(100));
+  return num_elements * DataTypeSize(compression_type) <=
+         horovod_global.fusion_buffer_size;
+}
+
+// Performs a collective operation on the tensors of `entries`, which must
+// reside in host memory, through the fusion buffer, in which values are stored
+// as `buffer_dtype` (see CopyFusionBuffer). The buffer is processed in chunks
+// of fusion_chunk_size bytes, so that copying the tensors of the next chunk
+// into the buffer and copying the results of the previous chunk out of it
+// happen on the thread pool, while `collective` is applied to the current
+// chunk, given its position and size in bytes. Copying the tensors in or out
+// can be skipped, e.g., on the ranks that send or receive a broadcast.
+int PipelinedFusedOperation(
+    std::vector<TensorTableEntry>& entries, uint8_t* buffer,
+    MPIDataType buffer_dtype, const std::string& activity, bool copy_in,
+    bool copy_out, std::function<int(uint8_t*, int64_t)> collective) {
+  auto& timeline = horovod_global.timeline;
+  auto pool = horovod_global.thread_pool.get();
+  auto offsets = FusionBufferOffsets(entries);
+  int64_t total_size = offsets.back();
+  int64_t element_size = DataTypeSize(entries[0].tensor->dtype());
+  int64_t buffer_element_size = DataTypeSize(buffer_dtype);
+  bool convert = buffer_dtype != entries[0].tensor->dtype();
+
+  // Chunk boundaries refer to the uncompressed fusion buffer, but the chunk
+  // size is applied to the data that is actually communicated. Without helper
+  // threads there is nothing to overlap, and so the whole buffer is processed
+  // at once.
+  int64_t chunk_size =
+      horovod_global.fusion_chunk_size / buffer_element_size * element_size;
+  if (pool == nullptr || pool->num_threads() == 0 || chunk_size <= 0) {
+    chunk_size = std::max(total_size, element_size);
   }
-  for (auto it = entries.begin(); it != entries.end(); it++) {
-    if (it->ready_event != nullptr) {
-      timeline.ActivityEnd(it->tensor_name);
-    }
+  auto buffer_position = [=](int64_t position) {
+    return convert ? position / element_size * buffer_element_size : position;
+  };
+
+  TaskGroup copy_in_group(pool);
+  TaskGroup copy_out_group(pool);
+
+  if (copy_in) {
+    ACTIVITY_START_ALL(entries, timeline, "MEMCPY_IN_FUSION_BUFFER")
+    CopyFusionBuffer(copy_in_group, entries, offsets, buffer, buffer_dtype, 0,
+                     std::min(total_size, chunk_size), true);
+    copy_in_group.Wait();
+    ACTIVITY_END_ALL(entries, timeline)
   }
 
-  Status status;
-  if (response.response_type() == MPIResponse::ALLGATHER) {
-    assert(entries.size() == 1);
-    auto e = entries[0];
+  ACTIVITY_START_ALL(entries, timeline, activity)
+  for (int64_t begin = 0; begin < total_size; begin += chunk_size) {
+    int64_t end = std::min(total_size, begin + chunk_size);
 
-    // Copy tensor sizes from the MPI response into a vector of int64_t
-    // and compute total size.  This is size of first dimension.
-    std::vector<int64_t> tensor_sizes;
-    int64_t total_dimension_size = 0;
-    for (auto it = response.tensor_sizes().begin();
-         it != response.tensor_sizes().end(); it++) {
-      tensor_sizes.push_back(*it);
-      total_dimension_size += *it;
+    // Start copying the next chunk into the buffer, while processing this one.
+    if (copy_in && end < total_size) {
+      CopyFusionBuffer(copy_in_group, entries, offsets, buffer, buffer_dtype,
+                       end, std::min(total_size, end + chunk_size), true);
     }
 
-    // Every tensor participating in Allgather operation may have different
-    // first dimension size, but the rest of dimensions are same for all
-    // tensors.  Here we get shape of tensor sliced by first dimension.
-    TensorShape single_slice_shape;
-    for (int i = 1; i < e.tensor->shape().dims(); i++) {
-      single_slice_shape.AddDim(e.tensor->shape().dim_size(i));
+    int result = collective(buffer + buffer_position(begin),
+                            buffer_position(end) - buffer_position(begin));
+    if (result != MPI_SUCCESS) {
+      copy_in_group.Wait();
+      copy_out_group.Wait();
+      return result;
     }
 
-    // Allgather output will have shape of:
-    // (sum of first dimension of every tensor) x (tensor slice shape).
-    TensorShape output_shape;
-    output_shape.AddDim((int64_t)total_dimension_size);
-    output_shape.AppendShape(single_slice_shape);
-
-    ACTIVITY_START_ALL(entries, timeline, "ALLOCATE_OUTPUT")
-    status = e.context->AllocateOutput(output_shape, &e.output);
-    if (!status.ok()) {
-      timeline.End(e.tensor_name, nullptr);
-      e.callback(status);
-      return;
+    if (copy_out) {
+      CopyFusionBuffer(copy_out_group, entries, offsets, buffer, buffer_dtype,
+                       begin, end, false);
     }
-    ACTIVITY_END_ALL(entries, timeline)
+    copy_in_group.Wait();
+  }
+  ACTIVITY_END_ALL(entries, timeline)
 
-    // Tensors may have different first dimension, so we need to use
-    // MPI_Allgatherv API that supports gathering arrays of different length.
-    ACTIVITY_START_ALL(entries, timeline, "MPI_ALLGATHER")
-    int* recvcounts = new int[tensor_sizes.size()];
-    int* displcmnts = new int[tensor_sizes.size()];
-    for (unsigned int i = 0; i < tensor_sizes.size(); i++) {
-      recvcounts[i] =
-          (int)(single_slice_shape.num_elements() * tensor_sizes[i]);
-      if (i == 0) {
-        displcmnts[i] = 0;
-      } else {
-        displcmnts[i] = recvcounts[i - 1] + displcmnts[i - 1];
-      }
-    }
-    auto result = MPI_Allgatherv(
-        e.tensor->data(), (int)e.tensor->shape().num_elements(),
-        GetMPIDataType(e.tensor), (void*)e.output->data(), recvcounts,
-        displcmnts, GetMPIDataType(e.tensor), MPI_COMM_WORLD);
-    delete[] recvcounts;
-    delete[] displcmnts;
-    MPI_CHECK(entries, "MPI_Allgatherv", result)
+  if (copy_out) {
+    ACTIVITY_START_ALL(entries, timeline, "MEMCPY_OUT_FUSION_BUFFER")
+    copy_out_group.Wait();
     ACTIVITY_END_ALL(entries, timeline)
+  }
+  return MPI_SUCCESS;
+}
 
-    timeline.End(e.tensor_name, e.output);
-    e.callback(Status::OK());
+// Allreduces the tensors of `entries`, which must reside in host memory,
+// among the ranks of `comm` through the fusion buffer (see
+// PipelinedFusedOperation). Hierarchical allreduce always involves all ranks.
+int PipelinedFusedAllreduce(std::vector<TensorTableEntry>& entries,
+                            uint8_t* buffer, MPIDataType buffer_dtype,
+                            bool hierarchical, MPI_Comm comm) {
+  auto datatype = GetMPIDataType(buffer_dtype);
+  auto op = GetMPISumOp(buffer_dtype);
+  int64_t buffer_element_size = DataTypeSize(buffer_dtype);
+  return PipelinedFusedOperation(
+      entries, buffer, buffer_dtype, "MPI_ALLREDUCE", true, true,
+      [datatype, op, buffer_dtype, buffer_element_size, hierarchical,
+       comm](uint8_t* chunk, int64_t chunk_size) {
+        int64_t num_elements = chunk_size / buffer_element_size;
+        return hierarchical
+                   ? HierarchicalAllreduce(chunk, num_elements, datatype, op,
+                                           nullptr)
+                   : AllreduceBuffer(chunk, chunk, num_elements, buffer_dtype,
+                                     comm);
+      });
+}
 
-  } else if (response.response_type() == MPIResponse::ALLREDUCE) {
-    auto first_entry = entries[0];
-#if HAVE_CUDA
-    bool on_gpu = first_entry.device != CPU_DEVICE_ID;
-    if (on_gpu) {
-      CUDA_CHECK(entries, "cudaSetDevice", cudaSetDevice(first_entry.device))
+// Broadcasts the tensors of `entries`, which must reside in host memory and
+// have the same root rank, through the fusion buffer (see
+// PipelinedFusedOperation). The tensors may have different types, since they
+// are broadcast as bytes.
+int PipelinedFusedBroadcast(const ProcessSet& process_set,
+                            std::vector<TensorTableEntry>& entries,
+                            uint8_t* buffer) {
+  int root_rank = entries[0].root_rank;
+  bool is_root = process_set.rank == root_rank;
+  MPI_Comm comm = process_set.comm;
+  return PipelinedFusedOperation(
+      entries, buffer, entries[0].tensor->dtype(), "MPI_BCAST", is_root,
+      !is_root, [root_rank, comm](uint8_t* chunk, int64_t chunk_size) {
+        return BroadcastBuffer(chunk, chunk_size, HOROVOD_UINT8, root_rank,
+                               comm);
+      });
+}
 
-      // Ensure stream is in the map before executing reduction.
-      cudaStream_t& stream = horovod_global.streams[first_entry.device];
-      if (stream == nullptr) {
-        CUDA_CHECK(entries, "cudaStreamCreate", cudaStreamCreate(&stream))
-      }
+// Broadcasts the single tensor of `entry` in place, in chunks of
+// fusion_chunk_size bytes, like the fused broadcasts. There is nothing to copy,
+// and so nothing to overlap with the chunks, but chunking bounds the size of
+// every MPI_Bcast, whose count would otherwise overflow for tensors larger than
+// 2 GB. The tensor may reside in GPU memory, since it is never accessed here.
+int ChunkedBroadcast(const ProcessSet& process_set,
+                     const TensorTableEntry& entry) {
+  // On root rank, the broadcast sends data, on other ranks it receives data.
+  uint8_t* data;
+  if (process_set.rank == entry.root_rank) {
+    data = (uint8_t*)entry.tensor->data();
+  } else {
+    data = (uint8_t*)entry.output->data();
+  }
+  int64_t total_size = entry.tensor->size();
+  int64_t chunk_size = horovod_global.fusion_chunk_size;
+  if (chunk_size <= 0) {
+    chunk_size = std::max(total_size, (int64_t)1);
+  }
+  for (int64_t begin = 0; begin < total_size; begin += chunk_size) {
+    int result = BroadcastBuffer(data + begin,
+                                 std::min(chunk_size, total_size - begin),
+                                 HOROVOD_UINT8, entry.root_rank,
+                                 process_set.comm);
+    if (result != MPI_SUCCESS) {
+      return result;
     }
-#endif
-
-#if HOROVOD_GPU_ALLREDUCE == 'N' // 'N' stands for NCCL
-    if (on_gpu) {
-      auto stream = horovod_global.streams[first_entry.device];
+  }
+  return MPI_SUCCESS;
+}
 
-      // Ensure NCCL communicator is in the map before executing reduction.
-      ncclComm_t& nccl_comm = horovod_global.nccl_comms[response.devices()];
-      if (nccl_comm == nullptr) {
-        ACTIVITY_START_ALL(entries, timeline, "INIT_NCCL")
+// Gathers the tensors of `entries`, which must reside in host memory, from all
+// ranks of `process_set` using a single allgather on the fusion buffer.
+// `tensor_sizes` contains the first dimension of every tensor on every rank, in
+// the format of MPIResponse::tensor_sizes, and the outputs of `entries` must
+// have been allocated accordingly. The fusion buffer contains the blocks of all
+// ranks, one after the other, and every block contains the tensors of that
+// rank, packed back to back. The tensors may have different types, since they
+// are gathered as bytes.
+int FusedAllgather(const ProcessSet& process_set,
+                   std::vector<TensorTableEntry>& entries,
+                   const std::vector<int64_t>& tensor_sizes,
+                   const std::vector<int64_t>& slice_sizes, uint8_t* buffer) {
+  auto& timeline = horovod_global.timeline;
+  int size = process_set.size;
+
+  // Compute the size and displacement of the block of each rank, as well as
+  // the offset of every tensor within the output of that tensor.
+  std::vector<int64_t> recvcounts(size, 0);
+  std::vector<int64_t> displacements(size, 0);
+  for (int r = 0; r < size; r++) {
+    for (size_t i = 0; i < entries.size(); i++) {
+      recvcounts[r] += tensor_sizes[i * size + r] * slice_sizes[i];
+    }
+    if (r > 0) {
+      displacements[r] = displacements[r - 1] + recvcounts[r - 1];
+    }
+  }
 
-        ncclUniqueId nccl_id;
-        if (horovod_global.rank == 0) {
-          NCCL_CHECK(entries, "ncclGetUniqueId", ncclGetUniqueId(&nccl_id))
-        }
+  ACTIVITY_START_ALL(entries, timeline, "MEMCPY_IN_FUSION_BUFFER")
+  {
+    TaskGroup group(horovod_global.thread_pool.get());
+    auto offsets = FusionBufferOffsets(entries);
+    CopyFusionBuffer(group, entries, offsets,
+                     buffer + displacements[process_set.rank],
+                     entries[0].tensor->dtype(), 0, offsets.back(), true);
+    group.Wait();
+  }
+  ACTIVITY_END_ALL(entries, timeline)
 
-        MPI_CHECK(entries, "MPI_Bcast",
-                  MPI_Bcast((void*)&nccl_id, sizeof(nccl_id), MPI_BYTE, 0,
-                            MPI_COMM_WORLD));
+  ACTIVITY_START_ALL(entries, timeline, "MPI_ALLGATHER")
+  int result =
+      AllgathervBuffer(buffer, recvcounts, HOROVOD_UINT8, process_set.comm);
+  if (result != MPI_SUCCESS) {
+    return result;
+  }
+  ACTIVITY_END_ALL(entries, timeline)
+
+  ACTIVITY_START_ALL(entries, timeline, "MEMCPY_OUT_FUSION_BUFFER")
+  std::vector<int64_t> output_offsets(entries.size(), 0);
+  for (int r = 0; r < size; r++) {
+    const uint8_t* block = buffer + displacements[r];
+    for (size_t i = 0; i < entries.size(); i++) {
+      int64_t num_bytes = tensor_sizes[i * size + r] * slice_sizes[i];
+      std::memcpy((uint8_t*)entries[i].output->data() + output_offsets[i],
+                  block, (size_t)num_bytes);
+      output_offsets[i] += num_bytes;
+      block += num_bytes;
+    }
+  }
+  ACTIVITY_END_ALL(entries, timeline)
+  return MPI_SUCCESS;
+}
 
-        ncclComm_t new_nccl_comm;
-        NCCL_CHECK(entries, "ncclCommInitRank",
-                   ncclCommInitRank(&new_nccl_comm, horovod_global.size,
-                                    nccl_id, horovod_global.rank))
-        nccl_comm = new_nccl_comm;
+// Exchanges splits of the tensors of `entries`, which must reside in host
+// memory, between all ranks of `process_set` using a single alltoall on the
+// fusion buffer.
+// `splits` contains the number of rows that every rank sends to every rank for
+// every tensor, in the format of MPIResponse::tensor_sizes, and the outputs of
+// `entries` must have been allocated accordingly. The first part of the fusion
+// buffer contains the blocks sent to every rank and the second part the blocks
+// received from every rank. Every block contains the rows of all tensors
+// exchanged between a pair of ranks, packed back to back.
+int FusedAlltoall(const ProcessSet& process_set,
+                  std::vector<TensorTableEntry>& entries,
+                  const std::vector<int64_t>& splits,
+                  const std::vector<int64_t>& slice_sizes, uint8_t* buffer) {
+  auto& timeline = horovod_global.timeline;
+  int rank = process_set.rank;
+  int size = process_set.size;
+  auto split = [&splits, size](size_t i, int sender, int receiver) {
+    return splits[(i * size + sender) * size + receiver];
+  };
+
+  std::vector<int64_t> sendcounts(size, 0);
+  std::vector<int64_t> recvcounts(size, 0);
+  int64_t send_size = 0;
+  for (int r = 0; r < size; r++) {
+    for (size_t i = 0; i < entries.size(); i++) {
+      sendcounts[r] += split(i, rank, r) * slice_sizes[i];
+      recvcounts[r] += split(i, r, rank) * slice_sizes[i];
+    }
+    send_size += sendcounts[r];
+  }
+  uint8_t* recv_buffer = buffer + send_size;
+
+  ACTIVITY_START_ALL(entries, timeline, "MEMCPY_IN_FUSION_BUFFER")
+  std::vector<int64_t> input_offsets(entries.size(), 0);
+  uint8_t* block = buffer;
+  for (int r = 0; r < size; r++) {
+    for (size_t i = 0; i < entries.size(); i++) {
+      int64_t num_bytes = split(i, rank, r) * slice_sizes[i];
+      std::memcpy(block,
+                  (const uint8_t*)entries[i].tensor->data() + input_offsets[i],
+                  (size_t)num_bytes);
+      input_offsets[i] += num_bytes;
+      block += num_bytes;
+    }
+  }
+  ACTIVITY_END_ALL(entries, timeline)
 
-        // Barrier helps NCCL to synchronize after initialization and avoid
+  ACTIVITY_START_ALL(entries, timeline, "MPI_ALLTOALL")
+  int result = AlltoallvBuffer(buffer, sendcounts, recv_buffer, recvcounts,
+                               HOROVOD_UINT8, process_set.comm);
+  if (result != MPI_SUCCESS) {
+    return result;
+  }
+  ACTIVITY_END_ALL(entries, timeline)
+
+  ACTIVITY_START_ALL(entries, timeline, "MEMCPY_OUT_FUSION_BUFFER")
+  std::vector<int64_t> output_offsets(entries.size(), 0);
+  block = recv_buffer;
+  for (int r = 0; r < size; r++) {
+    for (size_t i = 0; i < entries.size(); i++) {
+      int64_t num_bytes = split(i, r, rank) * slice_sizes[i];
+      std::memcpy((uint8_t*)entries[i].output->data() + output_offsets[i],
+                  block, (size_t)num_bytes);
+      output_offsets[i] += num_bytes;
+      block += num_bytes;
+    }
+  }
+  ACTIVITY_END_ALL(entries, timeline)
+  return MPI_SUCCESS;
+}
+
+// Returns the number of elements of the tensor of `entry` that every rank
+// sends when it is sparsified, i.e., the fraction top_k_ratio of its elements,
+// rounded up.
+int64_t TopKCount(const TensorTableEntry& entry) {
+  int64_t num_elements = entry.tensor->shape().num_elements();
+  auto k = (int64_t)std::ceil(entry.top_k_ratio * num_elements);
+  return std::min(std::max(k, (int64_t)1), num_elements);
+}
+
+// Returns the number of bytes that the values selected from the tensor of
+// `entry` and their indices occupy in the block that every rank sends when it
+// is sparsified.
+int64_t TopKSelectionSize(const TensorTableEntry& entry) {
+  return TopKCount(entry) *
+         (DataTypeSize(entry.tensor->dtype()) + (int64_t)sizeof(int32_t));
+}
+
+// Returns the size of the block that every rank sends when sparsifying the
+// tensors of `entries`, which contains the selected values of all tensors,
+// followed by their indices, and is padded to a multiple of 8 bytes so that
+// the values of all blocks are aligned.
+int64_t TopKBlockSize(const std::vector<TensorTableEntry>& entries) {
+  int64_t block_size = 0;
+  for (auto it = entries.begin(); it != entries.end(); it++) {
+    block_size += TopKSelectionSize(*it);
+  }
+  return (block_size + 7) / 8 * 8;
+}
+
+// Returns the number of bytes of the fusion buffer that sparsifying tensors,
+// whose selections occupy `selection_size` bytes in total (see
+// TopKSelectionSize), among `size` ranks requires, i.e., the size of the
+// padded blocks of all ranks. Both SparsifyAllreduce and FuseResponses use it,
+// so that fused sparsified tensors always fit in the fusion buffer.
+int64_t TopKFusedSize(int64_t selection_size, int size) {
+  return size * ((selection_size + 7) / 8 * 8);
+}
+
+// Returns whether the tensors of `entries` should be sparsified while being
+// allreduced among `size` ranks. All of them then have a positive top-k ratio
+// (see EnqueueTensorAllreduce). Sparsification is only applied when the
+// blocks of all ranks fit in the fusion buffer, through which they are
+// gathered.
+bool SparsifyAllreduce(const std::vector<TensorTableEntry>& entries,
+                       int size) {
+  if (entries[0].top_k_ratio <= 0) {
+    return false;
+  }
+  int64_t selection_size = 0;
+  for (auto it = entries.begin(); it != entries.end(); it++) {
+    selection_size += TopKSelectionSize(*it);
+  }
+  return TopKFusedSize(selection_size, size) <=
+         horovod_global.fusion_buffer_size;
+}
+
+// Allreduces the sparsified tensors of `entries` among the ranks of
+// `process_set`, using top-k sparsification with error feedback. Every rank
+// adds its residual for each tensor to the tensor, and moves the elements with
+// the largest magnitudes out of the result (see TopKCount and ExtractTopK),
+// which leaves the next residual. The selected values and their indices are
+// then gathered from all ranks in a single allgather on the fusion buffer (see
+// TopKBlockSize), and every rank sums them into the zero-initialized outputs,
+// in order of rank, so that all ranks obtain the same outputs.
+int TopKAllreduce(ProcessSet& process_set,
+                  std::vector<TensorTableEntry>& entries, uint8_t* buffer) {
+  auto& timeline = horovod_global.timeline;
+  auto dtype = entries[0].tensor->dtype();
+  int64_t element_size = DataTypeSize(dtype);
+  int64_t block_size = TopKBlockSize(entries);
+
+  // Compute the number of elements selected from every tensor, and their
+  // position among the elements selected from all tensors.
+  std::vector<int64_t> counts;
+  std::vector<int64_t> positions(1, 0);
+  std::vector<std::vector<uint8_t>*> residuals;
+  for (auto it = entries.begin(); it != entries.end(); it++) {
+    counts.push_back(TopKCount(*it));
+    positions.push_back(positions.back() + counts.back());
+    auto& residual = process_set.top_k_residuals[it->tensor_name];
+    if ((int64_t)residual.size() != it->tensor->size()) {
+      residual.assign((size_t)it->tensor->size(), 0);
+    }
+    residuals.push_back(&residual);
+  }
+  auto values = [&](int rank, size_t i) {
+    return buffer + rank * block_size + positions[i] * element_size;
+  };
+  auto indices = [&](int rank, size_t i) {
+    return (int32_t*)(buffer + rank * block_size +
+                      positions.back() * element_size) +
+           positions[i];
+  };
+
+  ACTIVITY_START_ALL(entries, timeline, "TOP_K_SELECTION")
+  {
+    TaskGroup group(horovod_global.thread_pool.get());
+    for (size_t i = 0; i < entries.size(); i++) {
+      group.Run([&, i] {
+        auto& e = entries[i];
+        void* residual = residuals[i]->data();
+        int64_t num_elements = e.tensor->shape().num_elements();
+        SumInto(dtype, residual, e.tensor->data(), num_elements);
+        ExtractTopK(dtype, residual, num_elements, counts[i],
+                    indices(process_set.rank, i), values(process_set.rank, i));
+      });
+    }
+    group.Wait();
+  }
+  ACTIVITY_END_ALL(entries, timeline)
+
+  ACTIVITY_START_ALL(entries, timeline, "MPI_ALLGATHER")
+  int result = AllgathervBuffer(
+      buffer, std::vector<int64_t>(process_set.size, block_size),
+      HOROVOD_UINT8, process_set.comm);
+  if (result != MPI_SUCCESS) {
+    return result;
+  }
+  ACTIVITY_END_ALL(entries, timeline)
+
+  ACTIVITY_START_ALL(entries, timeline, "TOP_K_ACCUMULATION")
+  {
+    TaskGroup group(horovod_global.thread_pool.get());
+    for (size_t i = 0; i < entries.size(); i++) {
+      group.Run([&, i] {
+        auto& e = entries[i];
+        void* output = (void*)e.output->data();
+        std::memset(output, 0, (size_t)e.output->size());
+        for (int r = 0; r < process_set.size; r++) {
+          ScatterSumInto(dtype, output, indices(r, i), values(r, i),
+                         counts[i]);
+        }
+      });
+    }
+    group.Wait();
+  }
+  ACTIVITY_END_ALL(entries, timeline)
+  return MPI_SUCCESS;
+}
+
+// Synchronizes the ranks of this node, and makes the updates that they made
+// to the shared memory buffers visible to each other.
+int SharedMemoryBarrier() {
+  MPI_Win_sync(horovod_global.shared_window);
+  int result = MPI_Barrier(horovod_global.local_comm);
+  MPI_Win_sync(horovod_global.shared_window);
+  return result;
+}
+
+// Allreduces the tensors of `entries`, which must reside in host memory, using
+// buffers that are shared by all the ranks of this node:
+//
+//      1. Every rank copies its tensors into its own shared buffer.
+//      2. Every rank sums a different segment of the shared buffers of all
+//      local ranks into its own shared buffer, using SIMD instructions.
+//      3. Every rank allreduces its segment across nodes, among the ranks that
+//      have the same local rank.
+//      4. Every rank copies each reduced segment out of the shared buffer of
+//      the local rank that owns it, directly into its output tensors.
+//
+// Compared to HierarchicalAllreduce, data exchanged within a node never goes
+// through MPI and is only copied once in each direction.
+int SharedMemoryAllreduce(std::vector<TensorTableEntry>& entries) {
+  auto& timeline = horovod_global.timeline;
+  auto pool = horovod_global.thread_pool.get();
+  auto& shared_buffers = horovod_global.shared_buffers;
+  int local_rank = horovod_global.local_rank;
+  int local_size = horovod_global.local_size;
+  uint8_t* own_buffer = shared_buffers[local_rank];
+
+  auto offsets = FusionBufferOffsets(entries);
+  auto dtype = entries[0].tensor->dtype();
+  int64_t element_size = DataTypeSize(dtype);
+  std::vector<int> counts;
+  std::vector<int> displacements;
+  SplitEvenly(offsets.back() / element_size, local_size, counts,
+              displacements);
+
+  ACTIVITY_START_ALL(entries, timeline, "MEMCPY_IN_FUSION_BUFFER")
+  {
+    TaskGroup group(pool);
+    CopyFusionBuffer(group, entries, offsets, own_buffer, dtype, 0,
+                     offsets.back(), true);
+    group.Wait();
+  }
+  ACTIVITY_END_ALL(entries, timeline)
+
+  ACTIVITY_START_ALL(entries, timeline, "SHARED_MEMORY_REDUCE")
+  int result = SharedMemoryBarrier();
+  if (result != MPI_SUCCESS) {
+    return result;
+  }
+  int64_t segment_begin = displacements[local_rank] * element_size;
+  int64_t segment_end = segment_begin + counts[local_rank] * element_size;
+  {
+    TaskGroup group(pool);
+    int64_t block_size =
+        TaskBlockSize(segment_end - segment_begin, element_size);
+    for (int64_t block_begin = segment_begin; block_begin < segment_end;
+         block_begin += block_size) {
+      int64_t block_end = std::min(segment_end, block_begin + block_size);
+      group.Run([&shared_buffers, own_buffer, local_rank, local_size, dtype,
+                 element_size, block_begin, block_end] {
+        for (int r = 0; r < local_size; r++) {
+          if (r != local_rank) {
+            SumInto(dtype, own_buffer + block_begin,
+                    shared_buffers[r] + block_begin,
+                    (block_end - block_begin) / element_size);
+          }
+        }
+      });
+    }
+    group.Wait();
+  }
+  ACTIVITY_END_ALL(entries, timeline)
+
+  if (horovod_global.size > local_size) {
+    ACTIVITY_START_ALL(entries, timeline, "MPI_CROSS_ALLREDUCE")
+    result = MPI_Allreduce(MPI_IN_PLACE, own_buffer + segment_begin,
+                           counts[local_rank], GetMPIDataType(dtype),
+                           GetMPISumOp(dtype), horovod_global.cross_comm);
+    if (result != MPI_SUCCESS) {
+      return result;
+    }
+    ACTIVITY_END_ALL(entries, timeline)
+  }
+
+  ACTIVITY_START_ALL(entries, timeline, "MEMCPY_OUT_FUSION_BUFFER")
+  result = SharedMemoryBarrier();
+  if (result != MPI_SUCCESS) {
+    return result;
+  }
+  {
+    TaskGroup group(pool);
+    for (int r = 0; r < local_size; r++) {
+      CopyFusionBuffer(group, entries, offsets, shared_buffers[r], dtype,
+                       displacements[r] * element_size,
+                       (displacements[r] + counts[r]) * element_size, false);
+    }
+    group.Wait();
+  }
+
+  // Make sure that no rank starts overwriting its shared buffer with the
+  // tensors of the next operation, while other ranks are still reading it.
+  result = SharedMemoryBarrier();
+  if (result != MPI_SUCCESS) {
+    return result;
+  }
+  ACTIVITY_END_ALL(entries, timeline)
+  return MPI_SUCCESS;
+}
+
+// Returns true if the operation of `response` on the tensors of `entries`
+// goes through the fusion buffer.
+bool UsesFusionBuffer(const ProcessSet& process_set,
+                      const MPIResponse& response,
+                      const std::vector<TensorTableEntry>& entries) {
+  // Single tensors only go through the fusion buffer if they are compressed
+  // or sparsified.
+  return entries.size() > 1 ||
+         (response.response_type() == MPIResponse::ALLREDUCE &&
+          (CompressAllreduce(entries) ||
+           SparsifyAllreduce(entries, process_set.size)));
+}
+
+// Process an MPIResponse of `process_set` by doing a reduction, a gather, a
+// broadcast, or raising an error, for the tensors of `entries`, which have
+// been removed from the tensor table.
+void ExecuteOperation(ProcessSet& process_set, MPIResponse response,
+                      std::vector<TensorTableEntry>& entries) {
+  auto& timeline = horovod_global.timeline;
+  for (auto it = entries.begin(); it != entries.end(); it++) {
+    timeline.Start(it->tensor_name, response.response_type());
+  }
+
+  if (horovod_global.parameter_manager.active()) {
+    int64_t bytes = 0;
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+      bytes += it->tensor->size();
+    }
+    horovod_global.parameter_manager.RecordBytes(bytes);
+  }
+
+  if (UsesFusionBuffer(process_set, response, entries)) {
+    auto first_entry = entries[0];
+    // Note: it is OK for different entries to come from different frameworks
+    // since buffer allocated here is guaranteed to survive at least till the
+    // end of this operation.
+    auto& buffer = horovod_global.tensor_fusion_buffers[std::make_tuple(
+        first_entry.device, first_entry.context->framework())];
+    if (buffer == nullptr) {
+      ACTIVITY_START_ALL(entries, timeline, "INIT_FUSION_BUFFER")
+
+      // Lazily allocate persistent buffer for Tensor Fusion and keep it
+      // forever per device.
+      Status status = first_entry.context->AllocatePersistent(
+          horovod_global.fusion_buffer_size, &buffer);
+      if (!status.ok()) {
+        for (auto it = entries.begin(); it != entries.end(); it++) {
+          timeline.End(it->tensor_name, nullptr);
+          it->callback(status);
+        }
+        return;
+      }
+
+      ACTIVITY_END_ALL(entries, timeline)
+    }
+  }
+
+  // On GPU data readiness is signalled by ready_event.
+  std::vector<TensorTableEntry> waiting_tensors;
+  for (auto it = entries.begin(); it != entries.end(); it++) {
+    if (it->ready_event != nullptr) {
+      timeline.ActivityStart(it->tensor_name, "WAIT_FOR_DATA");
+      waiting_tensors.push_back(*it);
+    }
+  }
+  while (!waiting_tensors.empty()) {
+    for (auto it = waiting_tensors.begin(); it != waiting_tensors.end();) {
+      if (it->ready_event->Ready()) {
+        timeline.ActivityEnd(it->tensor_name);
+        timeline.ActivityStart(it->tensor_name, "WAIT_FOR_OTHER_TENSOR_DATA");
+        it = waiting_tensors.erase(it);
+      } else {
+        it++;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::nanoseconds(100));
+  }
+  for (auto it = entries.begin(); it != entries.end(); it++) {
+    if (it->ready_event != nullptr) {
+      timeline.ActivityEnd(it->tensor_name);
+    }
+  }
+
+  Status status;
+  if (response.response_type() == MPIResponse::ALLGATHER) {
+    int size = process_set.size;
+    auto& tensor_sizes = response.tensor_sizes();
+    assert(tensor_sizes.size() == entries.size() * size);
+
+    // Every tensor participating in Allgather operation may have different
+    // first dimension size, but the rest of dimensions are same for all
+    // tensors. The output of each tensor has shape of:
+    // (sum of first dimension of every tensor) x (tensor slice shape).
+    ACTIVITY_START_ALL(entries, timeline, "ALLOCATE_OUTPUT")
+    std::vector<int64_t> slice_sizes;
+    for (size_t i = 0; i < entries.size(); i++) {
+      auto& e = entries[i];
+      TensorShape single_slice_shape;
+      for (int d = 1; d < e.tensor->shape().dims(); d++) {
+        single_slice_shape.AddDim(e.tensor->shape().dim_size(d));
+      }
+      slice_sizes.push_back(single_slice_shape.num_elements() *
+                            DataTypeSize(e.tensor->dtype()));
+
+      int64_t total_dimension_size = 0;
+      for (int r = 0; r < size; r++) {
+        total_dimension_size += tensor_sizes[i * size + r];
+      }
+      TensorShape output_shape;
+      output_shape.AddDim(total_dimension_size);
+      output_shape.AppendShape(single_slice_shape);
+
+      status = e.context->AllocateOutput(output_shape, &e.output);
+      if (!status.ok()) {
+        for (auto it = entries.begin(); it != entries.end(); it++) {
+          timeline.End(it->tensor_name, nullptr);
+          it->callback(status);
+        }
+        return;
+      }
+    }
+    ACTIVITY_END_ALL(entries, timeline)
+
+    if (entries.size() > 1) {
+      auto first_entry = entries[0];
+      auto& buffer = horovod_global.tensor_fusion_buffers[std::make_tuple(
+          first_entry.device, first_entry.context->framework())];
+      auto buffer_data = buffer->AccessData(first_entry.context);
+      MPI_CHECK(entries, "MPI_Allgatherv",
+                FusedAllgather(process_set, entries, tensor_sizes, slice_sizes,
+                               (uint8_t*)buffer_data))
+    } else {
+      auto e = entries[0];
+
+      // Tensors may have different first dimension, so we need to use an
+      // allgather that supports gathering arrays of different length.
+      ACTIVITY_START_ALL(entries, timeline, "MPI_ALLGATHER")
+      int64_t slice_elements =
+          slice_sizes[0] / DataTypeSize(e.tensor->dtype());
+      std::vector<int64_t> recvcounts(size);
+      for (int i = 0; i < size; i++) {
+        recvcounts[i] = slice_elements * tensor_sizes[i];
+      }
+      if (horovod_global.transport != nullptr) {
+        // Transports gather in place, and only support tensors that reside in
+        // host memory, so the tensor of this rank is copied into the output.
+        int64_t displacement = 0;
+        for (int i = 0; i < process_set.rank; i++) {
+          displacement += recvcounts[i] * DataTypeSize(e.tensor->dtype());
+        }
+        std::memcpy((uint8_t*)e.output->data() + displacement,
+                    e.tensor->data(), (size_t)e.tensor->size());
+        MPI_CHECK(entries, "MPI_Allgatherv",
+                  AllgathervBuffer((void*)e.output->data(), recvcounts,
+                                   e.tensor->dtype(), process_set.comm))
+      } else {
+        // With CUDA-aware MPI, the tensor may reside in GPU memory, and so it
+        // is gathered directly from the tensor.
+        std::vector<int> counts(size);
+        std::vector<int> displacements(size, 0);
+        for (int i = 0; i < size; i++) {
+          counts[i] = (int)recvcounts[i];
+          if (i > 0) {
+            displacements[i] = displacements[i - 1] + counts[i - 1];
+          }
+        }
+        MPI_CHECK(entries, "MPI_Allgatherv",
+                  MPI_Allgatherv(e.tensor->data(),
+                                 (int)e.tensor->shape().num_elements(),
+                                 GetMPIDataType(e.tensor),
+                                 (void*)e.output->data(), counts.data(),
+                                 displacements.data(),
+                                 GetMPIDataType(e.tensor), process_set.comm))
+      }
+      ACTIVITY_END_ALL(entries, timeline)
+    }
+
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+      timeline.End(it->tensor_name, it->output);
+      it->callback(Status::OK());
+    }
+
+  } else if (response.response_type() == MPIResponse::ALLREDUCE) {
+    auto first_entry = entries[0];
+#if HAVE_CUDA
+    bool on_gpu = first_entry.device != CPU_DEVICE_ID;
+    if (on_gpu) {
+      CUDA_CHECK(entries, "cudaSetDevice", cudaSetDevice(first_entry.device))
+
+      // Ensure stream is in the map before executing reduction.
+      cudaStream_t& stream = horovod_global.streams[first_entry.device];
+      if (stream == nullptr) {
+        CUDA_CHECK(entries, "cudaStreamCreate", cudaStreamCreate(&stream))
+      }
+    }
+#endif
+
+#if HOROVOD_GPU_ALLREDUCE == 'N' // 'N' stands for NCCL
+    if (on_gpu) {
+      auto stream = horovod_global.streams[first_entry.device];
+
+      // Ensure NCCL communicator is in the map before executing reduction.
+      // Communicators are keyed by the devices of the ranks, followed by the
+      // ID of the process set.
+      auto nccl_key = response.devices();
+      nccl_key.push_back(process_set.id);
+      ncclComm_t& nccl_comm = horovod_global.nccl_comms[nccl_key];
+      if (nccl_comm == nullptr) {
+        ACTIVITY_START_ALL(entries, timeline, "INIT_NCCL")
+
+        ncclUniqueId nccl_id;
+        if (process_set.rank == 0) {
+          NCCL_CHECK(entries, "ncclGetUniqueId", ncclGetUniqueId(&nccl_id))
+        }
+
+        MPI_CHECK(entries, "MPI_Bcast",
+                  MPI_Bcast((void*)&nccl_id, sizeof(nccl_id), MPI_BYTE, 0,
+                            process_set.comm));
+
+        ncclComm_t new_nccl_comm;
+        NCCL_CHECK(entries, "ncclCommInitRank",
+                   ncclCommInitRank(&new_nccl_comm, process_set.size, nccl_id,
+                                    process_set.rank))
+        nccl_comm = new_nccl_comm;
+
+        // Barrier helps NCCL to synchronize after initialization and avoid
         // deadlock that we've been seeing without it.
-        MPI_CHECK(entries, "MPI_Barrier", MPI_Barrier(MPI_COMM_WORLD));
+        MPI_CHECK(entries, "MPI_Barrier", MPI_Barrier(process_set.comm));
 
         ACTIVITY_END_ALL(entries, timeline)
       }
@@ -938,7 +2087,63 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
     }
 #endif
 
-    if (entries.size() > 1) {
+    // Hierarchical and shared memory allreduce, as well as parallel copies,
+    // are only used for tensors that reside in host memory. The first two
+    // always involve all ranks, and so they are only used for process set
+    // zero.
+    bool on_cpu = true;
+#if HAVE_CUDA
+    on_cpu = !on_gpu;
+#endif
+    bool global = process_set.id == 0;
+    bool hierarchical =
+        horovod_global.hierarchical_allreduce && on_cpu && global;
+    int64_t total_size = 0;
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+      total_size += it->tensor->size();
+    }
+    // Compressed tensors are always reduced through the fusion buffer, since
+    // the shared memory path sums them in their own type.
+    bool sparsify = SparsifyAllreduce(entries, process_set.size);
+    bool compress = CompressAllreduce(entries);
+    bool shared_memory = on_cpu && !compress && global &&
+                         horovod_global.shared_window != MPI_WIN_NULL &&
+                         total_size <= horovod_global.shared_buffer_size;
+    auto dtype = first_entry.tensor->dtype();
+
+    if (sparsify) {
+      auto& buffer = horovod_global.tensor_fusion_buffers[std::make_tuple(
+          first_entry.device, first_entry.context->framework())];
+      auto buffer_data = buffer->AccessData(first_entry.context);
+      MPI_CHECK(entries, "MPI_Allgatherv",
+                TopKAllreduce(process_set, entries, (uint8_t*)buffer_data))
+    } else if (shared_memory) {
+      MPI_CHECK(entries, "MPI_Allreduce", SharedMemoryAllreduce(entries))
+    } else if (entries.size() > 1 &&
+               total_size > horovod_global.fusion_buffer_size) {
+      // Only tensors that were fused to be sparsified can exceed the fusion
+      // buffer, since they are fused by the size of their selected elements
+      // (see FusedTensorSize). If they are reduced densely instead, they are
+      // reduced one at a time, without going through the fusion buffer.
+      ACTIVITY_START_ALL(entries, timeline, "MPI_ALLREDUCE")
+      for (size_t i = 0; i < entries.size(); i++) {
+        auto& e = entries[i];
+        MPI_CHECK(entries, "MPI_Allreduce",
+                  AllreduceBuffer(e.tensor->data(), (void*)e.output->data(),
+                                  e.tensor->shape().num_elements(), dtype,
+                                  process_set.comm))
+      }
+      ACTIVITY_END_ALL(entries, timeline)
+    } else if ((entries.size() > 1 || compress) && on_cpu) {
+      auto& buffer = horovod_global.tensor_fusion_buffers[std::make_tuple(
+          first_entry.device, first_entry.context->framework())];
+      auto buffer_data = buffer->AccessData(first_entry.context);
+      MPI_CHECK(entries, "MPI_Allreduce",
+                PipelinedFusedAllreduce(
+                    entries, (uint8_t*)buffer_data,
+                    compress ? horovod_global.compression_type : dtype,
+                    hierarchical, process_set.comm))
+    } else if (entries.size() > 1) {
       // Access the fusion buffer.
       auto& buffer = horovod_global.tensor_fusion_buffers[std::make_tuple(
           first_entry.device, first_entry.context->framework())];
@@ -976,16 +2181,15 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
 #endif
       ACTIVITY_END_ALL(entries, timeline)
 
-      ACTIVITY_START_ALL(entries, timeline, "MPI_ALLREDUCE")
       int64_t num_elements = 0;
       for (auto it = entries.begin(); it != entries.end(); it++) {
         num_elements += it->tensor->shape().num_elements();
       }
+      ACTIVITY_START_ALL(entries, timeline, "MPI_ALLREDUCE")
       MPI_CHECK(entries, "MPI_Allreduce",
                 MPI_Allreduce(MPI_IN_PLACE, (void*)buffer_data,
-                              (int)num_elements,
-                              GetMPIDataType(first_entry.tensor), MPI_SUM,
-                              MPI_COMM_WORLD))
+                              (int)num_elements, GetMPIDataType(dtype),
+                              GetMPISumOp(dtype), process_set.comm))
       ACTIVITY_END_ALL(entries, timeline)
 
       // Copy memory out of the fusion buffer.
@@ -1019,17 +2223,26 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
       }
 #endif
       ACTIVITY_END_ALL(entries, timeline)
+    } else if (hierarchical) {
+      auto e = first_entry;
+      if (e.tensor->data() != e.output->data()) {
+        ACTIVITY_START_ALL(entries, timeline, "MEMCPY_IN_OUTPUT")
+        std::memcpy((void*)e.output->data(), e.tensor->data(),
+                    (size_t)e.tensor->size());
+        ACTIVITY_END_ALL(entries, timeline)
+      }
+      MPI_CHECK(entries, "MPI_Allreduce",
+                HierarchicalAllreduce((void*)e.output->data(),
+                                      e.tensor->shape().num_elements(),
+                                      GetMPIDataType(dtype), GetMPISumOp(dtype),
+                                      &entries))
     } else {
       auto e = first_entry;
       ACTIVITY_START_ALL(entries, timeline, "MPI_ALLREDUCE")
-      const void* sendbuf = e.tensor->data() == e.output->data()
-                                ? MPI_IN_PLACE
-                                : e.tensor->data();
       MPI_CHECK(entries, "MPI_Allreduce",
-                MPI_Allreduce(sendbuf, (void*)e.output->data(),
-                              (int)e.tensor->shape().num_elements(),
-                              GetMPIDataType(e.tensor), MPI_SUM,
-                              MPI_COMM_WORLD))
+                AllreduceBuffer(e.tensor->data(), (void*)e.output->data(),
+                                e.tensor->shape().num_elements(), dtype,
+                                process_set.comm))
       ACTIVITY_END_ALL(entries, timeline)
     }
 
@@ -1038,80 +2251,1018 @@ void PerformOperation(TensorTable& tensor_table, MPIResponse response) {
       it->callback(Status::OK());
     }
   } else if (response.response_type() == MPIResponse::BROADCAST) {
-    assert(entries.size() == 1);
-    auto e = entries[0];
+    if (entries.size() > 1) {
+      auto first_entry = entries[0];
+      auto& buffer = horovod_global.tensor_fusion_buffers[std::make_tuple(
+          first_entry.device, first_entry.context->framework())];
+      auto buffer_data = buffer->AccessData(first_entry.context);
+      MPI_CHECK(entries, "MPI_Bcast",
+                PipelinedFusedBroadcast(process_set, entries,
+                                        (uint8_t*)buffer_data))
+    } else {
+      ACTIVITY_START_ALL(entries, timeline, "MPI_BCAST")
+      MPI_CHECK(entries, "MPI_Bcast", ChunkedBroadcast(process_set, entries[0]))
+      ACTIVITY_END_ALL(entries, timeline)
+    }
+
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+      timeline.End(it->tensor_name, it->output);
+      it->callback(Status::OK());
+    }
+  } else if (response.response_type() == MPIResponse::ALLTOALL) {
+    int rank = process_set.rank;
+    int size = process_set.size;
+    auto& splits = response.tensor_sizes();
+    assert(splits.size() == entries.size() * size * size);
+
+    // The output of each tensor has shape of:
+    // (sum of the splits received from every rank) x (tensor slice shape).
+    ACTIVITY_START_ALL(entries, timeline, "ALLOCATE_OUTPUT")
+    std::vector<int64_t> slice_sizes;
+    for (size_t i = 0; i < entries.size(); i++) {
+      auto& e = entries[i];
+      TensorShape single_slice_shape;
+      for (int d = 1; d < e.tensor->shape().dims(); d++) {
+        single_slice_shape.AddDim(e.tensor->shape().dim_size(d));
+      }
+      slice_sizes.push_back(single_slice_shape.num_elements() *
+                            DataTypeSize(e.tensor->dtype()));
+
+      int64_t total_dimension_size = 0;
+      for (int r = 0; r < size; r++) {
+        total_dimension_size += splits[(i * size + r) * size + rank];
+      }
+      TensorShape output_shape;
+      output_shape.AddDim(total_dimension_size);
+      output_shape.AppendShape(single_slice_shape);
+
+      status = e.context->AllocateOutput(output_shape, &e.output);
+      if (!status.ok()) {
+        for (auto it = entries.begin(); it != entries.end(); it++) {
+          timeline.End(it->tensor_name, nullptr);
+          it->callback(status);
+        }
+        return;
+      }
+    }
+    ACTIVITY_END_ALL(entries, timeline)
 
-    // On root rank, MPI_Bcast sends data, on other ranks it receives data.
-    void* data_ptr;
-    if (horovod_global.rank == e.root_rank) {
-      data_ptr = (void*)e.tensor->data();
+    if (entries.size() > 1) {
+      auto first_entry = entries[0];
+      auto& buffer = horovod_global.tensor_fusion_buffers[std::make_tuple(
+          first_entry.device, first_entry.context->framework())];
+      auto buffer_data = buffer->AccessData(first_entry.context);
+      MPI_CHECK(entries, "MPI_Alltoallv",
+                FusedAlltoall(process_set, entries, splits, slice_sizes,
+                              (uint8_t*)buffer_data))
     } else {
-      data_ptr = (void*)e.output->data();
+      auto e = entries[0];
+
+      ACTIVITY_START_ALL(entries, timeline, "MPI_ALLTOALL")
+      int64_t slice_elements =
+          slice_sizes[0] / DataTypeSize(e.tensor->dtype());
+      std::vector<int64_t> sendcounts(size);
+      std::vector<int64_t> recvcounts(size);
+      for (int r = 0; r < size; r++) {
+        sendcounts[r] = slice_elements * splits[rank * size + r];
+        recvcounts[r] = slice_elements * splits[r * size + rank];
+      }
+      MPI_CHECK(entries, "MPI_Alltoallv",
+                AlltoallvBuffer(e.tensor->data(), sendcounts,
+                                (void*)e.output->data(), recvcounts,
+                                e.tensor->dtype(), process_set.comm))
+      ACTIVITY_END_ALL(entries, timeline)
     }
 
-    ACTIVITY_START_ALL(entries, timeline, "MPI_BCAST")
-    MPI_CHECK(entries, "MPI_Bcast",
-              MPI_Bcast(data_ptr, (int)e.tensor->shape().num_elements(),
-                        GetMPIDataType(e.tensor), e.root_rank, MPI_COMM_WORLD))
-    ACTIVITY_END_ALL(entries, timeline)
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+      timeline.End(it->tensor_name, it->output);
+      it->callback(Status::OK());
+    }
+  } else if (response.response_type() == MPIResponse::ERROR) {
+    assert(entries.size() == 1);
+    auto e = entries[0];
+
+    status = Status::PreconditionError(response.error_message());
+    timeline.End(e.tensor_name, nullptr);
+    e.callback(status);
+  }
+}
+
+double Seconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double>(duration).count();
+}
+
+// Performs the operation of `response`, which all ranks of `process_set` are
+// ready to perform, and records its metrics. The queueing time of a tensor
+// ends, and its negotiation starts, when the background thread picks up its
+// request (see NegotiationStarted).
+void PerformOperation(ProcessSet& process_set, MPIResponse response) {
+  auto& tensor_table = process_set.tensor_table;
+  std::vector<TensorTableEntry> entries;
+  {
+    // Lock on the tensor table.
+    std::lock_guard<std::mutex> guard(horovod_global.mutex);
+
+    for (auto it = response.tensor_names().begin();
+         it != response.tensor_names().end(); it++) {
+      // We should never fail at finding this key in the tensor table.
+      auto name = *it;
+      auto iter = tensor_table.find(name);
+      assert(iter != tensor_table.end());
+
+      assert(response.response_type() == MPIResponse::ALLREDUCE ||
+             response.response_type() == MPIResponse::ALLGATHER ||
+             response.response_type() == MPIResponse::BROADCAST ||
+             response.response_type() == MPIResponse::ALLTOALL ||
+             response.response_type() == MPIResponse::ERROR);
+
+      entries.push_back(iter->second);
+
+      // Clear the tensor table of this tensor and its callbacks; the rest of
+      // this function takes care of it.
+      tensor_table.erase(iter);
+    }
+  }
+
+  bool fused = response.response_type() != MPIResponse::ERROR &&
+               UsesFusionBuffer(process_set, response, entries);
+  auto start = std::chrono::steady_clock::now();
+  ExecuteOperation(process_set, response, entries);
+  double execution_time = Seconds(std::chrono::steady_clock::now() - start);
+
+  auto& metrics = horovod_global.metrics;
+  int64_t num_bytes = 0;
+  for (auto& e : entries) {
+    auto negotiation_start = start;
+    auto it = process_set.negotiation_starts.find(e.tensor_name);
+    if (it != process_set.negotiation_starts.end()) {
+      negotiation_start = std::max(it->second, e.enqueue_time);
+      process_set.negotiation_starts.erase(it);
+    }
+    if (response.response_type() != MPIResponse::ERROR) {
+      metrics.RecordTensor(
+          e.tensor_name, e.tensor->size(),
+          response.response_type() == MPIResponse::ALLREDUCE,
+          Seconds(negotiation_start - e.enqueue_time),
+          Seconds(start - negotiation_start), execution_time);
+      num_bytes += e.tensor->size();
+    }
+  }
+  if (response.response_type() != MPIResponse::ERROR) {
+    metrics.RecordOperation(
+        num_bytes, execution_time,
+        fused ? horovod_global.tensor_fusion_threshold : 0);
+  }
+}
+
+// Returns the number of bytes that the tensor of `entry` occupies in the
+// fusion buffer when performing the operation of `response`, which must cover
+// only that tensor. For allgather, this is the size of the gathered output.
+// For alltoall, this is the largest size of the input plus the output on any
+// of the `size` ranks, so that all ranks fuse the same responses. For
+// sparsified allreduce, this is the size of the values and indices that every
+// rank selects, which FuseResponses converts to the size of the fusion buffer
+// that all ranks use (see TopKFusedSize).
+int64_t FusedTensorSize(const TensorTableEntry& entry,
+                        const MPIResponse& response, int size) {
+  auto response_type = response.response_type();
+  if (response_type == MPIResponse::ALLREDUCE && entry.top_k_ratio > 0) {
+    return TopKSelectionSize(entry);
+  }
+  if (response_type != MPIResponse::ALLGATHER &&
+      response_type != MPIResponse::ALLTOALL) {
+    return entry.tensor->size();
+  }
+  int64_t slice_size = DataTypeSize(entry.tensor->dtype());
+  for (int d = 1; d < entry.tensor->shape().dims(); d++) {
+    slice_size *= entry.tensor->shape().dim_size(d);
+  }
+  int64_t total_dimension_size = 0;
+  if (response_type == MPIResponse::ALLGATHER) {
+    for (auto dim : response.tensor_sizes()) {
+      total_dimension_size += dim;
+    }
+    return total_dimension_size * slice_size;
+  }
+  auto& splits = response.tensor_sizes();
+  for (int q = 0; q < size; q++) {
+    int64_t dimension_size = 0;
+    for (int r = 0; r < size; r++) {
+      dimension_size += splits[q * size + r] + splits[r * size + q];
+    }
+    total_dimension_size = std::max(total_dimension_size, dimension_size);
+  }
+  return total_dimension_size * slice_size;
+}
+
+// Fuses consecutive responses into responses covering multiple tensors, when
+// that is possible, as long as the fused tensors fit in the fusion buffer.
+// Allreduce responses are fused for tensors with the same data type and
+// devices, which are either all sparsified or all dense. Allgather, broadcast
+// and alltoall responses are fused for tensors that reside in host memory,
+// regardless of their data types, since they are communicated as bytes, but
+// broadcasts must have the same root rank. All ranks of `process_set` must
+// fuse the same responses in the same way.
+std::vector<MPIResponse> FuseResponses(HorovodGlobalState& state,
+                                       ProcessSet& process_set,
+                                       std::vector<MPIResponse> responses) {
+  std::vector<MPIResponse> fused_responses;
+  while (!responses.empty()) {
+    auto it = responses.begin();
+    MPIResponse response = *it;
+    assert(response.tensor_names().size() == 1);
+    it = responses.erase(it);
+
+    auto response_type = response.response_type();
+    bool fusable = response_type == MPIResponse::ALLREDUCE ||
+                   ((response_type == MPIResponse::ALLGATHER ||
+                     response_type == MPIResponse::BROADCAST ||
+                     response_type == MPIResponse::ALLTOALL) &&
+                    response.devices()[0] == CPU_DEVICE_ID);
+    if (fusable) {
+      // Attempt to add more responses to this fused response.
+      auto& entry = process_set.tensor_table[response.tensor_names()[0]];
+      int64_t tensor_size =
+          FusedTensorSize(entry, response, process_set.size);
+      bool sparsified =
+          response_type == MPIResponse::ALLREDUCE && entry.top_k_ratio > 0;
+      auto fused_size = [&process_set, sparsified](int64_t size) {
+        return sparsified ? TopKFusedSize(size, process_set.size) : size;
+      };
+
+      while (it != responses.end()) {
+        assert(it->tensor_names().size() == 1);
+        auto& new_entry = process_set.tensor_table[it->tensor_names()[0]];
+        int64_t new_tensor_size =
+            FusedTensorSize(new_entry, *it, process_set.size);
+
+        if (response_type == it->response_type() &&
+            response.devices() == it->devices() &&
+            (response_type != MPIResponse::ALLREDUCE ||
+             (entry.tensor->dtype() == new_entry.tensor->dtype() &&
+              (entry.top_k_ratio > 0) == (new_entry.top_k_ratio > 0))) &&
+            (response_type != MPIResponse::BROADCAST ||
+             entry.root_rank == new_entry.root_rank) &&
+            fused_size(tensor_size + new_tensor_size) <=
+                state.tensor_fusion_threshold) {
+          // These tensors will fuse together well.
+          tensor_size += new_tensor_size;
+          response.add_tensor_names(it->tensor_names()[0]);
+          for (auto dim : it->tensor_sizes()) {
+            response.add_tensor_sizes(dim);
+          }
+          it = responses.erase(it);
+        } else {
+          // Don't try to fuse additional tensors since they are usually
+          // computed in order of requests and skipping tensors may mean
+          // that the batch will have to wait longer while skipped tensors
+          // could be reduced at that time.
+          break;
+        }
+      }
+    }
+
+    fused_responses.push_back(std::move(response));
+  }
+  return fused_responses;
+}
+
+// Adds the tensors of a response received from the coordinator to the
+// response cache. Only allreduce and broadcast responses are cached, since
+// allgather responses depend on the first dimension sizes of the gathered
+// tensors, which typically change from step to step.
+void CacheResponse(ProcessSet& process_set, const MPIResponse& response) {
+  for (auto& name : response.tensor_names()) {
+    auto it = process_set.negotiated_requests.find(name);
+    if (it == process_set.negotiated_requests.end()) {
+      continue;
+    }
+    if (response.response_type() == MPIResponse::ALLREDUCE ||
+        response.response_type() == MPIResponse::BROADCAST) {
+      MPIResponse tensor_response;
+      tensor_response.set_response_type(response.response_type());
+      tensor_response.add_tensor_names(name);
+      tensor_response.set_devices(response.devices());
+      process_set.response_cache.put(tensor_response, it->second);
+    }
+    process_set.negotiated_requests.erase(it);
+  }
+}
+
+// Records that the background thread picked up `message` during the current
+// tick, unless it was already picked up during an earlier tick or by an
+// earlier step of this tick.
+void NegotiationStarted(const HorovodGlobalState& state,
+                        ProcessSet& process_set, const MPIRequest& message) {
+  process_set.negotiation_starts.emplace(message.tensor_name(),
+                                         state.last_cycle_start);
+}
+
+// Returns whether this rank should ask the other ranks of `process_set` to shut
+// down. Only process set zero negotiates shutdown, which stops the negotiation
+// of all process sets at once (see BackgroundThreadLoop).
+bool ShuttingDown(const HorovodGlobalState& state,
+                  const ProcessSet& process_set) {
+  return state.shut_down && process_set.id == 0;
+}
+
+#define CACHE_NO_UNCACHED_REQUESTS 1ULL
+#define CACHE_NO_SHUT_DOWN 2ULL
+
+// Negotiates the requests of `process_set` for tensors whose responses are
+// cached, without involving the coordinator, and performs the corresponding
+// operations.
+//
+// Each rank sets, in a bit vector, the cache bits of the cached tensors that
+// it is ready to process, as well as the cache bits of the tensors that it
+// requested with parameters that do not match the cached ones. The bit vector
+// is then allreduced, with a bitwise AND for the former bits (so that only
+// tensors that all ranks are ready to process remain set) and a bitwise OR for
+// the latter (so that mismatched responses get evicted on all ranks). In order
+// to use a single allreduce, the invalid bits are inverted and reduced with a
+// bitwise AND as well. The first word of the bit vector contains flags that
+// indicate whether any rank needs to communicate with the coordinator during
+// the current tick.
+//
+// On return, `message_queue` contains the requests that need to be negotiated
+// through the coordinator. Returns true if any rank needs to negotiate with the
+// coordinator during this tick, and false otherwise.
+bool NegotiateCachedRequests(HorovodGlobalState& state,
+                             ProcessSet& process_set,
+                             std::queue<MPIRequest>& message_queue,
+                             bool& performed_operations) {
+  auto& cache = process_set.response_cache;
+  auto num_words = (cache.capacity() + 63) / 64;
+  std::vector<uint64_t> bits(1 + 2 * num_words, 0);
+  uint64_t* hit_bits = bits.data() + 1;
+  uint64_t* valid_bits = bits.data() + 1 + num_words;
+  std::fill(valid_bits, valid_bits + num_words, ~0ULL);
+
+  std::queue<MPIRequest> uncached_queue;
+  while (!message_queue.empty()) {
+    MPIRequest message = message_queue.front();
+    message_queue.pop();
+    NegotiationStarted(state, process_set, message);
+    auto cache_state = cache.cached(message);
+    if (cache_state == ResponseCache::HIT) {
+      process_set.cached_requests[message.tensor_name()] = message;
+    } else {
+      if (cache_state == ResponseCache::INVALID) {
+        auto bit = cache.peek_cache_bit(message.tensor_name());
+        valid_bits[bit / 64] &= ~(1ULL << (bit % 64));
+      }
+      uncached_queue.push(message);
+    }
+  }
+
+  // Responses of previously cached requests may have been evicted since they
+  // were first checked, in which case they need to be negotiated again.
+  for (auto it = process_set.cached_requests.begin();
+       it != process_set.cached_requests.end();) {
+    if (cache.cached(it->second) == ResponseCache::HIT) {
+      auto bit = cache.peek_cache_bit(it->first);
+      hit_bits[bit / 64] |= 1ULL << (bit % 64);
+      it++;
+    } else {
+      uncached_queue.push(it->second);
+      it = process_set.cached_requests.erase(it);
+    }
+  }
+
+  if (uncached_queue.empty()) {
+    bits[0] |= CACHE_NO_UNCACHED_REQUESTS;
+  }
+  if (!ShuttingDown(state, process_set)) {
+    bits[0] |= CACHE_NO_SHUT_DOWN;
+  }
+
+  if (state.transport != nullptr) {
+    // If the transport failed, no tensor is processed from the cache, and the
+    // negotiation through the coordinator fails as well and shuts down.
+    if (!state.transport->BitwiseAndAllreduce(bits.data(),
+                                              (int64_t)bits.size())) {
+      std::fill(bits.begin(), bits.end(), 0ULL);
+    }
+  } else {
+    MPI_Allreduce(MPI_IN_PLACE, bits.data(), (int)bits.size(), MPI_UINT64_T,
+                  MPI_BAND, process_set.comm);
+  }
+
+  // Evict the responses that some rank found to be invalid, and negotiate any
+  // requests that were waiting on them through the coordinator.
+  bool invalidated = false;
+  for (uint32_t bit = 0; bit < cache.capacity(); bit++) {
+    if ((valid_bits[bit / 64] & (1ULL << (bit % 64))) == 0) {
+      cache.erase_response(bit);
+      invalidated = true;
+    }
+  }
+  if (invalidated) {
+    for (auto it = process_set.cached_requests.begin();
+         it != process_set.cached_requests.end();) {
+      if (cache.cached(it->second) != ResponseCache::HIT) {
+        uncached_queue.push(it->second);
+        it = process_set.cached_requests.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+
+  // Perform the operations for the cached tensors that all ranks are ready to
+  // process, in the order of their cache bits.
+  std::vector<MPIResponse> responses;
+  for (uint32_t bit = 0; bit < cache.capacity(); bit++) {
+    if ((hit_bits[bit / 64] & (1ULL << (bit % 64))) != 0) {
+      MPIResponse response = cache.get_response(bit);
+      process_set.cached_requests.erase(response.tensor_names()[0]);
+      responses.push_back(std::move(response));
+    }
+  }
+  state.metrics.RecordCacheHits((int64_t)responses.size());
+  auto fused_responses =
+      FuseResponses(state, process_set, std::move(responses));
+  for (auto& response : fused_responses) {
+    PerformOperation(process_set, response);
+  }
+  performed_operations = !fused_responses.empty();
+
+  std::swap(message_queue, uncached_queue);
+  return invalidated || (bits[0] & CACHE_NO_UNCACHED_REQUESTS) == 0 ||
+         (bits[0] & CACHE_NO_SHUT_DOWN) == 0;
+}
+
+// Report Tensors that were submitted to be reduced, gathered or broadcasted by
+// some ranks of `process_set` but not others and are waiting for long time to
+// get processed. Ranks are reported by their global rank.
+void CheckForStalledTensors(ProcessSet& process_set) {
+  bool preamble = false;
+  auto now = std::chrono::steady_clock::now();
+  auto& message_table = process_set.message_table;
+  for (auto it = message_table->begin(); it != message_table->end(); it++) {
+    auto tensor_name = it->first;
+    std::vector<MPIRequest>& messages = std::get<0>(it->second);
+    std::chrono::steady_clock::time_point start_at = std::get<1>(it->second);
+
+    if (now - start_at > STALL_WARNING_TIME) {
+      horovod_global.metrics.RecordStall(tensor_name);
+      if (!preamble) {
+        std::cerr << "WARNING: One or more tensors were submitted to be "
+                     "reduced, gathered or broadcasted by subset of ranks and "
+                     "are waiting for remainder of ranks for more than "
+                  << std::chrono::duration_cast<std::chrono::seconds>(
+                         STALL_WARNING_TIME)
+                         .count()
+                  << " seconds. ";
+        std::cerr << "This may indicate that different ranks are trying to "
+                     "submit different tensors or that only subset of ranks is "
+                     "submitting tensors, which will cause deadlock. ";
+        if (process_set.id != 0) {
+          std::cerr << "Stalled ops in process set " << process_set.id
+                    << ": ";
+        } else {
+          std::cerr << "Stalled ops: ";
+        }
+        preamble = true;
+      } else {
+        std::cerr << ", ";
+      }
+      std::cerr << tensor_name;
+      std::cerr << " [ready ranks:";
+      for (auto msg_iter = messages.begin(); msg_iter != messages.end();
+           msg_iter++) {
+        if (msg_iter == messages.begin()) {
+          std::cerr << " ";
+        } else {
+          std::cerr << ", ";
+        }
+        std::cerr << process_set.ranks[msg_iter->request_rank()];
+      }
+      std::cerr << "]";
+    }
+  }
+  if (preamble) {
+    std::cerr << std::endl;
+  }
+}
+
+// Number of round trips used to estimate the clock offset of each rank.
+#define CLOCK_SYNC_ROUND_TRIPS 10
+
+int64_t SteadyClockNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Returns the time point of this rank's steady clock that corresponds to the
+// current time of the coordinator's steady clock, so that the timelines of all
+// ranks can be aligned. Every rank estimates the offset of the coordinator's
+// clock as in NTP: it sends a message to the coordinator, which replies with
+// its current time, assuming that both messages took the same time. The round
+// trip with the smallest delay is used. Must be called by all ranks.
+//
+// Without MPI, clocks are assumed to be aligned already, which holds for ranks
+// that run on the same host.
+std::chrono::steady_clock::time_point
+AlignedTimelineStartTime(HorovodGlobalState& state) {
+  int64_t start_time = SteadyClockNanos();
+  BroadcastBuffer(&start_time, 1, HOROVOD_INT64, RANK_ZERO, MPI_COMM_WORLD);
+  if (state.transport != nullptr) {
+    return std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::nanoseconds(start_time)));
+  }
+
+  // Coordinator clock minus this rank's clock.
+  int64_t offset = 0;
+  if (state.rank == RANK_ZERO) {
+    for (int r = 1; r < state.size; r++) {
+      for (int i = 0; i < CLOCK_SYNC_ROUND_TRIPS; i++) {
+        int64_t request;
+        MPI_Recv(&request, 1, MPI_INT64_T, r, TAG_CLOCK, MPI_COMM_WORLD,
+                 MPI_STATUS_IGNORE);
+        int64_t now = SteadyClockNanos();
+        MPI_Send(&now, 1, MPI_INT64_T, r, TAG_CLOCK, MPI_COMM_WORLD);
+      }
+    }
+  } else {
+    int64_t min_delay = std::numeric_limits<int64_t>::max();
+    for (int i = 0; i < CLOCK_SYNC_ROUND_TRIPS; i++) {
+      int64_t sent = SteadyClockNanos();
+      int64_t coordinator_time;
+      MPI_Send(&sent, 1, MPI_INT64_T, RANK_ZERO, TAG_CLOCK, MPI_COMM_WORLD);
+      MPI_Recv(&coordinator_time, 1, MPI_INT64_T, RANK_ZERO, TAG_CLOCK,
+               MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      int64_t received = SteadyClockNanos();
+      if (received - sent < min_delay) {
+        min_delay = received - sent;
+        offset = coordinator_time - (sent + received) / 2;
+      }
+    }
+  }
+
+  return std::chrono::steady_clock::time_point(
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::nanoseconds(start_time - offset)));
+}
+
+// Lets the coordinator advance the autotuning of the tunable parameters, and
+// applies its current choice on all ranks. This must be called by all ranks at
+// the same point of the same tick, while tuning is in progress, so that all
+// ranks fuse responses and perform allreduces in the same way.
+void SynchronizeParameters(HorovodGlobalState& state) {
+  auto& manager = state.parameter_manager;
+  if (state.rank == RANK_ZERO) {
+    manager.Update(std::chrono::steady_clock::now());
+  }
+
+  auto& current = manager.parameters();
+  int64_t values[4] = {manager.active() ? 1 : 0, current.fusion_threshold,
+                       current.cycle_time_us,
+                       current.hierarchical_allreduce ? 1 : 0};
+  BroadcastBuffer(values, 4, HOROVOD_INT64, RANK_ZERO, MPI_COMM_WORLD);
+
+  TunableParameters parameters;
+  parameters.fusion_threshold = values[1];
+  parameters.cycle_time_us = values[2];
+  parameters.hierarchical_allreduce = values[3] != 0;
+  if (state.rank != RANK_ZERO) {
+    manager.SetParameters(parameters, values[0] != 0);
+  }
+
+  state.tensor_fusion_threshold = parameters.fusion_threshold;
+  state.cycle_time = std::chrono::microseconds(parameters.cycle_time_us);
+  state.hierarchical_allreduce = parameters.hierarchical_allreduce;
+}
+
+// Negotiates the requests of all ranks through the transport, when Horovod
+// runs without MPI and so `process_set` is process set zero, and performs the
+// corresponding operations. The protocol is
+// the same as with MPI (see BackgroundThreadLoop), except that the request
+// lists of all ranks are gathered by the coordinator in a single collective
+// operation, and that all the responses of a tick, followed by a DONE or
+// SHUTDOWN response, are broadcast at once. Returns true if the background
+// thread should shut down.
+bool NegotiateThroughTransport(HorovodGlobalState& state,
+                               ProcessSet& process_set,
+                               std::queue<MPIRequest>& message_queue,
+                               bool& performed_operations) {
+  auto transport = state.transport.get();
+  MPIRequestList message_list;
+  while (!message_queue.empty()) {
+    auto& message = message_queue.front();
+    NegotiationStarted(state, process_set, message);
+    process_set.negotiated_requests[message.tensor_name()] = message;
+    message_list.add_requests(message);
+    message_queue.pop();
+  }
+  message_list.set_shutdown(state.shut_down);
+  std::string encoded_message;
+  MPIRequestList::SerializeToString(message_list, encoded_message);
+  std::vector<std::string> encoded_messages;
+  bool success = transport->Gather(encoded_message, encoded_messages);
+
+  // Every response is preceded by its length.
+  std::string encoded_responses;
+  if (success && process_set.rank == RANK_ZERO) {
+    std::vector<std::string> ready_to_reduce;
+    for (auto& received_data : encoded_messages) {
+      MPIRequestList received_message_list;
+      MPIRequestList::ParseFromString(received_message_list, received_data);
+      for (auto& received_message : received_message_list.requests()) {
+        bool reduce = IncrementTensorCount(process_set.message_table,
+                                           received_message, process_set.size);
+        if (reduce) {
+          ready_to_reduce.push_back(received_message.tensor_name());
+        }
+      }
+      if (received_message_list.shutdown()) {
+        state.shut_down = true;
+      }
+    }
+
+    std::vector<MPIResponse> responses;
+    for (auto it = ready_to_reduce.begin(); it != ready_to_reduce.end();
+         it++) {
+      responses.push_back(ConstructMPIResponse(process_set.message_table, *it));
+    }
+    auto fused_responses =
+        FuseResponses(state, process_set, std::move(responses));
+    MPIResponse done_response;
+    done_response.set_response_type(state.shut_down ? MPIResponse::SHUTDOWN
+                                                    : MPIResponse::DONE);
+    fused_responses.push_back(std::move(done_response));
+    for (auto& response : fused_responses) {
+      std::string encoded_response;
+      MPIResponse::SerializeToString(response, encoded_response);
+      int64_t length = (int64_t)encoded_response.size();
+      encoded_responses.append((const char*)&length, sizeof(length));
+      encoded_responses.append(encoded_response);
+    }
+
+    // Check for stalled tensors.
+    if (std::chrono::steady_clock::now() - process_set.last_stall_check >
+        STALL_WARNING_TIME) {
+      CheckForStalledTensors(process_set);
+      process_set.last_stall_check = std::chrono::steady_clock::now();
+    }
+  }
+  success = success && transport->BroadcastString(encoded_responses, RANK_ZERO);
+  if (!success) {
+    std::cerr << "ERROR: Horovod failed to communicate with the other ranks "
+                 "through its transport. Shutting down." << std::endl;
+    return true;
+  }
+
+  size_t position = 0;
+  while (position < encoded_responses.size()) {
+    int64_t length;
+    std::memcpy(&length, encoded_responses.data() + position, sizeof(length));
+    position += sizeof(length);
+    MPIResponse response;
+    MPIResponse::ParseFromString(
+        response, encoded_responses.substr(position, (size_t)length));
+    position += (size_t)length;
+    if (response.response_type() == MPIResponse::DONE) {
+      break;
+    } else if (response.response_type() == MPIResponse::SHUTDOWN) {
+      return true;
+    }
+    CacheResponse(process_set, response);
+    PerformOperation(process_set, response);
+    performed_operations = true;
+  }
+  return false;
+}
+
+// Negotiates the requests of the ranks of `process_set` through its
+// coordinator using MPI, and performs the corresponding operations (see steps
+// a) through e) in BackgroundThreadLoop). Returns true if the background thread
+// should shut down.
+bool NegotiateThroughCoordinator(HorovodGlobalState& state,
+                                 ProcessSet& process_set,
+                                 std::queue<MPIRequest>& message_queue,
+                                 bool& performed_operations) {
+  bool is_coordinator = process_set.rank == RANK_ZERO;
+  int size = process_set.size;
+  MPI_Comm comm = process_set.comm;
+  auto& message_table = process_set.message_table;
+  bool should_shut_down = false;
+
+  // Collect all tensors that are ready to be reduced. Record them in the
+  // tensor count table (rank zero) or send them to rank zero to be
+  // recorded (everyone else).
+  std::vector<std::string> ready_to_reduce;
+  if (is_coordinator) {
+    while (!message_queue.empty()) {
+      // Pop the first available message message
+      MPIRequest message = message_queue.front();
+      message_queue.pop();
+      NegotiationStarted(state, process_set, message);
+      process_set.negotiated_requests[message.tensor_name()] = message;
+
+      bool reduce = IncrementTensorCount(message_table, message, size);
+      if (reduce) {
+        ready_to_reduce.push_back(message.tensor_name());
+      }
+    }
+  } else {
+    if (!message_queue.empty()) {
+      std::string encoded_message;
+      MPIRequestList message_list;
+      while (!message_queue.empty()) {
+        auto& message = message_queue.front();
+        NegotiationStarted(state, process_set, message);
+        process_set.negotiated_requests[message.tensor_name()] = message;
+        message_list.add_requests(message);
+        message_queue.pop();
+      }
+      MPIRequestList::SerializeToString(message_list, encoded_message);
+      MPI_Send(encoded_message.c_str(), (int)encoded_message.length() + 1,
+               MPI_BYTE, RANK_ZERO, TAG_NOTIFY, comm);
+    }
+  }
+
+  // Rank zero has put all its own tensors in the tensor count table.
+  // Now, it should count all the tensors that are coming from other
+  // ranks at this tick. It should keep getting tensors until it gets a
+  // DONE message from all the other ranks.
+  if (is_coordinator) {
+    // Count of DONE messages. Keep receiving messages until the number
+    // of messages is equal to the number of processes. Initialize to
+    // one since the coordinator is effectively done.
+    int completed_ranks = 1;
+    while (completed_ranks != size) {
+      MPI_Status status;
+      MPI_Probe(MPI_ANY_SOURCE, TAG_NOTIFY, comm, &status);
+
+      // Find number of characters in message (including zero byte).
+      int source_rank = status.MPI_SOURCE;
+      int msg_length;
+      MPI_Get_count(&status, MPI_BYTE, &msg_length);
+
+      // If the length is zero, this is a DONE message.
+      if (msg_length == 0) {
+        completed_ranks++;
+        MPI_Recv(NULL, 0, MPI_BYTE, source_rank, TAG_NOTIFY, comm, &status);
+        continue;
+      }
+
+      // Get tensor name from MPI into an std::string.
+      char* buffer = new char[msg_length];
+      MPI_Recv(buffer, msg_length, MPI_BYTE, source_rank, TAG_NOTIFY, comm,
+               &status);
+      std::string received_data(buffer, (size_t)msg_length);
+      delete[] buffer;
+
+      MPIRequestList received_message_list;
+      MPIRequestList::ParseFromString(received_message_list, received_data);
+      for (auto& received_message : received_message_list.requests()) {
+        auto received_name = received_message.tensor_name();
+
+        bool reduce =
+            IncrementTensorCount(message_table, received_message, size);
+        if (reduce) {
+          ready_to_reduce.push_back(received_name);
+        }
+      }
+      if (received_message_list.shutdown()) {
+        // Received SHUTDOWN request from one of the workers.
+        state.shut_down = true;
+      }
+    }
+
+    // At this point, rank zero should have a fully updated tensor count
+    // table and should know all the tensors that need to be reduced or
+    // gathered, and everyone else should have sent all their information
+    // to rank zero. We can now do reductions and gathers; rank zero will
+    // choose which ones and in what order, and will notify the other ranks
+    // before doing each reduction.
+    std::vector<MPIResponse> responses;
+    for (auto it = ready_to_reduce.begin(); it != ready_to_reduce.end();
+         it++) {
+      MPIResponse response = ConstructMPIResponse(message_table, *it);
+      responses.push_back(std::move(response));
+    }
+
+    auto fused_responses =
+        FuseResponses(state, process_set, std::move(responses));
+    performed_operations = !fused_responses.empty();
+    for (auto& response : fused_responses) {
+      CacheResponse(process_set, response);
+
+      // Notify all nodes which tensors we'd like to reduce at this step.
+      std::string encoded_response;
+      MPIResponse::SerializeToString(response, encoded_response);
+      for (int r = 1; r < size; r++) {
+        MPI_Send(encoded_response.c_str(), (int)encoded_response.length() + 1,
+                 MPI_BYTE, r, TAG_NOTIFY, comm);
+      }
+
+      // Perform the collective operation. All nodes should end up performing
+      // the same operation.
+      PerformOperation(process_set, response);
+    }
+
+    // Notify all nodes that we are done with the reductions for this tick.
+    MPIResponse done_response;
+    should_shut_down = ShuttingDown(state, process_set);
+    done_response.set_response_type(should_shut_down ? MPIResponse::SHUTDOWN
+                                                     : MPIResponse::DONE);
+    std::string encoded_response;
+    MPIResponse::SerializeToString(done_response, encoded_response);
+    for (int r = 1; r < size; r++) {
+      MPI_Send(encoded_response.c_str(), (int)encoded_response.length() + 1,
+               MPI_BYTE, r, TAG_NOTIFY, comm);
+    }
+
+    // Check for stalled tensors.
+    if (std::chrono::steady_clock::now() - process_set.last_stall_check >
+        STALL_WARNING_TIME) {
+      CheckForStalledTensors(process_set);
+      process_set.last_stall_check = std::chrono::steady_clock::now();
+    }
+  } else {
+    if (ShuttingDown(state, process_set)) {
+      // Send a SHUTDOWN request to the coordinator.
+      std::string encoded_message;
+      MPIRequestList shutdown_request;
+      shutdown_request.set_shutdown(true);
+      MPIRequestList::SerializeToString(shutdown_request, encoded_message);
+      MPI_Send(encoded_message.c_str(), (int)encoded_message.length() + 1,
+               MPI_BYTE, RANK_ZERO, TAG_NOTIFY, comm);
+    }
+
+    // Notify the coordinator that this node is done sending messages.
+    // A DONE message is encoded as a zero-length message.
+    MPI_Send(NULL, 0, MPI_BYTE, RANK_ZERO, TAG_NOTIFY, comm);
+
+    // Receive names for tensors to reduce from rank zero.
+    // Once we receive a empty DONE message, stop waiting for more names.
+    while (true) {
+      MPI_Status status;
+      MPI_Probe(0, TAG_NOTIFY, comm, &status);
+
+      // Find number of characters in message (including zero byte).
+      int msg_length;
+      MPI_Get_count(&status, MPI_BYTE, &msg_length);
+
+      // Get tensor name from MPI into an std::string.
+      char* buffer = new char[msg_length];
+      MPI_Recv(buffer, msg_length, MPI_BYTE, 0, TAG_NOTIFY, comm, &status);
+      std::string received_message(buffer, (size_t)msg_length);
+      delete[] buffer;
+
+      MPIResponse response;
+      MPIResponse::ParseFromString(response, received_message);
+      if (response.response_type() == MPIResponse::DONE) {
+        // No more messages this tick
+        break;
+      } else if (response.response_type() == MPIResponse::SHUTDOWN) {
+        // No more messages this tick, and the background thread should shut
+        // down
+        should_shut_down = true;
+        break;
+      } else {
+        // Process the current message
+        CacheResponse(process_set, response);
+        PerformOperation(process_set, response);
+        performed_operations = true;
+      }
+    }
+  }
+  return should_shut_down;
+}
+
+// Negotiates the requests of `process_set` during the current tick, and
+// performs the corresponding operations. Returns true if the background thread
+// should shut down.
+bool NegotiateProcessSet(HorovodGlobalState& state, ProcessSet& process_set,
+                         std::queue<MPIRequest>& message_queue,
+                         bool& performed_operations) {
+  // Process the requests for cached tensors, and skip the rest of this tick
+  // if no rank has any requests that need to go through the coordinator.
+  if (process_set.response_cache.capacity() > 0 &&
+      !NegotiateCachedRequests(state, process_set, message_queue,
+                               performed_operations)) {
+    return false;
+  }
+
+  bool performed_negotiated_operations = false;
+  bool should_shut_down =
+      state.transport != nullptr
+          ? NegotiateThroughTransport(state, process_set, message_queue,
+                                      performed_negotiated_operations)
+          : NegotiateThroughCoordinator(state, process_set, message_queue,
+                                        performed_negotiated_operations);
+  performed_operations =
+      performed_operations || performed_negotiated_operations;
+  return should_shut_down;
+}
+
+// Initializes MPI and the state that depends on it. `is_homogeneous` is set to
+// whether all nodes run the same number of ranks.
+void InitializeMPI(HorovodGlobalState& state, bool& is_homogeneous) {
+  // Initialize MPI. This must happen on the background thread, since not all
+  // MPI implementations support being called from multiple threads.
+  //
+  // We will ask for multiple threads, so other libraries like mpi4py can
+  // be used together with Horovod if multi-threaded MPI is installed.
+  int provided;
+  MPI_Init_thread(NULL, NULL, MPI_THREAD_MULTIPLE, &provided);
+
+  // Get MPI rank to determine if we are rank zero.
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  // Get MPI size to determine how many tensors to wait for before reducing.
+  int size;
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  // Determine local rank by querying the local communicator.
+  MPI_Comm local_comm;
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL,
+                      &local_comm);
+  int local_rank, local_size;
+  MPI_Comm_rank(local_comm, &local_rank);
+  MPI_Comm_size(local_comm, &local_size);
 
-    timeline.End(e.tensor_name, e.output);
-    e.callback(Status::OK());
-  } else if (response.response_type() == MPIResponse::ERROR) {
-    assert(entries.size() == 1);
-    auto e = entries[0];
+  // Create a communicator containing the ranks with the same local rank,
+  // across all nodes.
+  MPI_Comm cross_comm;
+  MPI_Comm_split(MPI_COMM_WORLD, local_rank, rank, &cross_comm);
+
+  // Check whether all nodes run the same number of ranks.
+  int local_size_bounds[2] = {local_size, -local_size};
+  MPI_Allreduce(MPI_IN_PLACE, local_size_bounds, 2, MPI_INT, MPI_MAX,
+                MPI_COMM_WORLD);
+  is_homogeneous = local_size_bounds[0] == -local_size_bounds[1];
+
+  state.local_comm = local_comm;
+  state.cross_comm = cross_comm;
+
+  // Create the MPI datatypes and sum operations for the 16-bit floating-point
+  // types. Both operations are commutative.
+  MPI_Type_contiguous(2, MPI_BYTE, &state.mpi_float16_t);
+  MPI_Type_commit(&state.mpi_float16_t);
+  MPI_Type_contiguous(2, MPI_BYTE, &state.mpi_bfloat16_t);
+  MPI_Type_commit(&state.mpi_bfloat16_t);
+  MPI_Op_create(&Float16Sum, 1, &state.mpi_float16_sum);
+  MPI_Op_create(&BFloat16Sum, 1, &state.mpi_bfloat16_sum);
 
-    status = Status::PreconditionError(response.error_message());
-    timeline.End(e.tensor_name, nullptr);
-    e.callback(status);
-  }
+  state.rank = rank;
+  state.local_rank = local_rank;
+  state.size = size;
+  state.local_size = local_size;
+  state.mpi_threads_supported = (provided == MPI_THREAD_MULTIPLE);
 }
 
-// Report Tensors that were submitted to be reduced, gathered or broadcasted by
-// some ranks but not others and are waiting for long time to get processed.
-void CheckForStalledTensors(HorovodGlobalState& state) {
-  bool preamble = false;
-  auto now = std::chrono::steady_clock::now();
-  for (auto it = state.message_table->begin(); it != state.message_table->end();
-       it++) {
-    auto tensor_name = it->first;
-    std::vector<MPIRequest>& messages = std::get<0>(it->second);
-    std::chrono::steady_clock::time_point start_at = std::get<1>(it->second);
+// Creates process set zero, which contains all ranks, followed by the process
+// sets that were requested when Horovod was initialized. Returns false and
+// sets `error` if a requested process set is invalid, in which case all ranks
+// fail alike, since they must all request the same process sets.
+bool CreateProcessSets(HorovodGlobalState& state, std::string& error) {
+  std::unique_ptr<ProcessSet> global_process_set(new ProcessSet());
+  global_process_set->comm = MPI_COMM_WORLD;
+  global_process_set->rank = state.rank;
+  global_process_set->size = state.size;
+  for (int r = 0; r < state.size; r++) {
+    global_process_set->ranks.push_back(r);
+  }
+  state.process_sets.push_back(std::move(global_process_set));
 
-    if (now - start_at > STALL_WARNING_TIME) {
-      if (!preamble) {
-        std::cerr << "WARNING: One or more tensors were submitted to be "
-                     "reduced, gathered or broadcasted by subset of ranks and "
-                     "are waiting for remainder of ranks for more than "
-                  << std::chrono::duration_cast<std::chrono::seconds>(
-                         STALL_WARNING_TIME)
-                         .count()
-                  << " seconds. ";
-        std::cerr << "This may indicate that different ranks are trying to "
-                     "submit different tensors or that only subset of ranks is "
-                     "submitting tensors, which will cause deadlock. ";
-        std::cerr << "Stalled ops: ";
-        preamble = true;
-      } else {
-        std::cerr << ", ";
-      }
-      std::cerr << tensor_name;
-      std::cerr << " [ready ranks:";
-      for (auto msg_iter = messages.begin(); msg_iter != messages.end();
-           msg_iter++) {
-        if (msg_iter == messages.begin()) {
-          std::cerr << " ";
-        } else {
-          std::cerr << ", ";
-        }
-        std::cerr << msg_iter->request_rank();
-      }
-      std::cerr << "]";
-    }
+  if (!state.requested_process_sets.empty() && state.transport != nullptr) {
+    error = "Process sets require MPI.";
+    return false;
   }
-  if (preamble) {
-    std::cerr << std::endl;
+  for (auto& requested_ranks : state.requested_process_sets) {
+    std::unique_ptr<ProcessSet> process_set(new ProcessSet());
+    process_set->id = (int32_t)state.process_sets.size();
+    auto& ranks = process_set->ranks;
+    ranks = requested_ranks;
+    std::sort(ranks.begin(), ranks.end());
+    if (ranks.empty() || ranks.front() < 0 || ranks.back() >= state.size ||
+        std::adjacent_find(ranks.begin(), ranks.end()) != ranks.end()) {
+      error = "Process set " + std::to_string(process_set->id) +
+              " must consist of distinct ranks between 0 and " +
+              std::to_string(state.size - 1) + ".";
+      return false;
+    }
+
+    // The ranks of the communicator are ordered by their global ranks, and so
+    // they match the positions of the global ranks in `ranks`.
+    auto position = std::lower_bound(ranks.begin(), ranks.end(), state.rank);
+    bool member = position != ranks.end() && *position == state.rank;
+    MPI_Comm_split(MPI_COMM_WORLD, member ? 0 : MPI_UNDEFINED, state.rank,
+                   &process_set->comm);
+    process_set->size = (int)ranks.size();
+    if (member) {
+      process_set->rank = (int)(position - ranks.begin());
+    }
+    state.process_sets.push_back(std::move(process_set));
   }
+  return true;
 }
 
 // The MPI background thread loop coordinates all the MPI processes and the
@@ -1164,43 +3315,122 @@ void CheckForStalledTensors(HorovodGlobalState& state) {
 //      response from the coordinator. At that point, the tick ends.
 //      If instead of "DONE" they receive "SHUTDOWN", they exit their background
 //      loop.
+//
+// Ticks are event-driven rather than polled at a fixed rate. A tick starts at
+// most HOROVOD_CYCLE_TIME milliseconds (5 by default) after the previous one
+// started, but an idle rank starts its next tick as soon as a new request is
+// enqueued, so that isolated collectives are negotiated immediately instead of
+// paying up to a full cycle of latency. While collectives keep flowing (i.e.,
+// the previous tick performed at least one operation), ranks wait for the full
+// cycle time instead, so that requests produced during back-propagation get
+// batched together and fused. Since the coordinator waits for a DONE message
+// from every rank, the slowest rank to start a tick still bounds the latency;
+// ranks that did not enqueue anything catch up after at most one cycle.
+//
+// Finally, most tensors are submitted with the same parameters on every
+// training step, and so the coordinator would construct the same responses
+// for them over and over again. Unless HOROVOD_CACHE_CAPACITY is set to zero,
+// the responses received from the coordinator are cached and at the start of
+// every tick the ranks negotiate cached tensors using a single bit vector
+// allreduce (see NegotiateCachedRequests). Steps a) through e) only happen in
+// ticks where at least one rank has a request that is not cached, or is
+// shutting down.
+//
+// Every process set is negotiated separately, among its own ranks and through
+// its own coordinator (its rank zero) and communicator. In every tick, each
+// rank negotiates the process sets that it belongs to in order of ID, so that
+// the negotiations of different process sets cannot deadlock. Process set zero
+// contains all ranks and comes first, and it is the only one that negotiates
+// shutting down. A process set without any requests costs its ranks a single
+// bit vector allreduce per tick.
+//
+// Note that, since process set zero is negotiated in every tick, every tick
+// still starts with a collective over all ranks, even when they only operate
+// on other process sets. The operations of a process set thus do not wait for
+// the operations of other process sets, but the ticks of all ranks remain
+// synchronized, and so a tick cannot start before the slowest rank of the job
+// starts it. Skipping process set zero on idle ticks would require the ranks to
+// agree on which ticks it is negotiated in, which needs that same collective,
+// and letting them disagree would deadlock ranks that wait for each other in
+// different process sets.
 void BackgroundThreadLoop(HorovodGlobalState& state) {
-  // Initialize MPI. This must happen on the background thread, since not all
-  // MPI implementations support being called from multiple threads.
-  //
-  // We will ask for multiple threads, so other libraries like mpi4py can
-  // be used together with Horovod if multi-threaded MPI is installed.
-  int provided;
-  MPI_Init_thread(NULL, NULL, MPI_THREAD_MULTIPLE, &provided);
-
-  // Get MPI rank to determine if we are rank zero.
-  int rank;
-  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  // Horovod runs without MPI if HOROVOD_TRANSPORT is set to "shm" or "tcp",
+  // in which case the launcher must set HOROVOD_RANK, HOROVOD_SIZE and
+  // HOROVOD_RENDEZVOUS_FILE on every rank (see Transport).
+  auto horovod_transport = std::getenv("HOROVOD_TRANSPORT");
+  bool is_homogeneous = false;
+  if (horovod_transport == nullptr || std::string(horovod_transport).empty() ||
+      std::string(horovod_transport) == "mpi") {
+    InitializeMPI(state, is_homogeneous);
+  } else {
+    auto horovod_rank = std::getenv("HOROVOD_RANK");
+    auto horovod_size = std::getenv("HOROVOD_SIZE");
+    auto horovod_rendezvous_file = std::getenv("HOROVOD_RENDEZVOUS_FILE");
+    int transport_rank = horovod_rank == nullptr ? 0 : std::atoi(horovod_rank);
+    int transport_size = horovod_size == nullptr ? 1 : std::atoi(horovod_size);
+    // Waits for other ranks fail after HOROVOD_TRANSPORT_TIMEOUT seconds
+    // without progress, so that a dead rank does not hang all other ranks.
+    auto horovod_transport_timeout = std::getenv("HOROVOD_TRANSPORT_TIMEOUT");
+    auto transport_timeout = std::chrono::seconds(
+        horovod_transport_timeout == nullptr
+            ? DEFAULT_TRANSPORT_TIMEOUT_SECONDS
+            : std::max(1, std::atoi(horovod_transport_timeout)));
+    std::string error;
+    state.transport = CreateTransport(
+        horovod_transport, transport_rank, transport_size,
+        horovod_rendezvous_file == nullptr ? "" : horovod_rendezvous_file,
+        transport_timeout, error);
+    if (state.transport == nullptr) {
+      std::cerr << "ERROR: Failed to initialize the Horovod "
+                << horovod_transport << " transport: " << error << std::endl;
+      std::abort();
+    }
+    state.rank = state.transport->rank();
+    state.local_rank = state.transport->local_rank();
+    state.size = state.transport->size();
+    state.local_size = state.transport->local_size();
+  }
+  int rank = state.rank;
+  int size = state.size;
+  int local_size = state.local_size;
   bool is_coordinator = rank == 0;
-
-  // Get MPI size to determine how many tensors to wait for before reducing.
-  int size;
-  MPI_Comm_size(MPI_COMM_WORLD, &size);
-
-  // Determine local rank by querying the local communicator.
-  MPI_Comm local_comm;
-  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL,
-                      &local_comm);
-  int local_rank, local_size;
-  MPI_Comm_rank(local_comm, &local_rank);
-  MPI_Comm_size(local_comm, &local_size);
-
-  state.rank = rank;
-  state.local_rank = local_rank;
-  state.size = size;
-  state.local_size = local_size;
-  state.mpi_threads_supported = (provided == MPI_THREAD_MULTIPLE);
+  std::string process_set_error;
+  if (!CreateProcessSets(state, process_set_error)) {
+    std::cerr << "ERROR: Failed to create the Horovod process sets: "
+              << process_set_error << std::endl;
+    std::abort();
+  }
   state.initialization_done = true;
 
-  // Open the timeline file on coordinator.
+  // Open the timeline file on coordinator. If HOROVOD_TIMELINE_ALL_RANKS is
+  // also set on the coordinator, every other rank writes its own timeline to
+  // the same file name followed by its rank, with timestamps aligned to the
+  // coordinator's clock.
   auto horovod_timeline = std::getenv("HOROVOD_TIMELINE");
+  auto horovod_timeline_all_ranks = std::getenv("HOROVOD_TIMELINE_ALL_RANKS");
+  std::string timeline_file;
+  int timeline_all_ranks = 0;
   if (is_coordinator && horovod_timeline != nullptr) {
-    state.timeline.Initialize(std::string(horovod_timeline));
+    timeline_file = horovod_timeline;
+    timeline_all_ranks = horovod_timeline_all_ranks != nullptr &&
+                         std::atoi(horovod_timeline_all_ranks) > 0;
+  }
+  BroadcastBuffer(&timeline_all_ranks, 1, HOROVOD_INT32, RANK_ZERO,
+                  MPI_COMM_WORLD);
+  if (timeline_all_ranks) {
+    int timeline_file_length = (int)timeline_file.size();
+    BroadcastBuffer(&timeline_file_length, 1, HOROVOD_INT32, RANK_ZERO,
+                    MPI_COMM_WORLD);
+    timeline_file.resize((size_t)timeline_file_length);
+    BroadcastBuffer(&timeline_file[0], timeline_file_length, HOROVOD_UINT8,
+                    RANK_ZERO, MPI_COMM_WORLD);
+    auto start_time = AlignedTimelineStartTime(state);
+    if (!is_coordinator) {
+      timeline_file += "." + std::to_string(rank);
+    }
+    state.timeline.Initialize(timeline_file, start_time);
+  } else if (is_coordinator && !timeline_file.empty()) {
+    state.timeline.Initialize(timeline_file);
   }
 
   // Override Tensor Fusion threshold, if it's set.
@@ -1208,235 +3438,208 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
   if (horovod_fusion_threshold != nullptr) {
     state.tensor_fusion_threshold = std::atol(horovod_fusion_threshold);
   }
+  state.fusion_buffer_size = state.tensor_fusion_threshold;
+
+  // Enable hierarchical allreduce, if requested.
+  auto horovod_hierarchical_allreduce =
+      std::getenv("HOROVOD_HIERARCHICAL_ALLREDUCE");
+  if (horovod_hierarchical_allreduce != nullptr &&
+      std::atoi(horovod_hierarchical_allreduce) > 0) {
+    if (is_homogeneous) {
+      state.hierarchical_allreduce = true;
+    } else if (is_coordinator) {
+      std::cerr << "WARNING: Hierarchical allreduce was requested, but it "
+                   "requires MPI and all nodes to run the same number of "
+                   "ranks. Falling back to flat allreduce." << std::endl;
+    }
+  }
 
-  // Initialize the tensor count table. No tensors are available yet.
-  if (is_coordinator) {
-    state.message_table = std::unique_ptr<MessageTable>(new MessageTable());
+  // Create the thread pool used for memory copies and local reductions. By
+  // default, the cores of each node are shared among its local ranks.
+  int num_threads = std::min(
+      4, std::max(1, (int)std::thread::hardware_concurrency() / local_size));
+  auto horovod_fusion_threads = std::getenv("HOROVOD_FUSION_THREADS");
+  if (horovod_fusion_threads != nullptr) {
+    num_threads = std::max(std::atoi(horovod_fusion_threads), 0);
   }
+  state.thread_pool.reset(new ThreadPool(num_threads));
 
-  // The coordinator sends a SHUTDOWN message to trigger shutdown.
-  bool should_shut_down = false;
-  do {
-    // This delay determines thread frequency and MPI message latency
-    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  // Override the fusion buffer chunk size, if it's set. A chunk size of zero
+  // disables pipelining.
+  auto horovod_fusion_chunk_size = std::getenv("HOROVOD_FUSION_CHUNK_SIZE");
+  if (horovod_fusion_chunk_size != nullptr) {
+    state.fusion_chunk_size = std::atol(horovod_fusion_chunk_size);
+  }
 
-    // Copy the data structures from global state under this lock.
-    // However, don't keep the lock for the rest of the loop, so that
-    // enqueued stream callbacks can continue.
-    std::queue<MPIRequest> message_queue;
-    {
-      std::lock_guard<std::mutex> guard(state.mutex);
-      while (!state.message_queue.empty()) {
-        MPIRequest message = state.message_queue.front();
-        state.message_queue.pop();
-        message_queue.push(message);
+  // Compress float32 tensors that reside in host memory to float16 or
+  // bfloat16 while allreducing them, if requested. This halves the amount of
+  // data that is communicated at the cost of precision, and must be set to the
+  // same value on all ranks.
+  auto horovod_compression = std::getenv("HOROVOD_COMPRESSION");
+  if (horovod_compression != nullptr) {
+    std::string compression(horovod_compression);
+    if (compression == "fp16") {
+      state.compression_type = HOROVOD_FLOAT16;
+    } else if (compression == "bf16") {
+      state.compression_type = HOROVOD_BFLOAT16;
+    } else if (!compression.empty() && compression != "none" &&
+               is_coordinator) {
+      std::cerr << "WARNING: Unknown HOROVOD_COMPRESSION value \""
+                << compression << "\". Supported values are \"fp16\", "
+                << "\"bf16\" and \"none\"." << std::endl;
+    }
+  }
+
+  // Allocate the shared memory buffers used for shared memory allreduce, if
+  // requested. Each local rank owns a buffer as large as the fusion buffer.
+  auto horovod_shared_memory_allreduce =
+      std::getenv("HOROVOD_SHARED_MEMORY_ALLREDUCE");
+  if (horovod_shared_memory_allreduce != nullptr &&
+      std::atoi(horovod_shared_memory_allreduce) > 0) {
+    if (local_size > 1 && is_homogeneous) {
+      void* shared_buffer;
+      MPI_Win_allocate_shared((MPI_Aint)state.tensor_fusion_threshold, 1,
+                              MPI_INFO_NULL, state.local_comm, &shared_buffer,
+                              &state.shared_window);
+      for (int r = 0; r < local_size; r++) {
+        MPI_Aint buffer_size;
+        int displacement_unit;
+        void* buffer;
+        MPI_Win_shared_query(state.shared_window, r, &buffer_size,
+                             &displacement_unit, &buffer);
+        state.shared_buffers.push_back((uint8_t*)buffer);
       }
+      state.shared_buffer_size = state.tensor_fusion_threshold;
+      MPI_Win_lock_all(MPI_MODE_NOCHECK, state.shared_window);
+    } else if (is_coordinator) {
+      std::cerr << "WARNING: Shared memory allreduce was requested, but it "
+                   "requires MPI, all nodes to run the same number of ranks "
+                   "and more than one rank per node. Falling back to regular "
+                   "allreduce." << std::endl;
     }
+  }
 
-    // Collect all tensors that are ready to be reduced. Record them in the
-    // tensor count table (rank zero) or send them to rank zero to be
-    // recorded (everyone else).
-    std::vector<std::string> ready_to_reduce;
-    if (is_coordinator) {
-      while (!message_queue.empty()) {
-        // Pop the first available message message
-        MPIRequest message = message_queue.front();
-        message_queue.pop();
+  // Override the cycle time (in milliseconds), if it's set. A cycle time of
+  // zero makes every rank tick continuously, which minimizes latency at the
+  // cost of keeping the background thread busy.
+  auto horovod_cycle_time = std::getenv("HOROVOD_CYCLE_TIME");
+  if (horovod_cycle_time != nullptr) {
+    state.cycle_time = std::chrono::microseconds(
+        (int64_t)(std::max(std::atof(horovod_cycle_time), 0.0) * 1000));
+  }
 
-        bool reduce = IncrementTensorCount(state.message_table, message, size);
-        if (reduce) {
-          ready_to_reduce.push_back(message.tensor_name());
-        }
-      }
-    } else {
-      if (!message_queue.empty()) {
-        std::string encoded_message;
-        MPIRequestList message_list;
-        while (!message_queue.empty()) {
-          message_list.add_requests(message_queue.front());
-          message_queue.pop();
-        }
-        MPIRequestList::SerializeToString(message_list, encoded_message);
-        MPI_Send(encoded_message.c_str(), (int)encoded_message.length() + 1,
-                 MPI_BYTE, RANK_ZERO, TAG_NOTIFY, MPI_COMM_WORLD);
-      }
-    }
-
-    // Rank zero has put all its own tensors in the tensor count table.
-    // Now, it should count all the tensors that are coming from other
-    // ranks at this tick. It should keep getting tensors until it gets a
-    // DONE message from all the other ranks.
-    if (is_coordinator) {
-      // Count of DONE messages. Keep receiving messages until the number
-      // of messages is equal to the number of processes. Initialize to
-      // one since the coordinator is effectively done.
-      int completed_ranks = 1;
-      while (completed_ranks != size) {
-        MPI_Status status;
-        MPI_Probe(MPI_ANY_SOURCE, TAG_NOTIFY, MPI_COMM_WORLD, &status);
-
-        // Find number of characters in message (including zero byte).
-        int source_rank = status.MPI_SOURCE;
-        int msg_length;
-        MPI_Get_count(&status, MPI_BYTE, &msg_length);
-
-        // If the length is zero, this is a DONE message.
-        if (msg_length == 0) {
-          completed_ranks++;
-          MPI_Recv(NULL, 0, MPI_BYTE, source_rank, TAG_NOTIFY, MPI_COMM_WORLD,
-                   &status);
-          continue;
-        }
+  // Set the response cache capacity. It must be the same on all ranks.
+  uint32_t cache_capacity = 1024;
+  auto horovod_cache_capacity = std::getenv("HOROVOD_CACHE_CAPACITY");
+  if (horovod_cache_capacity != nullptr) {
+    cache_capacity = (uint32_t)std::max(std::atol(horovod_cache_capacity), 0L);
+  }
+  for (auto& process_set : state.process_sets) {
+    process_set->response_cache.set_capacity(cache_capacity);
+  }
 
-        // Get tensor name from MPI into an std::string.
-        char* buffer = new char[msg_length];
-        MPI_Recv(buffer, msg_length, MPI_BYTE, source_rank, TAG_NOTIFY,
-                 MPI_COMM_WORLD, &status);
-        std::string received_data(buffer, (size_t)msg_length);
-        delete[] buffer;
-
-        MPIRequestList received_message_list;
-        MPIRequestList::ParseFromString(received_message_list, received_data);
-        for (auto& received_message : received_message_list.requests()) {
-          auto received_name = received_message.tensor_name();
-
-          bool reduce =
-              IncrementTensorCount(state.message_table, received_message, size);
-          if (reduce) {
-            ready_to_reduce.push_back(received_name);
-          }
-        }
-        if (received_message_list.shutdown()) {
-          // Received SHUTDOWN request from one of the workers.
-          state.shut_down = true;
-        }
-      }
+  // Tune the fusion threshold, the cycle time and hierarchical allreduce
+  // automatically while training runs, if requested. Parameters that were set
+  // explicitly are not tuned. Each candidate is measured over samples of
+  // HOROVOD_AUTOTUNE_SAMPLE_TIME seconds (1 by default), and the coordinator
+  // logs the chosen parameters, as well as the score of every candidate to
+  // HOROVOD_AUTOTUNE_LOG if it's set.
+  auto horovod_autotune = std::getenv("HOROVOD_AUTOTUNE");
+  if (horovod_autotune != nullptr && std::atoi(horovod_autotune) > 0) {
+    TunableParameters initial;
+    initial.fusion_threshold = state.tensor_fusion_threshold;
+    initial.cycle_time_us = state.cycle_time.count();
+    initial.hierarchical_allreduce = state.hierarchical_allreduce;
+
+    double sample_seconds = 1.0;
+    auto horovod_autotune_sample_time =
+        std::getenv("HOROVOD_AUTOTUNE_SAMPLE_TIME");
+    if (horovod_autotune_sample_time != nullptr) {
+      sample_seconds = std::max(std::atof(horovod_autotune_sample_time), 0.0);
+    }
+    auto horovod_autotune_log = std::getenv("HOROVOD_AUTOTUNE_LOG");
+    std::string log_file;
+    if (is_coordinator && horovod_autotune_log != nullptr) {
+      log_file = horovod_autotune_log;
+    }
 
-      // At this point, rank zero should have a fully updated tensor count
-      // table and should know all the tensors that need to be reduced or
-      // gathered, and everyone else should have sent all their information
-      // to rank zero. We can now do reductions and gathers; rank zero will
-      // choose which ones and in what order, and will notify the other ranks
-      // before doing each reduction.
-      std::vector<MPIResponse> responses;
-      for (auto it = ready_to_reduce.begin(); it != ready_to_reduce.end();
-           it++) {
-        MPIResponse response = ConstructMPIResponse(state.message_table, *it);
-        responses.push_back(std::move(response));
-      }
-
-      while (!responses.empty()) {
-        auto it = responses.begin();
-        MPIResponse response = *it;
-        assert(response.tensor_names().size() == 1);
-        it = responses.erase(it);
-
-        if (response.response_type() == MPIResponse::ResponseType::ALLREDUCE) {
-          // Attempt to add more responses to this fused response.
-          auto& entry = state.tensor_table[response.tensor_names()[0]];
-          int64_t tensor_size = entry.tensor->size();
-
-          while (it != responses.end()) {
-            assert(it->tensor_names().size() == 1);
-            auto& new_entry = state.tensor_table[it->tensor_names()[0]];
-            int64_t new_tensor_size = new_entry.tensor->size();
-
-            if (response.response_type() == it->response_type() &&
-                response.devices() == it->devices() &&
-                entry.tensor->dtype() == new_entry.tensor->dtype() &&
-                tensor_size + new_tensor_size <=
-                    state.tensor_fusion_threshold) {
-              // These tensors will fuse together well.
-              tensor_size += new_tensor_size;
-              response.add_tensor_names(it->tensor_names()[0]);
-              it = responses.erase(it);
-            } else {
-              // Don't try to fuse additional tensors since they are usually
-              // computed in order of requests and skipping tensors may mean
-              // that the batch will have to wait longer while skipped tensors
-              // could be reduced at that time.
-              break;
-            }
-          }
-        }
+    bool tune_hierarchical_allreduce = horovod_hierarchical_allreduce ==
+                                           nullptr &&
+                                       is_homogeneous && local_size > 1 &&
+                                       size > local_size;
+    state.parameter_manager.Initialize(
+        initial, horovod_fusion_threshold == nullptr,
+        horovod_cycle_time == nullptr, tune_hierarchical_allreduce,
+        sample_seconds, log_file);
+  }
 
-        // Notify all nodes which tensors we'd like to reduce at this step.
-        std::string encoded_response;
-        MPIResponse::SerializeToString(response, encoded_response);
-        for (int r = 1; r < size; r++) {
-          MPI_Send(encoded_response.c_str(), (int)encoded_response.length() + 1,
-                   MPI_BYTE, r, TAG_NOTIFY, MPI_COMM_WORLD);
-        }
+  // Initialize the tensor count tables of the process sets that this rank
+  // coordinates. No tensors are available yet.
+  for (auto& process_set : state.process_sets) {
+    if (process_set->rank == RANK_ZERO) {
+      process_set->message_table.reset(new MessageTable());
+    }
+  }
+
+  // The coordinator sends a SHUTDOWN message to trigger shutdown.
+  bool should_shut_down = false;
 
-        // Perform the collective operation. All nodes should end up performing
-        // the same operation.
-        PerformOperation(state.tensor_table, response);
+  // Whether the previous tick performed any collective operations.
+  bool previous_tick_busy = false;
+  state.last_cycle_start = std::chrono::steady_clock::now();
+  do {
+    // Copy the data structures from global state under this lock.
+    // However, don't keep the lock for the rest of the loop, so that
+    // enqueued stream callbacks can continue.
+    std::vector<std::queue<MPIRequest>> message_queues(
+        state.process_sets.size());
+    {
+      std::unique_lock<std::mutex> lock(state.mutex);
+
+      // Wait for the next tick. This delay determines thread frequency and
+      // MPI message latency.
+      auto next_cycle_start = state.last_cycle_start + state.cycle_time;
+      if (previous_tick_busy) {
+        state.message_queue_cv.wait_until(lock, next_cycle_start,
+                                          [&] { return state.shut_down; });
+      } else {
+        state.message_queue_cv.wait_until(lock, next_cycle_start, [&] {
+          return state.shut_down ||
+                 std::any_of(state.process_sets.begin(),
+                             state.process_sets.end(),
+                             [](const std::unique_ptr<ProcessSet>& set) {
+                               return !set->message_queue.empty();
+                             });
+        });
       }
+      state.last_cycle_start = std::chrono::steady_clock::now();
 
-      // Notify all nodes that we are done with the reductions for this tick.
-      MPIResponse done_response;
-      should_shut_down = state.shut_down;
-      done_response.set_response_type(should_shut_down ? MPIResponse::SHUTDOWN
-                                                       : MPIResponse::DONE);
-      std::string encoded_response;
-      MPIResponse::SerializeToString(done_response, encoded_response);
-      for (int r = 1; r < size; r++) {
-        MPI_Send(encoded_response.c_str(), (int)encoded_response.length() + 1,
-                 MPI_BYTE, r, TAG_NOTIFY, MPI_COMM_WORLD);
+      for (size_t i = 0; i < state.process_sets.size(); i++) {
+        std::swap(message_queues[i], state.process_sets[i]->message_queue);
       }
+    }
+
+    if (state.parameter_manager.active()) {
+      SynchronizeParameters(state);
+    }
 
-      // Check for stalled tensors.
-      if (std::chrono::steady_clock::now() - state.last_stall_check >
-          STALL_WARNING_TIME) {
-        CheckForStalledTensors(state);
-        state.last_stall_check = std::chrono::steady_clock::now();
+    // Negotiate the process sets that this rank belongs to, in order of ID.
+    // Process set zero comes first, and so all ranks stop at the same tick
+    // when it shuts down. This also synchronizes the ticks of all ranks (see
+    // the notes on process sets above).
+    previous_tick_busy = false;
+    for (auto& process_set : state.process_sets) {
+      if (process_set->rank < 0) {
+        continue;
       }
-    } else {
-      if (state.shut_down) {
-        // Send a SHUTDOWN request to the coordinator.
-        std::string encoded_message;
-        MPIRequestList shutdown_request;
-        shutdown_request.set_shutdown(true);
-        MPIRequestList::SerializeToString(shutdown_request, encoded_message);
-        MPI_Send(encoded_message.c_str(), (int)encoded_message.length() + 1,
-                 MPI_BYTE, RANK_ZERO, TAG_NOTIFY, MPI_COMM_WORLD);
-      }
-
-      // Notify the coordinator that this node is done sending messages.
-      // A DONE message is encoded as a zero-length message.
-      MPI_Send(NULL, 0, MPI_BYTE, RANK_ZERO, TAG_NOTIFY, MPI_COMM_WORLD);
-
-      // Receive names for tensors to reduce from rank zero.
-      // Once we receive a empty DONE message, stop waiting for more names.
-      while (true) {
-        MPI_Status status;
-        MPI_Probe(0, TAG_NOTIFY, MPI_COMM_WORLD, &status);
-
-        // Find number of characters in message (including zero byte).
-        int msg_length;
-        MPI_Get_count(&status, MPI_BYTE, &msg_length);
-
-        // Get tensor name from MPI into an std::string.
-        char* buffer = new char[msg_length];
-        MPI_Recv(buffer, msg_length, MPI_BYTE, 0, TAG_NOTIFY, MPI_COMM_WORLD,
-                 &status);
-        std::string received_message(buffer, (size_t)msg_length);
-        delete[] buffer;
-
-        MPIResponse response;
-        MPIResponse::ParseFromString(response, received_message);
-        if (response.response_type() == MPIResponse::DONE) {
-          // No more messages this tick
-          break;
-        } else if (response.response_type() == MPIResponse::SHUTDOWN) {
-          // No more messages this tick, and the background thread should shut
-          // down
-          should_shut_down = true;
-          break;
-        } else {
-          // Process the current message
-          PerformOperation(state.tensor_table, response);
-        }
+      bool performed_operations = false;
+      should_shut_down =
+          NegotiateProcessSet(state, *process_set,
+                              message_queues[process_set->id],
+                              performed_operations);
+      previous_tick_busy = previous_tick_busy || performed_operations;
+      if (should_shut_down) {
+        break;
       }
     }
   } while (!should_shut_down);
@@ -1454,39 +3657,106 @@ void BackgroundThreadLoop(HorovodGlobalState& state) {
   //#endif
 
   // Notify all outstanding operations that Horovod has been shut down
-  // and clear up the tensor table and message queue.
+  // and clear up the tensor tables and message queues.
   std::vector<StatusCallback> callbacks;
   {
     std::lock_guard<std::mutex> guard(state.mutex);
-    for (auto it = state.tensor_table.begin(); it != state.tensor_table.end();
-         it++) {
-      callbacks.emplace_back(it->second.callback);
-    }
-    state.tensor_table.clear();
-    while (!state.message_queue.empty()) {
-      state.message_queue.pop();
+    for (auto& process_set : state.process_sets) {
+      auto& tensor_table = process_set->tensor_table;
+      for (auto it = tensor_table.begin(); it != tensor_table.end(); it++) {
+        callbacks.emplace_back(it->second.callback);
+      }
+      tensor_table.clear();
+      while (!process_set->message_queue.empty()) {
+        process_set->message_queue.pop();
+      }
     }
   }
   for (auto it = callbacks.begin(); it != callbacks.end(); it++) {
     (*it)(SHUT_DOWN_ERROR);
   }
 
+  if (state.shared_window != MPI_WIN_NULL) {
+    MPI_Win_unlock_all(state.shared_window);
+    MPI_Win_free(&state.shared_window);
+  }
+  state.timeline.Shutdown();
+  if (state.transport != nullptr) {
+    state.transport.reset();
+    return;
+  }
+  MPI_Op_free(&state.mpi_float16_sum);
+  MPI_Op_free(&state.mpi_bfloat16_sum);
+  MPI_Type_free(&state.mpi_float16_t);
+  MPI_Type_free(&state.mpi_bfloat16_t);
+  MPI_Comm_free(&state.cross_comm);
+  MPI_Comm_free(&state.local_comm);
+  for (auto& process_set : state.process_sets) {
+    if (process_set->id != 0 && process_set->comm != MPI_COMM_NULL) {
+      MPI_Comm_free(&process_set->comm);
+    }
+  }
   MPI_Finalize();
 }
 
+// Returns true if `process_sets` are the process sets that Horovod was
+// initialized with, ignoring the order of the ranks within each of them.
+bool ProcessSetsMatch(const std::vector<std::vector<int>>& process_sets) {
+  if (process_sets.size() + 1 != horovod_global.process_sets.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < process_sets.size(); i++) {
+    auto ranks = process_sets[i];
+    std::sort(ranks.begin(), ranks.end());
+    if (ranks != horovod_global.process_sets[i + 1]->ranks) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Start Horovod background thread. Ensure that this is
 // only done once no matter how many times this function is called.
-void InitializeHorovodOnce() {
+// Returns false if Horovod was already initialized with process sets other
+// than `process_sets`, since they cannot be changed after initialization.
+bool InitializeHorovodOnce(
+    const std::vector<std::vector<int>>& process_sets = {},
+    bool check_process_sets = false) {
   // Ensure background thread is only started once.
   if (!horovod_global.initialize_flag.test_and_set()) {
+    horovod_global.requested_process_sets = process_sets;
     horovod_global.background_thread =
         std::thread(BackgroundThreadLoop, std::ref(horovod_global));
+    check_process_sets = false;
   }
 
   // Wait to ensure that the background thread has finished initializing MPI.
   while (!horovod_global.initialization_done) {
     std::this_thread::sleep_for(std::chrono::milliseconds(1));
   }
+  return !check_process_sets || ProcessSetsMatch(process_sets);
+}
+
+// Returns the process set with ID `process_set_id`, or null if it does not
+// exist or this rank does not belong to it. Process sets do not change after
+// initialization, and so they can be read without holding the mutex.
+ProcessSet* GetProcessSet(int process_set_id) {
+  if (!horovod_global.initialization_done || process_set_id < 0 ||
+      process_set_id >= (int)horovod_global.process_sets.size()) {
+    return nullptr;
+  }
+  ProcessSet* process_set = horovod_global.process_sets[process_set_id].get();
+  return process_set->rank >= 0 ? process_set : nullptr;
+}
+
+Status InvalidProcessSetError(int process_set_id) {
+  if (!horovod_global.initialization_done) {
+    return NOT_INITIALIZED_ERROR;
+  }
+  return Status::PreconditionError(
+      "Process set " + std::to_string(process_set_id) +
+      " does not exist or does not contain rank " +
+      std::to_string(horovod_global.rank) + ".");
 }
 
 } // namespace
@@ -1498,10 +3768,30 @@ Status CheckInitialized() {
   return Status::OK();
 }
 
+Status GetMetricsTensorNames(std::vector<std::string>& names) {
+  if (!horovod_global.initialization_done) {
+    return NOT_INITIALIZED_ERROR;
+  }
+  names = horovod_global.metrics.tensor_names();
+  return Status::OK();
+}
+
 extern "C" {
 
 void horovod_init() { InitializeHorovodOnce(); }
 
+bool horovod_init_with_process_sets(const int* process_set_ranks,
+                                    const int* process_set_sizes,
+                                    int num_process_sets) {
+  std::vector<std::vector<int>> process_sets;
+  for (int i = 0; i < num_process_sets; i++) {
+    process_sets.emplace_back(process_set_ranks,
+                              process_set_ranks + process_set_sizes[i]);
+    process_set_ranks += process_set_sizes[i];
+  }
+  return InitializeHorovodOnce(process_sets, true);
+}
+
 int horovod_rank() {
   if (!horovod_global.initialization_done) {
     return -1;
@@ -1536,6 +3826,71 @@ int horovod_mpi_threads_supported() {
   }
   return horovod_global.mpi_threads_supported ? 1 : 0;
 }
+
+int horovod_process_set_rank(int process_set_id) {
+  ProcessSet* process_set = GetProcessSet(process_set_id);
+  if (process_set == nullptr) {
+    return -1;
+  }
+  return process_set->rank;
+}
+
+int horovod_process_set_size(int process_set_id) {
+  if (!horovod_global.initialization_done || process_set_id < 0 ||
+      process_set_id >= (int)horovod_global.process_sets.size()) {
+    return -1;
+  }
+  return horovod_global.process_sets[process_set_id]->size;
+}
+
+int horovod_metrics(double* values, int num_values) {
+  if (!horovod_global.initialization_done) {
+    return -1;
+  }
+  auto metrics = horovod_global.metrics.aggregate();
+  double all_values[HOROVOD_NUM_METRICS];
+  all_values[HOROVOD_METRIC_TENSOR_OPERATIONS] =
+      (double)metrics.tensor_operations;
+  all_values[HOROVOD_METRIC_OPERATIONS] = (double)metrics.operations;
+  all_values[HOROVOD_METRIC_FUSED_OPERATIONS] =
+      (double)metrics.fused_operations;
+  all_values[HOROVOD_METRIC_BYTES] = (double)metrics.bytes;
+  all_values[HOROVOD_METRIC_BYTES_REDUCED] = (double)metrics.bytes_reduced;
+  all_values[HOROVOD_METRIC_QUEUEING_TIME] = metrics.queueing_time;
+  all_values[HOROVOD_METRIC_NEGOTIATION_TIME] = metrics.negotiation_time;
+  all_values[HOROVOD_METRIC_EXECUTION_TIME] = metrics.execution_time;
+  all_values[HOROVOD_METRIC_BANDWIDTH] = metrics.bandwidth();
+  all_values[HOROVOD_METRIC_FUSION_BUFFER_UTILIZATION] =
+      metrics.fusion_buffer_utilization();
+  all_values[HOROVOD_METRIC_STALL_EVENTS] = (double)metrics.stall_events;
+  all_values[HOROVOD_METRIC_CACHED_TENSOR_OPERATIONS] =
+      (double)metrics.cached_tensor_operations;
+  num_values = std::max(0, std::min(num_values, (int)HOROVOD_NUM_METRICS));
+  std::copy(all_values, all_values + num_values, values);
+  return num_values;
+}
+
+int horovod_tensor_metrics(const char* tensor_name, double* values,
+                           int num_values) {
+  TensorMetrics metrics;
+  if (!horovod_global.initialization_done ||
+      !horovod_global.metrics.tensor(tensor_name, metrics)) {
+    return -1;
+  }
+  double all_values[HOROVOD_NUM_TENSOR_METRICS];
+  all_values[HOROVOD_TENSOR_METRIC_OPERATIONS] = (double)metrics.operations;
+  all_values[HOROVOD_TENSOR_METRIC_BYTES] = (double)metrics.bytes;
+  all_values[HOROVOD_TENSOR_METRIC_QUEUEING_TIME] = metrics.queueing_time;
+  all_values[HOROVOD_TENSOR_METRIC_NEGOTIATION_TIME] =
+      metrics.negotiation_time;
+  all_values[HOROVOD_TENSOR_METRIC_EXECUTION_TIME] = metrics.execution_time;
+  all_values[HOROVOD_TENSOR_METRIC_STALL_EVENTS] =
+      (double)metrics.stall_events;
+  num_values =
+      std::max(0, std::min(num_values, (int)HOROVOD_NUM_TENSOR_METRICS));
+  std::copy(all_values, all_values + num_values, values);
+  return num_values;
+}
 }
 
 // MPI must be initialized and the background thread must be running before
@@ -1545,16 +3900,33 @@ Status EnqueueTensorAllreduce(std::shared_ptr<OpContext> context,
                               std::shared_ptr<Tensor> output,
                               std::shared_ptr<ReadyEvent> ready_event,
                               const std::string name, const int device,
+                              const float top_k_ratio,
+                              const int process_set_id,
                               StatusCallback callback) {
+  ProcessSet* process_set = GetProcessSet(process_set_id);
+  if (process_set == nullptr) {
+    return InvalidProcessSetError(process_set_id);
+  }
+
+  // Other tensors are always reduced densely. Indices of sparsified tensors
+  // are sent as int32 values.
+  auto dtype = tensor->dtype();
+  bool sparsify = top_k_ratio > 0 && top_k_ratio < 1 &&
+                  device == CPU_DEVICE_ID &&
+                  (dtype == HOROVOD_FLOAT32 || dtype == HOROVOD_FLOAT64) &&
+                  tensor->shape().num_elements() <=
+                      std::numeric_limits<int32_t>::max();
+
   MPIRequest message;
-  message.set_request_rank(horovod_global.rank);
+  message.set_request_rank(process_set->rank);
   message.set_tensor_name(name);
-  message.set_tensor_type(tensor->dtype());
+  message.set_tensor_type(dtype);
   message.set_device(device);
   message.set_request_type(MPIRequest::ALLREDUCE);
   for (int i = 0; i < tensor->shape().dims(); i++) {
     message.add_tensor_shape((int64_t)tensor->shape().dim_size(i));
   }
+  message.set_top_k_ratio(sparsify ? top_k_ratio : 0.0f);
 
   TensorTableEntry e;
   e.tensor_name = name;
@@ -1563,16 +3935,20 @@ Status EnqueueTensorAllreduce(std::shared_ptr<OpContext> context,
   e.output = output;
   e.ready_event = ready_event;
   e.device = device;
+  e.enqueue_time = std::chrono::steady_clock::now();
+  e.top_k_ratio = message.top_k_ratio();
   e.callback = callback;
 
-  std::lock_guard<std::mutex> guard(horovod_global.mutex);
-  if (!horovod_global.shut_down) {
-    horovod_global.tensor_table.emplace(name, std::move(e));
-    horovod_global.message_queue.push(message);
-    return Status::OK();
-  } else {
-    return SHUT_DOWN_ERROR;
+  {
+    std::lock_guard<std::mutex> guard(horovod_global.mutex);
+    if (horovod_global.shut_down) {
+      return SHUT_DOWN_ERROR;
+    }
+    process_set->tensor_table.emplace(name, std::move(e));
+    process_set->message_queue.push(message);
   }
+  horovod_global.message_queue_cv.notify_one();
+  return Status::OK();
 }
 
 // MPI must be initialized and the background thread must be running before
@@ -1581,9 +3957,15 @@ Status EnqueueTensorAllgather(std::shared_ptr<OpContext> context,
                               std::shared_ptr<Tensor> tensor,
                               std::shared_ptr<ReadyEvent> ready_event,
                               const std::string name, const int device,
+                              const int process_set_id,
                               StatusCallback callback) {
+  ProcessSet* process_set = GetProcessSet(process_set_id);
+  if (process_set == nullptr) {
+    return InvalidProcessSetError(process_set_id);
+  }
+
   MPIRequest message;
-  message.set_request_rank(horovod_global.rank);
+  message.set_request_rank(process_set->rank);
   message.set_tensor_name(name);
   message.set_tensor_type(tensor->dtype());
   message.set_device(device);
@@ -1598,16 +3980,19 @@ Status EnqueueTensorAllgather(std::shared_ptr<OpContext> context,
   e.tensor = tensor;
   e.ready_event = ready_event;
   e.device = device;
+  e.enqueue_time = std::chrono::steady_clock::now();
   e.callback = callback;
 
-  std::lock_guard<std::mutex> guard(horovod_global.mutex);
-  if (!horovod_global.shut_down) {
-    horovod_global.tensor_table.emplace(name, std::move(e));
-    horovod_global.message_queue.push(message);
-    return Status::OK();
-  } else {
-    return SHUT_DOWN_ERROR;
+  {
+    std::lock_guard<std::mutex> guard(horovod_global.mutex);
+    if (horovod_global.shut_down) {
+      return SHUT_DOWN_ERROR;
+    }
+    process_set->tensor_table.emplace(name, std::move(e));
+    process_set->message_queue.push(message);
   }
+  horovod_global.message_queue_cv.notify_one();
+  return Status::OK();
 }
 
 // MPI must be initialized and the background thread must be running before
@@ -1617,9 +4002,15 @@ Status EnqueueTensorBroadcast(std::shared_ptr<OpContext> context,
                               std::shared_ptr<Tensor> output, int root_rank,
                               std::shared_ptr<ReadyEvent> ready_event,
                               const std::string name, const int device,
+                              const int process_set_id,
                               StatusCallback callback) {
+  ProcessSet* process_set = GetProcessSet(process_set_id);
+  if (process_set == nullptr) {
+    return InvalidProcessSetError(process_set_id);
+  }
+
   MPIRequest message;
-  message.set_request_rank(horovod_global.rank);
+  message.set_request_rank(process_set->rank);
   message.set_tensor_name(name);
   message.set_tensor_type(tensor->dtype());
   message.set_root_rank(root_rank);
@@ -1637,16 +4028,65 @@ Status EnqueueTensorBroadcast(std::shared_ptr<OpContext> context,
   e.root_rank = root_rank;
   e.ready_event = ready_event;
   e.device = device;
+  e.enqueue_time = std::chrono::steady_clock::now();
   e.callback = callback;
 
-  std::lock_guard<std::mutex> guard(horovod_global.mutex);
-  if (!horovod_global.shut_down) {
-    horovod_global.tensor_table.emplace(name, std::move(e));
-    horovod_global.message_queue.push(message);
-    return Status::OK();
-  } else {
-    return SHUT_DOWN_ERROR;
+  {
+    std::lock_guard<std::mutex> guard(horovod_global.mutex);
+    if (horovod_global.shut_down) {
+      return SHUT_DOWN_ERROR;
+    }
+    process_set->tensor_table.emplace(name, std::move(e));
+    process_set->message_queue.push(message);
+  }
+  horovod_global.message_queue_cv.notify_one();
+  return Status::OK();
+}
+
+// MPI must be initialized and the background thread must be running before
+// this function is called.
+Status EnqueueTensorAlltoall(std::shared_ptr<OpContext> context,
+                             std::shared_ptr<Tensor> tensor,
+                             const std::vector<int64_t>& splits,
+                             std::shared_ptr<ReadyEvent> ready_event,
+                             const std::string name, const int device,
+                             const int process_set_id,
+                             StatusCallback callback) {
+  ProcessSet* process_set = GetProcessSet(process_set_id);
+  if (process_set == nullptr) {
+    return InvalidProcessSetError(process_set_id);
+  }
+
+  MPIRequest message;
+  message.set_request_rank(process_set->rank);
+  message.set_tensor_name(name);
+  message.set_tensor_type(tensor->dtype());
+  message.set_device(device);
+  message.set_request_type(MPIRequest::ALLTOALL);
+  for (int i = 0; i < tensor->shape().dims(); i++) {
+    message.add_tensor_shape((int64_t)tensor->shape().dim_size(i));
+  }
+  message.set_splits(splits);
+
+  TensorTableEntry e;
+  e.tensor_name = name;
+  e.context = context;
+  e.tensor = tensor;
+  e.ready_event = ready_event;
+  e.device = device;
+  e.enqueue_time = std::chrono::steady_clock::now();
+  e.callback = callback;
+
+  {
+    std::lock_guard<std::mutex> guard(horovod_global.mutex);
+    if (horovod_global.shut_down) {
+      return SHUT_DOWN_ERROR;
+    }
+    process_set->tensor_table.emplace(name, std::move(e));
+    process_set->message_queue.push(message);
   }
+  horovod_global.message_queue_cv.notify_one();
+  return Status::OK();
 }
 
 } // namespace common
@@ -34,11 +34,63 @@ typedef std::function<void(const Status&)> StatusCallback;
 // Check that Horovod is initialized.
 Status CheckInitialized();
 
+// Sets `names` to the names of the tensors for which horovod_tensor_metrics
+// returns metrics.
+Status GetMetricsTensorNames(std::vector<std::string>& names);
+
+// Indices of the metrics returned by horovod_metrics. Tensor operations count
+// every tensor separately, whereas operations count fused tensors once. Times
+// are in seconds and summed over all tensors, except for the execution time,
+// which is summed over all operations. The bandwidth is the number of bytes
+// processed per second of execution time, and the fusion buffer utilization
+// is the average fraction of the fusion threshold used by fused operations.
+// Cached tensor operations count the tensors whose responses were taken from
+// the response cache.
+enum HorovodMetric {
+  HOROVOD_METRIC_TENSOR_OPERATIONS = 0,
+  HOROVOD_METRIC_OPERATIONS = 1,
+  HOROVOD_METRIC_FUSED_OPERATIONS = 2,
+  HOROVOD_METRIC_BYTES = 3,
+  HOROVOD_METRIC_BYTES_REDUCED = 4,
+  HOROVOD_METRIC_QUEUEING_TIME = 5,
+  HOROVOD_METRIC_NEGOTIATION_TIME = 6,
+  HOROVOD_METRIC_EXECUTION_TIME = 7,
+  HOROVOD_METRIC_BANDWIDTH = 8,
+  HOROVOD_METRIC_FUSION_BUFFER_UTILIZATION = 9,
+  HOROVOD_METRIC_STALL_EVENTS = 10,
+  HOROVOD_METRIC_CACHED_TENSOR_OPERATIONS = 11,
+  HOROVOD_NUM_METRICS = 12
+};
+
+// Indices of the metrics returned by horovod_tensor_metrics. Times are in
+// seconds and summed over all operations on the tensor.
+enum HorovodTensorMetric {
+  HOROVOD_TENSOR_METRIC_OPERATIONS = 0,
+  HOROVOD_TENSOR_METRIC_BYTES = 1,
+  HOROVOD_TENSOR_METRIC_QUEUEING_TIME = 2,
+  HOROVOD_TENSOR_METRIC_NEGOTIATION_TIME = 3,
+  HOROVOD_TENSOR_METRIC_EXECUTION_TIME = 4,
+  HOROVOD_TENSOR_METRIC_STALL_EVENTS = 5,
+  HOROVOD_NUM_TENSOR_METRICS = 6
+};
+
 extern "C" {
 
 // C interface to initialize Horovod.
 void horovod_init();
 
+// C interface to initialize Horovod with additional process sets, i.e.,
+// subsets of the ranks that perform collective operations among themselves.
+// The i-th process set has ID i + 1 and consists of the next
+// `process_set_sizes[i]` ranks of `process_set_ranks`. Process set zero
+// always contains all ranks. Must be called by all ranks with the same
+// arguments. Returns false, without changing anything, if Horovod has already
+// been initialized with different process sets, including when it was
+// initialized by horovod_init() and process sets are requested now.
+bool horovod_init_with_process_sets(const int* process_set_ranks,
+                                    const int* process_set_sizes,
+                                    int num_process_sets);
+
 // C interface to get index of current Horovod process.
 // Returns -1 if Horovod is not initialized.
 int horovod_rank();
@@ -58,19 +110,55 @@ int horovod_local_size();
 // C interface to return flag indicating whether MPI multi-threading is
 // supported. Returns -1 if Horovod is not initialized.
 int horovod_mpi_threads_supported();
+
+// C interface to get the index of current Horovod process within a process
+// set. Returns -1 if Horovod is not initialized, if the process set does not
+// exist, or if the current process does not belong to it.
+int horovod_process_set_rank(int process_set_id);
+
+// C interface to return the number of Horovod processes in a process set.
+// Returns -1 if Horovod is not initialized or if the process set does not
+// exist.
+int horovod_process_set_size(int process_set_id);
+
+// C interface to get the metrics of the operations that this rank has
+// performed since Horovod was initialized. Writes the first `num_values`
+// metrics, indexed by HorovodMetric, to `values`, and returns the number of
+// metrics written. Returns -1 if Horovod is not initialized.
+int horovod_metrics(double* values, int num_values);
+
+// C interface to get the metrics of the operations that this rank has
+// performed on the tensor named `tensor_name`, indexed by
+// HorovodTensorMetric, in the same way as horovod_metrics. Stall events are
+// only recorded by the coordinators of the process sets. Returns -1 if
+// Horovod is not initialized or if no metrics were recorded for the tensor.
+int horovod_tensor_metrics(const char* tensor_name, double* values,
+                           int num_values);
 }
 
+// The following functions enqueue collective operations among the ranks of the
+// process set with ID `process_set_id`. Root ranks and splits refer to the
+// ranks within that process set.
+
+// If `top_k_ratio` is between zero and one, and the tensor is a float32 or
+// float64 tensor that resides in host memory, every rank only sends that
+// fraction of the elements of the tensor with the largest magnitudes, and
+// adds the elements that it did not send to the tensor with the same name the
+// next time it is reduced. All ranks must use the same ratio.
 Status EnqueueTensorAllreduce(std::shared_ptr<OpContext> context,
                               std::shared_ptr<Tensor> tensor,
                               std::shared_ptr<Tensor> output,
                               std::shared_ptr<ReadyEvent> ready_event,
                               const std::string name, const int device,
+                              const float top_k_ratio,
+                              const int process_set_id,
                               StatusCallback callback);
 
 Status EnqueueTensorAllgather(std::shared_ptr<OpContext> context,
                               std::shared_ptr<Tensor> tensor,
                               std::shared_ptr<ReadyEvent> ready_event,
                               const std::string name, const int device,
+                              const int process_set_id,
                               StatusCallback callback);
 
 Status EnqueueTensorBroadcast(std::shared_ptr<OpContext> context,
@@ -78,8 +166,20 @@ Status EnqueueTensorBroadcast(std::shared_ptr<OpContext> context,
                               std::shared_ptr<Tensor> output, int root_rank,
                               std::shared_ptr<ReadyEvent> ready_event,
                               const std::string name, const int device,
+                              const int process_set_id,
                               StatusCallback callback);
 
+// Sends `splits[r]` rows of `tensor` to every rank `r` of the process set, in
+// order of rank, and allocates an output containing the rows received from
+// every rank.
+Status EnqueueTensorAlltoall(std::shared_ptr<OpContext> context,
+                             std::shared_ptr<Tensor> tensor,
+                             const std::vector<int64_t>& splits,
+                             std::shared_ptr<ReadyEvent> ready_event,
+                             const std::string name, const int device,
+                             const int process_set_id,
+                             StatusCallback callback);
+
 } // namespace common
 } // namespace horovod
 
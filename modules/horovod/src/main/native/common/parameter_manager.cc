@@ -0,0 +1,204 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <algorithm>
+#include <iostream>
+
+#include "parameter_manager.h"
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+#define WARMUP_SAMPLES 1
+#define MEASURED_SAMPLES 2
+
+// Smallest candidate fusion threshold.
+#define MIN_FUSION_THRESHOLD (1 << 20)
+
+// Candidate cycle times, in microseconds.
+const int64_t CYCLE_TIMES[] = {1000, 2500, 5000, 10000, 20000};
+
+} // namespace
+
+void ParameterManager::Initialize(const TunableParameters& initial,
+                                  bool tune_fusion_threshold,
+                                  bool tune_cycle_time,
+                                  bool tune_hierarchical_allreduce,
+                                  double sample_seconds,
+                                  const std::string& log_file) {
+  current_ = initial;
+  best_ = initial;
+  sample_seconds_ = sample_seconds;
+
+  for (int d = 0; d < NUM_DIMENSIONS; d++) {
+    candidates_[d].clear();
+  }
+  if (tune_hierarchical_allreduce) {
+    candidates_[HIERARCHICAL_ALLREDUCE] = {0, 1};
+  }
+  if (tune_fusion_threshold) {
+    for (int64_t threshold = initial.fusion_threshold;
+         threshold >= MIN_FUSION_THRESHOLD; threshold /= 2) {
+      candidates_[FUSION_THRESHOLD].push_back(threshold);
+    }
+  }
+  if (tune_cycle_time) {
+    auto& cycle_times = candidates_[CYCLE_TIME];
+    cycle_times.assign(std::begin(CYCLE_TIMES), std::end(CYCLE_TIMES));
+    if (std::find(cycle_times.begin(), cycle_times.end(),
+                  initial.cycle_time_us) == cycle_times.end()) {
+      cycle_times.push_back(initial.cycle_time_us);
+    }
+  }
+
+  if (!log_file.empty()) {
+    log_.open(log_file, std::ios::out | std::ios::trunc);
+    log_ << "hierarchical_allreduce,fusion_threshold,cycle_time_ms,"
+            "bytes_per_second"
+         << std::endl;
+  }
+
+  // Start with the first candidate of the first parameter that is tuned.
+  active_ = true;
+  dimension_ = 0;
+  candidate_ = 0;
+  while (dimension_ < NUM_DIMENSIONS && candidates_[dimension_].size() < 2) {
+    dimension_++;
+  }
+  if (dimension_ == NUM_DIMENSIONS) {
+    active_ = false;
+    return;
+  }
+  SetValue(current_, dimension_, candidates_[dimension_][0]);
+  sample_ = 0;
+  sample_start_ = std::chrono::steady_clock::now();
+  sample_bytes_ = 0;
+  measured_bytes_ = 0;
+  measured_seconds_ = 0.0;
+}
+
+bool ParameterManager::active() const { return active_; }
+
+const TunableParameters& ParameterManager::parameters() const {
+  return current_;
+}
+
+void ParameterManager::RecordBytes(int64_t bytes) {
+  if (active_) {
+    sample_bytes_ += bytes;
+  }
+}
+
+bool ParameterManager::Update(std::chrono::steady_clock::time_point now) {
+  if (!active_) {
+    return false;
+  }
+
+  // Samples in which no collective operations were performed (e.g., while the
+  // model is being evaluated) are extended until some are.
+  double seconds = std::chrono::duration<double>(now - sample_start_).count();
+  if (seconds < sample_seconds_ || sample_bytes_ == 0) {
+    return false;
+  }
+  if (sample_ >= WARMUP_SAMPLES) {
+    measured_bytes_ += sample_bytes_;
+    measured_seconds_ += seconds;
+  }
+  sample_++;
+  sample_start_ = now;
+  sample_bytes_ = 0;
+  if (sample_ < WARMUP_SAMPLES + MEASURED_SAMPLES) {
+    return false;
+  }
+
+  double score = measured_bytes_ / measured_seconds_;
+  LogScore(score);
+  if (score > best_score_) {
+    best_score_ = score;
+    best_ = current_;
+  }
+  NextCandidate(now);
+  return true;
+}
+
+void ParameterManager::SetParameters(const TunableParameters& parameters,
+                                     bool active) {
+  current_ = parameters;
+  active_ = active;
+}
+
+void ParameterManager::SetValue(TunableParameters& parameters, int dimension,
+                                int64_t value) {
+  switch (dimension) {
+  case HIERARCHICAL_ALLREDUCE:
+    parameters.hierarchical_allreduce = value != 0;
+    break;
+  case FUSION_THRESHOLD:
+    parameters.fusion_threshold = value;
+    break;
+  case CYCLE_TIME:
+    parameters.cycle_time_us = value;
+    break;
+  }
+}
+
+void ParameterManager::NextCandidate(
+    std::chrono::steady_clock::time_point now) {
+  sample_ = 0;
+  sample_start_ = now;
+  sample_bytes_ = 0;
+  measured_bytes_ = 0;
+  measured_seconds_ = 0.0;
+
+  candidate_++;
+  if (candidate_ == candidates_[dimension_].size()) {
+    // Keep the best value of this parameter and move on to the next one.
+    best_score_ = -1.0;
+    candidate_ = 0;
+    do {
+      dimension_++;
+    } while (dimension_ < NUM_DIMENSIONS &&
+             candidates_[dimension_].size() < 2);
+  }
+
+  current_ = best_;
+  if (dimension_ == NUM_DIMENSIONS) {
+    active_ = false;
+    std::cerr << "INFO: Horovod autotuning finished. Fusion threshold: "
+              << current_.fusion_threshold << " bytes, cycle time: "
+              << current_.cycle_time_us / 1000.0 << " ms, hierarchical "
+              << "allreduce: "
+              << (current_.hierarchical_allreduce ? "on" : "off") << "."
+              << std::endl;
+    if (log_.is_open()) {
+      log_.close();
+    }
+    return;
+  }
+  SetValue(current_, dimension_, candidates_[dimension_][candidate_]);
+}
+
+void ParameterManager::LogScore(double score) {
+  if (log_.is_open()) {
+    log_ << (current_.hierarchical_allreduce ? 1 : 0) << ","
+         << current_.fusion_threshold << "," << current_.cycle_time_us / 1000.0
+         << "," << score << std::endl;
+  }
+}
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,115 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_PARAMETER_MANAGER_H
+#define HOROVOD_PARAMETER_MANAGER_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace horovod {
+namespace common {
+
+// Parameters of the background loop that can be tuned automatically.
+struct TunableParameters {
+  int64_t fusion_threshold = 0;
+  int64_t cycle_time_us = 0;
+  bool hierarchical_allreduce = false;
+};
+
+// A ParameterManager searches for the tunable parameters that maximize the
+// number of bytes processed per second by collective operations, while
+// training is running.
+//
+// The parameters are tuned one at a time, starting with hierarchical
+// allreduce, then the fusion threshold and finally the cycle time. Each
+// candidate value is applied for a warmup sample, which is discarded, followed
+// by a number of measured samples that each last at least the sample time and
+// include some collective operations. Once all the candidates of a parameter
+// have been measured, the best one is kept and the next parameter is tuned.
+//
+// Only the coordinator makes tuning decisions (via `Update`), which must then
+// be applied by all ranks at the same point of the same tick, since response
+// fusion and the allreduce algorithm must be identical on all ranks.
+class ParameterManager {
+public:
+  // Starts tuning from the `initial` parameters. Parameters whose `tune_*`
+  // flag is false keep their initial values. Candidate fusion thresholds never
+  // exceed the initial one, since the fusion buffers are sized accordingly. If
+  // `log_file` is not empty, the score of every candidate is appended to it.
+  void Initialize(const TunableParameters& initial, bool tune_fusion_threshold,
+                  bool tune_cycle_time, bool tune_hierarchical_allreduce,
+                  double sample_seconds, const std::string& log_file);
+
+  // Whether tuning is still in progress.
+  bool active() const;
+
+  // The parameters that should currently be used.
+  const TunableParameters& parameters() const;
+
+  // Records that collective operations processed `bytes` more bytes.
+  void RecordBytes(int64_t bytes);
+
+  // Advances tuning at the start of a tick. Returns true if the parameters
+  // changed.
+  bool Update(std::chrono::steady_clock::time_point now);
+
+  // Applies the parameters chosen by the coordinator, on the other ranks.
+  void SetParameters(const TunableParameters& parameters, bool active);
+
+private:
+  enum Dimension {
+    HIERARCHICAL_ALLREDUCE = 0,
+    FUSION_THRESHOLD = 1,
+    CYCLE_TIME = 2,
+    NUM_DIMENSIONS = 3
+  };
+
+  void SetValue(TunableParameters& parameters, int dimension, int64_t value);
+
+  // Moves on to the next candidate, or to the next parameter once all the
+  // candidates of the current one have been measured.
+  void NextCandidate(std::chrono::steady_clock::time_point now);
+
+  void LogScore(double score);
+
+  bool active_ = false;
+  TunableParameters current_;
+  TunableParameters best_;
+  double best_score_ = -1.0;
+
+  // Candidate values of each parameter. Parameters that are not tuned have no
+  // candidates.
+  std::vector<int64_t> candidates_[NUM_DIMENSIONS];
+  int dimension_ = 0;
+  size_t candidate_ = 0;
+
+  double sample_seconds_ = 1.0;
+  int sample_ = 0;
+  std::chrono::steady_clock::time_point sample_start_;
+  int64_t sample_bytes_ = 0;
+  int64_t measured_bytes_ = 0;
+  double measured_seconds_ = 0.0;
+
+  std::ofstream log_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_PARAMETER_MANAGER_H
@@ -0,0 +1,559 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "reduction.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HOROVOD_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+template <typename T>
+void SumIntoScalar(T* dst, const T* src, int64_t num_elements) {
+  for (int64_t i = 0; i < num_elements; i++) {
+    dst[i] += src[i];
+  }
+}
+
+void OrInto(bool* dst, const bool* src, int64_t num_elements) {
+  for (int64_t i = 0; i < num_elements; i++) {
+    dst[i] = dst[i] || src[i];
+  }
+}
+
+// Number of elements of 16-bit floating-point types that are converted to
+// float32 at once when adding them without SIMD instructions.
+#define HALF_BLOCK_SIZE 256
+
+// The following conversions between float32 and float16 handle subnormal
+// numbers, infinities and NaNs, and round to the nearest even value. They are
+// based on the public domain implementations by Fabian Giesen.
+uint16_t FloatToHalf(float value) {
+  const uint32_t float_infinity = 255u << 23;
+  const uint32_t half_overflow = (127u + 16u) << 23;
+  const uint32_t subnormal_magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  uint32_t sign = bits & 0x80000000u;
+  bits ^= sign;
+
+  uint16_t result;
+  if (bits >= half_overflow) {
+    // Infinities and NaNs, as well as values that overflow to infinity.
+    result = bits > float_infinity ? 0x7E00 : 0x7C00;
+  } else if (bits < (113u << 23)) {
+    // Values that become subnormal (or zero) in float16. Adding the magic
+    // number lets the floating-point unit do the rounding.
+    float magic;
+    std::memcpy(&magic, &subnormal_magic, sizeof(magic));
+    float shifted;
+    std::memcpy(&shifted, &bits, sizeof(shifted));
+    shifted += magic;
+    std::memcpy(&bits, &shifted, sizeof(bits));
+    result = (uint16_t)(bits - subnormal_magic);
+  } else {
+    uint32_t mantissa_odd = (bits >> 13) & 1;
+    bits += ((uint32_t)(15 - 127) << 23) + 0xFFF;
+    bits += mantissa_odd;
+    result = (uint16_t)(bits >> 13);
+  }
+  return (uint16_t)(result | (sign >> 16));
+}
+
+float HalfToFloat(uint16_t value) {
+  const uint32_t shifted_exponent = 0x7C00u << 13;
+  const uint32_t subnormal_magic = 113u << 23;
+
+  uint32_t bits = ((uint32_t)value & 0x7FFF) << 13;
+  uint32_t exponent = shifted_exponent & bits;
+  bits += (127u - 15u) << 23;
+  if (exponent == shifted_exponent) {
+    // Infinities and NaNs.
+    bits += (128u - 16u) << 23;
+  } else if (exponent == 0) {
+    // Zeros and subnormal numbers.
+    bits += 1u << 23;
+    float magic;
+    std::memcpy(&magic, &subnormal_magic, sizeof(magic));
+    float normalized;
+    std::memcpy(&normalized, &bits, sizeof(normalized));
+    normalized -= magic;
+    std::memcpy(&bits, &normalized, sizeof(bits));
+  }
+  bits |= ((uint32_t)value & 0x8000) << 16;
+
+  float result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+uint16_t FloatToBFloat16(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+    // Keep NaNs quiet, since rounding could turn them into infinities.
+    return (uint16_t)((bits >> 16) | 0x0040);
+  }
+  bits += 0x7FFF + ((bits >> 16) & 1);
+  return (uint16_t)(bits >> 16);
+}
+
+float BFloat16ToFloat(uint16_t value) {
+  uint32_t bits = (uint32_t)value << 16;
+  float result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+void ConvertFromFloatScalar(MPIDataType dtype, uint16_t* dst, const float* src,
+                            int64_t num_elements) {
+  if (dtype == HOROVOD_FLOAT16) {
+    for (int64_t i = 0; i < num_elements; i++) {
+      dst[i] = FloatToHalf(src[i]);
+    }
+  } else {
+    for (int64_t i = 0; i < num_elements; i++) {
+      dst[i] = FloatToBFloat16(src[i]);
+    }
+  }
+}
+
+void ConvertToFloatScalar(MPIDataType dtype, float* dst, const uint16_t* src,
+                          int64_t num_elements) {
+  if (dtype == HOROVOD_FLOAT16) {
+    for (int64_t i = 0; i < num_elements; i++) {
+      dst[i] = HalfToFloat(src[i]);
+    }
+  } else {
+    for (int64_t i = 0; i < num_elements; i++) {
+      dst[i] = BFloat16ToFloat(src[i]);
+    }
+  }
+}
+
+void SumIntoHalfScalar(MPIDataType dtype, uint16_t* dst, const uint16_t* src,
+                       int64_t num_elements) {
+  float dst_block[HALF_BLOCK_SIZE];
+  float src_block[HALF_BLOCK_SIZE];
+  for (int64_t i = 0; i < num_elements; i += HALF_BLOCK_SIZE) {
+    int64_t n = std::min((int64_t)HALF_BLOCK_SIZE, num_elements - i);
+    ConvertToFloatScalar(dtype, dst_block, dst + i, n);
+    ConvertToFloatScalar(dtype, src_block, src + i, n);
+    SumIntoScalar(dst_block, src_block, n);
+    ConvertFromFloatScalar(dtype, dst + i, dst_block, n);
+  }
+}
+
+#if HOROVOD_X86_SIMD
+// The AVX kernels are compiled for AVX regardless of the compiler flags and
+// are only used if the CPU supports AVX, which is checked at runtime.
+__attribute__((target("avx"))) void
+SumIntoFloatAVX(float* dst, const float* src, int64_t num_elements) {
+  int64_t i = 0;
+  for (; i + 8 <= num_elements; i += 8) {
+    __m256 a = _mm256_loadu_ps(dst + i);
+    __m256 b = _mm256_loadu_ps(src + i);
+    _mm256_storeu_ps(dst + i, _mm256_add_ps(a, b));
+  }
+  SumIntoScalar(dst + i, src + i, num_elements - i);
+}
+
+__attribute__((target("avx"))) void
+SumIntoDoubleAVX(double* dst, const double* src, int64_t num_elements) {
+  int64_t i = 0;
+  for (; i + 4 <= num_elements; i += 4) {
+    __m256d a = _mm256_loadu_pd(dst + i);
+    __m256d b = _mm256_loadu_pd(src + i);
+    _mm256_storeu_pd(dst + i, _mm256_add_pd(a, b));
+  }
+  SumIntoScalar(dst + i, src + i, num_elements - i);
+}
+
+bool CpuSupportsAVX() {
+  static const bool supported = __builtin_cpu_supports("avx");
+  return supported;
+}
+
+// float16 values are converted using the F16C instructions.
+__attribute__((target("avx,f16c"))) void
+ConvertFromFloatF16C(uint16_t* dst, const float* src, int64_t num_elements) {
+  int64_t i = 0;
+  for (; i + 8 <= num_elements; i += 8) {
+    __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(src + i),
+                                   _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128((__m128i*)(dst + i), half);
+  }
+  ConvertFromFloatScalar(HOROVOD_FLOAT16, dst + i, src + i, num_elements - i);
+}
+
+__attribute__((target("avx,f16c"))) void
+ConvertToFloatF16C(float* dst, const uint16_t* src, int64_t num_elements) {
+  int64_t i = 0;
+  for (; i + 8 <= num_elements; i += 8) {
+    __m128i half = _mm_loadu_si128((const __m128i*)(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(half));
+  }
+  ConvertToFloatScalar(HOROVOD_FLOAT16, dst + i, src + i, num_elements - i);
+}
+
+__attribute__((target("avx,f16c"))) void
+SumIntoHalfF16C(uint16_t* dst, const uint16_t* src, int64_t num_elements) {
+  int64_t i = 0;
+  for (; i + 8 <= num_elements; i += 8) {
+    __m256 a = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(dst + i)));
+    __m256 b = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i)));
+    __m128i sum =
+        _mm256_cvtps_ph(_mm256_add_ps(a, b), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128((__m128i*)(dst + i), sum);
+  }
+  SumIntoHalfScalar(HOROVOD_FLOAT16, dst + i, src + i, num_elements - i);
+}
+
+bool CpuSupportsF16C() {
+  static const bool supported =
+      __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+  return supported;
+}
+
+// bfloat16 values are the upper halves of float32 values, and so they are
+// converted using AVX2 integer instructions.
+__attribute__((target("avx2"))) inline __m256
+BFloat16ToFloatAVX2(const uint16_t* src) {
+  __m256i bits = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)src));
+  return _mm256_castsi256_ps(_mm256_slli_epi32(bits, 16));
+}
+
+__attribute__((target("avx2"))) inline void
+FloatToBFloat16AVX2(uint16_t* dst, __m256 value) {
+  __m256i bits = _mm256_castps_si256(value);
+  __m256i odd = _mm256_and_si256(_mm256_srli_epi32(bits, 16),
+                                 _mm256_set1_epi32(1));
+  __m256i rounded = _mm256_add_epi32(
+      bits, _mm256_add_epi32(odd, _mm256_set1_epi32(0x7FFF)));
+  // Keep NaNs quiet, since rounding could turn them into infinities.
+  __m256i nan = _mm256_or_si256(bits, _mm256_set1_epi32(0x00400000));
+  __m256 is_nan = _mm256_cmp_ps(value, value, _CMP_UNORD_Q);
+  bits = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(rounded),
+                                              _mm256_castsi256_ps(nan), is_nan));
+  bits = _mm256_srli_epi32(bits, 16);
+  __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(bits),
+                                    _mm256_extracti128_si256(bits, 1));
+  _mm_storeu_si128((__m128i*)dst, packed);
+}
+
+__attribute__((target("avx2"))) void
+ConvertFromFloatAVX2(uint16_t* dst, const float* src, int64_t num_elements) {
+  int64_t i = 0;
+  for (; i + 8 <= num_elements; i += 8) {
+    FloatToBFloat16AVX2(dst + i, _mm256_loadu_ps(src + i));
+  }
+  ConvertFromFloatScalar(HOROVOD_BFLOAT16, dst + i, src + i, num_elements - i);
+}
+
+__attribute__((target("avx2"))) void
+ConvertToFloatAVX2(float* dst, const uint16_t* src, int64_t num_elements) {
+  int64_t i = 0;
+  for (; i + 8 <= num_elements; i += 8) {
+    _mm256_storeu_ps(dst + i, BFloat16ToFloatAVX2(src + i));
+  }
+  ConvertToFloatScalar(HOROVOD_BFLOAT16, dst + i, src + i, num_elements - i);
+}
+
+__attribute__((target("avx2"))) void
+SumIntoBFloat16AVX2(uint16_t* dst, const uint16_t* src, int64_t num_elements) {
+  int64_t i = 0;
+  for (; i + 8 <= num_elements; i += 8) {
+    __m256 sum = _mm256_add_ps(BFloat16ToFloatAVX2(dst + i),
+                               BFloat16ToFloatAVX2(src + i));
+    FloatToBFloat16AVX2(dst + i, sum);
+  }
+  SumIntoHalfScalar(HOROVOD_BFLOAT16, dst + i, src + i, num_elements - i);
+}
+
+bool CpuSupportsAVX2() {
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+}
+#endif
+
+void SumIntoHalf(MPIDataType dtype, uint16_t* dst, const uint16_t* src,
+                 int64_t num_elements) {
+#if HOROVOD_X86_SIMD
+  if (dtype == HOROVOD_FLOAT16 && CpuSupportsF16C()) {
+    SumIntoHalfF16C(dst, src, num_elements);
+    return;
+  }
+  if (dtype == HOROVOD_BFLOAT16 && CpuSupportsAVX2()) {
+    SumIntoBFloat16AVX2(dst, src, num_elements);
+    return;
+  }
+#endif
+  SumIntoHalfScalar(dtype, dst, src, num_elements);
+}
+
+void SumIntoFloat(float* dst, const float* src, int64_t num_elements) {
+#if HOROVOD_X86_SIMD
+  if (CpuSupportsAVX()) {
+    SumIntoFloatAVX(dst, src, num_elements);
+    return;
+  }
+#endif
+  SumIntoScalar(dst, src, num_elements);
+}
+
+void SumIntoDouble(double* dst, const double* src, int64_t num_elements) {
+#if HOROVOD_X86_SIMD
+  if (CpuSupportsAVX()) {
+    SumIntoDoubleAVX(dst, src, num_elements);
+    return;
+  }
+#endif
+  SumIntoScalar(dst, src, num_elements);
+}
+
+template <typename T> T Magnitude(T value) {
+  return std::isnan(value) ? std::numeric_limits<T>::infinity()
+                           : std::abs(value);
+}
+
+// Number of evenly spaced elements from which ExtractTopK estimates a lower
+// bound of the k-th largest magnitude.
+#define TOP_K_SAMPLE_SIZE 4096
+
+// Finds the k-th largest magnitude using a selection on the magnitudes of the
+// candidate elements, and then extracts the elements above it, as well as the
+// first elements equal to it, in a single pass that preserves their order.
+// When k is small, the candidates are the elements whose magnitudes are at
+// least a lower bound of the k-th largest one, which is estimated from a
+// sample so that it is unlikely to be too large. If it still is, all elements
+// are candidates.
+template <typename T>
+void ExtractTopKScalar(T* values, int64_t num_elements, int64_t k,
+                       int32_t* indices, T* selected) {
+  if (k <= 0) {
+    return;
+  }
+  T threshold = 0;
+  int64_t num_ties = num_elements;
+  if (k < num_elements) {
+    // The candidates are reused by the next calls on the same thread.
+    thread_local std::vector<T> candidates;
+    candidates.clear();
+    int64_t sample_size = TOP_K_SAMPLE_SIZE;
+    if (num_elements >= 4 * sample_size && k * 4 <= num_elements) {
+      for (int64_t i = 0; i < sample_size; i++) {
+        candidates.push_back(Magnitude(values[i * num_elements / sample_size]));
+      }
+      int64_t rank = std::min(
+          sample_size, 2 * k * sample_size / num_elements + 16);
+      auto bound = candidates.end() - rank;
+      std::nth_element(candidates.begin(), bound, candidates.end());
+      T lower_bound = *bound;
+      candidates.clear();
+      for (int64_t i = 0; i < num_elements; i++) {
+        T magnitude = Magnitude(values[i]);
+        if (magnitude >= lower_bound) {
+          candidates.push_back(magnitude);
+        }
+      }
+    }
+    if ((int64_t)candidates.size() < k) {
+      candidates.resize((size_t)num_elements);
+      for (int64_t i = 0; i < num_elements; i++) {
+        candidates[i] = Magnitude(values[i]);
+      }
+    }
+    auto kth = candidates.end() - k;
+    std::nth_element(candidates.begin(), kth, candidates.end());
+    threshold = *kth;
+    num_ties = 1;
+    for (auto it = kth + 1; it != candidates.end(); it++) {
+      if (*it == threshold) {
+        num_ties++;
+      }
+    }
+  }
+  int64_t j = 0;
+  for (int64_t i = 0; i < num_elements && j < k; i++) {
+    T magnitude = Magnitude(values[i]);
+    if (magnitude > threshold || (magnitude == threshold && num_ties-- > 0)) {
+      indices[j] = (int32_t)i;
+      selected[j] = values[i];
+      values[i] = 0;
+      j++;
+    }
+  }
+}
+
+template <typename T>
+void ScatterSumIntoScalar(T* dst, const int32_t* indices, const T* src,
+                          int64_t num_indices) {
+  for (int64_t i = 0; i < num_indices; i++) {
+    dst[indices[i]] += src[i];
+  }
+}
+
+} // namespace
+
+void SumInto(MPIDataType dtype, void* dst, const void* src,
+             int64_t num_elements) {
+  switch (dtype) {
+  case HOROVOD_UINT8:
+    SumIntoScalar((uint8_t*)dst, (const uint8_t*)src, num_elements);
+    break;
+  case HOROVOD_INT8:
+    SumIntoScalar((int8_t*)dst, (const int8_t*)src, num_elements);
+    break;
+  case HOROVOD_UINT16:
+    SumIntoScalar((uint16_t*)dst, (const uint16_t*)src, num_elements);
+    break;
+  case HOROVOD_INT16:
+    SumIntoScalar((int16_t*)dst, (const int16_t*)src, num_elements);
+    break;
+  case HOROVOD_INT32:
+    SumIntoScalar((int32_t*)dst, (const int32_t*)src, num_elements);
+    break;
+  case HOROVOD_INT64:
+    SumIntoScalar((int64_t*)dst, (const int64_t*)src, num_elements);
+    break;
+  case HOROVOD_FLOAT32:
+    SumIntoFloat((float*)dst, (const float*)src, num_elements);
+    break;
+  case HOROVOD_FLOAT64:
+    SumIntoDouble((double*)dst, (const double*)src, num_elements);
+    break;
+  case HOROVOD_BOOL:
+    OrInto((bool*)dst, (const bool*)src, num_elements);
+    break;
+  case HOROVOD_FLOAT16:
+  case HOROVOD_BFLOAT16:
+    SumIntoHalf(dtype, (uint16_t*)dst, (const uint16_t*)src, num_elements);
+    break;
+  default:
+    throw std::logic_error("Type " + MPIDataType_Name(dtype) +
+                           " is not supported for local reductions.");
+  }
+}
+
+int64_t DataTypeSize(MPIDataType dtype) {
+  switch (dtype) {
+  case HOROVOD_UINT8:
+  case HOROVOD_INT8:
+    return 1;
+  case HOROVOD_UINT16:
+  case HOROVOD_INT16:
+  case HOROVOD_FLOAT16:
+  case HOROVOD_BFLOAT16:
+    return 2;
+  case HOROVOD_INT32:
+  case HOROVOD_FLOAT32:
+    return 4;
+  case HOROVOD_INT64:
+  case HOROVOD_FLOAT64:
+    return 8;
+  case HOROVOD_BOOL:
+    return sizeof(bool);
+  default:
+    throw std::logic_error("Type " + MPIDataType_Name(dtype) +
+                           " has an unknown size.");
+  }
+}
+
+void ConvertFromFloat(MPIDataType dtype, void* dst, const float* src,
+                      int64_t num_elements) {
+  if (dtype != HOROVOD_FLOAT16 && dtype != HOROVOD_BFLOAT16) {
+    throw std::logic_error("Cannot convert float32 values to type " +
+                           MPIDataType_Name(dtype) + ".");
+  }
+#if HOROVOD_X86_SIMD
+  if (dtype == HOROVOD_FLOAT16 && CpuSupportsF16C()) {
+    ConvertFromFloatF16C((uint16_t*)dst, src, num_elements);
+    return;
+  }
+  if (dtype == HOROVOD_BFLOAT16 && CpuSupportsAVX2()) {
+    ConvertFromFloatAVX2((uint16_t*)dst, src, num_elements);
+    return;
+  }
+#endif
+  ConvertFromFloatScalar(dtype, (uint16_t*)dst, src, num_elements);
+}
+
+void ConvertToFloat(MPIDataType dtype, float* dst, const void* src,
+                    int64_t num_elements) {
+  if (dtype != HOROVOD_FLOAT16 && dtype != HOROVOD_BFLOAT16) {
+    throw std::logic_error("Cannot convert values of type " +
+                           MPIDataType_Name(dtype) + " to float32.");
+  }
+#if HOROVOD_X86_SIMD
+  if (dtype == HOROVOD_FLOAT16 && CpuSupportsF16C()) {
+    ConvertToFloatF16C(dst, (const uint16_t*)src, num_elements);
+    return;
+  }
+  if (dtype == HOROVOD_BFLOAT16 && CpuSupportsAVX2()) {
+    ConvertToFloatAVX2(dst, (const uint16_t*)src, num_elements);
+    return;
+  }
+#endif
+  ConvertToFloatScalar(dtype, dst, (const uint16_t*)src, num_elements);
+}
+
+void ExtractTopK(MPIDataType dtype, void* values, int64_t num_elements,
+                 int64_t k, int32_t* indices, void* selected) {
+  switch (dtype) {
+  case HOROVOD_FLOAT32:
+    ExtractTopKScalar((float*)values, num_elements, k, indices,
+                      (float*)selected);
+    break;
+  case HOROVOD_FLOAT64:
+    ExtractTopKScalar((double*)values, num_elements, k, indices,
+                      (double*)selected);
+    break;
+  default:
+    throw std::logic_error("Type " + MPIDataType_Name(dtype) +
+                           " is not supported for top-k selection.");
+  }
+}
+
+void ScatterSumInto(MPIDataType dtype, void* dst, const int32_t* indices,
+                    const void* src, int64_t num_indices) {
+  switch (dtype) {
+  case HOROVOD_FLOAT32:
+    ScatterSumIntoScalar((float*)dst, indices, (const float*)src, num_indices);
+    break;
+  case HOROVOD_FLOAT64:
+    ScatterSumIntoScalar((double*)dst, indices, (const double*)src,
+                         num_indices);
+    break;
+  default:
+    throw std::logic_error("Type " + MPIDataType_Name(dtype) +
+                           " is not supported for scattered reductions.");
+  }
+}
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,63 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_REDUCTION_H
+#define HOROVOD_REDUCTION_H
+
+#include <cstdint>
+
+#include "mpi_message.h"
+
+namespace horovod {
+namespace common {
+
+// Adds `num_elements` elements of type `dtype` from `src` to `dst`, in place.
+// Booleans are combined using a logical OR. Floating-point types use SIMD
+// instructions when the CPU supports them. 16-bit floating-point values are
+// added in float32 precision and rounded back to 16 bits.
+void SumInto(MPIDataType dtype, void* dst, const void* src,
+             int64_t num_elements);
+
+// Returns the size in bytes of a single element of type `dtype`.
+int64_t DataTypeSize(MPIDataType dtype);
+
+// Converts `num_elements` float32 values from `src` to `dtype`, which must be
+// HOROVOD_FLOAT16 or HOROVOD_BFLOAT16, rounding to the nearest even value.
+void ConvertFromFloat(MPIDataType dtype, void* dst, const float* src,
+                      int64_t num_elements);
+
+// Converts `num_elements` values of type `dtype`, which must be
+// HOROVOD_FLOAT16 or HOROVOD_BFLOAT16, from `src` to float32.
+void ConvertToFloat(MPIDataType dtype, float* dst, const void* src,
+                    int64_t num_elements);
+
+// Moves the `k` elements with the largest magnitudes out of the
+// `num_elements` values of type `dtype`, which must be HOROVOD_FLOAT32 or
+// HOROVOD_FLOAT64, in `values`: their positions are stored in increasing order
+// in `indices` and their values in `selected`, and they are then set to zero
+// in `values`. NaNs count as the largest magnitudes. Takes expected linear
+// time in `num_elements`.
+void ExtractTopK(MPIDataType dtype, void* values, int64_t num_elements,
+                 int64_t k, int32_t* indices, void* selected);
+
+// Adds the `num_indices` values of type `dtype` from `src` to the elements of
+// `dst` at positions `indices`.
+void ScatterSumInto(MPIDataType dtype, void* dst, const int32_t* indices,
+                    const void* src, int64_t num_indices);
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_REDUCTION_H
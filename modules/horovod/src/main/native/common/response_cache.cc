@@ -0,0 +1,125 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <assert.h>
+
+#include "response_cache.h"
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+bool SameParameters(const MPIRequest& a, const MPIRequest& b) {
+  return a.request_type() == b.request_type() &&
+         a.tensor_type() == b.tensor_type() &&
+         a.tensor_shape() == b.tensor_shape() && a.device() == b.device() &&
+         a.root_rank() == b.root_rank() &&
+         a.top_k_ratio() == b.top_k_ratio();
+}
+
+} // namespace
+
+void ResponseCache::set_capacity(uint32_t capacity) {
+  clear();
+  capacity_ = capacity;
+  entries_.resize(capacity);
+  valid_.assign(capacity, false);
+  free_bits_.clear();
+  for (uint32_t bit = capacity; bit > 0; bit--) {
+    free_bits_.push_back(bit - 1);
+  }
+}
+
+uint32_t ResponseCache::capacity() const { return capacity_; }
+
+size_t ResponseCache::num_active_bits() const {
+  return tensor_name_to_bit_.size();
+}
+
+ResponseCache::CacheState
+ResponseCache::cached(const MPIRequest& request) const {
+  auto it = tensor_name_to_bit_.find(request.tensor_name());
+  if (it == tensor_name_to_bit_.end()) {
+    return MISS;
+  }
+  return SameParameters(entries_[it->second].request, request) ? HIT : INVALID;
+}
+
+uint32_t ResponseCache::peek_cache_bit(const std::string& tensor_name) const {
+  auto it = tensor_name_to_bit_.find(tensor_name);
+  assert(it != tensor_name_to_bit_.end());
+  return it->second;
+}
+
+void ResponseCache::put(const MPIResponse& response,
+                        const MPIRequest& request) {
+  assert(response.tensor_names().size() == 1);
+  if (capacity_ == 0) {
+    return;
+  }
+
+  auto& name = response.tensor_names()[0];
+  auto it = tensor_name_to_bit_.find(name);
+  if (it != tensor_name_to_bit_.end()) {
+    // Replace the existing entry, but keep its bit position.
+    auto& entry = entries_[it->second];
+    entry.response = response;
+    entry.request = request;
+    lru_.splice(lru_.begin(), lru_, entry.lru_position);
+    return;
+  }
+
+  if (free_bits_.empty()) {
+    erase_response(lru_.back());
+  }
+  uint32_t bit = free_bits_.back();
+  free_bits_.pop_back();
+
+  auto& entry = entries_[bit];
+  entry.response = response;
+  entry.request = request;
+  lru_.push_front(bit);
+  entry.lru_position = lru_.begin();
+  valid_[bit] = true;
+  tensor_name_to_bit_[name] = bit;
+}
+
+const MPIResponse& ResponseCache::get_response(uint32_t bit) {
+  assert(bit < capacity_ && valid_[bit]);
+  auto& entry = entries_[bit];
+  lru_.splice(lru_.begin(), lru_, entry.lru_position);
+  return entry.response;
+}
+
+void ResponseCache::erase_response(uint32_t bit) {
+  if (bit >= capacity_ || !valid_[bit]) {
+    return;
+  }
+  auto& entry = entries_[bit];
+  tensor_name_to_bit_.erase(entry.response.tensor_names()[0]);
+  lru_.erase(entry.lru_position);
+  valid_[bit] = false;
+  free_bits_.push_back(bit);
+}
+
+void ResponseCache::clear() {
+  for (uint32_t bit = 0; bit < capacity_; bit++) {
+    erase_response(bit);
+  }
+}
+
+} // namespace common
+} // namespace horovod
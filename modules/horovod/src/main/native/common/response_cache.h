@@ -0,0 +1,100 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_RESPONSE_CACHE_H
+#define HOROVOD_RESPONSE_CACHE_H
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mpi_message.h"
+
+namespace horovod {
+namespace common {
+
+// A ResponseCache stores the MPIResponses that the coordinator constructed for
+// previously negotiated tensors, so that tensors that are submitted with the
+// same parameters on every step can skip the coordinator round trip.
+//
+// Every cached response is assigned a bit position in [0, capacity). Ranks
+// negotiate cached tensors by allreducing bit vectors in which they set the
+// bits of the cached tensors they are ready to process. In order for the bit
+// positions to be meaningful, all ranks must keep identical caches. This is
+// guaranteed as long as the cache is only modified (via `put`, `get_response`
+// and `erase_response`) in response to events that every rank observes in the
+// same order, such as the responses sent by the coordinator and the results of
+// the bit vector allreduce. `cached` and `peek_cache_bit` never modify the
+// cache and can thus be used freely.
+class ResponseCache {
+public:
+  enum CacheState { MISS = 0, HIT = 1, INVALID = 2 };
+
+  void set_capacity(uint32_t capacity);
+  uint32_t capacity() const;
+
+  // Number of bit positions currently assigned to cached responses.
+  size_t num_active_bits() const;
+
+  // Returns HIT if a response for the tensor named by `request` is cached and
+  // it was created for a request with the same parameters (i.e., type, data
+  // type, shape, device and root rank), INVALID if a response for that tensor
+  // is cached but its parameters differ, and MISS otherwise.
+  CacheState cached(const MPIRequest& request) const;
+
+  // Returns the bit position assigned to the cached response for the tensor
+  // with name `tensor_name`. The tensor must be cached.
+  uint32_t peek_cache_bit(const std::string& tensor_name) const;
+
+  // Caches `response`, which must refer to a single tensor, as the response
+  // for requests with the same parameters as `request`. If the cache is full,
+  // the least recently used response is evicted to make room for it.
+  void put(const MPIResponse& response, const MPIRequest& request);
+
+  // Returns the cached response at position `bit` and marks it as the most
+  // recently used one.
+  const MPIResponse& get_response(uint32_t bit);
+
+  // Removes the cached response at position `bit`, if there is one.
+  void erase_response(uint32_t bit);
+
+  void clear();
+
+private:
+  struct CacheEntry {
+    MPIResponse response;
+    MPIRequest request;
+    std::list<uint32_t>::iterator lru_position;
+  };
+
+  uint32_t capacity_ = 0;
+
+  // Cache entries indexed by their bit position. Positions that are not in
+  // use are recorded in `free_bits_`.
+  std::vector<CacheEntry> entries_;
+  std::vector<bool> valid_;
+  std::vector<uint32_t> free_bits_;
+
+  // Bit positions ordered from the most to the least recently used.
+  std::list<uint32_t> lru_;
+
+  std::unordered_map<std::string, uint32_t> tensor_name_to_bit_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_RESPONSE_CACHE_H
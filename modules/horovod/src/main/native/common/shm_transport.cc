@@ -0,0 +1,347 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "reduction.h"
+#include "shm_transport.h"
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+// Size of the slot of every rank. Larger buffers are exchanged in rounds.
+#define SHM_SLOT_SIZE (8 << 20)
+
+// Size reserved for the header at the start of the mapping, which keeps the
+// slots page-aligned.
+#define SHM_HEADER_SIZE 4096
+
+#define SHM_MAGIC 0x486f726f766f6453ULL
+
+// Number of times a rank polls a barrier before yielding its core, and
+// between checks of the timeout.
+#define BARRIER_SPINS 1000
+
+} // namespace
+
+struct ShmTransport::Header {
+  std::atomic<uint64_t> magic;
+  std::atomic<int32_t> size;
+  std::atomic<int32_t> attached;
+  std::atomic<int32_t> arrived;
+  std::atomic<uint32_t> generation;
+};
+
+ShmTransport::ShmTransport(int rank, int size,
+                           std::chrono::steady_clock::duration timeout) {
+  rank_ = rank;
+  size_ = size;
+  timeout_ = timeout;
+  local_rank_ = rank;
+  local_size_ = size;
+  slot_size_ = SHM_SLOT_SIZE;
+  mapping_size_ = SHM_HEADER_SIZE + slot_size_ * size;
+}
+
+ShmTransport::~ShmTransport() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, (size_t)mapping_size_);
+  }
+}
+
+bool ShmTransport::Connect(const std::string& path, std::string& error) {
+  static_assert(sizeof(Header) <= SHM_HEADER_SIZE, "Header is too large.");
+  static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+                "Shared memory atomics must be lock-free.");
+
+  // Rank zero initializes the file under a temporary name and then renames it,
+  // so that other ranks never see a partially initialized file.
+  int fd;
+  if (rank_ == 0) {
+    std::string temporary_path = path + ".tmp";
+    fd = open(temporary_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0 || ftruncate(fd, (off_t)mapping_size_) != 0) {
+      error = "Failed to create " + temporary_path + ": " + strerror(errno);
+      if (fd >= 0) {
+        close(fd);
+      }
+      return false;
+    }
+  } else {
+    auto deadline = std::chrono::steady_clock::now() + timeout_;
+    while ((fd = open(path.c_str(), O_RDWR)) < 0) {
+      if (errno != ENOENT || std::chrono::steady_clock::now() > deadline) {
+        error = "Failed to open " + path + ": " + strerror(errno);
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size != mapping_size_) {
+      error = path + " was not created for a job of size " +
+              std::to_string(size_) + ".";
+      close(fd);
+      return false;
+    }
+  }
+
+  void* mapping = mmap(nullptr, (size_t)mapping_size_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    error = "Failed to map " + path + ": " + strerror(errno);
+    return false;
+  }
+  mapping_ = (uint8_t*)mapping;
+  header_ = (Header*)mapping_;
+
+  if (rank_ == 0) {
+    // The file is zero-filled, which is a valid initial state for the
+    // atomics.
+    header_->size.store(size_);
+    header_->magic.store(SHM_MAGIC);
+    if (std::rename((path + ".tmp").c_str(), path.c_str()) != 0) {
+      error = "Failed to create " + path + ": " + strerror(errno);
+      return false;
+    }
+  } else if (header_->magic.load() != SHM_MAGIC ||
+             header_->size.load() != size_) {
+    error = path + " was not created for a job of size " +
+            std::to_string(size_) + ".";
+    return false;
+  }
+
+  // Wait for all ranks to map the file. After that, it is no longer needed.
+  header_->attached.fetch_add(1);
+  auto deadline = std::chrono::steady_clock::now() + timeout_;
+  while (header_->attached.load() < size_) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      error = "Timed out waiting for all ranks to open " + path + ".";
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (rank_ == 0) {
+    unlink(path.c_str());
+  }
+  return true;
+}
+
+// A sense-reversing barrier: the last rank to arrive resets the count and
+// starts a new generation, which releases the other ranks. A rank that times
+// out leaves the count incremented, and so the barrier cannot be used anymore.
+bool ShmTransport::Barrier() {
+  if (failed_) {
+    return false;
+  }
+  uint32_t generation = header_->generation.load(std::memory_order_acquire);
+  if (header_->arrived.fetch_add(1, std::memory_order_acq_rel) == size_ - 1) {
+    header_->arrived.store(0, std::memory_order_relaxed);
+    header_->generation.fetch_add(1, std::memory_order_release);
+    return true;
+  }
+  auto deadline = std::chrono::steady_clock::now() + timeout_;
+  for (int spins = 1;
+       header_->generation.load(std::memory_order_acquire) == generation;
+       spins++) {
+    if (spins >= BARRIER_SPINS) {
+      std::this_thread::yield();
+    }
+    if (spins % BARRIER_SPINS == 0 &&
+        std::chrono::steady_clock::now() > deadline) {
+      failed_ = true;
+      return false;
+    }
+  }
+  return true;
+}
+
+uint8_t* ShmTransport::slot(int rank) const {
+  return mapping_ + SHM_HEADER_SIZE + slot_size_ * rank;
+}
+
+bool ShmTransport::Allreduce(void* buffer, int64_t num_elements,
+                             MPIDataType dtype) {
+  if (size_ == 1) {
+    return true;
+  }
+  int64_t element_size = DataTypeSize(dtype);
+  int64_t chunk_elements = slot_size_ / element_size;
+  for (int64_t begin = 0; begin < num_elements; begin += chunk_elements) {
+    int64_t count = std::min(chunk_elements, num_elements - begin);
+    uint8_t* chunk = (uint8_t*)buffer + begin * element_size;
+    std::memcpy(slot(rank_), chunk, (size_t)(count * element_size));
+    if (!Barrier()) {
+      return false;
+    }
+
+    // Sum the segment of the chunk that this rank owns into its own slot.
+    int64_t segment_begin = count * rank_ / size_ * element_size;
+    int64_t segment_end = count * (rank_ + 1) / size_ * element_size;
+    for (int r = 0; r < size_; r++) {
+      if (r != rank_) {
+        SumInto(dtype, slot(rank_) + segment_begin, slot(r) + segment_begin,
+                (segment_end - segment_begin) / element_size);
+      }
+    }
+    if (!Barrier()) {
+      return false;
+    }
+
+    for (int r = 0; r < size_; r++) {
+      int64_t begin_r = count * r / size_ * element_size;
+      int64_t end_r = count * (r + 1) / size_ * element_size;
+      std::memcpy(chunk + begin_r, slot(r) + begin_r,
+                  (size_t)(end_r - begin_r));
+    }
+
+    // Make sure that no rank overwrites its slot with the next chunk while
+    // other ranks are still reading it.
+    if (!Barrier()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ShmTransport::Allgatherv(void* buffer,
+                              const std::vector<int64_t>& counts) {
+  if (size_ == 1) {
+    return true;
+  }
+  std::vector<int64_t> displacements(size_, 0);
+  for (int r = 1; r < size_; r++) {
+    displacements[r] = displacements[r - 1] + counts[r - 1];
+  }
+  int64_t max_count = *std::max_element(counts.begin(), counts.end());
+  uint8_t* data = (uint8_t*)buffer;
+  for (int64_t begin = 0; begin < max_count; begin += slot_size_) {
+    int64_t own_bytes =
+        std::max((int64_t)0, std::min(slot_size_, counts[rank_] - begin));
+    std::memcpy(slot(rank_), data + displacements[rank_] + begin,
+                (size_t)own_bytes);
+    if (!Barrier()) {
+      return false;
+    }
+    for (int r = 0; r < size_; r++) {
+      int64_t bytes =
+          std::max((int64_t)0, std::min(slot_size_, counts[r] - begin));
+      if (r != rank_ && bytes > 0) {
+        std::memcpy(data + displacements[r] + begin, slot(r), (size_t)bytes);
+      }
+    }
+    if (!Barrier()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ShmTransport::Broadcast(void* buffer, int64_t num_bytes, int root_rank) {
+  if (size_ == 1) {
+    return true;
+  }
+  uint8_t* data = (uint8_t*)buffer;
+  for (int64_t begin = 0; begin < num_bytes; begin += slot_size_) {
+    int64_t bytes = std::min(slot_size_, num_bytes - begin);
+    if (rank_ == root_rank) {
+      std::memcpy(slot(root_rank), data + begin, (size_t)bytes);
+    }
+    if (!Barrier()) {
+      return false;
+    }
+    if (rank_ != root_rank) {
+      std::memcpy(data + begin, slot(root_rank), (size_t)bytes);
+    }
+    if (!Barrier()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ShmTransport::Alltoallv(const void* sendbuf,
+                             const std::vector<int64_t>& sendcounts,
+                             void* recvbuf,
+                             const std::vector<int64_t>& recvcounts) {
+  // Publish the send counts of every rank, so that every rank can find the
+  // bytes that it receives within the bytes sent by the other ranks.
+  std::memcpy(slot(rank_), sendcounts.data(), size_ * sizeof(int64_t));
+  if (!Barrier()) {
+    return false;
+  }
+  std::vector<int64_t> offsets(size_, 0);
+  int64_t max_send_size = 0;
+  for (int r = 0; r < size_; r++) {
+    const int64_t* counts = (const int64_t*)slot(r);
+    int64_t send_size = 0;
+    for (int q = 0; q < size_; q++) {
+      if (q == rank_) {
+        offsets[r] = send_size;
+      }
+      send_size += counts[q];
+    }
+    max_send_size = std::max(max_send_size, send_size);
+  }
+  if (!Barrier()) {
+    return false;
+  }
+
+  std::vector<int64_t> displacements(size_, 0);
+  for (int r = 1; r < size_; r++) {
+    displacements[r] = displacements[r - 1] + recvcounts[r - 1];
+  }
+  int64_t own_send_size = 0;
+  for (auto count : sendcounts) {
+    own_send_size += count;
+  }
+  for (int64_t begin = 0; begin < max_send_size; begin += slot_size_) {
+    int64_t end = begin + slot_size_;
+    std::memcpy(slot(rank_), (const uint8_t*)sendbuf + begin,
+                (size_t)std::max((int64_t)0,
+                                 std::min(end, own_send_size) - begin));
+    if (!Barrier()) {
+      return false;
+    }
+    for (int r = 0; r < size_; r++) {
+      int64_t low = std::max(offsets[r], begin);
+      int64_t high = std::min(offsets[r] + recvcounts[r], end);
+      if (low < high) {
+        std::memcpy((uint8_t*)recvbuf + displacements[r] + low - offsets[r],
+                    slot(r) + low - begin, (size_t)(high - low));
+      }
+    }
+    if (!Barrier()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,72 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_SHM_TRANSPORT_H
+#define HOROVOD_SHM_TRANSPORT_H
+
+#include "transport.h"
+
+namespace horovod {
+namespace common {
+
+// A transport for ranks that all run on the same host, which communicate
+// through a file that they all map into memory. The rendezvous file itself is
+// mapped, and so it should reside on a memory-backed file system such as
+// /dev/shm. Rank zero creates it and removes it as soon as all ranks have
+// mapped it.
+//
+// Every rank owns a fixed-size slot of the mapping. Collective operations
+// proceed in rounds separated by barriers: in every round, ranks write (part
+// of) their data into their own slot and then read the slots of the other
+// ranks. Allreduce sums every segment of the data only once, on the rank that
+// owns the segment, using SumInto, and every rank then copies the reduced
+// segments directly out of the slots of their owners.
+class ShmTransport : public Transport {
+public:
+  ShmTransport(int rank, int size,
+               std::chrono::steady_clock::duration timeout);
+  ~ShmTransport();
+
+  // Creates (on rank zero) or opens (on other ranks) the rendezvous file at
+  // `path`, and waits for all ranks to map it.
+  bool Connect(const std::string& path, std::string& error);
+
+  bool Allreduce(void* buffer, int64_t num_elements,
+                 MPIDataType dtype) override;
+  bool Allgatherv(void* buffer, const std::vector<int64_t>& counts) override;
+  bool Broadcast(void* buffer, int64_t num_bytes, int root_rank) override;
+  bool Alltoallv(const void* sendbuf, const std::vector<int64_t>& sendcounts,
+                 void* recvbuf,
+                 const std::vector<int64_t>& recvcounts) override;
+
+private:
+  struct Header;
+
+  // Blocks until all ranks have reached the barrier. Returns false if they did
+  // not reach it within the timeout.
+  bool Barrier();
+
+  uint8_t* slot(int rank) const;
+
+  Header* header_ = nullptr;
+  uint8_t* mapping_ = nullptr;
+  int64_t mapping_size_ = 0;
+  int64_t slot_size_ = 0;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_SHM_TRANSPORT_H
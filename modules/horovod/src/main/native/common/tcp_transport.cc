@@ -0,0 +1,468 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "reduction.h"
+#include "tcp_transport.h"
+
+namespace horovod {
+namespace common {
+
+namespace {
+
+// Size of the chunks in which broadcasts are forwarded along the ring.
+#define BROADCAST_CHUNK_SIZE (1 << 20)
+
+struct Peer {
+  std::string host;
+  int port = 0;
+};
+
+// Reads the peers registered in the rendezvous file so far, indexed by rank.
+// Returns the number of ranks that have registered.
+int ReadPeers(const std::string& path, std::vector<Peer>& peers) {
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream fields(line);
+    int rank;
+    Peer peer;
+    if ((fields >> rank >> peer.host >> peer.port) && rank >= 0 &&
+        rank < (int)peers.size()) {
+      peers[rank] = peer;
+    }
+  }
+  return (int)std::count_if(peers.begin(), peers.end(),
+                            [](const Peer& peer) { return peer.port != 0; });
+}
+
+// Connects to `peer`. Ranks on this host may also be reached through the
+// loopback interface, in case the host name does not resolve locally.
+int ConnectToPeer(const Peer& peer, const std::string& own_host) {
+  std::vector<std::string> hosts = {peer.host};
+  if (peer.host == own_host) {
+    hosts.push_back("127.0.0.1");
+  }
+  for (auto& host : hosts) {
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses;
+    if (getaddrinfo(host.c_str(), std::to_string(peer.port).c_str(), &hints,
+                    &addresses) != 0) {
+      continue;
+    }
+    for (addrinfo* address = addresses; address != nullptr;
+         address = address->ai_next) {
+      int fd = socket(address->ai_family, address->ai_socktype,
+                      address->ai_protocol);
+      if (fd < 0) {
+        continue;
+      }
+      if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+        freeaddrinfo(addresses);
+        return fd;
+      }
+      close(fd);
+    }
+    freeaddrinfo(addresses);
+  }
+  return -1;
+}
+
+// Returns the number of milliseconds until `deadline`, for poll.
+int PollTimeout(std::chrono::steady_clock::time_point deadline) {
+  auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - std::chrono::steady_clock::now());
+  return (int)std::max((int64_t)0, std::min((int64_t)remaining.count(),
+                                            (int64_t)INT32_MAX));
+}
+
+// Waits until `fd` is readable, e.g., until a listening socket has a pending
+// connection. Returns false if it did not become readable before `deadline`.
+bool WaitReadable(int fd, std::chrono::steady_clock::time_point deadline) {
+  pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  while (true) {
+    int result = poll(&pfd, 1, PollTimeout(deadline));
+    if (result > 0) {
+      return true;
+    }
+    if (result == 0 || errno != EINTR) {
+      return false;
+    }
+  }
+}
+
+// Sends or receives exactly `num_bytes` bytes on a blocking socket.
+bool SendAll(int fd, const void* data, int64_t num_bytes) {
+  const uint8_t* position = (const uint8_t*)data;
+  while (num_bytes > 0) {
+    ssize_t sent = send(fd, position, (size_t)num_bytes, MSG_NOSIGNAL);
+    if (sent <= 0) {
+      return false;
+    }
+    position += sent;
+    num_bytes -= sent;
+  }
+  return true;
+}
+
+bool ReceiveAll(int fd, void* data, int64_t num_bytes) {
+  uint8_t* position = (uint8_t*)data;
+  while (num_bytes > 0) {
+    ssize_t received = recv(fd, position, (size_t)num_bytes, 0);
+    if (received <= 0) {
+      return false;
+    }
+    position += received;
+    num_bytes -= received;
+  }
+  return true;
+}
+
+} // namespace
+
+TcpTransport::TcpTransport(int rank, int size,
+                           std::chrono::steady_clock::duration timeout) {
+  rank_ = rank;
+  size_ = size;
+  timeout_ = timeout;
+  sockets_.assign((size_t)size, -1);
+}
+
+TcpTransport::~TcpTransport() {
+  for (auto fd : sockets_) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  if (listen_socket_ >= 0) {
+    close(listen_socket_);
+  }
+}
+
+bool TcpTransport::Connect(const std::string& path, std::string& error) {
+  // Listen on an ephemeral port, which is registered in the rendezvous file.
+  listen_socket_ = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = 0;
+  socklen_t address_length = sizeof(address);
+  if (listen_socket_ < 0 ||
+      bind(listen_socket_, (sockaddr*)&address, sizeof(address)) != 0 ||
+      listen(listen_socket_, size_) != 0 ||
+      getsockname(listen_socket_, (sockaddr*)&address, &address_length) != 0) {
+    error = std::string("Failed to listen for connections: ") +
+            strerror(errno);
+    return false;
+  }
+
+  char host_name[256];
+  if (gethostname(host_name, sizeof(host_name)) != 0) {
+    error = std::string("Failed to get the host name: ") + strerror(errno);
+    return false;
+  }
+  host_name[sizeof(host_name) - 1] = '\0';
+  std::string own_host(host_name);
+
+  // A single append of a short line is atomic, and so ranks can register
+  // concurrently.
+  std::string registration = std::to_string(rank_) + " " + own_host + " " +
+                             std::to_string(ntohs(address.sin_port)) + "\n";
+  int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+  if (fd < 0 || write(fd, registration.c_str(), registration.size()) !=
+                    (ssize_t)registration.size()) {
+    error = "Failed to register in " + path + ": " + strerror(errno);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return false;
+  }
+  close(fd);
+
+  std::vector<Peer> peers((size_t)size_);
+  auto deadline = std::chrono::steady_clock::now() + timeout_;
+  while (ReadPeers(path, peers) < size_) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      error = "Timed out waiting for all ranks to register in " + path + ".";
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  local_rank_ = 0;
+  local_size_ = 0;
+  for (int r = 0; r < size_; r++) {
+    if (peers[r].host == own_host) {
+      local_rank_ += r < rank_ ? 1 : 0;
+      local_size_++;
+    }
+  }
+
+  // Every rank connects to the lower ranks, introducing itself with its rank,
+  // and accepts connections from the higher ranks.
+  for (int r = 0; r < rank_; r++) {
+    sockets_[r] = ConnectToPeer(peers[r], own_host);
+    int32_t own_rank = rank_;
+    if (sockets_[r] < 0 || !SendAll(sockets_[r], &own_rank, sizeof(own_rank))) {
+      error = "Failed to connect to rank " + std::to_string(r) + " at " +
+              peers[r].host + ":" + std::to_string(peers[r].port) + ".";
+      return false;
+    }
+  }
+  // Higher ranks that never connect, e.g., because they died after
+  // registering, must not block this rank forever.
+  deadline = std::chrono::steady_clock::now() + timeout_;
+  for (int i = rank_ + 1; i < size_; i++) {
+    if (!WaitReadable(listen_socket_, deadline)) {
+      error = "Timed out waiting for the higher ranks to connect.";
+      return false;
+    }
+    int peer_socket = accept(listen_socket_, nullptr, nullptr);
+    int32_t peer_rank = -1;
+    if (peer_socket < 0 || !WaitReadable(peer_socket, deadline) ||
+        !ReceiveAll(peer_socket, &peer_rank, sizeof(peer_rank)) ||
+        peer_rank <= rank_ || peer_rank >= size_ || sockets_[peer_rank] >= 0) {
+      error = "Failed to accept a connection from a higher rank.";
+      if (peer_socket >= 0) {
+        close(peer_socket);
+      }
+      return false;
+    }
+    sockets_[peer_rank] = peer_socket;
+  }
+  close(listen_socket_);
+  listen_socket_ = -1;
+
+  // All ranks have connected to rank zero, and so they have all read the
+  // rendezvous file.
+  if (rank_ == 0) {
+    unlink(path.c_str());
+  }
+
+  for (auto peer_socket : sockets_) {
+    if (peer_socket >= 0) {
+      int flag = 1;
+      setsockopt(peer_socket, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+      fcntl(peer_socket, F_SETFL, fcntl(peer_socket, F_GETFL) | O_NONBLOCK);
+    }
+  }
+  return true;
+}
+
+bool TcpTransport::Exchange(int send_rank, const void* send_data,
+                            int64_t send_bytes, int recv_rank, void* recv_data,
+                            int64_t recv_bytes) {
+  if (failed_) {
+    return false;
+  }
+  int timeout_ms = (int)std::min(
+      (int64_t)std::chrono::duration_cast<std::chrono::milliseconds>(timeout_)
+          .count(),
+      (int64_t)INT32_MAX);
+  const uint8_t* send_position = (const uint8_t*)send_data;
+  uint8_t* recv_position = (uint8_t*)recv_data;
+  while (send_bytes > 0 || recv_bytes > 0) {
+    pollfd fds[2];
+    int num_fds = 0;
+    if (send_bytes > 0) {
+      fds[num_fds].fd = sockets_[send_rank];
+      fds[num_fds].events = POLLOUT;
+      num_fds++;
+    }
+    if (recv_bytes > 0) {
+      fds[num_fds].fd = sockets_[recv_rank];
+      fds[num_fds].events = POLLIN;
+      num_fds++;
+    }
+    int ready = poll(fds, (nfds_t)num_fds, timeout_ms);
+    if (ready < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ready <= 0) {
+      failed_ = true;
+      return false;
+    }
+    for (int i = 0; i < num_fds; i++) {
+      if (fds[i].revents == 0) {
+        continue;
+      }
+      if (fds[i].events == POLLOUT) {
+        ssize_t sent = send(fds[i].fd, send_position, (size_t)send_bytes,
+                            MSG_NOSIGNAL);
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+            errno != EINTR) {
+          failed_ = true;
+          return false;
+        }
+        if (sent > 0) {
+          send_position += sent;
+          send_bytes -= sent;
+        }
+      } else {
+        ssize_t received =
+            recv(fds[i].fd, recv_position, (size_t)recv_bytes, 0);
+        if (received == 0 || (received < 0 && errno != EAGAIN &&
+                              errno != EWOULDBLOCK && errno != EINTR)) {
+          failed_ = true;
+          return false;
+        }
+        if (received > 0) {
+          recv_position += received;
+          recv_bytes -= received;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+int TcpTransport::next_rank() const { return (rank_ + 1) % size_; }
+
+int TcpTransport::previous_rank() const { return (rank_ + size_ - 1) % size_; }
+
+bool TcpTransport::Allreduce(void* buffer, int64_t num_elements,
+                             MPIDataType dtype) {
+  if (size_ == 1) {
+    return true;
+  }
+  uint8_t* data = (uint8_t*)buffer;
+  int64_t element_size = DataTypeSize(dtype);
+  auto segment_begin = [=](int segment) {
+    return num_elements * segment / size_ * element_size;
+  };
+  auto segment_size = [=](int segment) {
+    return segment_begin(segment + 1) - segment_begin(segment);
+  };
+  receive_buffer_.resize((size_t)((num_elements / size_ + 1) * element_size));
+
+  // Reduce-scatter: in every step, every rank passes a partially reduced
+  // segment to the next rank, which adds its own values to it. In the end,
+  // every rank holds the sum of segment rank + 1.
+  for (int step = 0; step < size_ - 1; step++) {
+    int send_segment = (rank_ - step + size_) % size_;
+    int recv_segment = (rank_ - step - 1 + size_) % size_;
+    if (!Exchange(next_rank(), data + segment_begin(send_segment),
+                  segment_size(send_segment), previous_rank(),
+                  receive_buffer_.data(), segment_size(recv_segment))) {
+      return false;
+    }
+    SumInto(dtype, data + segment_begin(recv_segment), receive_buffer_.data(),
+            segment_size(recv_segment) / element_size);
+  }
+
+  // Allgather: the reduced segments are passed around the ring.
+  for (int step = 0; step < size_ - 1; step++) {
+    int send_segment = (rank_ - step + 1 + size_) % size_;
+    int recv_segment = (rank_ - step + size_) % size_;
+    if (!Exchange(next_rank(), data + segment_begin(send_segment),
+                  segment_size(send_segment), previous_rank(),
+                  data + segment_begin(recv_segment),
+                  segment_size(recv_segment))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TcpTransport::Allgatherv(void* buffer,
+                              const std::vector<int64_t>& counts) {
+  std::vector<int64_t> displacements(size_, 0);
+  for (int r = 1; r < size_; r++) {
+    displacements[r] = displacements[r - 1] + counts[r - 1];
+  }
+  uint8_t* data = (uint8_t*)buffer;
+  for (int step = 0; step < size_ - 1; step++) {
+    int send_block = (rank_ - step + size_) % size_;
+    int recv_block = (rank_ - step - 1 + size_) % size_;
+    if (!Exchange(next_rank(), data + displacements[send_block],
+                  counts[send_block], previous_rank(),
+                  data + displacements[recv_block], counts[recv_block])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TcpTransport::Broadcast(void* buffer, int64_t num_bytes, int root_rank) {
+  // Position of this rank along the ring that starts at the root.
+  int position = (rank_ - root_rank + size_) % size_;
+  uint8_t* data = (uint8_t*)buffer;
+  for (int64_t begin = 0; begin < num_bytes; begin += BROADCAST_CHUNK_SIZE) {
+    int64_t bytes = std::min((int64_t)BROADCAST_CHUNK_SIZE, num_bytes - begin);
+    if (position > 0 &&
+        !Exchange(next_rank(), nullptr, 0, previous_rank(), data + begin,
+                  bytes)) {
+      return false;
+    }
+    if (position < size_ - 1 &&
+        !Exchange(next_rank(), data + begin, bytes, previous_rank(), nullptr,
+                  0)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TcpTransport::Alltoallv(const void* sendbuf,
+                             const std::vector<int64_t>& sendcounts,
+                             void* recvbuf,
+                             const std::vector<int64_t>& recvcounts) {
+  std::vector<int64_t> sdispls(size_, 0);
+  std::vector<int64_t> rdispls(size_, 0);
+  for (int r = 1; r < size_; r++) {
+    sdispls[r] = sdispls[r - 1] + sendcounts[r - 1];
+    rdispls[r] = rdispls[r - 1] + recvcounts[r - 1];
+  }
+  const uint8_t* send_data = (const uint8_t*)sendbuf;
+  uint8_t* recv_data = (uint8_t*)recvbuf;
+  std::memcpy(recv_data + rdispls[rank_], send_data + sdispls[rank_],
+              (size_t)sendcounts[rank_]);
+
+  // In step k, every rank sends to the rank k places after it and receives
+  // from the rank k places before it.
+  for (int step = 1; step < size_; step++) {
+    int send_rank = (rank_ + step) % size_;
+    int recv_rank = (rank_ - step + size_) % size_;
+    if (!Exchange(send_rank, send_data + sdispls[send_rank],
+                  sendcounts[send_rank], recv_rank,
+                  recv_data + rdispls[recv_rank], recvcounts[recv_rank])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace common
+} // namespace horovod
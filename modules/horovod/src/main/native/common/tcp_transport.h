@@ -0,0 +1,75 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_TCP_TRANSPORT_H
+#define HOROVOD_TCP_TRANSPORT_H
+
+#include "transport.h"
+
+namespace horovod {
+namespace common {
+
+// A transport for ranks that may run on different hosts, which communicate
+// through TCP sockets. Every rank listens on an ephemeral port and appends its
+// host name and port to the rendezvous file, which must therefore be visible
+// to all hosts and support atomic appends. Once all ranks have registered,
+// every pair of ranks is connected and rank zero removes the file.
+//
+// Allreduce and allgather use a ring, in which every rank only sends data to
+// the next rank and receives data from the previous one, so that every rank
+// sends about twice the size of the buffer regardless of the number of ranks.
+// Broadcasts are pipelined along the ring starting at the root, and alltoall
+// exchanges data directly between every pair of ranks.
+class TcpTransport : public Transport {
+public:
+  TcpTransport(int rank, int size,
+               std::chrono::steady_clock::duration timeout);
+  ~TcpTransport();
+
+  // Registers this rank in the rendezvous file at `path`, and connects to all
+  // other ranks once they have registered.
+  bool Connect(const std::string& path, std::string& error);
+
+  bool Allreduce(void* buffer, int64_t num_elements,
+                 MPIDataType dtype) override;
+  bool Allgatherv(void* buffer, const std::vector<int64_t>& counts) override;
+  bool Broadcast(void* buffer, int64_t num_bytes, int root_rank) override;
+  bool Alltoallv(const void* sendbuf, const std::vector<int64_t>& sendcounts,
+                 void* recvbuf,
+                 const std::vector<int64_t>& recvcounts) override;
+
+private:
+  // Sends `send_bytes` bytes to `send_rank` while receiving `recv_bytes`
+  // bytes from `recv_rank`, so that two ranks can send data to each other at
+  // the same time without deadlocking. Fails if no data can be sent or
+  // received for longer than the timeout.
+  bool Exchange(int send_rank, const void* send_data, int64_t send_bytes,
+                int recv_rank, void* recv_data, int64_t recv_bytes);
+
+  int next_rank() const;
+  int previous_rank() const;
+
+  // Connected sockets, indexed by the rank of the peer, or -1 for this rank.
+  std::vector<int> sockets_;
+  int listen_socket_ = -1;
+
+  // Receives the segments that are summed into the buffer during allreduce.
+  std::vector<uint8_t> receive_buffer_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_TCP_TRANSPORT_H
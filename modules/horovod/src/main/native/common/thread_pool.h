@@ -0,0 +1,73 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_THREAD_POOL_H
+#define HOROVOD_THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace horovod {
+namespace common {
+
+// A fixed-size pool of threads that execute tasks in the order in which they
+// were scheduled. It is used by the background thread to parallelize memory
+// copies and local reductions, while it keeps making the MPI calls itself.
+class ThreadPool {
+public:
+  explicit ThreadPool(int num_threads);
+  ~ThreadPool();
+
+  int num_threads() const;
+
+  void Schedule(std::function<void()> task);
+
+private:
+  void WorkerLoop();
+
+  std::vector<std::thread> threads_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool shut_down_ = false;
+};
+
+// A group of tasks that can be waited on together. If no thread pool is
+// provided, tasks are executed synchronously by `Run`.
+class TaskGroup {
+public:
+  explicit TaskGroup(ThreadPool* pool);
+  ~TaskGroup();
+
+  void Run(std::function<void()> task);
+
+  // Blocks until all the tasks that were run in this group have completed.
+  void Wait();
+
+private:
+  ThreadPool* pool_;
+  int pending_ = 0;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_THREAD_POOL_H
@@ -13,7 +13,7 @@
 // limitations under the License.
 // =============================================================================
 
-#include <sstream>
+#include <algorithm>
 #include <assert.h>
 
 #include "timeline.h"
@@ -21,12 +21,80 @@
 namespace horovod {
 namespace common {
 
-void Timeline::Initialize(std::string file_name) {
+TimelineRingBuffer::TimelineRingBuffer(size_t capacity)
+    : cells_(new Cell[capacity]), mask_(capacity - 1), enqueue_position_(0) {
+  // The capacity must be a power of two.
+  assert(capacity >= 2 && (capacity & mask_) == 0);
+  for (size_t i = 0; i < capacity; i++) {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool TimelineRingBuffer::Push(const TimelineRecord& record) {
+  Cell* cell;
+  size_t position = enqueue_position_.load(std::memory_order_relaxed);
+  while (true) {
+    cell = &cells_[position & mask_];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+    if (difference == 0) {
+      // The cell is free, so try to claim it.
+      if (enqueue_position_.compare_exchange_weak(
+              position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      // The cell still holds an event from the previous lap.
+      return false;
+    } else {
+      position = enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+  cell->record = record;
+  cell->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+bool TimelineRingBuffer::Pop(TimelineRecord& record) {
+  Cell* cell = &cells_[dequeue_position_ & mask_];
+  size_t sequence = cell->sequence.load(std::memory_order_acquire);
+  if (sequence != dequeue_position_ + 1) {
+    return false;
+  }
+  record = cell->record;
+  cell->sequence.store(dequeue_position_ + mask_ + 1,
+                       std::memory_order_release);
+  dequeue_position_++;
+  return true;
+}
+
+int32_t TimelineNameTable::Intern(const std::string& name) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto& index = indices_[name];
+  if (index == 0) {
+    names_.push_back(name);
+    index = (int32_t)names_.size();
+  }
+  return index;
+}
+
+void TimelineNameTable::CopyNewNames(std::vector<std::string>* names) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  names->insert(names->end(), names_.begin() + names->size(), names_.end());
+}
+
+Timeline::~Timeline() { Shutdown(); }
+
+void Timeline::Initialize(std::string file_name,
+                          std::chrono::steady_clock::time_point start_time) {
   file_.open(file_name, std::ios::out | std::ios::trunc);
   if (file_.good()) {
     // Initialize the timeline with '[' character.
     file_ << "[" << std::endl;
-    start_time_ = last_flush_time_ = std::chrono::steady_clock::now();
+    start_time_ = start_time;
+    last_flush_time_ = std::chrono::steady_clock::now();
+    buffer_.reset(new TimelineRingBuffer(TIMELINE_BUFFER_SIZE));
+    writer_thread_ = std::thread(&Timeline::WriterLoop, this);
     initialized_ = true;
   } else {
     std::cerr << "WARNING: Error opening the Horovod Timeline file "
@@ -36,71 +104,143 @@ void Timeline::Initialize(std::string file_name) {
 
 bool Timeline::Initialized() const { return initialized_; }
 
-// Write event to the Horovod Timeline file.
-void Timeline::WriteEvent(const std::string& tensor_name, const char phase,
-                          const std::string& op_name, const std::string& args) {
-  if (!file_.good()) {
-    return;
+void Timeline::Shutdown() {
+  if (writer_thread_.joinable()) {
+    shut_down_ = true;
+    writer_thread_.join();
   }
+}
 
-  // Ensure only single thread writes to file to avoid mangling.
-  std::lock_guard<std::mutex> guard(mutex_);
+// Record an event, to be written to the Horovod Timeline file by the writer
+// thread.
+void Timeline::WriteEvent(const std::string& tensor_name, const char phase,
+                          const std::string& op_name,
+                          const std::shared_ptr<Tensor> tensor) {
+  auto ts = std::chrono::steady_clock::now() - start_time_;
 
-  // Check if file is still good, as it may have errored in competing thread.
-  if (!file_.good()) {
-    return;
+  TimelineRecord record;
+  record.ts_micros =
+      std::chrono::duration_cast<std::chrono::microseconds>(ts).count();
+  record.tensor_index = tensor_names_.Intern(tensor_name);
+  record.name_index = op_name.empty() ? 0 : event_names_.Intern(op_name);
+  record.phase = phase;
+  record.dtype = -1;
+  record.num_dims = 0;
+  if (tensor != nullptr) {
+    auto& shape = tensor->shape();
+    record.dtype = (int8_t)tensor->dtype();
+    record.num_dims = (int8_t)std::min(shape.dims(), 127);
+    for (int d = 0; d < std::min(shape.dims(), TIMELINE_MAX_DIMS); d++) {
+      record.dims[d] = shape.dim_size(d);
+    }
   }
 
-  auto now = std::chrono::steady_clock::now();
-  auto ts = now - start_time_;
-  auto ts_micros =
-      std::chrono::duration_cast<std::chrono::microseconds>(ts).count();
+  if (!buffer_->Push(record)) {
+    dropped_events_++;
+  }
+}
+
+void Timeline::WriterLoop() {
+  while (true) {
+    // Read the flag before draining the buffer, so that the events recorded
+    // before shutting down are written.
+    bool shut_down = shut_down_;
+    bool wrote_events = false;
+    TimelineRecord record;
+    while (file_.good() && buffer_->Pop(record)) {
+      WriteRecord(record);
+      wrote_events = true;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (shut_down || now - last_flush_time_ >= TIMELINE_FLUSH_TIME) {
+      int64_t dropped_events = dropped_events_;
+      if (dropped_events > reported_dropped_events_) {
+        std::cerr << "WARNING: The Horovod Timeline buffer overflowed, "
+                  << dropped_events - reported_dropped_events_
+                  << " events were dropped." << std::endl;
+        reported_dropped_events_ = dropped_events;
+      }
+      file_.flush();
+      last_flush_time_ = now;
+      if (!file_.good()) {
+        std::cerr << "WARNING: Error writing to the Horovod Timeline after it "
+                     "was successfully opened, will stop writing the timeline."
+                  << std::endl;
+        return;
+      }
+    }
+    if (shut_down) {
+      return;
+    }
+    if (!wrote_events) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+}
 
-  auto& tensor_idx = tensor_table_[tensor_name];
-  if (tensor_idx == 0) {
-    tensor_idx = (int)tensor_table_.size();
+// Lines are not flushed individually, since the file is flushed periodically by
+// WriterLoop.
+void Timeline::WriteRecord(const TimelineRecord& record) {
+  if (record.tensor_index > (int32_t)tensor_name_copies_.size()) {
+    tensor_names_.CopyNewNames(&tensor_name_copies_);
+  }
+  if (record.name_index > (int32_t)event_name_copies_.size()) {
+    event_names_.CopyNewNames(&event_name_copies_);
+  }
 
+  int32_t tensor_idx = record.tensor_index;
+  if (registered_tensors_.insert(tensor_idx).second) {
     // We model tensors as processes. Register metadata for this "pid".
     file_ << "{";
     file_ << "\"name\": \"process_name\"";
     file_ << ", \"ph\": \"M\"";
     file_ << ", \"pid\": " << tensor_idx << "";
-    file_ << ", \"args\": {\"name\": \"" << tensor_name << "\"}";
-    file_ << "}," << std::endl;
+    file_ << ", \"args\": {\"name\": \""
+          << tensor_name_copies_[tensor_idx - 1] << "\"}";
+    file_ << "},\n";
     file_ << "{";
     file_ << "\"name\": \"process_sort_index\"";
     file_ << ", \"ph\": \"M\"";
     file_ << ", \"pid\": " << tensor_idx << "";
     file_ << ", \"args\": {\"sort_index\": " << tensor_idx << "}";
-    file_ << "}," << std::endl;
+    file_ << "},\n";
   }
 
+  char phase = record.phase;
   file_ << "{";
   file_ << "\"ph\": \"" << phase << "\"";
   if (phase != 'E') {
     // Not necessary for ending event.
-    file_ << ", \"name\": \"" << op_name << "\"";
+    file_ << ", \"name\": \"";
+    if (record.name_index > 0) {
+      file_ << event_name_copies_[record.name_index - 1];
+    }
+    file_ << "\"";
   }
-  file_ << ", \"ts\": " << ts_micros << "";
+  file_ << ", \"ts\": " << record.ts_micros << "";
   file_ << ", \"pid\": " << tensor_idx << "";
   if (phase == 'X') {
     file_ << ", \"dur\": " << 0 << "";
   }
-  if (args != "") {
-    file_ << ", \"args\": {" << args << "}";
-  }
-  file_ << "}," << std::endl;
-
-  if (now - last_flush_time_ >= TIMELINE_FLUSH_TIME) {
-    file_.flush();
-    last_flush_time_ = now;
-  }
-
-  if (!file_.good()) {
-    std::cerr << "WARNING: Error writing to the Horovod Timeline after it was "
-                 "successfully opened, will stop writing the timeline."
-              << std::endl;
+  if (record.dtype >= 0) {
+    file_ << ", \"args\": {";
+    file_ << "\"dtype\": \""
+          << MPIDataType_Name((MPIDataType)record.dtype) << "\"";
+    file_ << ", \"shape\": \"[";
+    for (int d = 0; d < std::min((int)record.num_dims, TIMELINE_MAX_DIMS);
+         d++) {
+      if (d > 0) {
+        file_ << ", ";
+      }
+      file_ << record.dims[d];
+    }
+    if (record.num_dims > TIMELINE_MAX_DIMS) {
+      file_ << ", ...";
+    }
+    file_ << "]\"}";
   }
+  file_ << "},\n";
 }
 
 void Timeline::NegotiateStart(const std::string& tensor_name,
@@ -173,12 +313,7 @@ void Timeline::End(const std::string& tensor_name, const std::shared_ptr<Tensor>
     ActivityEnd(tensor_name);
   }
 
-  std::stringstream args;
-  if (tensor != nullptr) {
-    args << "\"dtype\": \"" << MPIDataType_Name(tensor->dtype()) << "\"";
-    args << ", \"shape\": \"" << tensor->shape().DebugString() << "\"";
-  }
-  WriteEvent(tensor_name, 'E', "", args.str());
+  WriteEvent(tensor_name, 'E', "", tensor);
 }
 
 } // namespace common
@@ -16,11 +16,16 @@
 #ifndef HOROVOD_TIMELINE_H
 #define HOROVOD_TIMELINE_H
 
+#include <atomic>
 #include <chrono>
 #include <fstream>
 #include <iostream>
-#include <unordered_map>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "common.h"
 #include "mpi_message.h"
@@ -31,14 +36,98 @@ namespace common {
 // How frequently Horovod Timeline should be flushed to disk.
 #define TIMELINE_FLUSH_TIME std::chrono::seconds(1)
 
+// Number of events that can be recorded before the writer thread serializes
+// them. Events recorded while the buffer is full are dropped.
+#define TIMELINE_BUFFER_SIZE (1 << 16)
+
+// Maximum number of dimensions of the tensor shapes recorded in events.
+#define TIMELINE_MAX_DIMS 8
+
 enum TimelineState { UNKNOWN, NEGOTIATING, TOP_LEVEL, ACTIVITY };
 
+// A fixed-size timeline event. Tensor and event names are interned and
+// referred to by their index, starting from 1, and 0 means no name.
+struct TimelineRecord {
+  int64_t ts_micros;
+  int32_t tensor_index;
+  int32_t name_index;
+  char phase;
+  // Data type and shape of the tensor at the end of an operation, if `dtype`
+  // is not negative.
+  int8_t dtype;
+  int8_t num_dims;
+  int64_t dims[TIMELINE_MAX_DIMS];
+};
+
+// A bounded, lock-free queue of timeline events, which can be pushed by
+// multiple threads and popped by a single thread. It is based on the bounded
+// MPMC queue by Dmitry Vyukov.
+class TimelineRingBuffer {
+public:
+  explicit TimelineRingBuffer(size_t capacity);
+
+  // Returns false, without blocking, if the buffer is full.
+  bool Push(const TimelineRecord& record);
+
+  // Returns false if the buffer is empty. Must only be called by one thread.
+  bool Pop(TimelineRecord& record);
+
+private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    TimelineRecord record;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  std::atomic<size_t> enqueue_position_;
+  size_t dequeue_position_ = 0;
+};
+
+// Interns strings, so that timeline events can refer to them by index.
+class TimelineNameTable {
+public:
+  // Returns the index of `name`, starting from one, and interns it if it was
+  // not interned yet.
+  int32_t Intern(const std::string& name);
+
+  // Appends the names that were interned after the first `names->size()` ones
+  // to `names`.
+  void CopyNewNames(std::vector<std::string>* names);
+
+private:
+  // Guards the table, which is shared by the threads that record events and
+  // the writer thread.
+  std::mutex mutex_;
+  std::unordered_map<std::string, int32_t> indices_;
+  std::vector<std::string> names_;
+};
+
 // Writes timeline in Chrome Tracing format. Timeline spec is from:
 // https://github.com/catapult-project/catapult/tree/master/tracing
+//
+// Recording an event only looks up the indices of its names and pushes a
+// fixed-size record into a ring buffer, so that collective operations are not
+// slowed down by the timeline. The events are serialized and written to the
+// file by a separate writer thread. Events are recorded by the background
+// thread, as well as by the threads that finalize NCCL operations, and so the
+// name tables are guarded by locks and the ring buffer accepts multiple
+// producers.
 class Timeline {
 public:
-  void Initialize(std::string file_name);
+  ~Timeline();
+
+  // Starts writing the timeline to `file_name`. Timestamps are measured from
+  // `start_time`, which allows timelines recorded by different ranks to be
+  // aligned.
+  void Initialize(std::string file_name,
+                  std::chrono::steady_clock::time_point start_time =
+                      std::chrono::steady_clock::now());
   bool Initialized() const;
+
+  // Writes the events that are still buffered and stops the writer thread.
+  void Shutdown();
+
   void NegotiateStart(const std::string& tensor_name,
                       const MPIRequest::RequestType request_type);
   void NegotiateRankReady(const std::string& tensor_name, const int rank);
@@ -53,7 +142,13 @@ public:
 private:
   void WriteEvent(const std::string& tensor_name, const char phase,
                   const std::string& op_name = "",
-                  const std::string& args = "");
+                  const std::shared_ptr<Tensor> tensor = nullptr);
+
+  void WriterLoop();
+
+  // Serializes `record` to the timeline file. Only called by the writer
+  // thread.
+  void WriteRecord(const TimelineRecord& record);
 
   // Boolean flag indicating whether Timeline was initialized (and thus should
   // be recorded).
@@ -62,21 +157,35 @@ private:
   // Time point when Horovod was started.
   std::chrono::steady_clock::time_point start_time_;
 
-  // Last time stream was flushed.
-  std::chrono::steady_clock::time_point last_flush_time_;
+  // Events that have been recorded, but not yet written.
+  std::unique_ptr<TimelineRingBuffer> buffer_;
 
-  // Timeline file.
-  std::ofstream file_;
+  // Number of events that were dropped because the buffer was full.
+  std::atomic<int64_t> dropped_events_{0};
 
-  // A mutex that guards timeline file from concurrent access.
-  std::mutex mutex_;
+  TimelineNameTable tensor_names_;
+  TimelineNameTable event_names_;
 
-  // Mapping of tensor names to indexes. It is used to reduce size of the
-  // timeline file.
-  std::unordered_map<std::string, int> tensor_table_;
+  std::thread writer_thread_;
+  std::atomic<bool> shut_down_{false};
 
   // Current state of each tensor in the timeline.
   std::unordered_map<std::string, TimelineState> tensor_states_;
+
+  // The following are only accessed by the writer thread.
+
+  // Timeline file.
+  std::ofstream file_;
+
+  // Last time stream was flushed.
+  std::chrono::steady_clock::time_point last_flush_time_;
+
+  // Copies of the interned names, and indexes of the tensors for which the
+  // metadata was already written.
+  std::vector<std::string> tensor_name_copies_;
+  std::vector<std::string> event_name_copies_;
+  std::unordered_set<int32_t> registered_tensors_;
+  int64_t reported_dropped_events_ = 0;
 };
 
 } // namespace common
@@ -0,0 +1,131 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <cstring>
+#include <utility>
+
+#include "shm_transport.h"
+#include "tcp_transport.h"
+#include "transport.h"
+
+namespace horovod {
+namespace common {
+
+int Transport::rank() const { return rank_; }
+
+int Transport::size() const { return size_; }
+
+int Transport::local_rank() const { return local_rank_; }
+
+int Transport::local_size() const { return local_size_; }
+
+bool Transport::Gather(const std::string& message,
+                       std::vector<std::string>& messages) {
+  // Exchange the message lengths first, so that every rank knows the layout
+  // of the gathered buffer. Only rank zero keeps the messages.
+  std::vector<int64_t> lengths(size_, 0);
+  lengths[rank_] = (int64_t)message.size();
+  if (!Allgatherv(lengths.data(),
+                  std::vector<int64_t>(size_, sizeof(int64_t)))) {
+    return false;
+  }
+
+  int64_t offset = 0;
+  for (int r = 0; r < rank_; r++) {
+    offset += lengths[r];
+  }
+  int64_t total_length = offset;
+  for (int r = rank_; r < size_; r++) {
+    total_length += lengths[r];
+  }
+  std::vector<char> buffer((size_t)total_length + 1);
+  std::memcpy(buffer.data() + offset, message.data(), message.size());
+  if (!Allgatherv(buffer.data(), lengths)) {
+    return false;
+  }
+
+  messages.clear();
+  if (rank_ == 0) {
+    offset = 0;
+    for (int r = 0; r < size_; r++) {
+      messages.emplace_back(buffer.data() + offset, (size_t)lengths[r]);
+      offset += lengths[r];
+    }
+  }
+  return true;
+}
+
+bool Transport::BroadcastString(std::string& message, int root_rank) {
+  int64_t length = (int64_t)message.size();
+  if (!Broadcast(&length, sizeof(length), root_rank)) {
+    return false;
+  }
+  message.resize((size_t)length);
+  return length == 0 || Broadcast(&message[0], length, root_rank);
+}
+
+bool Transport::BitwiseAndAllreduce(uint64_t* words, int64_t num_words) {
+  std::vector<uint64_t> gathered((size_t)(num_words * size_));
+  std::memcpy(gathered.data() + rank_ * num_words, words,
+              (size_t)num_words * sizeof(uint64_t));
+  if (!Allgatherv(gathered.data(),
+                  std::vector<int64_t>(size_, num_words * sizeof(uint64_t)))) {
+    return false;
+  }
+  for (int r = 0; r < size_; r++) {
+    for (int64_t i = 0; i < num_words; i++) {
+      words[i] &= gathered[r * num_words + i];
+    }
+  }
+  return true;
+}
+
+std::unique_ptr<Transport>
+CreateTransport(const std::string& name, int rank, int size,
+                const std::string& rendezvous_file,
+                std::chrono::steady_clock::duration timeout,
+                std::string& error) {
+  if (size < 1 || rank < 0 || rank >= size) {
+    error = "Invalid rank " + std::to_string(rank) + " for a job of size " +
+            std::to_string(size) + ".";
+    return nullptr;
+  }
+  if (rendezvous_file.empty()) {
+    error = "A rendezvous file is required.";
+    return nullptr;
+  }
+  if (name == "shm") {
+    auto shm_transport = new ShmTransport(rank, size, timeout);
+    std::unique_ptr<Transport> transport(shm_transport);
+    if (!shm_transport->Connect(rendezvous_file, error)) {
+      return nullptr;
+    }
+    return transport;
+  }
+  if (name == "tcp") {
+    auto tcp_transport = new TcpTransport(rank, size, timeout);
+    std::unique_ptr<Transport> transport(tcp_transport);
+    if (!tcp_transport->Connect(rendezvous_file, error)) {
+      return nullptr;
+    }
+    return transport;
+  }
+  error = "Unknown transport \"" + name +
+          "\". Supported transports are \"shm\" and \"tcp\".";
+  return nullptr;
+}
+
+} // namespace common
+} // namespace horovod
@@ -0,0 +1,106 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HOROVOD_TRANSPORT_H
+#define HOROVOD_TRANSPORT_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mpi_message.h"
+
+namespace horovod {
+namespace common {
+
+// A Transport performs the collective operations that the background thread
+// needs, without MPI. All ranks must call the same operations in the same
+// order, with buffers that reside in host memory. Operations return false if
+// communication failed, after which the transport must not be used anymore.
+// Operations also fail, instead of blocking forever, when the other ranks make
+// no progress for longer than the timeout of the transport, e.g., because one
+// of them died.
+//
+// Ranks find each other through a rendezvous file, whose path must be the same
+// on all ranks and must not exist before the job starts.
+class Transport {
+public:
+  virtual ~Transport(){};
+
+  int rank() const;
+  int size() const;
+  int local_rank() const;
+  int local_size() const;
+
+  // Sums `num_elements` values of type `dtype` across all ranks, in place.
+  virtual bool Allreduce(void* buffer, int64_t num_elements,
+                         MPIDataType dtype) = 0;
+
+  // Concatenates blocks of bytes across all ranks, in place. The block of rank
+  // r is `counts[r]` bytes long and starts after the blocks of all previous
+  // ranks. Every rank must have stored its own block at that position.
+  virtual bool Allgatherv(void* buffer, const std::vector<int64_t>& counts) = 0;
+
+  // Copies `num_bytes` bytes from `buffer` on `root_rank` to `buffer` on all
+  // other ranks.
+  virtual bool Broadcast(void* buffer, int64_t num_bytes, int root_rank) = 0;
+
+  // Sends `sendcounts[r]` bytes to every rank r, taken back to back from
+  // `sendbuf`, and receives `recvcounts[r]` bytes from every rank r, stored
+  // back to back in `recvbuf`.
+  virtual bool Alltoallv(const void* sendbuf,
+                         const std::vector<int64_t>& sendcounts, void* recvbuf,
+                         const std::vector<int64_t>& recvcounts) = 0;
+
+  // Gathers the `message` of every rank into `messages` on rank zero, indexed
+  // by rank. `messages` is left empty on other ranks.
+  bool Gather(const std::string& message, std::vector<std::string>& messages);
+
+  // Copies `message` from `root_rank` to all other ranks.
+  bool BroadcastString(std::string& message, int root_rank);
+
+  // Computes the bitwise AND of `num_words` words across all ranks, in place.
+  bool BitwiseAndAllreduce(uint64_t* words, int64_t num_words);
+
+protected:
+  int rank_ = 0;
+  int size_ = 1;
+  int local_rank_ = 0;
+  int local_size_ = 1;
+
+  // Bounds every wait for the other ranks, including the rendezvous.
+  std::chrono::steady_clock::duration timeout_;
+
+  // Set when an operation fails, after which all operations fail immediately,
+  // since the ranks can no longer agree on the state of the transport.
+  bool failed_ = false;
+};
+
+// Creates the transport called `name`, which is either "shm", for ranks that
+// all run on the same host and communicate through shared memory, or "tcp",
+// for ranks that may run on different hosts and communicate through sockets.
+// Returns null and sets `error` if the transport could not be created.
+std::unique_ptr<Transport>
+CreateTransport(const std::string& name, int rank, int size,
+                const std::string& rendezvous_file,
+                std::chrono::steady_clock::duration timeout,
+                std::string& error);
+
+} // namespace common
+} // namespace horovod
+
+#endif // HOROVOD_TRANSPORT_H
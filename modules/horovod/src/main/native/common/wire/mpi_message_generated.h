@@ -41,8 +41,10 @@ enum MPIDataType {
   MPIDataType_HOROVOD_FLOAT32 = 6,
   MPIDataType_HOROVOD_FLOAT64 = 7,
   MPIDataType_HOROVOD_BOOL = 8,
+  MPIDataType_HOROVOD_FLOAT16 = 9,
+  MPIDataType_HOROVOD_BFLOAT16 = 10,
   MPIDataType_MIN = MPIDataType_HOROVOD_UINT8,
-  MPIDataType_MAX = MPIDataType_HOROVOD_BOOL
+  MPIDataType_MAX = MPIDataType_HOROVOD_BFLOAT16
 };
 
 inline const char **EnumNamesMPIDataType() {
@@ -56,6 +58,8 @@ inline const char **EnumNamesMPIDataType() {
     "HOROVOD_FLOAT32",
     "HOROVOD_FLOAT64",
     "HOROVOD_BOOL",
+    "HOROVOD_FLOAT16",
+    "HOROVOD_BFLOAT16",
     nullptr
   };
   return names;
@@ -70,8 +74,9 @@ enum MPIRequestType {
   MPIRequestType_ALLREDUCE = 0,
   MPIRequestType_ALLGATHER = 1,
   MPIRequestType_BROADCAST = 2,
+  MPIRequestType_ALLTOALL = 3,
   MPIRequestType_MIN = MPIRequestType_ALLREDUCE,
-  MPIRequestType_MAX = MPIRequestType_BROADCAST
+  MPIRequestType_MAX = MPIRequestType_ALLTOALL
 };
 
 inline const char **EnumNamesMPIRequestType() {
@@ -79,6 +84,7 @@ inline const char **EnumNamesMPIRequestType() {
     "ALLREDUCE",
     "ALLGATHER",
     "BROADCAST",
+    "ALLTOALL",
     nullptr
   };
   return names;
@@ -96,8 +102,9 @@ enum MPIResponseType {
   MPIResponseType_ERROR = 3,
   MPIResponseType_DONE = 4,
   MPIResponseType_SHUTDOWN = 5,
+  MPIResponseType_ALLTOALL = 6,
   MPIResponseType_MIN = MPIResponseType_ALLREDUCE,
-  MPIResponseType_MAX = MPIResponseType_SHUTDOWN
+  MPIResponseType_MAX = MPIResponseType_ALLTOALL
 };
 
 inline const char **EnumNamesMPIResponseType() {
@@ -108,6 +115,7 @@ inline const char **EnumNamesMPIResponseType() {
     "ERROR",
     "DONE",
     "SHUTDOWN",
+    "ALLTOALL",
     nullptr
   };
   return names;
@@ -126,7 +134,9 @@ struct MPIRequest FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
     VT_TENSOR_NAME = 10,
     VT_ROOT_RANK = 12,
     VT_DEVICE = 14,
-    VT_TENSOR_SHAPE = 16
+    VT_TENSOR_SHAPE = 16,
+    VT_SPLITS = 18,
+    VT_TOP_K_RATIO = 20
   };
   int32_t request_rank() const {
     return GetField<int32_t>(VT_REQUEST_RANK, 0);
@@ -149,6 +159,12 @@ struct MPIRequest FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   const flatbuffers::Vector<int64_t> *tensor_shape() const {
     return GetPointer<const flatbuffers::Vector<int64_t> *>(VT_TENSOR_SHAPE);
   }
+  const flatbuffers::Vector<int64_t> *splits() const {
+    return GetPointer<const flatbuffers::Vector<int64_t> *>(VT_SPLITS);
+  }
+  float top_k_ratio() const {
+    return GetField<float>(VT_TOP_K_RATIO, 0.0f);
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<int32_t>(verifier, VT_REQUEST_RANK) &&
@@ -160,6 +176,9 @@ struct MPIRequest FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            VerifyField<int32_t>(verifier, VT_DEVICE) &&
            VerifyField<flatbuffers::uoffset_t>(verifier, VT_TENSOR_SHAPE) &&
            verifier.Verify(tensor_shape()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_SPLITS) &&
+           verifier.Verify(splits()) &&
+           VerifyField<float>(verifier, VT_TOP_K_RATIO) &&
            verifier.EndTable();
   }
 };
@@ -188,13 +207,19 @@ struct MPIRequestBuilder {
   void add_tensor_shape(flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_shape) {
     fbb_.AddOffset(MPIRequest::VT_TENSOR_SHAPE, tensor_shape);
   }
+  void add_splits(flatbuffers::Offset<flatbuffers::Vector<int64_t>> splits) {
+    fbb_.AddOffset(MPIRequest::VT_SPLITS, splits);
+  }
+  void add_top_k_ratio(float top_k_ratio) {
+    fbb_.AddElement<float>(MPIRequest::VT_TOP_K_RATIO, top_k_ratio, 0.0f);
+  }
   MPIRequestBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
   }
   MPIRequestBuilder &operator=(const MPIRequestBuilder &);
   flatbuffers::Offset<MPIRequest> Finish() {
-    const auto end = fbb_.EndTable(start_, 7);
+    const auto end = fbb_.EndTable(start_, 9);
     auto o = flatbuffers::Offset<MPIRequest>(end);
     return o;
   }
@@ -208,8 +233,12 @@ inline flatbuffers::Offset<MPIRequest> CreateMPIRequest(
     flatbuffers::Offset<flatbuffers::String> tensor_name = 0,
     int32_t root_rank = 0,
     int32_t device = 0,
-    flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_shape = 0) {
+    flatbuffers::Offset<flatbuffers::Vector<int64_t>> tensor_shape = 0,
+    flatbuffers::Offset<flatbuffers::Vector<int64_t>> splits = 0,
+    float top_k_ratio = 0.0f) {
   MPIRequestBuilder builder_(_fbb);
+  builder_.add_top_k_ratio(top_k_ratio);
+  builder_.add_splits(splits);
   builder_.add_tensor_shape(tensor_shape);
   builder_.add_device(device);
   builder_.add_root_rank(root_rank);
@@ -228,7 +257,9 @@ inline flatbuffers::Offset<MPIRequest> CreateMPIRequestDirect(
     const char *tensor_name = nullptr,
     int32_t root_rank = 0,
     int32_t device = 0,
-    const std::vector<int64_t> *tensor_shape = nullptr) {
+    const std::vector<int64_t> *tensor_shape = nullptr,
+    const std::vector<int64_t> *splits = nullptr,
+    float top_k_ratio = 0.0f) {
   return horovod::common::wire::CreateMPIRequest(
       _fbb,
       request_rank,
@@ -237,7 +268,9 @@ inline flatbuffers::Offset<MPIRequest> CreateMPIRequestDirect(
       tensor_name ? _fbb.CreateString(tensor_name) : 0,
       root_rank,
       device,
-      tensor_shape ? _fbb.CreateVector<int64_t>(*tensor_shape) : 0);
+      tensor_shape ? _fbb.CreateVector<int64_t>(*tensor_shape) : 0,
+      splits ? _fbb.CreateVector<int64_t>(*splits) : 0,
+      top_k_ratio);
 }
 
 struct MPIRequestList FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
@@ -21,6 +21,17 @@ JNIEXPORT void JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_init(
   horovod::common::horovod_init();
 }
 
+JNIEXPORT jboolean JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_initWithProcessSets(
+    JNIEnv* env, jobject object, jintArray process_set_ranks, jintArray process_set_sizes) {
+  jint* ranks = env->GetIntArrayElements(process_set_ranks, nullptr);
+  jint* sizes = env->GetIntArrayElements(process_set_sizes, nullptr);
+  bool initialized = horovod::common::horovod_init_with_process_sets(
+      reinterpret_cast<int*>(ranks), reinterpret_cast<int*>(sizes), env->GetArrayLength(process_set_sizes));
+  env->ReleaseIntArrayElements(process_set_sizes, sizes, JNI_ABORT);
+  env->ReleaseIntArrayElements(process_set_ranks, ranks, JNI_ABORT);
+  return static_cast<jboolean>(initialized);
+}
+
 JNIEXPORT int JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_rank(JNIEnv* env, jobject object) {
   return horovod::common::horovod_rank();
 }
@@ -40,3 +51,50 @@ JNIEXPORT int JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_localS
 JNIEXPORT int JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_mpiThreadsSupported(JNIEnv* env, jobject object) {
   return horovod::common::horovod_mpi_threads_supported();
 }
+
+JNIEXPORT int JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_processSetRank(
+    JNIEnv* env, jobject object, jint process_set_id) {
+  return horovod::common::horovod_process_set_rank(process_set_id);
+}
+
+JNIEXPORT int JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_processSetSize(
+    JNIEnv* env, jobject object, jint process_set_id) {
+  return horovod::common::horovod_process_set_size(process_set_id);
+}
+
+JNIEXPORT jdoubleArray JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_metrics(
+    JNIEnv* env, jobject object) {
+  double values[horovod::common::HOROVOD_NUM_METRICS];
+  int num_values = horovod::common::horovod_metrics(values, horovod::common::HOROVOD_NUM_METRICS);
+  if (num_values < 0) return nullptr;
+  jdoubleArray result = env->NewDoubleArray(num_values);
+  env->SetDoubleArrayRegion(result, 0, num_values, values);
+  return result;
+}
+
+JNIEXPORT jobjectArray JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_tensorMetricNames(
+    JNIEnv* env, jobject object) {
+  std::vector<std::string> names;
+  if (!horovod::common::GetMetricsTensorNames(names).ok()) return nullptr;
+  jclass string_class = env->FindClass("java/lang/String");
+  jobjectArray result = env->NewObjectArray(static_cast<jsize>(names.size()), string_class, nullptr);
+  for (size_t i = 0; i < names.size(); ++i) {
+    jstring name = env->NewStringUTF(names[i].c_str());
+    env->SetObjectArrayElement(result, static_cast<jsize>(i), name);
+    env->DeleteLocalRef(name);
+  }
+  return result;
+}
+
+JNIEXPORT jdoubleArray JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_tensorMetrics(
+    JNIEnv* env, jobject object, jstring tensor_name) {
+  const char* c_tensor_name = env->GetStringUTFChars(tensor_name, nullptr);
+  double values[horovod::common::HOROVOD_NUM_TENSOR_METRICS];
+  int num_values = horovod::common::horovod_tensor_metrics(
+      c_tensor_name, values, horovod::common::HOROVOD_NUM_TENSOR_METRICS);
+  env->ReleaseStringUTFChars(tensor_name, c_tensor_name);
+  if (num_values < 0) return nullptr;
+  jdoubleArray result = env->NewDoubleArray(num_values);
+  env->SetDoubleArrayRegion(result, 0, num_values, values);
+  return result;
+}
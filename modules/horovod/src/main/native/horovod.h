@@ -15,6 +15,14 @@ extern "C" {
 JNIEXPORT void JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_init
   (JNIEnv *, jobject);
 
+/*
+ * Class:     org_platanios_tensorflow_horovod_Horovod__
+ * Method:    initWithProcessSets
+ * Signature: ([I[I)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_initWithProcessSets
+  (JNIEnv *, jobject, jintArray, jintArray);
+
 /*
  * Class:     org_platanios_tensorflow_horovod_Horovod__
  * Method:    rank
@@ -55,6 +63,46 @@ JNIEXPORT int JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_localS
 JNIEXPORT int JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_mpiThreadsSupported
   (JNIEnv *, jobject);
 
+/*
+ * Class:     org_platanios_tensorflow_horovod_Horovod__
+ * Method:    processSetRank
+ * Signature: (I)I
+ */
+JNIEXPORT int JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_processSetRank
+  (JNIEnv *, jobject, jint);
+
+/*
+ * Class:     org_platanios_tensorflow_horovod_Horovod__
+ * Method:    processSetSize
+ * Signature: (I)I
+ */
+JNIEXPORT int JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_processSetSize
+  (JNIEnv *, jobject, jint);
+
+/*
+ * Class:     org_platanios_tensorflow_horovod_Horovod__
+ * Method:    metrics
+ * Signature: ()[D
+ */
+JNIEXPORT jdoubleArray JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_metrics
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     org_platanios_tensorflow_horovod_Horovod__
+ * Method:    tensorMetricNames
+ * Signature: ()[Ljava/lang/String;
+ */
+JNIEXPORT jobjectArray JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_tensorMetricNames
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     org_platanios_tensorflow_horovod_Horovod__
+ * Method:    tensorMetrics
+ * Signature: (Ljava/lang/String;)[D
+ */
+JNIEXPORT jdoubleArray JNICALL Java_org_platanios_tensorflow_horovod_Horovod_00024_tensorMetrics
+  (JNIEnv *, jobject, jstring);
+
 #ifdef __cplusplus
 }
 #endif
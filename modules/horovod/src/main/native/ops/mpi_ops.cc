@@ -14,7 +14,11 @@
 // limitations under the License.
 // =============================================================================
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <queue>
 #include <thread>
 #include <unordered_map>
@@ -22,6 +26,7 @@
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 
 #define EIGEN_USE_THREADS
 
@@ -31,6 +36,7 @@
 
 #define OMPI_SKIP_MPICXX
 #include "../common/operations.h"
+#include "../common/reduction.h"
 
 using namespace tensorflow;
 using namespace horovod;
@@ -118,6 +124,65 @@ private:
   OpKernelContext* context_;
 };
 
+// A TFOpContext that allocates the result of a Horovod operation as a
+// temporary tensor instead of as the output of the op, for ops that combine
+// the results of multiple Horovod operations.
+class TFTempOpContext : public TFOpContext {
+public:
+  TFTempOpContext(OpKernelContext* context, DataType dtype);
+  virtual common::Status
+  AllocateOutput(common::TensorShape shape,
+                 std::shared_ptr<common::Tensor>* tensor) override;
+  const Tensor& output() const;
+
+private:
+  DataType dtype_;
+  Tensor output_;
+};
+
+// Calls `callback` with the first error, if any, once `count` Horovod
+// operations have completed.
+class OperationGroup {
+public:
+  OperationGroup(int count, std::function<void(const Status&)> callback);
+  void Complete(const common::Status& status);
+
+private:
+  std::mutex mutex_;
+  int pending_;
+  Status status_;
+  std::function<void(const Status&)> callback_;
+};
+
+common::MPIDataType ConvertDataType(DataType dtype) {
+  switch (dtype) {
+  case DT_UINT8:
+    return common::HOROVOD_UINT8;
+  case DT_INT8:
+    return common::HOROVOD_INT8;
+  case DT_UINT16:
+    return common::HOROVOD_UINT16;
+  case DT_INT16:
+    return common::HOROVOD_INT16;
+  case DT_INT32:
+    return common::HOROVOD_INT32;
+  case DT_INT64:
+    return common::HOROVOD_INT64;
+  case DT_FLOAT:
+    return common::HOROVOD_FLOAT32;
+  case DT_DOUBLE:
+    return common::HOROVOD_FLOAT64;
+  case DT_BOOL:
+    return common::HOROVOD_BOOL;
+  case DT_HALF:
+    return common::HOROVOD_FLOAT16;
+  case DT_BFLOAT16:
+    return common::HOROVOD_BFLOAT16;
+  default:
+    throw std::logic_error("Invalid tensor type.");
+  }
+}
+
 TFReadyEvent::TFReadyEvent(DeviceContext* device_context) {
 #if HAVE_CUDA
   auto executor = device_context->stream()->parent();
@@ -171,28 +236,7 @@ const void* TFPersistentBuffer::AccessData(
 TFTensor::TFTensor(::tensorflow::Tensor& tensor) : tensor_(tensor) {}
 
 const common::MPIDataType TFTensor::dtype() const {
-  switch (tensor_.dtype()) {
-  case DT_UINT8:
-    return common::HOROVOD_UINT8;
-  case DT_INT8:
-    return common::HOROVOD_INT8;
-  case DT_UINT16:
-    return common::HOROVOD_UINT16;
-  case DT_INT16:
-    return common::HOROVOD_INT16;
-  case DT_INT32:
-    return common::HOROVOD_INT32;
-  case DT_INT64:
-    return common::HOROVOD_INT64;
-  case DT_FLOAT:
-    return common::HOROVOD_FLOAT32;
-  case DT_DOUBLE:
-    return common::HOROVOD_FLOAT64;
-  case DT_BOOL:
-    return common::HOROVOD_BOOL;
-  default:
-    throw std::logic_error("Invalid tensor type.");
-  }
+  return ConvertDataType(tensor_.dtype());
 }
 
 const common::TensorShape TFTensor::shape() const {
@@ -248,6 +292,154 @@ common::Framework TFOpContext::framework() const {
 
 OpKernelContext* TFOpContext::GetKernelContext() const { return context_; }
 
+TFTempOpContext::TFTempOpContext(OpKernelContext* context, DataType dtype)
+    : TFOpContext(context), dtype_(dtype) {}
+
+common::Status
+TFTempOpContext::AllocateOutput(common::TensorShape shape,
+                                std::shared_ptr<common::Tensor>* tensor) {
+  TensorShape tf_shape;
+  for (int idx = 0; idx < shape.dims(); idx++) {
+    tf_shape.AddDim(shape.dim_size(idx));
+  }
+  Status status =
+      GetKernelContext()->allocate_temp(dtype_, tf_shape, &output_);
+  if (status.ok()) {
+    *tensor = std::make_shared<TFTensor>(output_);
+  }
+  return ConvertStatus(status);
+}
+
+const Tensor& TFTempOpContext::output() const { return output_; }
+
+OperationGroup::OperationGroup(int count,
+                               std::function<void(const Status&)> callback)
+    : pending_(count), callback_(callback) {}
+
+void OperationGroup::Complete(const common::Status& status) {
+  bool done;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (status_.ok() && !status.ok()) {
+      status_ = ConvertStatus(status);
+    }
+    done = --pending_ == 0;
+  }
+  if (done) {
+    callback_(status_);
+  }
+}
+
+// Horovod invokes callbacks on its background thread, so any substantial work
+// they do is moved to the TensorFlow worker threads to avoid delaying other
+// collective operations.
+void ScheduleOnWorkers(OpKernelContext* context, std::function<void()> fn) {
+  context->device()->tensorflow_cpu_worker_threads()->workers->Schedule(fn);
+}
+
+int64 IndexAt(const Tensor& indices, int64 i) {
+  return indices.dtype() == DT_INT32 ? indices.vec<int32>()(i)
+                                     : indices.vec<int64>()(i);
+}
+
+// Returns true if all the indices are in the range [0, num_rows).
+bool IndicesInRange(const Tensor& indices, int64 num_rows) {
+  for (int64 i = 0; i < indices.dim_size(0); i++) {
+    auto index = IndexAt(indices, i);
+    if (index < 0 || index >= num_rows) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SetIndex(Tensor* indices, int64 i, int64 value) {
+  if (indices->dtype() == DT_INT32) {
+    indices->vec<int32>()(i) = (int32)value;
+  } else {
+    indices->vec<int64>()(i) = value;
+  }
+}
+
+// Adds the rows of `values` to the rows of `dense` selected by `indices`,
+// after zeroing `dense`.
+Status ScatterAdd(const Tensor& indices, const Tensor& values, Tensor* dense) {
+  auto dst = const_cast<char*>(dense->tensor_data().data());
+  std::memset(dst, 0, dense->tensor_data().size());
+  auto num_rows = dense->dim_size(0);
+  auto n = indices.dim_size(0);
+  if (n == 0) {
+    return Status::OK();
+  }
+  auto dtype = ConvertDataType(values.dtype());
+  auto row_elements = values.NumElements() / n;
+  auto row_bytes = (int64)values.tensor_data().size() / n;
+  auto src = values.tensor_data().data();
+  for (int64 i = 0; i < n; i++) {
+    auto index = IndexAt(indices, i);
+    if (index < 0 || index >= num_rows) {
+      return errors::InvalidArgument("Index ", index, " is out of range [0, ",
+                                     num_rows, ").");
+    }
+    common::SumInto(dtype, dst + index * row_bytes, src + i * row_bytes,
+                    row_elements);
+  }
+  return Status::OK();
+}
+
+// Sums the rows of `values` that have the same index, and outputs the distinct
+// indices in increasing order along with the summed rows.
+Status Deduplicate(OpKernelContext* context, const Tensor& indices,
+                   const Tensor& values) {
+  auto n = indices.dim_size(0);
+  std::vector<int64> keys(n);
+  for (int64 i = 0; i < n; i++) {
+    keys[i] = IndexAt(indices, i);
+  }
+  std::vector<int64> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&keys](int64 a, int64 b) {
+    return keys[a] < keys[b];
+  });
+  int64 num_unique = 0;
+  for (int64 i = 0; i < n; i++) {
+    if (i == 0 || keys[order[i]] != keys[order[i - 1]]) {
+      num_unique++;
+    }
+  }
+
+  TensorShape values_shape = values.shape();
+  values_shape.set_dim(0, num_unique);
+  Tensor* output_indices;
+  Tensor* output_values;
+  TF_RETURN_IF_ERROR(context->allocate_output(
+      0, TensorShape({num_unique}), &output_indices));
+  TF_RETURN_IF_ERROR(
+      context->allocate_output(1, values_shape, &output_values));
+  if (n == 0) {
+    return Status::OK();
+  }
+
+  auto dtype = ConvertDataType(values.dtype());
+  auto row_elements = values.NumElements() / n;
+  auto row_bytes = (int64)values.tensor_data().size() / n;
+  auto src = values.tensor_data().data();
+  auto dst = const_cast<char*>(output_values->tensor_data().data());
+  int64 u = -1;
+  for (int64 i = 0; i < n; i++) {
+    auto row = order[i];
+    if (i == 0 || keys[row] != keys[order[i - 1]]) {
+      u++;
+      SetIndex(output_indices, u, keys[row]);
+      std::memcpy(dst + u * row_bytes, src + row * row_bytes, row_bytes);
+    } else {
+      common::SumInto(dtype, dst + u * row_bytes, src + row * row_bytes,
+                      row_elements);
+    }
+  }
+  return Status::OK();
+}
+
 int GetDeviceID(OpKernelContext* context) {
   int device = CPU_DEVICE_ID;
   if (context->device() != nullptr &&
@@ -274,7 +466,11 @@ TFReadyEvent* RecordReadyEvent(OpKernelContext* context) {
 class HorovodAllreduceOp : public AsyncOpKernel {
 public:
   explicit HorovodAllreduceOp(OpKernelConstruction* context)
-      : AsyncOpKernel(context) {}
+      : AsyncOpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("top_k_ratio", &top_k_ratio_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("process_set_id", &process_set_id_));
+  }
 
   void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
     OP_REQUIRES_OK_ASYNC(context, ConvertStatus(common::CheckInitialized()),
@@ -293,12 +489,17 @@ public:
     auto hvd_output = std::make_shared<TFTensor>(*output);
     auto enqueue_result = EnqueueTensorAllreduce(
         hvd_context, hvd_tensor, hvd_output, ready_event, node_name, device,
+        top_k_ratio_, process_set_id_,
         [context, done](const common::Status& status) {
           context->SetStatus(ConvertStatus(status));
           done();
         });
     OP_REQUIRES_OK_ASYNC(context, ConvertStatus(enqueue_result), done);
   }
+
+private:
+  float top_k_ratio_;
+  int process_set_id_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("HorovodAllreduce").Device(DEVICE_CPU),
@@ -309,7 +510,9 @@ REGISTER_KERNEL_BUILDER(Name("HorovodAllreduce").Device(DEVICE_GPU),
 #endif
 
 REGISTER_OP("HorovodAllreduce")
-    .Attr("T: {int32, int64, float32, float64}")
+    .Attr("T: {int32, int64, float16, bfloat16, float32, float64}")
+    .Attr("top_k_ratio: float = 0.0")
+    .Attr("process_set_id: int = 0")
     .Input("tensor: T")
     .Output("sum: T")
     .SetShapeFn([](shape_inference::InferenceContext* c) {
@@ -322,17 +525,30 @@ on a tensor with the same name must have the same dimension for that tensor.
 Tensors are reduced with other tensors that have the same node name for the
 allreduce.
 
+If `top_k_ratio` is between zero and one, and `tensor` is a float32 or float64
+tensor in host memory, every process only contributes that fraction of the
+elements of `tensor` with the largest magnitudes, and carries the remaining
+elements over to the next reduction of the tensor with the same name.
+
 Arguments
-    tensor:     A tensor to reduce.
+    tensor:          A tensor to reduce.
+    top_k_ratio:     The fraction of the elements that every process sends, or
+                     zero to send all elements. All processes must use the
+                     same ratio.
+    process_set_id:  The process set whose processes perform the reduction.
 
 Output
-    sum:    A tensor with the same shape as `tensor`, summed across all MPI processes.
+    sum:    A tensor with the same shape as `tensor`, summed across all MPI
+            processes of the process set.
 )doc");
 
 class HorovodAllgatherOp : public AsyncOpKernel {
 public:
   explicit HorovodAllgatherOp(OpKernelConstruction* context)
-      : AsyncOpKernel(context) {}
+      : AsyncOpKernel(context) {
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("process_set_id", &process_set_id_));
+  }
 
   void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
     OP_REQUIRES_OK_ASYNC(context, ConvertStatus(common::CheckInitialized()),
@@ -349,12 +565,15 @@ public:
     auto hvd_tensor = std::make_shared<TFTensor>(tensor);
     auto enqueue_result = EnqueueTensorAllgather(
         hvd_context, hvd_tensor, ready_event, node_name, device,
-        [context, done](const common::Status& status) {
+        process_set_id_, [context, done](const common::Status& status) {
           context->SetStatus(ConvertStatus(status));
           done();
         });
     OP_REQUIRES_OK_ASYNC(context, ConvertStatus(enqueue_result), done);
   }
+
+private:
+  int process_set_id_;
 }; // namespace tensorflow
 
 REGISTER_KERNEL_BUILDER(Name("HorovodAllgather").Device(DEVICE_CPU),
@@ -366,7 +585,9 @@ REGISTER_KERNEL_BUILDER(Name("HorovodAllgather").Device(DEVICE_GPU),
 
 REGISTER_OP("HorovodAllgather")
     .Attr(
-        "T: {uint8, int8, uint16, int16, int32, int64, float32, float64, bool}")
+        "T: {uint8, int8, uint16, int16, int32, int64, float16, bfloat16, "
+        "float32, float64, bool}")
+    .Attr("process_set_id: int = 0")
     .Input("tensor: T")
     .Output("output: T")
     .SetShapeFn([](shape_inference::InferenceContext* c) {
@@ -382,7 +603,8 @@ tensor with the same name must have the same rank for that tensor, and have the
 same dimension on all but the first dimension.
 
 Arguments
-    tensor:     A tensor to gather.
+    tensor:          A tensor to gather.
+    process_set_id:  The process set whose processes perform the gather.
 
 Output
     gathered:    A tensor with the same shape as `tensor` except for the first dimension.
@@ -393,6 +615,8 @@ public:
   explicit HorovodBroadcastOp(OpKernelConstruction* context)
       : AsyncOpKernel(context) {
     OP_REQUIRES_OK(context, context->GetAttr("root_rank", &root_rank_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("process_set_id", &process_set_id_));
   }
 
   void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
@@ -403,7 +627,7 @@ public:
     auto device = GetDeviceID(context);
     auto tensor = context->input(0);
     Tensor* output = nullptr;
-    if (common::horovod_rank() == root_rank_) {
+    if (common::horovod_process_set_rank(process_set_id_) == root_rank_) {
       context->set_output(0, tensor);
     } else {
       OP_REQUIRES_OK_ASYNC(
@@ -419,7 +643,7 @@ public:
     }
     auto enqueue_result = EnqueueTensorBroadcast(
         hvd_context, hvd_tensor, hvd_output, root_rank_, ready_event, node_name,
-        device, [context, done](const common::Status& status) {
+        device, process_set_id_, [context, done](const common::Status& status) {
           context->SetStatus(ConvertStatus(status));
           done();
         });
@@ -428,6 +652,7 @@ public:
 
 private:
   int root_rank_;
+  int process_set_id_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("HorovodBroadcast").Device(DEVICE_CPU),
@@ -439,8 +664,10 @@ REGISTER_KERNEL_BUILDER(Name("HorovodBroadcast").Device(DEVICE_GPU),
 
 REGISTER_OP("HorovodBroadcast")
     .Attr(
-        "T: {uint8, int8, uint16, int16, int32, int64, float32, float64, bool}")
+        "T: {uint8, int8, uint16, int16, int32, int64, float16, bfloat16, "
+        "float32, float64, bool}")
     .Attr("root_rank: int")
+    .Attr("process_set_id: int = 0")
     .Input("tensor: T")
     .Output("output: T")
     .SetShapeFn([](shape_inference::InferenceContext* c) {
@@ -452,13 +679,335 @@ Perform an MPI Broadcast on a tensor. All other processes that do a broadcast
 on a tensor with the same name must have the same dimension for that tensor.
 
 Arguments
-    tensor:     A tensor to broadcast.
-    root_rank:  Rank that will send data, other ranks will receive data.
+    tensor:          A tensor to broadcast.
+    root_rank:       Rank that will send data, other ranks will receive data.
+                     This is the rank within the process set.
+    process_set_id:  The process set whose processes perform the broadcast.
 
 Output
     output:    A tensor with the same shape as `tensor` and same value as
                `tensor` on root rank.
 )doc");
 
+class HorovodAlltoallOp : public AsyncOpKernel {
+public:
+  explicit HorovodAlltoallOp(OpKernelConstruction* context)
+      : AsyncOpKernel(context) {
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("process_set_id", &process_set_id_));
+  }
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(common::CheckInitialized()),
+                         done);
+
+    auto node_name = name();
+    auto device = GetDeviceID(context);
+    auto tensor = context->input(0);
+    auto splits = context->input(1);
+    OP_REQUIRES_ASYNC(context, TensorShapeUtils::IsVector(splits.shape()),
+                      errors::InvalidArgument("splits must be a vector."),
+                      done);
+    std::vector<int64_t> hvd_splits(splits.NumElements());
+    for (int64 i = 0; i < splits.NumElements(); i++) {
+      hvd_splits[i] = splits.vec<int32>()(i);
+    }
+    // ReadyEvent makes sure input tensor is ready.  We cannot pre-allocate
+    // output for alltoall, since shape of result is only known after all
+    // ranks make a request.
+    auto ready_event = std::shared_ptr<TFReadyEvent>(RecordReadyEvent(context));
+    auto hvd_context = std::make_shared<TFOpContext>(context);
+    auto hvd_tensor = std::make_shared<TFTensor>(tensor);
+    auto enqueue_result = EnqueueTensorAlltoall(
+        hvd_context, hvd_tensor, hvd_splits, ready_event, node_name, device,
+        process_set_id_, [context, done](const common::Status& status) {
+          context->SetStatus(ConvertStatus(status));
+          done();
+        });
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(enqueue_result), done);
+  }
+
+private:
+  int process_set_id_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("HorovodAlltoall").Device(DEVICE_CPU),
+                        HorovodAlltoallOp);
+
+REGISTER_OP("HorovodAlltoall")
+    .Attr(
+        "T: {uint8, int8, uint16, int16, int32, int64, float16, bfloat16, "
+        "float32, float64, bool}")
+    .Attr("process_set_id: int = 0")
+    .Input("tensor: T")
+    .Input("splits: int32")
+    .Output("output: T")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle output;
+      TF_RETURN_IF_ERROR(
+          c->ReplaceDim(c->input(0), 0, c->UnknownDim(), &output));
+      c->set_output(0, output);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Perform an MPI Alltoall on a tensor. The tensor is split along its first
+dimension into one split per process, and the i-th split is sent to the
+process with rank i. All other processes that do an alltoall on a tensor with
+the same name must have the same rank for that tensor, and have the same
+dimension on all but the first dimension.
+
+Arguments
+    tensor:     A tensor to distribute.
+    splits:     A vector with the number of rows sent to each process, which
+                must add up to the first dimension of `tensor`.
+    process_set_id:
+                The process set whose processes perform the alltoall. Ranks
+                refer to the ranks within the process set.
+
+Output
+    output:    A tensor with the same shape as `tensor` except for the first
+               dimension, containing the splits received from all processes in
+               order of rank.
+)doc");
+
+class HorovodSparseAllreduceOp : public AsyncOpKernel {
+public:
+  explicit HorovodSparseAllreduceOp(OpKernelConstruction* context)
+      : AsyncOpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("deduplicate", &deduplicate_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("dense_threshold", &dense_threshold_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("process_set_id", &process_set_id_));
+  }
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(common::CheckInitialized()),
+                         done);
+
+    auto node_name = name();
+    auto indices = context->input(0);
+    auto values = context->input(1);
+    auto dense_shape = context->input(2);
+    OP_REQUIRES_ASYNC(context, TensorShapeUtils::IsVector(indices.shape()),
+                      errors::InvalidArgument("indices must be a vector."),
+                      done);
+    OP_REQUIRES_ASYNC(
+        context,
+        values.dims() >= 1 && values.dim_size(0) == indices.dim_size(0),
+        errors::InvalidArgument("values must have one row per index."), done);
+    OP_REQUIRES_ASYNC(
+        context,
+        TensorShapeUtils::IsVector(dense_shape.shape()) &&
+            dense_shape.NumElements() == values.dims(),
+        errors::InvalidArgument(
+            "dense_shape must have one element per dimension of values."),
+        done);
+    auto dense_shape_vec = dense_shape.vec<int64>();
+    auto num_rows = dense_shape_vec(0);
+    OP_REQUIRES_ASYNC(context, num_rows >= 0,
+                      errors::InvalidArgument(
+                          "dense_shape[0] must be non-negative, but it is ",
+                          num_rows, "."),
+                      done);
+    for (int d = 1; d < values.dims(); d++) {
+      OP_REQUIRES_ASYNC(
+          context, dense_shape_vec(d) == values.dim_size(d),
+          errors::InvalidArgument("dense_shape[", d, "] is ",
+                                  dense_shape_vec(d), ", but values has ",
+                                  values.dim_size(d), " elements along that ",
+                                  "dimension."),
+          done);
+    }
+
+    // All ranks must choose the same algorithm, so the choice is based on the
+    // total number of rows of all ranks, which a small allreduce provides.
+    // The allreduce also counts the ranks whose indices are out of range, so
+    // that either all ranks fail or all ranks proceed to the same collective
+    // operations.
+    Tensor num_indices;
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        context->allocate_temp(DT_INT64, TensorShape({2}), &num_indices),
+        done);
+    num_indices.vec<int64>()(0) = indices.dim_size(0);
+    num_indices.vec<int64>()(1) = IndicesInRange(indices, num_rows) ? 0 : 1;
+    auto hvd_context = std::make_shared<TFOpContext>(context);
+    auto hvd_num_indices = std::make_shared<TFTensor>(num_indices);
+    auto enqueue_result = EnqueueTensorAllreduce(
+        hvd_context, hvd_num_indices, hvd_num_indices, nullptr,
+        node_name + "/num_indices", CPU_DEVICE_ID, 0.0f, process_set_id_,
+        [this, context, done, node_name, indices, values, num_rows,
+         num_indices](const common::Status& status) {
+          if (!status.ok()) {
+            context->SetStatus(ConvertStatus(status));
+            done();
+            return;
+          }
+          auto total_indices = num_indices.vec<int64>()(0);
+          auto invalid_ranks = num_indices.vec<int64>()(1);
+          if (invalid_ranks > 0) {
+            context->SetStatus(errors::InvalidArgument(
+                "Indices are out of range [0, ", num_rows, ") on ",
+                invalid_ranks, " processes."));
+            done();
+            return;
+          }
+          ScheduleOnWorkers(context, [=]() {
+            if (total_indices > dense_threshold_ * num_rows) {
+              DenseAllreduce(context, done, node_name, indices, values,
+                             num_rows);
+            } else {
+              SparseAllgather(context, done, node_name, indices, values);
+            }
+          });
+        });
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(enqueue_result), done);
+  }
+
+private:
+  // Scatters the local rows into a dense tensor and allreduces it. All the
+  // rows are output, in order.
+  void DenseAllreduce(OpKernelContext* context, DoneCallback done,
+                      const std::string& node_name, const Tensor& indices,
+                      const Tensor& values, int64 num_rows) {
+    TensorShape dense_shape = values.shape();
+    dense_shape.set_dim(0, num_rows);
+    Tensor dense;
+    OP_REQUIRES_OK_ASYNC(
+        context, context->allocate_temp(values.dtype(), dense_shape, &dense),
+        done);
+    OP_REQUIRES_OK_ASYNC(context, ScatterAdd(indices, values, &dense), done);
+
+    auto hvd_context = std::make_shared<TFOpContext>(context);
+    auto hvd_dense = std::make_shared<TFTensor>(dense);
+    auto enqueue_result = EnqueueTensorAllreduce(
+        hvd_context, hvd_dense, hvd_dense, nullptr, node_name + "/dense",
+        CPU_DEVICE_ID, 0.0f, process_set_id_,
+        [context, done, dense, num_rows](const common::Status& status) {
+          if (!status.ok()) {
+            context->SetStatus(ConvertStatus(status));
+            done();
+            return;
+          }
+          ScheduleOnWorkers(context, [context, done, dense, num_rows]() {
+            Tensor* output_indices;
+            OP_REQUIRES_OK_ASYNC(context,
+                                 context->allocate_output(
+                                     0, TensorShape({num_rows}),
+                                     &output_indices),
+                                 done);
+            for (int64 i = 0; i < num_rows; i++) {
+              SetIndex(output_indices, i, i);
+            }
+            context->set_output(1, dense);
+            done();
+          });
+        });
+    OP_REQUIRES_OK_ASYNC(context, ConvertStatus(enqueue_result), done);
+  }
+
+  // Allgathers the indices and values of all ranks, which are fused into a
+  // single collective operation, and optionally sums the duplicate rows.
+  void SparseAllgather(OpKernelContext* context, DoneCallback done,
+                       const std::string& node_name, const Tensor& indices,
+                       const Tensor& values) {
+    auto deduplicate = deduplicate_;
+    auto indices_context =
+        std::make_shared<TFTempOpContext>(context, indices.dtype());
+    auto values_context =
+        std::make_shared<TFTempOpContext>(context, values.dtype());
+    auto group = std::make_shared<OperationGroup>(
+        2, [context, done, deduplicate, indices_context,
+            values_context](const Status& status) {
+          OP_REQUIRES_OK_ASYNC(context, status, done);
+          ScheduleOnWorkers(context, [context, done, deduplicate,
+                                      indices_context, values_context]() {
+            if (deduplicate) {
+              OP_REQUIRES_OK_ASYNC(context,
+                                   Deduplicate(context,
+                                               indices_context->output(),
+                                               values_context->output()),
+                                   done);
+            } else {
+              context->set_output(0, indices_context->output());
+              context->set_output(1, values_context->output());
+            }
+            done();
+          });
+        });
+    auto callback = [group](const common::Status& status) {
+      group->Complete(status);
+    };
+
+    Tensor gathered_indices = indices;
+    Tensor gathered_values = values;
+    auto enqueue_result = EnqueueTensorAllgather(
+        indices_context, std::make_shared<TFTensor>(gathered_indices), nullptr,
+        node_name + "/indices", CPU_DEVICE_ID, process_set_id_, callback);
+    if (!enqueue_result.ok()) {
+      group->Complete(enqueue_result);
+    }
+    enqueue_result = EnqueueTensorAllgather(
+        values_context, std::make_shared<TFTensor>(gathered_values), nullptr,
+        node_name + "/values", CPU_DEVICE_ID, process_set_id_, callback);
+    if (!enqueue_result.ok()) {
+      group->Complete(enqueue_result);
+    }
+  }
+
+  bool deduplicate_;
+  float dense_threshold_;
+  int process_set_id_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("HorovodSparseAllreduce").Device(DEVICE_CPU),
+                        HorovodSparseAllreduceOp);
+
+REGISTER_OP("HorovodSparseAllreduce")
+    .Attr("T: {int32, int64, float16, bfloat16, float32, float64}")
+    .Attr("Tindices: {int32, int64}")
+    .Attr("deduplicate: bool = true")
+    .Attr("dense_threshold: float = 1.0")
+    .Attr("process_set_id: int = 0")
+    .Input("indices: Tindices")
+    .Input("values: T")
+    .Input("dense_shape: int64")
+    .Output("sum_indices: Tindices")
+    .Output("sum_values: T")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle values;
+      TF_RETURN_IF_ERROR(
+          c->ReplaceDim(c->input(1), 0, c->UnknownDim(), &values));
+      c->set_output(0, c->Vector(c->UnknownDim()));
+      c->set_output(1, values);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Perform an MPI Allreduce on a sparse tensor, represented by the rows `values`
+of a dense tensor with shape `dense_shape`, at positions `indices`. All other
+processes that do a reduction on a tensor with the same name must have the same
+dense shape for that tensor.
+
+If the total number of indices of all processes does not exceed
+`dense_threshold` times the number of rows of the dense tensor, the indices
+and values of all processes are gathered, and rows with the same index are
+summed if `deduplicate` is true. Otherwise, the sparse tensor is scattered into
+a dense tensor which is allreduced, and all its rows are returned.
+
+Arguments
+    indices:          A vector of row indices, which must be smaller than the
+                      first element of `dense_shape` on all processes.
+    values:           A tensor with one row per index.
+    dense_shape:      The shape of the dense tensor.
+    deduplicate:      Whether to sum the rows that have the same index.
+    dense_threshold:  Density above which a dense allreduce is performed.
+    process_set_id:   The process set whose processes perform the reduction.
+
+Output
+    sum_indices:    The row indices of the sum.
+    sum_values:     The rows of the sum, summed across all MPI processes.
+)doc");
+
 } // namespace tensorflow
 } // namespace horovod
@@ -150,9 +150,15 @@ private[horovod] object Horovod {
   load()
 
   @native def init(): Unit
+  @native def initWithProcessSets(processSetRanks: Array[Int], processSetSizes: Array[Int]): Boolean
   @native def rank(): Int
   @native def localRank(): Int
   @native def size(): Int
   @native def localSize(): Int
   @native def mpiThreadsSupported(): Int
+  @native def processSetRank(processSetId: Int): Int
+  @native def processSetSize(processSetId: Int): Int
+  @native def metrics(): Array[Double]
+  @native def tensorMetricNames(): Array[String]
+  @native def tensorMetrics(tensorName: String): Array[Double]
 }
@@ -37,6 +37,64 @@ package object horovod {
     /** Initializes Horovod. */
     def initialize(): Unit = Horovod.init()
 
+    /** Initializes Horovod with additional process sets, i.e., subsets of the processes that perform collective
+      * operations among themselves. All processes must call this function with the same process sets, including the
+      * processes that do not belong to some of them. Process sets are only supported when Horovod uses MPI, and they
+      * cannot be changed once Horovod has been initialized.
+      *
+      * The collective operations of a process set do not wait for the operations of other process sets. However, all
+      * processes still negotiate the process set that contains all processes once every cycle, and so their negotiation
+      * cycles remain synchronized with the slowest process of the whole job.
+      *
+      * @param  processSets Ranks of the processes that belong to each process set.
+      * @return Created process sets, in the same order as `processSets`.
+      * @throws IllegalStateException If Horovod has already been initialized with different process sets.
+      */
+    @throws[IllegalStateException]
+    def initialize(processSets: Seq[Seq[Int]]): Seq[ProcessSet] = {
+      if (!Horovod.initWithProcessSets(processSets.flatten.toArray, processSets.map(_.size).toArray))
+        throw new IllegalStateException("Horovod has already been initialized with different process sets.")
+      processSets.indices.map(i => ProcessSet(i + 1))
+    }
+
+    /** Set of Horovod processes that perform collective operations among themselves. The ranks of the processes
+      * within a process set are ordered by their global ranks, and root ranks and splits that are provided to
+      * collective operations over a process set refer to these ranks.
+      *
+      * @param  id Process set ID.
+      */
+    case class ProcessSet(id: Int) {
+      /** Returns the rank of the calling process within this process set.
+        *
+        * @throws IllegalStateException If Horovod has not been initialized yet, if this process set does not exist,
+        *                               or if the calling process does not belong to it.
+        */
+      @throws[IllegalStateException]
+      def rank: Int = {
+        val cValue = Horovod.processSetRank(id)
+        if (cValue == -1)
+          throw new IllegalStateException(s"The calling process does not belong to Horovod process set $id.")
+        cValue
+      }
+
+      /** Returns the number of processes in this process set.
+        *
+        * @throws IllegalStateException If Horovod has not been initialized yet or if this process set does not exist.
+        */
+      @throws[IllegalStateException]
+      def size: Int = {
+        val cValue = Horovod.processSetSize(id)
+        if (cValue == -1)
+          throw new IllegalStateException(s"Horovod process set $id does not exist.")
+        cValue
+      }
+    }
+
+    object ProcessSet {
+      /** Process set that contains all processes. */
+      val Global: ProcessSet = ProcessSet(0)
+    }
+
     /** Returns the Horovod rank of the calling process.
       *
       * @throws IllegalStateException If Horovod has not been initialized yet.
@@ -99,32 +157,156 @@ package object horovod {
       cValue > 0
     }
 
+    /** Metrics of the collective operations that the calling process has performed since Horovod was initialized.
+      * Times are in seconds.
+      *
+      * @param  tensorOperations        Number of tensors that were processed, counting every tensor of a fused
+      *                                 operation separately.
+      * @param  cachedTensorOperations  Number of tensors whose responses were taken from the response cache, without
+      *                                 negotiating them through the coordinator.
+      * @param  operations              Number of operations that were performed, counting fused operations once.
+      * @param  fusedOperations         Number of operations that were performed through the fusion buffer.
+      * @param  bytes                   Total size of the processed tensors.
+      * @param  bytesReduced            Total size of the all-reduced tensors.
+      * @param  queueingTime            Time between the ops submitting tensors and the Horovod background thread
+      *                                 picking them up, summed over all tensors.
+      * @param  negotiationTime         Time between the Horovod background thread picking up tensors and all
+      *                                 processes being ready to process them, summed over all tensors.
+      * @param  executionTime           Time spent performing operations, summed over all operations.
+      * @param  bandwidth               Bytes processed per second of execution time.
+      * @param  fusionBufferUtilization Average fraction of the fusion threshold that fused operations used.
+      * @param  stallEvents             Number of times that tensors were reported as stalled, because only some
+      *                                 processes submitted them. Stalls are only detected by the coordinators of the
+      *                                 process sets.
+      */
+    case class Metrics(
+        tensorOperations: Long,
+        cachedTensorOperations: Long,
+        operations: Long,
+        fusedOperations: Long,
+        bytes: Long,
+        bytesReduced: Long,
+        queueingTime: Double,
+        negotiationTime: Double,
+        executionTime: Double,
+        bandwidth: Double,
+        fusionBufferUtilization: Double,
+        stallEvents: Long)
+
+    /** Metrics of the collective operations that the calling process has performed on one tensor since Horovod was
+      * initialized. Times are in seconds and summed over all operations (see [[Metrics]]). Tensors that are fused with
+      * other tensors are assigned the execution time of the whole fused operation.
+      *
+      * @param  operations      Number of operations performed on the tensor.
+      * @param  bytes           Size of the tensor, summed over all operations.
+      * @param  queueingTime    Time spent waiting for the Horovod background thread.
+      * @param  negotiationTime Time spent waiting for all processes to submit the tensor.
+      * @param  executionTime   Time spent performing the operations.
+      * @param  stallEvents     Number of times that the tensor was reported as stalled.
+      */
+    case class TensorMetrics(
+        operations: Long,
+        bytes: Long,
+        queueingTime: Double,
+        negotiationTime: Double,
+        executionTime: Double,
+        stallEvents: Long)
+
+    /** Returns the metrics of the collective operations that the calling process has performed.
+      *
+      * @throws IllegalStateException If Horovod has not been initialized yet.
+      */
+    @throws[IllegalStateException]
+    def metrics: Metrics = {
+      val values = Horovod.metrics()
+      if (values == null)
+        throw new IllegalStateException("Horovod has not been initialized.")
+      Metrics(
+        tensorOperations = values(0).toLong,
+        cachedTensorOperations = values(11).toLong,
+        operations = values(1).toLong,
+        fusedOperations = values(2).toLong,
+        bytes = values(3).toLong,
+        bytesReduced = values(4).toLong,
+        queueingTime = values(5),
+        negotiationTime = values(6),
+        executionTime = values(7),
+        bandwidth = values(8),
+        fusionBufferUtilization = values(9),
+        stallEvents = values(10).toLong)
+    }
+
+    /** Returns the metrics of the collective operations that the calling process has performed, for each tensor,
+      * keyed by the name of the op that submitted the tensor.
+      *
+      * @throws IllegalStateException If Horovod has not been initialized yet.
+      */
+    @throws[IllegalStateException]
+    def tensorMetrics: Map[String, TensorMetrics] = {
+      val names = Horovod.tensorMetricNames()
+      if (names == null)
+        throw new IllegalStateException("Horovod has not been initialized.")
+      names.flatMap(name => Option(Horovod.tensorMetrics(name)).map(values => name -> TensorMetrics(
+        operations = values(0).toLong,
+        bytes = values(1).toLong,
+        queueingTime = values(2),
+        negotiationTime = values(3),
+        executionTime = values(4),
+        stallEvents = values(5).toLong))).toMap
+    }
+
     /** Performs an all-reduce operation on `value`.
       *
-      * This function performs a bandwidth-optimal ring all-reduce on the input tensor. If the input is indexed slices,
-      * then this function instead does an all-gather on the values and the indices, effectively doing an all-reduce on
-      * the represented tensor.
+      * This function performs a bandwidth-optimal ring all-reduce on the input tensor. If the input is indexed slices
+      * with a known dense shape, then this function instead performs a sparse all-reduce, which gathers the indices and
+      * values of all processes and optionally sums the values that have the same index. If the total number of indices
+      * exceeds `denseThreshold` times the number of rows of the dense tensor, the sparse all-reduce is performed as a
+      * dense all-reduce instead, which returns all the rows. The sparse all-reduce runs on the CPU, and so indexed slices
+      * without a dense shape, or whose `deviceSparse` is a GPU, are all-gathered instead.
+      *
+      * Dense float32 and float64 tensors that are reduced on the CPU can be sparsified by setting `topKRatio` to a
+      * value between zero and one. Every process then only sends that fraction of the elements of `value` with the
+      * largest magnitudes, and adds the elements that it did not send to `value` the next time the same op is run, so
+      * that they are delayed rather than lost.
       *
-      * @param  value        Value to reduce.
-      * @param  average      If `true`, the average over all ranks will be computed.
-      * @param  deviceDense  Device to use for dense tensor reduce operations. Defaults to a GPU if Horovod was built
-      *                      with `HOROVOD_GPU_ALLREDUCE`.
-      * @param  deviceSparse Device to use for sparse tensor reduce operations. Defaults to a GPU if Horovod was built
-      *                      with `HOROVOD_GPU_ALLGATHER`.
+      * @param  value          Value to reduce.
+      * @param  average        If `true`, the average over all ranks will be computed.
+      * @param  deviceDense    Device to use for dense tensor reduce operations. Defaults to a GPU if Horovod was built
+      *                        with `HOROVOD_GPU_ALLREDUCE`.
+      * @param  deviceSparse   Device to use for sparse tensor reduce operations. Defaults to a GPU if Horovod was built
+      *                        with `HOROVOD_GPU_ALLGATHER`.
+      * @param  deduplicate    If `true`, the values of indexed slices that have the same index are summed.
+      * @param  denseThreshold Density of indexed slices above which a dense all-reduce is performed.
+      * @param  processSet     Process set whose processes perform the reduction. The average is computed over them.
+      * @param  topKRatio      Fraction of the elements of dense tensors that every process sends, or zero to send all
+      *                        elements. All processes must use the same ratio.
       * @return Reduced tensor value.
       */
     def allReduce[T: TF : IsNotQuantized, OL[A] <: OutputLike[A]](
         value: OL[T],
         average: Boolean = true,
         deviceDense: String = "",
-        deviceSparse: String = ""
+        deviceSparse: String = "",
+        deduplicate: Boolean = true,
+        denseThreshold: Float = 1.0f,
+        processSet: ProcessSet = ProcessSet.Global,
+        topKRatio: Float = 0.0f
     ): OL[T] = {
       value match {
+        case v: OutputIndexedSlices[T] if v.denseShape != null && !deviceSparse.toLowerCase.contains("gpu") =>
+          tf.device(deviceSparse) {
+            val horovodSize = tf.constant(processSet.size).castTo[T]
+            val (indices, summedValues) = sparseAllReduceOp(
+              v.indices, v.values, v.denseShape.castTo[Long], deduplicate, denseThreshold, processSet.id,
+              name = s"${v.values.name.replace(":", "_")}/SparseAllReduce")
+            val values = if (average) tf.divide(summedValues, horovodSize) else summedValues
+            OutputIndexedSlices(indices, values, v.denseShape).asInstanceOf[OL[T]]
+          }
         case v: OutputIndexedSlices[T] => tf.device(deviceSparse) {
           // For indexed slices we do two all-gathers instead of an all-reduce.
-          val horovodSize = tf.constant(size).castTo[T]
-          var values = allGatherOp(v.values, name = s"${v.values.name.replace(":", "_")}/AllGather")
-          val indices = allGatherOp(v.indices, name = s"${v.indices.name.replace(":", "_")}/AllGather")
+          val horovodSize = tf.constant(processSet.size).castTo[T]
+          var values = allGatherOp(v.values, processSet.id, name = s"${v.values.name.replace(":", "_")}/AllGather")
+          val indices = allGatherOp(v.indices, processSet.id, name = s"${v.indices.name.replace(":", "_")}/AllGather")
 
           // To convert this operation to an average, we divide all gathered values by the Horovod size.
           values = if (average) tf.divide(values, horovodSize) else values
@@ -132,8 +314,9 @@ package object horovod {
         }
         case v => tf.device(deviceDense) {
           // TODO: [HOROVOD] What about sparse tensors?
-          val horovodSize = tf.constant(size).castTo[T]
-          val summedValue = allReduceOp(v.toOutput, name = s"${v.name.replace(":", "_")}/AllReduce")
+          val horovodSize = tf.constant(processSet.size).castTo[T]
+          val summedValue = allReduceOp(
+            v.toOutput, topKRatio, processSet.id, name = s"${v.name.replace(":", "_")}/AllReduce")
           if (average)
             tf.divide(summedValue, horovodSize).asInstanceOf[OL[T]]
           else
@@ -142,20 +325,42 @@ package object horovod {
       }
     }
 
+    /** Performs an all-to-all operation on `value`.
+      *
+      * The rows of `value` are split along its first dimension into one split per process, and the `i`-th split, which
+      * consists of `splits(i)` rows, is sent to the process with rank `i`. This allows, for example, sharding embedding
+      * tables across processes and exchanging the lookups of every process with the processes that own the looked up
+      * rows, instead of replicating the tables on all processes.
+      *
+      * @param  value      Value to distribute.
+      * @param  splits     Number of rows of `value` to send to each process, which must add up to the first dimension
+      *                    of `value`.
+      * @param  processSet Process set whose processes exchange the splits. Ranks refer to the ranks within it.
+      * @return Concatenation of the splits received from all processes, in order of rank.
+      */
+    def allToAll[T: TF](
+        value: Output[T],
+        splits: Output[Int],
+        processSet: ProcessSet = ProcessSet.Global
+    ): Output[T] = {
+      allToAllOp(value, splits, processSet.id, name = s"${value.name.replace(":", "_")}/AllToAll")
+    }
+
     /** Broadcasts all global variables from root rank to all other processes.
       *
-      * @param  rootRank Rank of the process from which the global variable values will be broadcasted to all other
-      *                  processes.
+      * @param  rootRank   Rank of the process from which the global variable values will be broadcasted to all other
+      *                    processes.
+      * @param  processSet Process set whose processes perform the broadcast. `rootRank` refers to the ranks within it.
       * @return Created broadcast op.
       */
-    def broadcastGlobalVariables(rootRank: Int): UntypedOp = {
+    def broadcastGlobalVariables(rootRank: Int, processSet: ProcessSet = ProcessSet.Global): UntypedOp = {
       tf.group(tf.currentGraph.globalVariables.map(v => {
         Op.Builder[(Output[Any], Output[Any]), Output[Any]](
           opType = "AssignVariableOp",
           name = s"${v.name}/Broadcast/Assign",
           input = (
               v.op.outputsSeq.head,
-              broadcastOp(v.value, rootRank, s"${v.name}/Broadcast")(TF.fromDataType(v.dataType)))
+              broadcastOp(v.value, rootRank, processSet.id, s"${v.name}/Broadcast")(TF.fromDataType(v.dataType)))
         ).setAttribute("dtype", v.dataType)
             .build(): UntypedOp
       }))
@@ -166,19 +371,23 @@ package object horovod {
       * This is necessary to ensure consistent initialization of all workers when training is started with random
       * weights or restored from a checkpoint.
       *
-      * @param  rootRank Rank of the process from which the global variable values will be broadcasted to all other
-      *                  processes.
-      * @param  device   Device to be used for broadcasting. Defaults to a GPU if Horovod was built with
-      *                  `HOROVOD_GPU_BROADCAST`.
+      * @param  rootRank   Rank of the process from which the global variable values will be broadcasted to all other
+      *                    processes.
+      * @param  device     Device to be used for broadcasting. Defaults to a GPU if Horovod was built with
+      *                    `HOROVOD_GPU_BROADCAST`.
+      * @param  processSet Process set whose processes perform the broadcast. `rootRank` refers to the ranks within it.
       */
-    case class BroadcastGlobalVariablesHook(rootRank: Int, device: String = "")
-        extends tf.learn.Hook {
+    case class BroadcastGlobalVariablesHook(
+        rootRank: Int,
+        device: String = "",
+        processSet: ProcessSet = ProcessSet.Global
+    ) extends tf.learn.Hook {
       protected var broadcastOp: Option[UntypedOp] = None
 
       override protected def begin(): Unit = {
         if (broadcastOp.isEmpty || broadcastOp.get.graph != tf.currentGraph) {
           tf.device(device) {
-            broadcastOp = Some(broadcastGlobalVariables(rootRank))
+            broadcastOp = Some(broadcastGlobalVariables(rootRank, processSet))
           }
         }
       }
@@ -192,7 +401,9 @@ package object horovod {
         val optimizer: tf.train.Optimizer,
         val name: String = "DistributedOptimizer",
         val deviceDense: String = "",
-        val deviceSparse: String = ""
+        val deviceSparse: String = "",
+        val processSet: ProcessSet = ProcessSet.Global,
+        val topKRatio: Float = 0.0f
     ) extends tf.train.Optimizer {
       /** Boolean value indicating whether to apply use locks to prevent concurrent updates to variables. */
       override val useLocking: Boolean = optimizer.useLocking
@@ -223,13 +434,16 @@ package object horovod {
       ): Seq[(OutputLike[T], Variable[Any])] = {
         val gradients = optimizer.computeGradients(
           loss, lossGradients, variables, gradientsGatingMethod, gradientsAggregationMethod, colocateGradientsWithOps)
-        if (size <= 1) {
+        if (processSet.size <= 1) {
           gradients
         } else {
           tf.nameScope(s"$name/AllReduce") {
             gradients.map(gv => {
               if (gv._1 != null) {
-                (allReduce(gv._1, deviceDense = deviceDense, deviceSparse = deviceSparse), gv._2)
+                val gradient = allReduce(
+                  gv._1, deviceDense = deviceDense, deviceSparse = deviceSparse, processSet = processSet,
+                  topKRatio = topKRatio)
+                (gradient, gv._2)
               } else {
                 gv
               }
@@ -350,9 +564,11 @@ package object horovod {
           optimizer: api.tf.train.Optimizer,
           name: String = "DistributedOptimizer",
           deviceDense: String = "",
-          deviceSparse: String = ""
+          deviceSparse: String = "",
+          processSet: ProcessSet = ProcessSet.Global,
+          topKRatio: Float = 0.0f
       ): DistributedOptimizer = {
-        new DistributedOptimizer(optimizer, name, deviceDense, deviceSparse)
+        new DistributedOptimizer(optimizer, name, deviceDense, deviceSparse, processSet, topKRatio)
       }
     }
   }
@@ -363,19 +579,26 @@ package object horovod {
     * processes for a given name. The reduction will not start until all processes are ready to send and receive the
     * tensor.
     *
-    * @param  value Tensor to reduce.
-    * @param  name  Name for the created op.
+    * @param  value        Tensor to reduce.
+    * @param  topKRatio    Fraction of the elements of `value` with the largest magnitudes that every process sends, or
+    *                      zero to send all elements.
+    * @param  processSetId ID of the process set whose processes perform the reduction.
+    * @param  name         Name for the created op.
     * @return Tensor of the same shape and type as `value` that is summed across all processes.
     */
   private[horovod] def allReduceOp[T: TF](
       value: Output[T],
+      topKRatio: Float = 0.0f,
+      processSetId: Int = 0,
       name: String = "HorovodAllReduce"
   ): Output[T] = {
     Op.Builder[Output[T], Output[T]](
       opType = "HorovodAllreduce",
       name = name,
       input = value
-    ).build().output
+    ).setAttribute("top_k_ratio", topKRatio)
+        .setAttribute("process_set_id", processSetId)
+        .build().output
   }
 
   /** Creates an op which concatenates the input tensor with the same input tensor on all other Horovod processes.
@@ -383,21 +606,88 @@ package object horovod {
     * The concatenation is done along the first dimension, and so the input tensors on the different processes must
     * have the same rank and shape, except for the first dimension, which is allowed to be different.
     *
-    * @param  value Tensor to gather.
-    * @param  name  Name for the created op.
+    * @param  value        Tensor to gather.
+    * @param  processSetId ID of the process set whose processes perform the gather.
+    * @param  name         Name for the created op.
     * @return Tensor of the same type as `value`, concatenated along dimension zero across all processes. Its shape is
     *         identical to the input shape, except for the first dimension, which may be greater and is the sum of all
     *         first dimensions of the tensors in the different Horovod processes.
     */
   private[horovod] def allGatherOp[T: TF](
       value: Output[T],
+      processSetId: Int = 0,
       name: String = "HorovodAllGather"
   ): Output[T] = {
     Op.Builder[Output[T], Output[T]](
       opType = "HorovodAllgather",
       name = name,
       input = value
-    ).build().output
+    ).setAttribute("process_set_id", processSetId)
+        .build().output
+  }
+
+  /** Creates an op which sends splits of the input tensor to all Horovod processes.
+    *
+    * The tensor is split along its first dimension and the `i`-th split is sent to the process with rank `i`, and so
+    * the input tensors on the different processes must have the same rank and shape, except for the first dimension,
+    * which is allowed to be different.
+    *
+    * @param  value        Tensor to distribute.
+    * @param  splits       Number of rows of `value` to send to each process.
+    * @param  processSetId ID of the process set whose processes exchange the splits.
+    * @param  name         Name for the created op.
+    * @return Tensor of the same type as `value`, containing the splits received from all processes, concatenated along
+    *         dimension zero in order of rank. Its shape is identical to the input shape, except for the first
+    *         dimension, which is the total number of rows received.
+    */
+  private[horovod] def allToAllOp[T: TF](
+      value: Output[T],
+      splits: Output[Int],
+      processSetId: Int = 0,
+      name: String = "HorovodAllToAll"
+  ): Output[T] = {
+    Op.Builder[(Output[T], Output[Int]), Output[T]](
+      opType = "HorovodAlltoall",
+      name = name,
+      input = (value, splits)
+    ).setAttribute("process_set_id", processSetId)
+        .build().output
+  }
+
+  /** Creates an op which sums a sparse tensor over all the Horovod processes.
+    *
+    * The sparse tensor consists of the rows `values`, at positions `indices`, of a dense tensor with shape
+    * `denseShape`. If the total number of indices of all processes does not exceed `denseThreshold` times the number
+    * of rows of the dense tensor, the indices and values of all processes are gathered and, if `deduplicate` is
+    * `true`, the values that have the same index are summed. Otherwise, the sparse tensor is scattered into a dense
+    * tensor which is all-reduced, and all of its rows are returned.
+    *
+    * @param  indices        Row indices of the sparse tensor.
+    * @param  values         Rows of the sparse tensor.
+    * @param  denseShape     Shape of the dense tensor, which must be the same on all processes.
+    * @param  deduplicate    If `true`, the values that have the same index are summed.
+    * @param  denseThreshold Density above which a dense all-reduce is performed.
+    * @param  processSetId   ID of the process set whose processes perform the reduction.
+    * @param  name           Name for the created op.
+    * @return Tuple containing the indices and the values of the sum across all processes.
+    */
+  private[horovod] def sparseAllReduceOp[T: TF](
+      indices: Output[Int],
+      values: Output[T],
+      denseShape: Output[Long],
+      deduplicate: Boolean = true,
+      denseThreshold: Float = 1.0f,
+      processSetId: Int = 0,
+      name: String = "HorovodSparseAllReduce"
+  ): (Output[Int], Output[T]) = {
+    Op.Builder[(Output[Int], Output[T], Output[Long]), (Output[Int], Output[T])](
+      opType = "HorovodSparseAllreduce",
+      name = name,
+      input = (indices, values, denseShape)
+    ).setAttribute("deduplicate", deduplicate)
+        .setAttribute("dense_threshold", denseThreshold)
+        .setAttribute("process_set_id", processSetId)
+        .build().output
   }
 
   /** Creates an op which broadcasts the input tensor on root rank to the same input tensor on all other Horovod
@@ -407,14 +697,16 @@ package object horovod {
     * processes for a given name. The broadcast will not start until all processes are ready to send and receive the
     * tensor.
     *
-    * @param  value    Tensor to broadcast.
-    * @param  rootRank Rank that will send data, other ranks will receive data.
-    * @param  name     Name for the created op.
+    * @param  value        Tensor to broadcast.
+    * @param  rootRank     Rank that will send data, other ranks will receive data.
+    * @param  processSetId ID of the process set whose processes perform the broadcast.
+    * @param  name         Name for the created op.
     * @return Tensor of the same shape and type as `value`, with its value broadcasted from root rank.
     */
   private[horovod] def broadcastOp[T: TF](
       value: Output[T],
       rootRank: Int,
+      processSetId: Int = 0,
       name: String = "HorovodBroadcast"
   ): Output[T] = {
     Op.Builder[Output[T], Output[T]](
@@ -422,6 +714,7 @@ package object horovod {
       name = name,
       input = value
     ).setAttribute("root_rank", rootRank)
+        .setAttribute("process_set_id", processSetId)
         .build().output
   }
 }
@@ -0,0 +1,368 @@
+// Copyright 2018 Uber Technologies, Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Runs the collective operations of the shared memory and TCP transports with
+// ranks that are forked from this process and meet through one rendezvous
+// file, and checks their results on every rank.
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "transport.h"
+
+using horovod::common::CreateTransport;
+using horovod::common::MPIDataType;
+using horovod::common::Transport;
+
+namespace {
+
+// Must match the sizes in shm_transport.cc and tcp_transport.cc, so that the
+// tests cover operations that need more than one slot or chunk.
+const int64_t SHM_SLOT_SIZE = 8 << 20;
+const int64_t BROADCAST_CHUNK_SIZE = 1 << 20;
+
+const std::chrono::seconds TIMEOUT(60);
+
+#define EXPECT(condition)                                                      \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      std::fprintf(stderr, "%s:%d: rank %d: check failed: %s\n", __FILE__,     \
+                   __LINE__, transport.rank(), #condition);                    \
+      return false;                                                            \
+    }                                                                          \
+  } while (0)
+
+std::string temporary_directory;
+int rendezvous_count = 0;
+
+// Returns a rendezvous file path that no previous test has used.
+std::string NewRendezvousFile() {
+  return temporary_directory + "/rendezvous-" +
+         std::to_string(rendezvous_count++);
+}
+
+// Deterministic contents for byte `i` of the block that `rank` contributes to
+// an operation.
+uint8_t ByteOf(int rank, int64_t i) {
+  return (uint8_t)((rank * 131 + i * 7 + i / 251) & 0xff);
+}
+
+bool TestAllreduceInt32(Transport& transport, int64_t num_elements) {
+  std::vector<int32_t> buffer(num_elements);
+  for (int64_t i = 0; i < num_elements; ++i) {
+    buffer[i] = (int32_t)(i % 1000) + transport.rank();
+  }
+  EXPECT(transport.Allreduce(buffer.data(), num_elements,
+                             MPIDataType::HOROVOD_INT32));
+  int size = transport.size();
+  for (int64_t i = 0; i < num_elements; ++i) {
+    EXPECT(buffer[i] == (int32_t)(i % 1000) * size + size * (size - 1) / 2);
+  }
+  return true;
+}
+
+bool TestAllreduceFloat64(Transport& transport, int64_t num_elements) {
+  std::vector<double> buffer(num_elements);
+  for (int64_t i = 0; i < num_elements; ++i) {
+    buffer[i] = 0.5 * (double)i + (double)transport.rank();
+  }
+  EXPECT(transport.Allreduce(buffer.data(), num_elements,
+                             MPIDataType::HOROVOD_FLOAT64));
+  int size = transport.size();
+  for (int64_t i = 0; i < num_elements; ++i) {
+    EXPECT(buffer[i] ==
+           0.5 * (double)i * size + (double)(size * (size - 1) / 2));
+  }
+  return true;
+}
+
+bool TestAllgatherv(Transport& transport, int64_t base_count) {
+  std::vector<int64_t> counts(transport.size());
+  int64_t total = 0;
+  int64_t offset = 0;
+  for (int r = 0; r < transport.size(); ++r) {
+    counts[r] = base_count + 3 * r + 1;
+    if (r < transport.rank()) {
+      offset += counts[r];
+    }
+    total += counts[r];
+  }
+  std::vector<uint8_t> buffer(total, 0);
+  for (int64_t i = 0; i < counts[transport.rank()]; ++i) {
+    buffer[offset + i] = ByteOf(transport.rank(), i);
+  }
+  EXPECT(transport.Allgatherv(buffer.data(), counts));
+  offset = 0;
+  for (int r = 0; r < transport.size(); ++r) {
+    for (int64_t i = 0; i < counts[r]; ++i) {
+      EXPECT(buffer[offset + i] == ByteOf(r, i));
+    }
+    offset += counts[r];
+  }
+  return true;
+}
+
+bool TestBroadcast(Transport& transport, int64_t num_bytes, int root_rank) {
+  std::vector<uint8_t> buffer(num_bytes, 0);
+  if (transport.rank() == root_rank) {
+    for (int64_t i = 0; i < num_bytes; ++i) {
+      buffer[i] = ByteOf(root_rank, i);
+    }
+  }
+  EXPECT(transport.Broadcast(buffer.data(), num_bytes, root_rank));
+  for (int64_t i = 0; i < num_bytes; ++i) {
+    EXPECT(buffer[i] == ByteOf(root_rank, i));
+  }
+  return true;
+}
+
+// Number of bytes that `sender` sends to `receiver` in the all-to-all test.
+int64_t AlltoallvCount(int64_t base_count, int sender, int receiver) {
+  return base_count + (sender + 1) * (receiver + 2) - 1;
+}
+
+bool TestAlltoallv(Transport& transport, int64_t base_count) {
+  int rank = transport.rank();
+  int size = transport.size();
+  std::vector<int64_t> sendcounts(size);
+  std::vector<int64_t> recvcounts(size);
+  int64_t send_total = 0;
+  int64_t recv_total = 0;
+  for (int r = 0; r < size; ++r) {
+    sendcounts[r] = AlltoallvCount(base_count, rank, r);
+    recvcounts[r] = AlltoallvCount(base_count, r, rank);
+    send_total += sendcounts[r];
+    recv_total += recvcounts[r];
+  }
+  std::vector<uint8_t> sendbuf(send_total);
+  int64_t offset = 0;
+  for (int r = 0; r < size; ++r) {
+    for (int64_t i = 0; i < sendcounts[r]; ++i) {
+      sendbuf[offset + i] = ByteOf(rank * size + r, i);
+    }
+    offset += sendcounts[r];
+  }
+  std::vector<uint8_t> recvbuf(recv_total, 0);
+  EXPECT(transport.Alltoallv(sendbuf.data(), sendcounts, recvbuf.data(),
+                             recvcounts));
+  offset = 0;
+  for (int r = 0; r < size; ++r) {
+    for (int64_t i = 0; i < recvcounts[r]; ++i) {
+      EXPECT(recvbuf[offset + i] == ByteOf(r * size + rank, i));
+    }
+    offset += recvcounts[r];
+  }
+  return true;
+}
+
+bool TestGatherAndBroadcastString(Transport& transport) {
+  std::string message(transport.rank() * 1000, 'a' + transport.rank());
+  std::vector<std::string> messages;
+  EXPECT(transport.Gather(message, messages));
+  if (transport.rank() == 0) {
+    EXPECT((int)messages.size() == transport.size());
+    for (int r = 0; r < transport.size(); ++r) {
+      EXPECT(messages[r] == std::string(r * 1000, 'a' + r));
+    }
+  } else {
+    EXPECT(messages.empty());
+  }
+
+  int root_rank = transport.size() - 1;
+  std::string broadcast;
+  if (transport.rank() == root_rank) {
+    broadcast = std::string(BROADCAST_CHUNK_SIZE + 17, 'z');
+  }
+  EXPECT(transport.BroadcastString(broadcast, root_rank));
+  EXPECT(broadcast == std::string(BROADCAST_CHUNK_SIZE + 17, 'z'));
+  return true;
+}
+
+bool TestBitwiseAndAllreduce(Transport& transport) {
+  // Bit r of every word is cleared only on rank r, and bit 63 is always set.
+  std::vector<uint64_t> words(5, ~0ULL);
+  for (auto& word : words) {
+    word &= ~(1ULL << transport.rank());
+  }
+  EXPECT(transport.BitwiseAndAllreduce(words.data(), (int64_t)words.size()));
+  uint64_t cleared = (1ULL << transport.size()) - 1;
+  for (auto word : words) {
+    EXPECT(word == ~cleared);
+  }
+  return true;
+}
+
+// Runs all operations, with element counts that do not divide evenly across
+// the ranks and buffers that span several shared memory slots and broadcast
+// chunks.
+bool RunOperations(Transport& transport) {
+  int size = transport.size();
+  int last_rank = size - 1;
+  return TestAllreduceInt32(transport, 1) &&
+         TestAllreduceInt32(transport, 7 * size + 1) &&
+         TestAllreduceInt32(transport, SHM_SLOT_SIZE / 4 * 2 + size + 1) &&
+         TestAllreduceFloat64(transport, 1000 * size + size - 1) &&
+         TestAllgatherv(transport, 0) &&
+         TestAllgatherv(transport, SHM_SLOT_SIZE / size + 5) &&
+         TestBroadcast(transport, 3, last_rank) &&
+         TestBroadcast(transport, 3 * BROADCAST_CHUNK_SIZE + 11, last_rank) &&
+         TestBroadcast(transport, SHM_SLOT_SIZE + 11, 0) &&
+         TestAlltoallv(transport, 0) &&
+         TestAlltoallv(transport, SHM_SLOT_SIZE / size + 3) &&
+         TestGatherAndBroadcastString(transport) &&
+         TestBitwiseAndAllreduce(transport);
+}
+
+// Forks one process per rank, runs `body` in each of them, and returns true if
+// all of them succeeded.
+bool RunRanks(int size, const std::function<bool(int)>& body) {
+  std::vector<pid_t> pids;
+  for (int rank = 0; rank < size; ++rank) {
+    pid_t pid = fork();
+    if (pid < 0) {
+      std::perror("fork");
+      return false;
+    }
+    if (pid == 0) {
+      std::fflush(stderr);
+      _exit(body(rank) ? 0 : 1);
+    }
+    pids.push_back(pid);
+  }
+  bool succeeded = true;
+  for (auto pid : pids) {
+    int status;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+      succeeded = false;
+    }
+  }
+  return succeeded;
+}
+
+bool TestOperations(const std::string& name, int size) {
+  auto rendezvous_file = NewRendezvousFile();
+  return RunRanks(size, [&](int rank) {
+    std::string error;
+    auto transport =
+        CreateTransport(name, rank, size, rendezvous_file, TIMEOUT, error);
+    if (!transport) {
+      std::fprintf(stderr, "rank %d: %s\n", rank, error.c_str());
+      return false;
+    }
+    return RunOperations(*transport);
+  });
+}
+
+// Starts only `rank` of a job with two ranks, whose rendezvous must then time
+// out instead of waiting forever for the missing rank.
+bool TestRendezvousTimeout(const std::string& name, int rank) {
+  auto rendezvous_file = NewRendezvousFile();
+  auto timeout = std::chrono::milliseconds(200);
+  auto start = std::chrono::steady_clock::now();
+  std::string error;
+  auto transport =
+      CreateTransport(name, rank, 2, rendezvous_file, timeout, error);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  if (transport) {
+    std::fprintf(stderr, "rank %d: the rendezvous did not fail\n", rank);
+    return false;
+  }
+  if (error.empty() || elapsed > std::chrono::seconds(10)) {
+    std::fprintf(stderr, "rank %d: the rendezvous failed with '%s' after %lld "
+                         "ms\n",
+                 rank, error.c_str(),
+                 (long long)std::chrono::duration_cast<
+                     std::chrono::milliseconds>(elapsed)
+                     .count());
+    return false;
+  }
+  return true;
+}
+
+// Operations fail, instead of blocking forever, after a rank leaves the job.
+bool TestOperationAfterRankExit(const std::string& name) {
+  auto rendezvous_file = NewRendezvousFile();
+  return RunRanks(2, [&](int rank) {
+    std::string error;
+    auto transport = CreateTransport(name, rank, 2, rendezvous_file,
+                                     std::chrono::seconds(2), error);
+    if (!transport) {
+      std::fprintf(stderr, "rank %d: %s\n", rank, error.c_str());
+      return false;
+    }
+    if (rank == 1) {
+      _exit(0);
+    }
+    int32_t value = 1;
+    if (transport->Allreduce(&value, 1, MPIDataType::HOROVOD_INT32)) {
+      std::fprintf(stderr, "rank 0: the allreduce did not fail\n");
+      return false;
+    }
+    // The transport stays failed after the first failure.
+    return !transport->Allreduce(&value, 1, MPIDataType::HOROVOD_INT32);
+  });
+}
+
+} // namespace
+
+int main() {
+  char directory_template[] = "/tmp/horovod-transport-test-XXXXXX";
+  if (mkdtemp(directory_template) == nullptr) {
+    std::perror("mkdtemp");
+    return 1;
+  }
+  temporary_directory = directory_template;
+
+  int failures = 0;
+  auto run = [&](const std::string& test, bool succeeded) {
+    std::printf("%s %s\n", succeeded ? "[  PASSED  ]" : "[  FAILED  ]",
+                test.c_str());
+    std::fflush(stdout);
+    if (!succeeded) {
+      ++failures;
+    }
+  };
+
+  for (std::string name : {"shm", "tcp"}) {
+    for (int size : {1, 2, 3, 4}) {
+      run(name + " operations with " + std::to_string(size) + " ranks",
+          TestOperations(name, size));
+    }
+    run(name + " rendezvous timeout of rank 0",
+        TestRendezvousTimeout(name, 0));
+    run(name + " rendezvous timeout of rank 1",
+        TestRendezvousTimeout(name, 1));
+    run(name + " operation after a rank exits",
+        TestOperationAfterRankExit(name));
+  }
+
+  std::string error;
+  run("unknown transport", !CreateTransport("mpi", 0, 1, NewRendezvousFile(),
+                                            TIMEOUT, error) &&
+                               !error.empty());
+
+  std::system(("rm -rf " + temporary_directory).c_str());
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.horovod
+
+import org.platanios.tensorflow.api._
+import org.platanios.tensorflow.api.core.exception.{FailedPreconditionException, InvalidArgumentException}
+import org.platanios.tensorflow.api.utilities.using
+
+import org.junit.{Before, Test}
+import org.scalatest.junit.JUnitSuite
+
+/** Tests the all-to-all operation. Every process sends a different number of rows to every other process, including
+  * none to some of them, and the values of the rows identify their sender and receiver. The tests can be run by a
+  * single process, or by multiple processes launched using `mpirun`, in which case every process must run the same
+  * tests in the same order.
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class AllToAllSuite extends JUnitSuite {
+  @Before def setUp(): Unit = {
+    hvd.initialize()
+  }
+
+  /** Number of rows that the process with rank `sender` sends to the process with rank `receiver`. Every process sends
+    * and receives at least one row in total. */
+  private[this] def split(sender: Int, receiver: Int): Int = (sender + 2 * receiver + 1) % 4
+
+  /** Rows that the process with rank `sender` sends to the process with rank `receiver` on step `step`. */
+  private[this] def rows(step: Int, sender: Int, receiver: Int): Seq[Seq[Float]] = {
+    (0 until split(sender, receiver)).map(i => {
+      val value = 1000.0f * step + 100.0f * sender + 10.0f * receiver + i
+      Seq(value, -value)
+    })
+  }
+
+  private[this] def toTensor(rows: Seq[Seq[Float]]): Tensor[Float] = {
+    Tensor(rows.map(row => Tensor(row.map(v => v: Tensor[Float]): _*)): _*)
+  }
+
+  private[this] def toIntTensor(values: Seq[Int]): Tensor[Int] = {
+    Tensor(values.map(v => v: Tensor[Int]): _*)
+  }
+
+  /** Runs an all-to-all operation on `rows` in a new graph and returns the received rows. */
+  private[this] def allToAll(name: String, rows: Seq[Seq[Float]], splits: Tensor[Int]): Seq[Seq[Float]] = {
+    using(Graph()) { graph =>
+      tf.createWith(graph = graph) {
+        val y = hvd.allToAll(tf.constant(toTensor(rows), name = name), tf.constant(splits))
+        val session = Session()
+        session.run(fetches = y).entriesIterator.toSeq.grouped(2).map(_.toSeq).toSeq
+      }
+    }
+  }
+
+  @Test def testUnevenSplits(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      val x = tf.placeholder[Float](Shape(-1, 2), name = "UnevenX")
+      val splits = tf.placeholder[Int](Shape(-1), name = "UnevenSplits")
+      val y = hvd.allToAll(x, splits)
+      val session = Session()
+      (0 until 3).foreach(step => {
+        val feeds: Map[Output[_], Tensor[_]] = Map(
+          x -> toTensor((0 until hvd.size).flatMap(receiver => rows(step, hvd.rank, receiver))),
+          splits -> toIntTensor((0 until hvd.size).map(receiver => split(hvd.rank, receiver))))
+        val result = session.run(feeds = feeds, fetches = y)
+        assert(result.shape(1) === 2)
+        // The received rows are ordered by the rank of their sender.
+        val expected = (0 until hvd.size).flatMap(sender => rows(step, sender, hvd.rank))
+        assert(result.entriesIterator.toSeq.grouped(2).map(_.toSeq).toSeq === expected)
+      })
+    }
+  }
+
+  @Test def testMultipleTensorsPerStep(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      // The second tensor is sent in the opposite direction, with a different data type and no trailing dimensions.
+      val x1 = tf.placeholder[Float](Shape(-1, 2), name = "MultipleX1")
+      val x2 = tf.placeholder[Int](Shape(-1), name = "MultipleX2")
+      val splits1 = tf.constant(toIntTensor((0 until hvd.size).map(receiver => split(hvd.rank, receiver))))
+      val splits2 = tf.constant(toIntTensor((0 until hvd.size).map(receiver => split(receiver, hvd.rank))))
+      val y1 = hvd.allToAll(x1, splits1)
+      val y2 = hvd.allToAll(x2, splits2)
+      val session = Session()
+      val rows2 = (0 until hvd.size).flatMap(receiver => Seq.fill(split(receiver, hvd.rank))(10 * hvd.rank + receiver))
+      val feeds: Map[Output[_], Tensor[_]] = Map(
+        x1 -> toTensor((0 until hvd.size).flatMap(receiver => rows(0, hvd.rank, receiver))),
+        x2 -> toIntTensor(rows2))
+      val (result1, result2) = session.run(feeds = feeds, fetches = (y1, y2))
+      val expected1 = (0 until hvd.size).flatMap(sender => rows(0, sender, hvd.rank))
+      val expected2 = (0 until hvd.size).flatMap(sender => Seq.fill(split(hvd.rank, sender))(10 * sender + hvd.rank))
+      assert(result1.entriesIterator.toSeq.grouped(2).map(_.toSeq).toSeq === expected1)
+      assert(result2.entriesIterator.toSeq === expected2)
+    }
+  }
+
+  @Test def testInvalidSplits(): Unit = {
+    val rows = Seq(Seq(1.0f, 2.0f), Seq(3.0f, 4.0f), Seq(5.0f, 6.0f))
+    // The splits are checked by the coordinator, which sends an error to all processes, when they add up to the wrong
+    // number of rows, when there are not as many splits as processes, or when some of them are negative.
+    intercept[FailedPreconditionException](allToAll("WrongSumX", rows, toIntTensor(4 +: Seq.fill(hvd.size - 1)(0))))
+    intercept[FailedPreconditionException](allToAll("WrongCountX", rows, toIntTensor(3 +: Seq.fill(hvd.size)(0))))
+    if (hvd.size > 1)
+      intercept[FailedPreconditionException](
+        allToAll("NegativeX", rows, toIntTensor(Seq(4, -1) ++ Seq.fill(hvd.size - 2)(0))))
+    // Splits that are not a vector are rejected by every process before the operation is submitted.
+    intercept[InvalidArgumentException](allToAll("MatrixX", rows, Tensor(toIntTensor(3 +: Seq.fill(hvd.size - 1)(0)))))
+    // Failed operations do not affect the operations that follow them.
+    // Every process sends all of its rows to the process with rank zero.
+    val expected = if (hvd.rank == 0) (0 until hvd.size).flatMap(_ => rows) else Seq.empty
+    assert(allToAll("ValidX", rows, toIntTensor(3 +: Seq.fill(hvd.size - 1)(0))) === expected)
+  }
+}
@@ -0,0 +1,112 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.horovod
+
+import org.platanios.tensorflow.api._
+import org.platanios.tensorflow.api.utilities.using
+
+import org.junit.{Before, Test}
+import org.scalatest.junit.JUnitSuite
+
+/** Tests the all-reduce of float16 and bfloat16 tensors. The values are created as float32 values and cast to the half
+  * precision types in the graph. Every process uses the same values, between -1 and 2, multiplied by `rank + 1`, and
+  * so all partial sums are integers that both types represent exactly, for up to 15 processes. The tests can be run by
+  * a single process, or by multiple processes launched using `mpirun`, in which case every process must run the same
+  * tests in the same order. They can also be run with `HOROVOD_COMPRESSION` set, since the float32 values are then
+  * also represented exactly while compressed.
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class HalfPrecisionAllReduceSuite extends JUnitSuite {
+  @Before def setUp(): Unit = {
+    hvd.initialize()
+  }
+
+  /** Sum of `rank + 1` over all ranks. */
+  private[this] def rankSum: Float = hvd.size * (hvd.size + 1) / 2.0f
+
+  private[this] def values(step: Int, size: Int): Seq[Float] = (0 until size).map(i => ((step + i) % 4 - 1).toFloat)
+
+  private[this] def feed(values: Seq[Float]): Tensor[Float] = {
+    Tensor(values.map(v => v * (hvd.rank + 1): Tensor[Float]): _*)
+  }
+
+  /** Creates an all-reduce of `x` after casting it to float16 or, if `truncated` is `true`, to bfloat16, and casts the
+    * result back to float32. */
+  private[this] def allReduce(x: Output[Float], truncated: Boolean): Output[Float] = {
+    if (truncated)
+      hvd.allReduce(x.toTruncatedHalf, average = false).toFloat
+    else
+      hvd.allReduce(x.toHalf, average = false).toFloat
+  }
+
+  @Test def testAllReduce(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      // The sizes cover tensors whose size is not a multiple of the vector width of the sum operations, as well as a
+      // large tensor, whose values are created in the graph, since feeding them would be slow.
+      val sizes = Seq(1, 7, 1003, 1 << 20)
+      val step = tf.placeholder[Int](Shape(), name = "Step")
+      val xs = sizes.map(size => {
+        val values = tf.subtract(
+          tf.floorMod(tf.add(tf.range(tf.constant(0), tf.constant(size)), step), tf.constant(4)), tf.constant(1))
+        tf.multiply(values.toFloat, tf.constant(hvd.rank + 1.0f))
+      })
+      val ys = xs.map(allReduce(_, truncated = false)) ++ xs.map(allReduce(_, truncated = true))
+      val session = Session()
+      (0 until 2).foreach(stepValue => {
+        val results = session.run(feeds = Map(step -> (stepValue: Tensor[Int])), fetches = ys)
+        results.zip(sizes ++ sizes).foreach {
+          case (result, size) =>
+            val expected = values(stepValue, size).map(_ * rankSum)
+            val mismatches = result.entriesIterator.zip(expected.iterator).count(p => p._1 != p._2)
+            assert(result.size === size)
+            assert(mismatches === 0)
+        }
+      })
+    }
+  }
+
+  @Test def testFusedAllReduce(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      // Tensors of the same type are fused with each other, while tensors of different types are reduced separately.
+      val types = Seq("Half", "TruncatedHalf", "Float")
+      val xs = types.map(t => (0 until 4).map(i => tf.placeholder[Float](Shape(i + 1), name = s"Fused${t}X$i")))
+      val ys = xs(0).map(allReduce(_, truncated = false)) ++
+          xs(1).map(allReduce(_, truncated = true)) ++
+          xs(2).map(hvd.allReduce(_, average = false))
+      val session = Session()
+      (0 until 3).foreach(step => {
+        val feeds = xs.flatten.zipWithIndex.map(p => p._1 -> feed(values(step + p._2, p._2 % 4 + 1))).toMap
+        val results = session.run(feeds = feeds, fetches = ys)
+        results.zipWithIndex.foreach {
+          case (result, i) => assert(result.entriesIterator.toSeq === values(step + i, i % 4 + 1).map(_ * rankSum))
+        }
+      })
+    }
+  }
+
+  @Test def testAverage(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      val x = tf.placeholder[Float](Shape(4), name = "AverageHalfX")
+      val y = hvd.allReduce(x.toHalf, average = true).toFloat
+      val session = Session()
+      // Every process feeds a multiple of the number of processes, and so the averages are exact as well.
+      val feed = Tensor(Seq(1.0f, -1.0f, 2.0f, 0.0f).map(v => v * hvd.size: Tensor[Float]): _*)
+      val result = session.run(feeds = Map(x -> feed), fetches = y)
+      assert(result.entriesIterator.toSeq === Seq(1.0f, -1.0f, 2.0f, 0.0f).map(_ * hvd.size))
+    }
+  }
+}
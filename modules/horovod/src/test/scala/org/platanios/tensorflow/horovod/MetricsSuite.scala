@@ -0,0 +1,125 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.horovod
+
+import org.platanios.tensorflow.api._
+import org.platanios.tensorflow.api.core.exception.FailedPreconditionException
+import org.platanios.tensorflow.api.utilities.using
+
+import org.junit.{Before, Test}
+import org.scalatest.junit.JUnitSuite
+
+/** Tests the metrics of the collective operations. The metrics accumulate over all operations since Horovod was
+  * initialized, and so the tests check how they change while running their own operations, which use their own tensor
+  * names. The tests can be run by a single process, or by multiple processes launched using `mpirun`, in which case
+  * every process must run the same tests in the same order.
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class MetricsSuite extends JUnitSuite {
+  @Before def setUp(): Unit = {
+    hvd.initialize()
+  }
+
+  private[this] def feed(size: Int): Tensor[Float] = {
+    Tensor((0 until size).map(i => i * (hvd.rank + 1.0f): Tensor[Float]): _*)
+  }
+
+  /** Checks that the metrics in `after` can follow the metrics in `before`, with all times and ratios being valid. */
+  private[this] def assertValidTransition(before: hvd.Metrics, after: hvd.Metrics): Unit = {
+    assert(after.fusedOperations - before.fusedOperations <= after.operations - before.operations)
+    assert(after.queueingTime >= before.queueingTime)
+    assert(after.negotiationTime >= before.negotiationTime)
+    assert(after.executionTime >= before.executionTime)
+    assert(after.bandwidth >= 0.0)
+    assert(after.fusionBufferUtilization >= 0.0 && after.fusionBufferUtilization <= 1.0)
+    assert(after.stallEvents === before.stallEvents)
+  }
+
+  @Test def testAllReduceMetrics(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      val x = tf.placeholder[Float](Shape(1000), name = "MetricsX")
+      val y = hvd.allReduce(x, average = false)
+      val session = Session()
+      val before = hvd.metrics
+      (0 until 5).foreach(_ => session.run(feeds = Map(x -> feed(1000)), fetches = y))
+      val after = hvd.metrics
+      assert(after.tensorOperations - before.tensorOperations === 5L)
+      assert(after.operations - before.operations === 5L)
+      assert(after.bytes - before.bytes === 5L * 4000L)
+      assert(after.bytesReduced - before.bytesReduced === 5L * 4000L)
+      assertValidTransition(before, after)
+      val tensorMetrics = hvd.tensorMetrics(y.op.name)
+      assert(tensorMetrics.operations === 5L)
+      assert(tensorMetrics.bytes === 5L * 4000L)
+      assert(tensorMetrics.queueingTime >= 0.0)
+      assert(tensorMetrics.negotiationTime >= 0.0)
+      assert(tensorMetrics.executionTime >= 0.0)
+      assert(tensorMetrics.executionTime <= after.executionTime)
+      assert(tensorMetrics.stallEvents === 0L)
+    }
+  }
+
+  @Test def testFusedAllReduceMetrics(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      val sizes = Seq(1, 10, 100, 1000)
+      val xs = sizes.map(size => tf.placeholder[Float](Shape(size), name = s"MetricsFusedX$size"))
+      val ys = xs.map(hvd.allReduce(_, average = false))
+      val session = Session()
+      val before = hvd.metrics
+      (0 until 3).foreach(_ => session.run(feeds = xs.zip(sizes).map(p => p._1 -> feed(p._2)).toMap, fetches = ys))
+      val after = hvd.metrics
+      // Every tensor is counted separately, but the tensors that are fused are counted as a single operation.
+      assert(after.tensorOperations - before.tensorOperations === 12L)
+      assert(after.operations - before.operations >= 3L)
+      assert(after.operations - before.operations <= 12L)
+      assert(after.bytes - before.bytes === 3L * 4L * sizes.sum)
+      assert(after.bytesReduced - before.bytesReduced === 3L * 4L * sizes.sum)
+      assertValidTransition(before, after)
+      ys.zip(sizes).foreach {
+        case (y, size) =>
+          assert(hvd.tensorMetrics(y.op.name).operations === 3L)
+          assert(hvd.tensorMetrics(y.op.name).bytes === 3L * 4L * size)
+      }
+    }
+  }
+
+  @Test def testAllToAllMetrics(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      // Every process sends both rows of its tensor to itself. All-to-all operations are not reductions, and failed
+      // operations are not recorded.
+      val x = tf.placeholder[Float](Shape(2, 3), name = "MetricsAllToAllX")
+      val splits = tf.placeholder[Int](Shape(-1), name = "MetricsAllToAllSplits")
+      val y = hvd.allToAll(x, splits)
+      val session = Session()
+      val feed = Tensor(Tensor(1.0f, 2.0f, 3.0f), Tensor(4.0f, 5.0f, 6.0f))
+      val validSplits = Tensor((0 until hvd.size).map(r => (if (r == hvd.rank) 2 else 0): Tensor[Int]): _*)
+      val invalidSplits = Tensor((0 until hvd.size).map(r => (if (r == hvd.rank) 3 else 0): Tensor[Int]): _*)
+      val before = hvd.metrics
+      val validFeeds: Map[Output[_], Tensor[_]] = Map(x -> feed, splits -> validSplits)
+      val invalidFeeds: Map[Output[_], Tensor[_]] = Map(x -> feed, splits -> invalidSplits)
+      session.run(feeds = validFeeds, fetches = y)
+      intercept[FailedPreconditionException](session.run(feeds = invalidFeeds, fetches = y))
+      val after = hvd.metrics
+      assert(after.tensorOperations - before.tensorOperations === 1L)
+      assert(after.operations - before.operations === 1L)
+      assert(after.bytes - before.bytes === 24L)
+      assert(after.bytesReduced === before.bytesReduced)
+      assertValidTransition(before, after)
+      assert(hvd.tensorMetrics(y.op.name).operations === 1L)
+    }
+  }
+}
@@ -0,0 +1,134 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.horovod
+
+import org.platanios.tensorflow.api._
+import org.platanios.tensorflow.api.utilities.using
+
+import org.junit.{Before, Test}
+import org.scalatest.junit.JUnitSuite
+
+/** Tests the negotiation of collective operations, including the response cache, which lets tensors that are
+  * submitted with the same parameters on every step skip the coordinator. Uses of the cache are counted by the cached
+  * tensor operations metric. Every test uses its own tensor names, so that it does not hit the responses cached by
+  * other tests. The tests can be run by a single process, or by multiple processes launched using `mpirun`, in which
+  * case every process must run the same tests in the same order.
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class NegotiationSuite extends JUnitSuite {
+  @Before def setUp(): Unit = {
+    hvd.initialize()
+  }
+
+  /** Sum of `rank + 1` over all ranks, i.e., the factor by which the reduced values are multiplied, when each process
+    * feeds its values multiplied by `rank + 1`. */
+  private[this] def rankSum: Float = hvd.size * (hvd.size + 1) / 2.0f
+
+  private[this] def cachedTensorOperations: Long = hvd.metrics.cachedTensorOperations
+
+  private[this] def values(step: Int, size: Int): Seq[Float] = (0 until size).map(i => (step + i).toFloat)
+
+  private[this] def allReduce(
+      session: Session,
+      input: Output[Float],
+      output: Output[Float],
+      values: Seq[Float]
+  ): Seq[Float] = {
+    val feed = Tensor(values.map(v => v * (hvd.rank + 1): Tensor[Float]): _*)
+    session.run(feeds = Map(input -> feed), fetches = output).entriesIterator.toSeq
+  }
+
+  @Test def testRepeatedAllReduceUsesCachedResponses(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      val x = tf.placeholder[Float](Shape(3), name = "RepeatedX")
+      val y = hvd.allReduce(x, average = false)
+      val session = Session()
+      val initialCachedTensorOperations = cachedTensorOperations
+      // The first step is negotiated through the coordinator and the rest use the cached response.
+      (0 until 10).foreach(step => {
+        assert(allReduce(session, x, y, values(step, 3)) === values(step, 3).map(_ * rankSum))
+      })
+      assert(cachedTensorOperations - initialCachedTensorOperations === 9L)
+      assert(hvd.tensorMetrics(y.op.name).operations === 10L)
+    }
+  }
+
+  @Test def testMultipleCachedTensorsPerStep(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      val xs = (0 until 4).map(i => tf.placeholder[Float](Shape(i + 1), name = s"MultipleX$i"))
+      val ys = xs.map(x => hvd.allReduce(x, average = false))
+      val session = Session()
+      val initialCachedTensorOperations = cachedTensorOperations
+      (0 until 5).foreach(step => {
+        val feeds = xs.zipWithIndex.map {
+          case (x, i) => x -> Tensor(values(step + i, i + 1).map(v => v * (hvd.rank + 1): Tensor[Float]): _*)
+        }.toMap
+        val results = session.run(feeds = feeds, fetches = ys)
+        results.zipWithIndex.foreach {
+          case (result, i) => assert(result.entriesIterator.toSeq === values(step + i, i + 1).map(_ * rankSum))
+        }
+      })
+      assert(cachedTensorOperations - initialCachedTensorOperations === 16L)
+    }
+  }
+
+  @Test def testChangedShapeInvalidatesCachedResponse(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      val x = tf.placeholder[Float](Shape(-1), name = "ReshapedX")
+      val y = hvd.allReduce(x, average = false)
+      val session = Session()
+      val initialCachedTensorOperations = cachedTensorOperations
+      // Every change of the shape invalidates the cached response for the tensor, which must then be negotiated
+      // through the coordinator again, before it can be cached with its new shape. Only the steps that repeat the shape
+      // of the previous step use the cache.
+      Seq(3, 3, 5, 5, 5, 3, 1, 1).zipWithIndex.foreach {
+        case (size, step) =>
+          assert(allReduce(session, x, y, values(step, size)) === values(step, size).map(_ * rankSum))
+      }
+      assert(cachedTensorOperations - initialCachedTensorOperations === 4L)
+    }
+  }
+
+  @Test def testChangedDataTypeInvalidatesCachedResponse(): Unit = {
+    // Both graphs create a tensor with the same name, and so they share the same cache entry. The first step of each
+    // graph is negotiated through the coordinator and the rest use the cached response.
+    val initialCachedTensorOperations = cachedTensorOperations
+    using(Graph()) { graph =>
+      tf.createWith(graph = graph) {
+        val x = tf.placeholder[Float](Shape(2), name = "SharedX")
+        val y = hvd.allReduce(x, average = false)
+        val session = Session()
+        (0 until 3).foreach(step => {
+          assert(allReduce(session, x, y, values(step, 2)) === values(step, 2).map(_ * rankSum))
+        })
+      }
+    }
+    using(Graph()) { graph =>
+      tf.createWith(graph = graph) {
+        val x = tf.placeholder[Double](Shape(2), name = "SharedX")
+        val y = hvd.allReduce(x, average = false)
+        val session = Session()
+        (0 until 3).foreach(step => {
+          val feed = Tensor(values(step, 2).map(v => v.toDouble * (hvd.rank + 1): Tensor[Double]): _*)
+          val result = session.run(feeds = Map(x -> feed), fetches = y).entriesIterator.toSeq
+          assert(result === values(step, 2).map(_.toDouble * rankSum))
+        })
+      }
+    }
+    assert(cachedTensorOperations - initialCachedTensorOperations === 4L)
+  }
+}
@@ -0,0 +1,125 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.horovod
+
+import org.platanios.tensorflow.api._
+import org.platanios.tensorflow.api.core.exception.FailedPreconditionException
+import org.platanios.tensorflow.api.utilities.using
+
+import org.junit.{Assume, Before, Test}
+import org.scalatest.junit.JUnitSuite
+
+import scala.util.Try
+
+/** Tests collective operations over process sets. The tests can be run by a single process, or by multiple processes
+  * launched using `mpirun`, in which case every process must run the same tests in the same order.
+  *
+  * Process sets require MPI and can only be created when Horovod is first initialized. The tests are thus skipped if
+  * Horovod uses another transport, or if another suite already initialized Horovod in the same JVM, in which case this
+  * suite can be run on its own (e.g., using `testOnly`).
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class ProcessSetSuite extends JUnitSuite {
+  private[this] var processSets: Seq[hvd.ProcessSet] = _
+
+  @Before def setUp(): Unit = {
+    Assume.assumeTrue(sys.env.get("HOROVOD_TRANSPORT").forall(t => t.isEmpty || t == "mpi"))
+    val initialized = Try(hvd.initialize(ProcessSetSuite.ranks))
+    Assume.assumeTrue("Horovod was initialized without the process sets of this suite.", initialized.isSuccess)
+    processSets = initialized.get
+  }
+
+  /** Process sets that the calling process belongs to, along with the global ranks of their processes. */
+  private[this] def memberships: Seq[(hvd.ProcessSet, Seq[Int])] = {
+    processSets.zip(ProcessSetSuite.ranks).filter(_._2.contains(hvd.rank))
+  }
+
+  @Test def testRankAndSize(): Unit = {
+    assert(hvd.size === ProcessSetSuite.size)
+    assert(hvd.ProcessSet.Global.rank === hvd.rank)
+    assert(hvd.ProcessSet.Global.size === hvd.size)
+    assert(processSets.map(_.id) === Seq(1, 2, 3))
+    processSets.zip(ProcessSetSuite.ranks).foreach {
+      case (processSet, ranks) =>
+        assert(processSet.size === ranks.size)
+        // The ranks within a process set are ordered by the global ranks of its processes.
+        if (ranks.contains(hvd.rank))
+          assert(processSet.rank === ranks.sorted.indexOf(hvd.rank))
+        else
+          intercept[IllegalStateException](processSet.rank)
+    }
+  }
+
+  @Test def testAllReduceWithinProcessSets(): Unit = {
+    // Processes that belong to multiple process sets reduce over them in order of ID.
+    memberships.foreach {
+      case (processSet, ranks) => using(Graph()) { graph =>
+        tf.createWith(graph = graph) {
+          val x = tf.placeholder[Float](Shape(3), name = s"SumX${processSet.id}")
+          val y = tf.placeholder[Float](Shape(3), name = s"AverageX${processSet.id}")
+          val sum = hvd.allReduce(x, average = false, processSet = processSet)
+          val average = hvd.allReduce(y, average = true, processSet = processSet)
+          val session = Session()
+          val rankSum = ranks.map(_ + 1).sum.toFloat
+          (0 until 3).foreach(step => {
+            val values = Seq(1.0f, 2.0f, 3.0f).map(_ + step)
+            val feed = Tensor(values.map(v => v * (hvd.rank + 1): Tensor[Float]): _*)
+            val (sumResult, averageResult) = session.run(feeds = Map(x -> feed, y -> feed), fetches = (sum, average))
+            assert(sumResult.entriesIterator.toSeq === values.map(_ * rankSum))
+            assert(averageResult.entriesIterator.toSeq === values.map(_ * rankSum / ranks.size))
+          })
+        }
+      }
+    }
+  }
+
+  @Test def testInitializeWithDifferentProcessSets(): Unit = {
+    // The order of the ranks within a process set does not matter.
+    assert(hvd.initialize(ProcessSetSuite.ranks.map(_.reverse)) === processSets)
+    intercept[IllegalStateException](hvd.initialize(ProcessSetSuite.ranks.take(1)))
+    intercept[IllegalStateException](hvd.initialize(ProcessSetSuite.ranks :+ Seq(0)))
+  }
+
+  @Test def testOperationsOutsideProcessSets(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      // These operations fail when they are submitted, without waiting for any other process.
+      val x = tf.placeholder[Float](Shape(3), name = "OutsideX")
+      val feed = Tensor(1.0f, 2.0f, 3.0f)
+      val missing = allReduceOp(x, processSetId = processSets.size + 1, name = "MissingProcessSetAllReduce")
+      val session = Session()
+      intercept[FailedPreconditionException](session.run(feeds = Map(x -> feed), fetches = missing))
+      intercept[IllegalStateException](hvd.ProcessSet(processSets.size + 1).size)
+      processSets.zip(ProcessSetSuite.ranks).filterNot(_._2.contains(hvd.rank)).foreach {
+        case (processSet, _) =>
+          val y = hvd.allReduce(x, average = false, processSet = processSet)
+          intercept[FailedPreconditionException](session.run(feeds = Map(x -> feed), fetches = y))
+      }
+    }
+  }
+}
+
+object ProcessSetSuite {
+  /** Number of processes, which needs to be known before Horovod is initialized, and so it is read from the environment
+    * variables that `mpirun` sets. A single process is assumed if they are not set. */
+  val size: Int = {
+    Seq("OMPI_COMM_WORLD_SIZE", "PMI_SIZE", "MV2_COMM_WORLD_SIZE").flatMap(sys.env.get).headOption.map(_.toInt)
+        .getOrElse(1)
+  }
+
+  /** Global ranks of the processes of each process set: the even ranks, the last rank, and all ranks in reverse. */
+  val ranks: Seq[Seq[Int]] = Seq(0 until size by 2, Seq(size - 1), (0 until size).reverse)
+}
@@ -0,0 +1,117 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.horovod
+
+import org.platanios.tensorflow.api._
+import org.platanios.tensorflow.api.core.exception.InvalidArgumentException
+import org.platanios.tensorflow.api.utilities.using
+
+import org.junit.{Before, Test}
+import org.scalatest.junit.JUnitSuite
+
+/** Tests the sparse and the dense algorithms of the sparse all-reduce. Every process contributes the same indices, with
+  * its rows multiplied by `rank + 1`. The tests can be run by a single process, or by multiple processes launched using
+  * `mpirun`, in which case every process must run the same tests in the same order.
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class SparseAllReduceSuite extends JUnitSuite {
+  @Before def setUp(): Unit = {
+    hvd.initialize()
+  }
+
+  private[this] val numRows: Int = 6
+  private[this] val indices: Seq[Int] = Seq(1, 4, 1)
+  private[this] val rows: Seq[Seq[Float]] = Seq(Seq(1.0f, 2.0f), Seq(3.0f, 4.0f), Seq(5.0f, 6.0f))
+
+  /** Sum of `rank + 1` over all ranks. */
+  private[this] def rankSum: Float = hvd.size * (hvd.size + 1) / 2.0f
+
+  private[this] def rowsOf(rank: Int): Seq[Seq[Float]] = rows.map(_.map(_ * (rank + 1)))
+
+  private[this] def toTensor(rows: Seq[Seq[Float]]): Tensor[Float] = {
+    Tensor(rows.map(row => Tensor(row.map(v => v: Tensor[Float]): _*)): _*)
+  }
+
+  /** Runs the sparse all-reduce op on the rows of this process and returns the resulting indices and rows. */
+  private[this] def sparseAllReduce(
+      indices: Seq[Int],
+      deduplicate: Boolean,
+      denseThreshold: Float
+  ): (Seq[Int], Seq[Seq[Float]]) = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      val (reducedIndices, reducedValues) = sparseAllReduceOp(
+        tf.constant(Tensor(indices.map(i => i: Tensor[Int]): _*)),
+        tf.constant(toTensor(rowsOf(hvd.rank))),
+        tf.constant(Tensor(numRows.toLong, 2L)),
+        deduplicate = deduplicate,
+        denseThreshold = denseThreshold)
+      val session = Session()
+      val (indicesResult, valuesResult) = session.run(fetches = (reducedIndices, reducedValues))
+      (indicesResult.entriesIterator.toSeq, valuesResult.entriesIterator.toSeq.grouped(2).map(_.toSeq).toSeq)
+    }
+  }
+
+  @Test def testSparseAlgorithmWithDeduplication(): Unit = {
+    val (resultIndices, resultRows) = sparseAllReduce(indices, deduplicate = true, denseThreshold = Float.MaxValue)
+    assert(resultIndices === Seq(1, 4))
+    assert(resultRows === Seq(Seq(6.0f, 8.0f), Seq(3.0f, 4.0f)).map(_.map(_ * rankSum)))
+  }
+
+  @Test def testSparseAlgorithmWithoutDeduplication(): Unit = {
+    val (resultIndices, resultRows) = sparseAllReduce(indices, deduplicate = false, denseThreshold = Float.MaxValue)
+    assert(resultIndices === (0 until hvd.size).flatMap(_ => indices))
+    assert(resultRows === (0 until hvd.size).flatMap(rowsOf))
+  }
+
+  @Test def testDenseAlgorithm(): Unit = {
+    val (resultIndices, resultRows) = sparseAllReduce(indices, deduplicate = true, denseThreshold = 0.0f)
+    assert(resultIndices === (0 until numRows))
+    val expectedRows = (0 until numRows).map {
+      case 1 => Seq(6.0f, 8.0f).map(_ * rankSum)
+      case 4 => Seq(3.0f, 4.0f).map(_ * rankSum)
+      case _ => Seq(0.0f, 0.0f)
+    }
+    assert(resultRows === expectedRows)
+  }
+
+  @Test def testOutOfRangeIndices(): Unit = {
+    // Both algorithms check the indices before performing any collective operation that depends on them, and so all
+    // processes fail alike.
+    Seq(Float.MaxValue, 0.0f).foreach(denseThreshold => {
+      intercept[InvalidArgumentException](
+        sparseAllReduce(Seq(1, numRows, 1), deduplicate = true, denseThreshold = denseThreshold))
+      intercept[InvalidArgumentException](
+        sparseAllReduce(Seq(1, -1, 1), deduplicate = true, denseThreshold = denseThreshold))
+    })
+    // Failed operations do not affect the operations that follow them.
+    assert(sparseAllReduce(indices, deduplicate = true, denseThreshold = 0.0f)._1 === (0 until numRows))
+  }
+
+  @Test def testAllReduceOfIndexedSlices(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      val slices = OutputIndexedSlices(
+        indices = tf.constant(Tensor(indices.map(i => i: Tensor[Int]): _*)),
+        values = tf.constant(toTensor(rowsOf(hvd.rank))),
+        denseShape = tf.constant(Tensor(numRows, 2)))
+      val reduced = hvd.allReduce(slices, average = true)
+      val session = Session()
+      val (indicesResult, valuesResult) = session.run(fetches = (reduced.indices, reduced.values))
+      assert(indicesResult.entriesIterator.toSeq === Seq(1, 4))
+      assert(valuesResult.entriesIterator.toSeq === Seq(6.0f, 8.0f, 3.0f, 4.0f).map(_ * rankSum / hvd.size))
+    }
+  }
+}
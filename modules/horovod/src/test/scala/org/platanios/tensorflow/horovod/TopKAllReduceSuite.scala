@@ -0,0 +1,93 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.horovod
+
+import org.platanios.tensorflow.api._
+import org.platanios.tensorflow.api.utilities.using
+
+import org.junit.{Before, Test}
+import org.scalatest.junit.JUnitSuite
+
+/** Tests the all-reduce of sparsified tensors, which sends only the elements with the largest magnitudes and delays the
+  * rest to the following steps. Every process feeds the same values multiplied by `rank + 1`, and so all processes
+  * select the same elements. The tests can be run by a single process, or by multiple processes launched using
+  * `mpirun`, in which case every process must run the same tests in the same order.
+  *
+  * @author Emmanouil Antonios Platanios
+  */
+class TopKAllReduceSuite extends JUnitSuite {
+  @Before def setUp(): Unit = {
+    hvd.initialize()
+  }
+
+  /** Fusion threshold that Horovod uses, when it is not being autotuned. */
+  private[this] val fusionThreshold: Long = {
+    sys.env.get("HOROVOD_FUSION_THRESHOLD").map(_.toLong).getOrElse(64L * 1024 * 1024)
+  }
+
+  /** Sum of `rank + 1` over all ranks. */
+  private[this] def rankSum: Double = hvd.size * (hvd.size + 1) / 2.0
+
+  @Test def testErrorFeedbackAcrossSteps(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      val x = tf.placeholder[Double](Shape(4), name = "X")
+      val y = hvd.allReduce(x, average = false, topKRatio = 0.5f)
+      val session = Session()
+      def step(values: Seq[Double]): Seq[Double] = {
+        val feed = Tensor(values.map(v => v * (hvd.rank + 1): Tensor[Double]): _*)
+        session.run(feeds = Map(x -> feed), fetches = y).entriesIterator.toSeq
+      }
+      // The elements that are not sent are added to the values of the next step, until they are sent.
+      assert(step(Seq(1.0, -4.0, 2.0, 3.0)) === Seq(0.0, -4.0, 0.0, 3.0).map(_ * rankSum))
+      assert(step(Seq(0.0, 0.0, 0.0, 0.5)) === Seq(1.0, 0.0, 2.0, 0.0).map(_ * rankSum))
+      assert(step(Seq(0.0, 0.0, 0.0, 0.0)) === Seq(0.0, 0.0, 0.0, 0.5).map(_ * rankSum))
+      assert(step(Seq(0.0, 0.0, 0.0, 0.0)) === Seq(0.0, 0.0, 0.0, 0.0))
+    }
+  }
+
+  @Test def testFusedTensorsNearFusionThreshold(): Unit = using(Graph()) { graph =>
+    tf.createWith(graph = graph) {
+      // Every process selects `count` float64 values and their int32 indices in total, which is the largest odd count
+      // for which the selections of all processes fit the fusion threshold. Their blocks are then padded by 4 bytes,
+      // which makes them exceed the threshold for some numbers of processes. The ratio is a power of two, so that the
+      // counts are exact, and it is low enough that the dense tensors do not fit in the fusion buffer.
+      val ratioInverse = Iterator.iterate(2)(_ * 2).find(_ >= 2 * hvd.size).get
+      val totalCount = fusionThreshold / (hvd.size * 12L)
+      val count = if (totalCount % 2 == 0) totalCount - 1 else totalCount
+      val counts = Seq.fill(7)(count / 8) :+ (count - 7 * (count / 8))
+      val sizes = counts.map(_ * ratioInverse)
+      val scale = tf.placeholder[Double](Shape(), name = "Scale")
+      val xs = sizes.map(size => tf.multiply(
+        tf.range(tf.constant[Double](1.0), tf.constant[Double](size + 1.0)), scale))
+      val ys = xs.map(x => hvd.allReduce(x, average = false, topKRatio = 1.0f / ratioInverse))
+      val session = Session()
+      // The first step sends the largest values of every tensor and the following steps send the next largest ones.
+      (0 until 3).foreach(step => {
+        val scaleValue: Tensor[Double] = if (step == 0) hvd.rank + 1.0 else 0.0
+        val results = session.run(feeds = Map(scale -> scaleValue), fetches = ys)
+        results.zip(sizes.zip(counts)).foreach {
+          case (result, (size, tensorCount)) =>
+            val end = size - step * tensorCount
+            val begin = end - tensorCount
+            val mismatches = result.entriesIterator.zipWithIndex.count {
+              case (value, i) => value != (if (i >= begin && i < end) (i + 1) * rankSum else 0.0)
+            }
+            assert(mismatches === 0)
+        }
+      })
+    }
+  }
+}
@@ -0,0 +1,253 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include "buffered_writable_file.h"
+#include "utilities.h"
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/c/tf_status_helper.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace {
+
+// Writable file that buffers appended data in memory and writes it to the underlying file on a background thread.
+//
+// Two buffers are used: the active buffer, which receives appended data, and the pending buffer, which is being
+// written by the background thread. When the active buffer fills up, the two are swapped. If the background thread is
+// still busy writing the previous buffer at that point, the appending thread blocks, which bounds memory usage to
+// roughly two buffers.
+//
+// Errors that occur on the background thread are recorded and returned by the next call to any of the public methods.
+// Once an error has occurred, all subsequent calls fail with that same error.
+class BufferedWritableFile {
+ public:
+  BufferedWritableFile(std::unique_ptr<tensorflow::WritableFile> file, size_t buffer_size)
+      : file_(std::move(file)), buffer_size_(buffer_size) {
+    active_.reserve(buffer_size_);
+    thread_.reset(tensorflow::Env::Default()->StartThread(
+      tensorflow::ThreadOptions(), "buffered_writable_file", [this]() { WriteLoop(); }));
+  }
+
+  ~BufferedWritableFile() { Close().IgnoreError(); }
+
+  tensorflow::Status Append(const char* data, size_t n) {
+    tensorflow::mutex_lock l(mu_);
+    if (closed_) return tensorflow::errors::FailedPrecondition("The file has already been closed.");
+    TF_RETURN_IF_ERROR(status_);
+    if (n >= buffer_size_) {
+      // Large appends would fill the whole buffer anyway, and so they skip the copy and are written directly, after
+      // the buffered data. The background thread stays idle until the lock is released.
+      TF_RETURN_IF_ERROR(Drain(&l));
+      status_.Update(file_->Append(tensorflow::StringPiece(data, n)));
+      return status_;
+    }
+    active_.append(data, n);
+    if (active_.size() >= buffer_size_) HandOff(&l);
+    return status_;
+  }
+
+  // Waits until all data appended so far has been written to the underlying file, and then flushes it.
+  tensorflow::Status Flush() {
+    tensorflow::mutex_lock l(mu_);
+    if (closed_) return tensorflow::errors::FailedPrecondition("The file has already been closed.");
+    TF_RETURN_IF_ERROR(Drain(&l));
+    status_.Update(file_->Flush());
+    return status_;
+  }
+
+  // Waits until all data appended so far has been written to the underlying file, and then syncs it to its storage.
+  tensorflow::Status Sync() {
+    tensorflow::mutex_lock l(mu_);
+    if (closed_) return tensorflow::errors::FailedPrecondition("The file has already been closed.");
+    TF_RETURN_IF_ERROR(Drain(&l));
+    status_.Update(file_->Sync());
+    return status_;
+  }
+
+  tensorflow::Status Close() {
+    {
+      tensorflow::mutex_lock l(mu_);
+      if (closed_) return status_;
+      Drain(&l).IgnoreError();
+      closed_ = true;
+      cv_.notify_all();
+    }
+    // Destroying the thread object joins the background thread.
+    thread_.reset();
+    tensorflow::mutex_lock l(mu_);
+    status_.Update(file_->Close());
+    return status_;
+  }
+
+ private:
+  // Hands the active buffer off to the background thread, waiting for it to finish writing the previous one first.
+  void HandOff(tensorflow::mutex_lock* l) {
+    while (write_pending_) cv_.wait(*l);
+    std::swap(active_, pending_);
+    active_.clear();
+    write_pending_ = true;
+    cv_.notify_all();
+  }
+
+  // Hands off any buffered data and waits for the background thread to write it.
+  tensorflow::Status Drain(tensorflow::mutex_lock* l) {
+    if (!active_.empty()) HandOff(l);
+    while (write_pending_) cv_.wait(*l);
+    return status_;
+  }
+
+  void WriteLoop() {
+    while (true) {
+      bool write;
+      {
+        tensorflow::mutex_lock l(mu_);
+        while (!write_pending_ && !closed_) cv_.wait(l);
+        if (!write_pending_) return;
+        write = status_.ok();
+      }
+      // The pending buffer is only touched by this thread while a write is pending, and so it can be written without
+      // holding the lock, which allows appends to the active buffer to proceed concurrently.
+      tensorflow::Status s;
+      if (write) s = file_->Append(pending_);
+      tensorflow::mutex_lock l(mu_);
+      status_.Update(s);
+      pending_.clear();
+      write_pending_ = false;
+      cv_.notify_all();
+    }
+  }
+
+  std::unique_ptr<tensorflow::WritableFile> file_;
+  const size_t buffer_size_;
+
+  tensorflow::mutex mu_;
+  tensorflow::condition_variable cv_;
+  std::string active_ GUARDED_BY(mu_);
+  std::string pending_;
+  bool write_pending_ GUARDED_BY(mu_) = false;
+  bool closed_ GUARDED_BY(mu_) = false;
+  tensorflow::Status status_ GUARDED_BY(mu_);
+  std::unique_ptr<tensorflow::Thread> thread_;
+};
+
+}  // namespace
+
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_BufferedWritableFile_00024_newBufferedWritableFile(
+    JNIEnv* env, jobject object, jstring filename, jstring mode, jlong buffer_size) {
+  if (buffer_size <= 0) {
+    throw_exception(
+      env, tf_invalid_argument_exception, "The buffer size must be positive, but it was %lld.",
+      static_cast<long long>(buffer_size));
+    return 0;
+  }
+  const char* c_filename = env->GetStringUTFChars(filename, nullptr);
+  const char* c_mode = env->GetStringUTFChars(mode, nullptr);
+  std::unique_ptr<tensorflow::WritableFile> file;
+  tensorflow::Status s;
+  if (std::string(c_mode).find("a") != std::string::npos) {
+    s = tensorflow::Env::Default()->NewAppendableFile(std::string(c_filename), &file);
+  } else {
+    s = tensorflow::Env::Default()->NewWritableFile(std::string(c_filename), &file);
+  }
+  env->ReleaseStringUTFChars(filename, c_filename);
+  env->ReleaseStringUTFChars(mode, c_mode);
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), 0);
+  }
+  return reinterpret_cast<jlong>(new BufferedWritableFile(std::move(file), static_cast<size_t>(buffer_size)));
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_BufferedWritableFile_00024_appendArray(
+    JNIEnv* env, jobject object, jlong file_handle, jbyteArray array, jint offset, jint length) {
+  REQUIRE_HANDLE(file, BufferedWritableFile, file_handle, void());
+  if (offset < 0 || length < 0 || offset > env->GetArrayLength(array) - length) {
+    throw_exception(
+      env, tf_invalid_argument_exception, "Invalid array region [%d, %d) for an array of length %d.",
+      offset, offset + length, env->GetArrayLength(array));
+    return;
+  }
+  // A critical section cannot be used here because appending may block while waiting for the background thread.
+  jbyte* elements = env->GetByteArrayElements(array, nullptr);
+  tensorflow::Status s = file->Append(reinterpret_cast<const char*>(elements + offset), static_cast<size_t>(length));
+  env->ReleaseByteArrayElements(array, elements, JNI_ABORT);
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_BufferedWritableFile_00024_appendBuffer(
+    JNIEnv* env, jobject object, jlong file_handle, jobject buffer, jint offset, jint length) {
+  REQUIRE_HANDLE(file, BufferedWritableFile, file_handle, void());
+  const char* buffer_data = reinterpret_cast<const char*>(env->GetDirectBufferAddress(buffer));
+  if (buffer_data == nullptr) {
+    throw_exception(env, tf_invalid_argument_exception, "The provided buffer must be a direct byte buffer.");
+    return;
+  }
+  jlong buffer_capacity = env->GetDirectBufferCapacity(buffer);
+  if (offset < 0 || length < 0 || offset > buffer_capacity - length) {
+    throw_exception(
+      env, tf_invalid_argument_exception, "Invalid buffer region [%d, %d) for a buffer with capacity %lld.",
+      offset, offset + length, static_cast<long long>(buffer_capacity));
+    return;
+  }
+  tensorflow::Status s = file->Append(buffer_data + offset, static_cast<size_t>(length));
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_BufferedWritableFile_00024_flush(
+    JNIEnv* env, jobject object, jlong file_handle) {
+  REQUIRE_HANDLE(file, BufferedWritableFile, file_handle, void());
+  tensorflow::Status s = file->Flush();
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_BufferedWritableFile_00024_sync(
+    JNIEnv* env, jobject object, jlong file_handle) {
+  REQUIRE_HANDLE(file, BufferedWritableFile, file_handle, void());
+  tensorflow::Status s = file->Sync();
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_BufferedWritableFile_00024_delete(
+    JNIEnv* env, jobject object, jlong file_handle) {
+  REQUIRE_HANDLE(file, BufferedWritableFile, file_handle, void());
+  tensorflow::Status s = file->Close();
+  delete file;
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+}
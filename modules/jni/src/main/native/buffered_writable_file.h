@@ -0,0 +1,61 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class org_platanios_tensorflow_jni_BufferedWritableFile__ */
+
+#ifndef _Included_org_platanios_tensorflow_jni_BufferedWritableFile__
+#define _Included_org_platanios_tensorflow_jni_BufferedWritableFile__
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     org_platanios_tensorflow_jni_BufferedWritableFile__
+ * Method:    newBufferedWritableFile
+ * Signature: (Ljava/lang/String;Ljava/lang/String;J)J
+ */
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_BufferedWritableFile_00024_newBufferedWritableFile
+  (JNIEnv *, jobject, jstring, jstring, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_BufferedWritableFile__
+ * Method:    appendArray
+ * Signature: (J[BII)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_BufferedWritableFile_00024_appendArray
+  (JNIEnv *, jobject, jlong, jbyteArray, jint, jint);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_BufferedWritableFile__
+ * Method:    appendBuffer
+ * Signature: (JLjava/nio/ByteBuffer;II)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_BufferedWritableFile_00024_appendBuffer
+  (JNIEnv *, jobject, jlong, jobject, jint, jint);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_BufferedWritableFile__
+ * Method:    flush
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_BufferedWritableFile_00024_flush
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_BufferedWritableFile__
+ * Method:    sync
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_BufferedWritableFile_00024_sync
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_BufferedWritableFile__
+ * Method:    delete
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_BufferedWritableFile_00024_delete
+  (JNIEnv *, jobject, jlong);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
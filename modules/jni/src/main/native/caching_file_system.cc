@@ -0,0 +1,654 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include "caching_file_system.h"
+#include "utilities.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/c/tf_status_helper.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace {
+
+// Statistics of a `TieredFileBlockCache`.
+struct CacheStats {
+  tensorflow::int64 ram_hits = 0;
+  tensorflow::int64 spill_hits = 0;
+  tensorflow::int64 misses = 0;
+  tensorflow::int64 ram_bytes = 0;
+  tensorflow::int64 spill_bytes = 0;
+  tensorflow::int64 ram_evictions = 0;
+  tensorflow::int64 spill_evictions = 0;
+};
+
+// File block cache with a RAM tier and an optional spill tier on local disk (e.g., an SSD), following the design of
+// `RamFileBlockCache`.
+//
+// Blocks are kept in RAM in LRU order. Blocks evicted from RAM are written to files in the spill directory, which is
+// also bounded in size and evicts in LRU order. The spill directory is owned by the cache, which removes it when it is
+// closed or destroyed, and so it must not be shared with other caches. The spill tier is inclusive: blocks that are read
+// back from it are promoted to RAM but also kept on disk, so that evicting them from RAM again does not require
+// rewriting them.
+//
+// Concurrent reads of a block that is not cached result in a single fetch, with all readers waiting for it. Failed
+// fetches are not cached.
+class TieredFileBlockCache : public tensorflow::FileBlockCache {
+ public:
+  TieredFileBlockCache(
+      size_t block_size, size_t max_bytes, const std::string& spill_dir, size_t max_spill_bytes, BlockFetcher fetcher)
+      : block_size_(block_size), max_bytes_(max_bytes), spill_dir_(spill_dir),
+        max_spill_bytes_(spill_dir.empty() ? 0 : max_spill_bytes), fetcher_(std::move(fetcher)) {}
+
+  ~TieredFileBlockCache() override { Close(); }
+
+  // Deletes all spilled blocks along with the spill directory, and stops spilling. The RAM tier remains usable.
+  void Close() {
+    tensorflow::mutex_lock l(mu_);
+    if (spill_closed_) return;
+    spill_closed_ = true;
+    for (const auto& entry : spilled_) tensorflow::Env::Default()->DeleteFile(entry.second.path).IgnoreError();
+    spilled_.clear();
+    spill_lru_.clear();
+    stats_.spill_bytes = 0;
+    // Blocks that are being spilled concurrently are dropped once written, because their generation no longer matches.
+    ++flush_generation_;
+    if (!spill_dir_.empty()) tensorflow::Env::Default()->DeleteDir(spill_dir_).IgnoreError();
+  }
+
+  tensorflow::Status Read(
+      const std::string& filename, size_t offset, size_t n, char* buffer, size_t* bytes_transferred) override {
+    *bytes_transferred = 0;
+    if (n == 0) return tensorflow::Status::OK();
+    if (!IsCacheEnabled()) return fetcher_(filename, offset, n, buffer, bytes_transferred);
+    const size_t start = offset - offset % block_size_;
+    const size_t finish = offset + n;
+    size_t total = 0;
+    for (size_t position = start; position < finish; position += block_size_) {
+      std::shared_ptr<Block> block;
+      TF_RETURN_IF_ERROR(GetBlock(std::make_pair(filename, position), &block));
+      // The block data is immutable once fetched, and so it can be copied without holding any locks.
+      const std::string& data = block->data;
+      const size_t begin = position < offset ? offset - position : 0;
+      if (begin >= data.size()) break;
+      const size_t length = std::min(data.size() - begin, finish - position - begin);
+      memcpy(buffer + total, data.data() + begin, length);
+      total += length;
+      if (data.size() < block_size_) break;
+    }
+    *bytes_transferred = total;
+    if (total == 0) return tensorflow::errors::OutOfRange("EOF at offset ", offset, " in file ", filename);
+    return tensorflow::Status::OK();
+  }
+
+  bool ValidateAndUpdateFileSignature(const std::string& filename, tensorflow::int64 file_signature) override {
+    tensorflow::mutex_lock l(mu_);
+    auto it = file_signatures_.find(filename);
+    if (it != file_signatures_.end()) {
+      if (it->second == file_signature) return true;
+      RemoveFileLocked(filename);
+      it->second = file_signature;
+      return false;
+    }
+    file_signatures_[filename] = file_signature;
+    return true;
+  }
+
+  void RemoveFile(const std::string& filename) override {
+    tensorflow::mutex_lock l(mu_);
+    RemoveFileLocked(filename);
+  }
+
+  void Flush() override {
+    tensorflow::mutex_lock l(mu_);
+    blocks_.clear();
+    lru_.clear();
+    for (const auto& entry : spilled_) tensorflow::Env::Default()->DeleteFile(entry.second.path).IgnoreError();
+    spilled_.clear();
+    spill_lru_.clear();
+    file_signatures_.clear();
+    ++flush_generation_;
+    stats_.ram_bytes = 0;
+    stats_.spill_bytes = 0;
+  }
+
+  size_t block_size() const override { return block_size_; }
+  size_t max_bytes() const override { return max_bytes_; }
+  tensorflow::uint64 max_staleness() const override { return 0; }
+
+  size_t CacheSize() const override {
+    tensorflow::mutex_lock l(mu_);
+    return static_cast<size_t>(stats_.ram_bytes);
+  }
+
+  bool IsCacheEnabled() const override { return block_size_ > 0 && max_bytes_ > 0; }
+
+  CacheStats stats() const {
+    tensorflow::mutex_lock l(mu_);
+    return stats_;
+  }
+
+ private:
+  typedef std::pair<std::string, size_t> Key;
+
+  struct Block {
+    std::string data;
+    bool ready = false;
+    tensorflow::Status status;
+    // Only valid once the block is ready and was fetched successfully.
+    std::list<Key>::iterator lru_iterator;
+  };
+
+  // Block evicted from RAM that is yet to be spilled, along with the generation of its file at the time of eviction.
+  struct EvictedBlock {
+    Key key;
+    std::shared_ptr<Block> block;
+    tensorflow::int64 generation;
+  };
+
+  struct SpilledBlock {
+    std::string path;
+    size_t size;
+    std::list<Key>::iterator lru_iterator;
+  };
+
+  tensorflow::Status GetBlock(const Key& key, std::shared_ptr<Block>* result) {
+    std::shared_ptr<Block> block;
+    std::string spill_path;
+    {
+      tensorflow::mutex_lock l(mu_);
+      auto it = blocks_.find(key);
+      if (it != blocks_.end()) {
+        block = it->second;
+        while (!block->ready) cv_.wait(l);
+        if (!block->status.ok()) return block->status;
+        if (blocks_.count(key) > 0 && blocks_[key] == block) lru_.splice(lru_.begin(), lru_, block->lru_iterator);
+        ++stats_.ram_hits;
+        *result = block;
+        return tensorflow::Status::OK();
+      }
+      block = std::make_shared<Block>();
+      blocks_.emplace(key, block);
+      auto spilled = spilled_.find(key);
+      if (spilled != spilled_.end()) {
+        spill_path = spilled->second.path;
+        spill_lru_.splice(spill_lru_.begin(), spill_lru_, spilled->second.lru_iterator);
+      }
+    }
+
+    // The block is fetched without holding the lock. Other readers of the same block wait for it to become ready.
+    tensorflow::Status s;
+    bool from_spill = false;
+    if (!spill_path.empty()) {
+      s = tensorflow::ReadFileToString(tensorflow::Env::Default(), spill_path, &block->data);
+      from_spill = s.ok();
+      if (!s.ok()) LOG(WARNING) << "Failed to read spilled block '" << spill_path << "': " << s;
+    }
+    if (!from_spill) {
+      block->data.resize(block_size_);
+      size_t bytes_transferred = 0;
+      s = fetcher_(key.first, key.second, block_size_, &block->data[0], &bytes_transferred);
+      block->data.resize(s.ok() ? bytes_transferred : 0);
+    }
+
+    std::vector<EvictedBlock> evicted;
+    {
+      tensorflow::mutex_lock l(mu_);
+      block->status = s;
+      block->ready = true;
+      // The block may have been removed while it was being fetched, in which case it is returned but not cached.
+      auto it = blocks_.find(key);
+      const bool cached = it != blocks_.end() && it->second == block;
+      if (cached && s.ok()) {
+        block->lru_iterator = lru_.insert(lru_.begin(), key);
+        stats_.ram_bytes += block->data.size();
+        TrimLocked(&evicted);
+      } else if (cached) {
+        blocks_.erase(it);
+      }
+      if (s.ok()) {
+        if (from_spill) {
+          ++stats_.spill_hits;
+        } else {
+          ++stats_.misses;
+        }
+      }
+      cv_.notify_all();
+    }
+    Spill(evicted);
+    if (!s.ok()) return s;
+    *result = block;
+    return tensorflow::Status::OK();
+  }
+
+  // Evicts blocks from RAM until the RAM tier fits within its size limit. Evicted blocks that are not already in the
+  // spill tier are added to `evicted` so that they can be spilled after the lock is released.
+  void TrimLocked(std::vector<EvictedBlock>* evicted) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    while (stats_.ram_bytes > static_cast<tensorflow::int64>(max_bytes_) && lru_.size() > 1) {
+      Key key = lru_.back();
+      auto it = blocks_.find(key);
+      if (max_spill_bytes_ > 0 && !spill_closed_ && spilled_.count(key) == 0)
+        evicted->push_back({key, it->second, GenerationLocked(key.first)});
+      RemoveBlockLocked(it);
+      ++stats_.ram_evictions;
+    }
+  }
+
+  // Writes `blocks` to the spill directory and adds them to the spill tier, evicting older spilled blocks as needed.
+  // Blocks of files that were invalidated after they were evicted from RAM are dropped.
+  void Spill(const std::vector<EvictedBlock>& blocks) LOCKS_EXCLUDED(mu_) {
+    for (const EvictedBlock& entry : blocks) {
+      std::string path;
+      {
+        tensorflow::mutex_lock l(mu_);
+        if (spill_closed_ || GenerationLocked(entry.key.first) != entry.generation) continue;
+        path = tensorflow::io::JoinPath(spill_dir_, tensorflow::strings::StrCat(next_spill_id_++, ".block"));
+      }
+      tensorflow::Status s = tensorflow::WriteStringToFile(tensorflow::Env::Default(), path, entry.block->data);
+      if (!s.ok()) {
+        LOG(WARNING) << "Failed to spill block to '" << path << "': " << s;
+        tensorflow::Env::Default()->DeleteFile(path).IgnoreError();
+        continue;
+      }
+      std::vector<std::string> deleted;
+      bool closed;
+      {
+        tensorflow::mutex_lock l(mu_);
+        closed = spill_closed_;
+        if (GenerationLocked(entry.key.first) != entry.generation || spilled_.count(entry.key) > 0) {
+          // The file was invalidated or the cache was closed while the block was being written, or another thread
+          // spilled the same block concurrently.
+          deleted.push_back(path);
+        } else {
+          SpilledBlock spilled;
+          spilled.path = path;
+          spilled.size = entry.block->data.size();
+          spilled.lru_iterator = spill_lru_.insert(spill_lru_.begin(), entry.key);
+          spilled_.emplace(entry.key, spilled);
+          stats_.spill_bytes += spilled.size;
+          while (stats_.spill_bytes > static_cast<tensorflow::int64>(max_spill_bytes_) && !spill_lru_.empty()) {
+            auto it = spilled_.find(spill_lru_.back());
+            deleted.push_back(it->second.path);
+            RemoveSpilledBlockLocked(it);
+            ++stats_.spill_evictions;
+          }
+        }
+      }
+      for (const std::string& deleted_path : deleted)
+        tensorflow::Env::Default()->DeleteFile(deleted_path).IgnoreError();
+      // Closing the cache could not remove the spill directory while this block was being written to it.
+      if (closed) tensorflow::Env::Default()->DeleteDir(spill_dir_).IgnoreError();
+    }
+  }
+
+  // Returns the generation of `filename`, which changes every time its blocks are invalidated.
+  tensorflow::int64 GenerationLocked(const std::string& filename) const EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    auto it = file_generations_.find(filename);
+    return flush_generation_ + (it == file_generations_.end() ? 0 : it->second);
+  }
+
+  void RemoveBlockLocked(std::map<Key, std::shared_ptr<Block>>::iterator it) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const std::shared_ptr<Block>& block = it->second;
+    if (block->ready && block->status.ok()) {
+      lru_.erase(block->lru_iterator);
+      stats_.ram_bytes -= block->data.size();
+    }
+    blocks_.erase(it);
+  }
+
+  void RemoveSpilledBlockLocked(std::map<Key, SpilledBlock>::iterator it) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    spill_lru_.erase(it->second.lru_iterator);
+    stats_.spill_bytes -= it->second.size;
+    spilled_.erase(it);
+  }
+
+  void RemoveFileLocked(const std::string& filename) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    ++file_generations_[filename];
+    auto block = blocks_.lower_bound(std::make_pair(filename, 0));
+    while (block != blocks_.end() && block->first.first == filename) RemoveBlockLocked(block++);
+    auto spilled = spilled_.lower_bound(std::make_pair(filename, 0));
+    while (spilled != spilled_.end() && spilled->first.first == filename) {
+      tensorflow::Env::Default()->DeleteFile(spilled->second.path).IgnoreError();
+      RemoveSpilledBlockLocked(spilled++);
+    }
+  }
+
+  const size_t block_size_;
+  const size_t max_bytes_;
+  const std::string spill_dir_;
+  const size_t max_spill_bytes_;
+  const BlockFetcher fetcher_;
+
+  mutable tensorflow::mutex mu_;
+  tensorflow::condition_variable cv_;
+  std::map<Key, std::shared_ptr<Block>> blocks_ GUARDED_BY(mu_);
+  std::list<Key> lru_ GUARDED_BY(mu_);
+  std::map<Key, SpilledBlock> spilled_ GUARDED_BY(mu_);
+  std::list<Key> spill_lru_ GUARDED_BY(mu_);
+  std::map<std::string, tensorflow::int64> file_signatures_ GUARDED_BY(mu_);
+  // Both generations only ever increase, and so their sum changes whenever either of them does.
+  std::map<std::string, tensorflow::int64> file_generations_ GUARDED_BY(mu_);
+  tensorflow::int64 flush_generation_ GUARDED_BY(mu_) = 0;
+  tensorflow::int64 next_spill_id_ GUARDED_BY(mu_) = 0;
+  bool spill_closed_ GUARDED_BY(mu_) = false;
+  CacheStats stats_ GUARDED_BY(mu_);
+};
+
+// Files of the underlying file systems that are currently open, used by the block fetcher so that it does not need to
+// reopen files for every block it fetches.
+class OpenFiles {
+ public:
+  void Add(const std::string& filename, const std::shared_ptr<tensorflow::RandomAccessFile>& file) {
+    tensorflow::mutex_lock l(mu_);
+    files_[filename] = file;
+  }
+
+  tensorflow::Status Get(const std::string& filename, std::shared_ptr<tensorflow::RandomAccessFile>* file) {
+    {
+      tensorflow::mutex_lock l(mu_);
+      auto it = files_.find(filename);
+      if (it != files_.end()) {
+        *file = it->second.lock();
+        if (*file != nullptr) return tensorflow::Status::OK();
+        files_.erase(it);
+      }
+    }
+    std::unique_ptr<tensorflow::RandomAccessFile> new_file;
+    TF_RETURN_IF_ERROR(tensorflow::Env::Default()->NewRandomAccessFile(filename, &new_file));
+    *file = std::move(new_file);
+    return tensorflow::Status::OK();
+  }
+
+ private:
+  tensorflow::mutex mu_;
+  std::map<std::string, std::weak_ptr<tensorflow::RandomAccessFile>> files_ GUARDED_BY(mu_);
+};
+
+class CachedRandomAccessFile : public tensorflow::RandomAccessFile {
+ public:
+  CachedRandomAccessFile(
+      const std::string& filename, std::shared_ptr<tensorflow::RandomAccessFile> file, TieredFileBlockCache* cache)
+      : filename_(filename), file_(std::move(file)), cache_(cache) {}
+
+  tensorflow::Status Read(
+      tensorflow::uint64 offset, size_t n, tensorflow::StringPiece* result, char* scratch) const override {
+    size_t bytes_transferred = 0;
+    tensorflow::Status s = cache_->Read(filename_, static_cast<size_t>(offset), n, scratch, &bytes_transferred);
+    *result = tensorflow::StringPiece(scratch, bytes_transferred);
+    if (s.ok() && bytes_transferred < n) return tensorflow::errors::OutOfRange("Read less bytes than requested.");
+    return s;
+  }
+
+ private:
+  const std::string filename_;
+  // Kept open so that the block fetcher can reuse it.
+  const std::shared_ptr<tensorflow::RandomAccessFile> file_;
+  TieredFileBlockCache* cache_;
+};
+
+// File system that caches blocks of the files of any other file system. Files are accessed using paths of the form
+// `<scheme>://<path>`, where `<path>` is the path of the file in the underlying file system (e.g.,
+// `cache:///mnt/data/file` for a local file, or `cache://hdfs://namenode/data/file`). Only random access reads are
+// cached. Writing, deleting, or renaming a file through this file system invalidates its cached blocks, and files that
+// were modified through other means are detected when they are opened, using their size and modification time.
+class CachingFileSystem : public tensorflow::FileSystem {
+ public:
+  CachingFileSystem(
+      const std::string& scheme, std::shared_ptr<TieredFileBlockCache> cache, std::shared_ptr<OpenFiles> open_files)
+      : prefix_(scheme + "://"), cache_(std::move(cache)), open_files_(std::move(open_files)) {}
+
+  tensorflow::Status NewRandomAccessFile(
+      const std::string& fname, std::unique_ptr<tensorflow::RandomAccessFile>* result) override {
+    std::string filename = TranslateName(fname);
+    tensorflow::FileStatistics stat;
+    TF_RETURN_IF_ERROR(env()->Stat(filename, &stat));
+    cache_->ValidateAndUpdateFileSignature(
+      filename, static_cast<tensorflow::int64>(tensorflow::Hash64Combine(
+        static_cast<tensorflow::uint64>(stat.length), static_cast<tensorflow::uint64>(stat.mtime_nsec))));
+    std::unique_ptr<tensorflow::RandomAccessFile> file;
+    TF_RETURN_IF_ERROR(env()->NewRandomAccessFile(filename, &file));
+    std::shared_ptr<tensorflow::RandomAccessFile> shared_file(std::move(file));
+    open_files_->Add(filename, shared_file);
+    result->reset(new CachedRandomAccessFile(filename, std::move(shared_file), cache_.get()));
+    return tensorflow::Status::OK();
+  }
+
+  tensorflow::Status NewWritableFile(
+      const std::string& fname, std::unique_ptr<tensorflow::WritableFile>* result) override {
+    cache_->RemoveFile(TranslateName(fname));
+    return env()->NewWritableFile(TranslateName(fname), result);
+  }
+
+  tensorflow::Status NewAppendableFile(
+      const std::string& fname, std::unique_ptr<tensorflow::WritableFile>* result) override {
+    cache_->RemoveFile(TranslateName(fname));
+    return env()->NewAppendableFile(TranslateName(fname), result);
+  }
+
+  tensorflow::Status NewReadOnlyMemoryRegionFromFile(
+      const std::string& fname, std::unique_ptr<tensorflow::ReadOnlyMemoryRegion>* result) override {
+    return env()->NewReadOnlyMemoryRegionFromFile(TranslateName(fname), result);
+  }
+
+  tensorflow::Status FileExists(const std::string& fname) override {
+    return env()->FileExists(TranslateName(fname));
+  }
+
+  tensorflow::Status GetChildren(const std::string& dir, std::vector<std::string>* result) override {
+    return env()->GetChildren(TranslateName(dir), result);
+  }
+
+  tensorflow::Status GetMatchingPaths(const std::string& pattern, std::vector<std::string>* results) override {
+    TF_RETURN_IF_ERROR(env()->GetMatchingPaths(TranslateName(pattern), results));
+    for (std::string& result : *results) result = prefix_ + result;
+    return tensorflow::Status::OK();
+  }
+
+  tensorflow::Status Stat(const std::string& fname, tensorflow::FileStatistics* stat) override {
+    return env()->Stat(TranslateName(fname), stat);
+  }
+
+  tensorflow::Status DeleteFile(const std::string& fname) override {
+    cache_->RemoveFile(TranslateName(fname));
+    return env()->DeleteFile(TranslateName(fname));
+  }
+
+  tensorflow::Status CreateDir(const std::string& dirname) override {
+    return env()->CreateDir(TranslateName(dirname));
+  }
+
+  tensorflow::Status RecursivelyCreateDir(const std::string& dirname) override {
+    return env()->RecursivelyCreateDir(TranslateName(dirname));
+  }
+
+  tensorflow::Status DeleteDir(const std::string& dirname) override {
+    return env()->DeleteDir(TranslateName(dirname));
+  }
+
+  tensorflow::Status GetFileSize(const std::string& fname, tensorflow::uint64* file_size) override {
+    return env()->GetFileSize(TranslateName(fname), file_size);
+  }
+
+  tensorflow::Status RenameFile(const std::string& src, const std::string& target) override {
+    cache_->RemoveFile(TranslateName(src));
+    cache_->RemoveFile(TranslateName(target));
+    return env()->RenameFile(TranslateName(src), TranslateName(target));
+  }
+
+  tensorflow::Status IsDirectory(const std::string& fname) override {
+    return env()->IsDirectory(TranslateName(fname));
+  }
+
+  // Returns the path of the file in the underlying file system.
+  std::string TranslateName(const std::string& name) const override {
+    if (name.compare(0, prefix_.size(), prefix_) == 0) return name.substr(prefix_.size());
+    return name;
+  }
+
+  void FlushCaches() override { cache_->Flush(); }
+
+ private:
+  static tensorflow::Env* env() { return tensorflow::Env::Default(); }
+
+  const std::string prefix_;
+  const std::shared_ptr<TieredFileBlockCache> cache_;
+  const std::shared_ptr<OpenFiles> open_files_;
+};
+
+// Creates a new, uniquely named directory under `parent` for the spill tier of the cache registered under `scheme`, so
+// that caches of different schemes or processes (e.g., multiple Horovod ranks on one host) can share `parent` without
+// overwriting each other's spilled blocks.
+tensorflow::Status createSpillDirectory(const std::string& parent, const std::string& scheme, std::string* directory) {
+  TF_RETURN_IF_ERROR(tensorflow::Env::Default()->RecursivelyCreateDir(parent));
+  std::string path = tensorflow::io::JoinPath(parent, tensorflow::strings::StrCat(getpid(), "-", scheme, "-XXXXXX"));
+  if (mkdtemp(&path[0]) == nullptr)
+    return tensorflow::errors::Internal("Failed to create a spill directory in '", parent, "': ", strerror(errno));
+  *directory = path;
+  return tensorflow::Status::OK();
+}
+
+// Caches of all registered caching file systems, keyed by scheme. TensorFlow provides no way to unregister file systems,
+// and so these caches are never destroyed.
+tensorflow::mutex caches_mu(tensorflow::LINKER_INITIALIZED);
+std::map<std::string, std::shared_ptr<TieredFileBlockCache>>* caches GUARDED_BY(caches_mu) = nullptr;
+
+// Closes all registered caches when the process exits, so that their spill directories are not left behind.
+void closeCaches() {
+  tensorflow::mutex_lock l(caches_mu);
+  if (caches == nullptr) return;
+  for (const auto& entry : *caches) entry.second->Close();
+}
+
+// Returns the cache of the caching file system registered under `scheme`, or throws an exception if there is none.
+std::shared_ptr<TieredFileBlockCache> getCache(JNIEnv* env, jstring scheme) {
+  const char* c_scheme = env->GetStringUTFChars(scheme, nullptr);
+  std::string scheme_string(c_scheme);
+  env->ReleaseStringUTFChars(scheme, c_scheme);
+  tensorflow::mutex_lock l(caches_mu);
+  if (caches != nullptr) {
+    auto it = caches->find(scheme_string);
+    if (it != caches->end()) return it->second;
+  }
+  throw_exception(
+    env, tf_invalid_argument_exception, "No caching file system is registered for scheme '%s'.",
+    scheme_string.c_str());
+  return nullptr;
+}
+
+}  // namespace
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_CachingFileSystem_00024_register(
+    JNIEnv* env, jobject object, jstring scheme, jlong block_size, jlong max_bytes, jstring spill_directory,
+    jlong max_spill_bytes) {
+  if (block_size <= 0 || max_bytes < 0 || max_spill_bytes < 0) {
+    throw_exception(
+      env, tf_invalid_argument_exception,
+      "The block size must be positive and the cache size limits must be non-negative.");
+    return;
+  }
+  const char* c_scheme = env->GetStringUTFChars(scheme, nullptr);
+  const char* c_spill_directory = env->GetStringUTFChars(spill_directory, nullptr);
+  std::string scheme_string(c_scheme);
+  std::string spill_directory_string(c_spill_directory);
+  env->ReleaseStringUTFChars(scheme, c_scheme);
+  env->ReleaseStringUTFChars(spill_directory, c_spill_directory);
+
+  tensorflow::Status s;
+  std::string cache_spill_directory;
+  if (!spill_directory_string.empty())
+    s = createSpillDirectory(spill_directory_string, scheme_string, &cache_spill_directory);
+  if (s.ok()) {
+    std::shared_ptr<OpenFiles> open_files = std::make_shared<OpenFiles>();
+    std::shared_ptr<TieredFileBlockCache> cache = std::make_shared<TieredFileBlockCache>(
+      static_cast<size_t>(block_size), static_cast<size_t>(max_bytes), cache_spill_directory,
+      static_cast<size_t>(max_spill_bytes),
+      [open_files](const std::string& filename, size_t offset, size_t n, char* buffer, size_t* bytes_transferred) {
+        std::shared_ptr<tensorflow::RandomAccessFile> file;
+        TF_RETURN_IF_ERROR(open_files->Get(filename, &file));
+        tensorflow::StringPiece result;
+        tensorflow::Status read_status = file->Read(offset, n, &result, buffer);
+        if (!read_status.ok() && !tensorflow::errors::IsOutOfRange(read_status)) return read_status;
+        if (result.data() != buffer) memmove(buffer, result.data(), result.size());
+        *bytes_transferred = result.size();
+        return tensorflow::Status::OK();
+      });
+    s = tensorflow::Env::Default()->RegisterFileSystem(
+      scheme_string, [scheme_string, cache, open_files]() -> tensorflow::FileSystem* {
+        return new CachingFileSystem(scheme_string, cache, open_files);
+      });
+    if (s.ok()) {
+      tensorflow::mutex_lock l(caches_mu);
+      if (caches == nullptr) {
+        caches = new std::map<std::string, std::shared_ptr<TieredFileBlockCache>>();
+        atexit(closeCaches);
+      }
+      (*caches)[scheme_string] = cache;
+    } else {
+      cache->Close();
+    }
+  }
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+}
+
+JNIEXPORT jobject JNICALL Java_org_platanios_tensorflow_jni_CachingFileSystem_00024_stats(
+    JNIEnv* env, jobject object, jstring scheme) {
+  std::shared_ptr<TieredFileBlockCache> cache = getCache(env, scheme);
+  if (cache == nullptr) return nullptr;
+  CacheStats stats = cache->stats();
+  jclass stats_class = env->FindClass("org/platanios/tensorflow/jni/CachingFileSystemStats");
+  jmethodID stats_constructor = env->GetStaticMethodID(
+      stats_class, "apply", "(JJJJJJJ)Lorg/platanios/tensorflow/jni/CachingFileSystemStats;");
+  return env->CallStaticObjectMethod(
+    stats_class, stats_constructor, static_cast<jlong>(stats.ram_hits), static_cast<jlong>(stats.spill_hits),
+    static_cast<jlong>(stats.misses), static_cast<jlong>(stats.ram_bytes), static_cast<jlong>(stats.spill_bytes),
+    static_cast<jlong>(stats.ram_evictions), static_cast<jlong>(stats.spill_evictions));
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_CachingFileSystem_00024_clear(
+    JNIEnv* env, jobject object, jstring scheme) {
+  std::shared_ptr<TieredFileBlockCache> cache = getCache(env, scheme);
+  if (cache == nullptr) return;
+  cache->Flush();
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_CachingFileSystem_00024_close(
+    JNIEnv* env, jobject object, jstring scheme) {
+  std::shared_ptr<TieredFileBlockCache> cache = getCache(env, scheme);
+  if (cache == nullptr) return;
+  cache->Close();
+}
@@ -0,0 +1,45 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class org_platanios_tensorflow_jni_CachingFileSystem__ */
+
+#ifndef _Included_org_platanios_tensorflow_jni_CachingFileSystem__
+#define _Included_org_platanios_tensorflow_jni_CachingFileSystem__
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     org_platanios_tensorflow_jni_CachingFileSystem__
+ * Method:    register
+ * Signature: (Ljava/lang/String;JJLjava/lang/String;J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_CachingFileSystem_00024_register
+  (JNIEnv *, jobject, jstring, jlong, jlong, jstring, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_CachingFileSystem__
+ * Method:    stats
+ * Signature: (Ljava/lang/String;)Lorg/platanios/tensorflow/jni/CachingFileSystemStats;
+ */
+JNIEXPORT jobject JNICALL Java_org_platanios_tensorflow_jni_CachingFileSystem_00024_stats
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_CachingFileSystem__
+ * Method:    clear
+ * Signature: (Ljava/lang/String;)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_CachingFileSystem_00024_clear
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_CachingFileSystem__
+ * Method:    close
+ * Signature: (Ljava/lang/String;)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_CachingFileSystem_00024_close
+  (JNIEnv *, jobject, jstring);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
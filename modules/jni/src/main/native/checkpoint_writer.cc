@@ -0,0 +1,287 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include "checkpoint_writer.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/c/eager/c_api_internal.h"
+#include "tensorflow/c/tf_status_helper.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace {
+
+// Writes a set of tensors to a V2 checkpoint (i.e., a tensor bundle) without blocking the caller.
+//
+// Tensors are snapshotted when they are added. A snapshot is a shallow copy that shares the underlying buffer with the
+// original tensor, and so it costs no memory copies. Resource variable updates never modify a buffer that is shared
+// with another tensor (they copy it first), and so the snapshot remains consistent while training continues.
+//
+// Once started, the tensors are partitioned into shards of roughly equal size and each shard is written by its own
+// `BundleWriter` on a background thread, under a temporary prefix. When all shards are done, they are merged into the
+// final prefix using `MergeBundles`, which writes the metadata (i.e., index) file last. This means that the checkpoint
+// becomes visible at the final prefix only after all of its data has been written successfully.
+class CheckpointWriter {
+ public:
+  CheckpointWriter(const std::string& prefix, int num_shards)
+      : prefix_(prefix),
+        num_shards_(std::max(num_shards, 1)),
+        temp_dir_(tensorflow::strings::Printf(
+          "%s_temp_%llx", prefix.c_str(), static_cast<unsigned long long>(tensorflow::random::New64()))) {}
+
+  ~CheckpointWriter() {
+    // Destroying the thread pool waits for all scheduled shard writes to complete.
+    thread_pool_.reset();
+  }
+
+  tensorflow::Status Add(const std::string& name, const tensorflow::Tensor& tensor) {
+    tensorflow::mutex_lock l(mu_);
+    if (started_)
+      return tensorflow::errors::FailedPrecondition("Cannot add tensors to a checkpoint writer that has been started.");
+    names_.push_back(name);
+    tensors_.push_back(tensor);
+    num_bytes_ += static_cast<tensorflow::int64>(tensor.TotalBytes());
+    return tensorflow::Status::OK();
+  }
+
+  tensorflow::Status Start() {
+    std::vector<std::vector<size_t>> shards;
+    {
+      tensorflow::mutex_lock l(mu_);
+      if (started_)
+        return tensorflow::errors::FailedPrecondition("This checkpoint writer has already been started.");
+      started_ = true;
+      shards = PartitionIntoShards();
+      num_shards_started_ = static_cast<int>(shards.size());
+      num_pending_shards_ = num_shards_started_;
+    }
+    tensorflow::Status s = tensorflow::Env::Default()->RecursivelyCreateDir(temp_dir_);
+    if (!s.ok()) {
+      tensorflow::mutex_lock l(mu_);
+      status_ = s;
+      done_ = true;
+      done_cv_.notify_all();
+      return s;
+    }
+    thread_pool_.reset(new tensorflow::thread::ThreadPool(
+      tensorflow::Env::Default(), "checkpoint_writer", static_cast<int>(shards.size())));
+    for (size_t shard = 0; shard < shards.size(); ++shard) {
+      std::vector<size_t> indices = std::move(shards[shard]);
+      thread_pool_->Schedule([this, shard, indices]() { WriteShard(shard, indices); });
+    }
+    return tensorflow::Status::OK();
+  }
+
+  tensorflow::Status Wait() {
+    tensorflow::mutex_lock l(mu_);
+    if (!started_)
+      return tensorflow::errors::FailedPrecondition("This checkpoint writer has not been started yet.");
+    while (!done_) done_cv_.wait(l);
+    return status_;
+  }
+
+  tensorflow::int64 num_tensors() const { return static_cast<tensorflow::int64>(tensors_.size()); }
+  tensorflow::int64 num_tensors_written() const { return num_tensors_written_.load(); }
+  tensorflow::int64 num_bytes() const { return num_bytes_; }
+  tensorflow::int64 num_bytes_written() const { return num_bytes_written_.load(); }
+
+  bool done() {
+    tensorflow::mutex_lock l(mu_);
+    return done_;
+  }
+
+ private:
+  // Assigns tensors to shards, largest tensor first, always picking the least loaded shard. This keeps the shards
+  // balanced, which matters because the checkpoint is only committed once the slowest shard has been written.
+  std::vector<std::vector<size_t>> PartitionIntoShards() {
+    std::vector<size_t> order(tensors_.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+      return tensors_[a].TotalBytes() > tensors_[b].TotalBytes();
+    });
+    size_t num_shards = std::max<size_t>(std::min<size_t>(num_shards_, tensors_.size()), 1);
+    std::vector<std::vector<size_t>> shards(num_shards);
+    std::vector<tensorflow::int64> shard_sizes(num_shards, 0);
+    for (size_t index : order) {
+      size_t shard = std::min_element(shard_sizes.begin(), shard_sizes.end()) - shard_sizes.begin();
+      shards[shard].push_back(index);
+      shard_sizes[shard] += static_cast<tensorflow::int64>(tensors_[index].TotalBytes());
+    }
+    return shards;
+  }
+
+  std::string ShardPrefix(size_t shard) const {
+    return tensorflow::io::JoinPath(temp_dir_, tensorflow::strings::Printf("part-%05d", static_cast<int>(shard)));
+  }
+
+  void WriteShard(size_t shard, const std::vector<size_t>& indices) {
+    tensorflow::BundleWriter writer(tensorflow::Env::Default(), ShardPrefix(shard));
+    tensorflow::Status s = writer.status();
+    for (size_t index : indices) {
+      if (!s.ok() || cancelled_.load()) break;
+      s = writer.Add(names_[index], tensors_[index]);
+      if (s.ok()) {
+        num_tensors_written_.fetch_add(1);
+        num_bytes_written_.fetch_add(static_cast<tensorflow::int64>(tensors_[index].TotalBytes()));
+      }
+    }
+    tensorflow::Status finish_status = writer.Finish();
+    if (s.ok()) s = finish_status;
+    if (!s.ok()) cancelled_.store(true);
+
+    bool is_last_shard;
+    {
+      tensorflow::mutex_lock l(mu_);
+      status_.Update(s);
+      is_last_shard = --num_pending_shards_ == 0;
+    }
+    if (is_last_shard) Commit();
+  }
+
+  // Merges the shards into the final prefix and removes the temporary directory.
+  void Commit() {
+    tensorflow::Status s;
+    {
+      tensorflow::mutex_lock l(mu_);
+      s = status_;
+    }
+    if (s.ok()) {
+      std::vector<std::string> shard_prefixes;
+      for (int shard = 0; shard < num_shards_started_; ++shard)
+        shard_prefixes.push_back(ShardPrefix(static_cast<size_t>(shard)));
+      s = tensorflow::MergeBundles(tensorflow::Env::Default(), shard_prefixes, prefix_);
+    }
+    tensorflow::int64 undeleted_files, undeleted_dirs;
+    tensorflow::Env::Default()->DeleteRecursively(temp_dir_, &undeleted_files, &undeleted_dirs).IgnoreError();
+    tensorflow::mutex_lock l(mu_);
+    status_.Update(s);
+    done_ = true;
+    done_cv_.notify_all();
+  }
+
+  const std::string prefix_;
+  const int num_shards_;
+  const std::string temp_dir_;
+
+  // Tensor names and snapshots. These are only modified before the writer is started.
+  std::vector<std::string> names_;
+  std::vector<tensorflow::Tensor> tensors_;
+  tensorflow::int64 num_bytes_ = 0;
+
+  std::atomic<tensorflow::int64> num_tensors_written_{0};
+  std::atomic<tensorflow::int64> num_bytes_written_{0};
+  std::atomic<bool> cancelled_{false};
+
+  tensorflow::mutex mu_;
+  tensorflow::condition_variable done_cv_;
+  bool started_ = false;
+  bool done_ = false;
+  int num_shards_started_ = 0;
+  int num_pending_shards_ = 0;
+  tensorflow::Status status_;
+
+  std::unique_ptr<tensorflow::thread::ThreadPool> thread_pool_;
+};
+}  // namespace
+
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_CheckpointWriter_00024_newCheckpointWriter(
+    JNIEnv* env, jobject object, jstring prefix, jint num_shards) {
+  const char* c_prefix = env->GetStringUTFChars(prefix, nullptr);
+  auto* writer = new CheckpointWriter(std::string(c_prefix), static_cast<int>(num_shards));
+  env->ReleaseStringUTFChars(prefix, c_prefix);
+  return reinterpret_cast<jlong>(writer);
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_CheckpointWriter_00024_addTensors(
+    JNIEnv* env, jobject object, jlong writer_handle, jobjectArray names, jlongArray tensor_handles) {
+  REQUIRE_HANDLE(writer, CheckpointWriter, writer_handle, void());
+  const int num_tensors = env->GetArrayLength(names);
+  std::unique_ptr<TFE_TensorHandle*[]> tensors(new TFE_TensorHandle*[num_tensors]);
+  REQUIRE_HANDLES(tensor_handles, tensors.get(), num_tensors, void());
+  std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+  for (int i = 0; i < num_tensors; ++i) {
+    jstring name = reinterpret_cast<jstring>(env->GetObjectArrayElement(names, i));
+    const char* c_name = env->GetStringUTFChars(name, nullptr);
+    std::string cpp_name(c_name);
+    env->ReleaseStringUTFChars(name, c_name);
+    env->DeleteLocalRef(name);
+    const tensorflow::Tensor* tensor = nullptr;
+    tensorflow::Device* device = nullptr;
+    tensorflow::Device* op_device = nullptr;
+    tensorflow::Status s = tensors[i]->handle->TensorAndDevice(&tensor, &device, &op_device);
+    if (s.ok() && device != nullptr && device->device_type() != tensorflow::DEVICE_CPU)
+      s = tensorflow::errors::InvalidArgument(
+        "Tensor '", cpp_name, "' is placed on device '", device->name(), "'. Only host tensors can be checkpointed.");
+    if (s.ok()) s = writer->Add(cpp_name, *tensor);
+    if (!s.ok()) {
+      Set_TF_Status_from_Status(status.get(), s);
+      CHECK_STATUS(env, status.get(), void());
+    }
+  }
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_CheckpointWriter_00024_start(
+    JNIEnv* env, jobject object, jlong writer_handle) {
+  REQUIRE_HANDLE(writer, CheckpointWriter, writer_handle, void());
+  tensorflow::Status s = writer->Start();
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+}
+
+JNIEXPORT jobject JNICALL Java_org_platanios_tensorflow_jni_CheckpointWriter_00024_progress(
+    JNIEnv* env, jobject object, jlong writer_handle) {
+  REQUIRE_HANDLE(writer, CheckpointWriter, writer_handle, nullptr);
+  jclass progress_class = env->FindClass("org/platanios/tensorflow/jni/CheckpointWriterProgress");
+  jmethodID progress_constructor = env->GetStaticMethodID(
+      progress_class, "apply", "(JJJJZ)Lorg/platanios/tensorflow/jni/CheckpointWriterProgress;");
+  return env->CallStaticObjectMethod(
+    progress_class, progress_constructor,
+    static_cast<jlong>(writer->num_tensors_written()), static_cast<jlong>(writer->num_tensors()),
+    static_cast<jlong>(writer->num_bytes_written()), static_cast<jlong>(writer->num_bytes()),
+    static_cast<jboolean>(writer->done()));
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_CheckpointWriter_00024_await(
+    JNIEnv* env, jobject object, jlong writer_handle) {
+  REQUIRE_HANDLE(writer, CheckpointWriter, writer_handle, void());
+  tensorflow::Status s = writer->Wait();
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_CheckpointWriter_00024_delete(
+    JNIEnv* env, jobject object, jlong writer_handle) {
+  REQUIRE_HANDLE(writer, CheckpointWriter, writer_handle, void());
+  delete writer;
+}
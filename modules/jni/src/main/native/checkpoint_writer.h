@@ -0,0 +1,61 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class org_platanios_tensorflow_jni_CheckpointWriter__ */
+
+#ifndef _Included_org_platanios_tensorflow_jni_CheckpointWriter__
+#define _Included_org_platanios_tensorflow_jni_CheckpointWriter__
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     org_platanios_tensorflow_jni_CheckpointWriter__
+ * Method:    newCheckpointWriter
+ * Signature: (Ljava/lang/String;I)J
+ */
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_CheckpointWriter_00024_newCheckpointWriter
+  (JNIEnv *, jobject, jstring, jint);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_CheckpointWriter__
+ * Method:    addTensors
+ * Signature: (J[Ljava/lang/String;[J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_CheckpointWriter_00024_addTensors
+  (JNIEnv *, jobject, jlong, jobjectArray, jlongArray);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_CheckpointWriter__
+ * Method:    start
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_CheckpointWriter_00024_start
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_CheckpointWriter__
+ * Method:    progress
+ * Signature: (J)Lorg/platanios/tensorflow/jni/CheckpointWriterProgress;
+ */
+JNIEXPORT jobject JNICALL Java_org_platanios_tensorflow_jni_CheckpointWriter_00024_progress
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_CheckpointWriter__
+ * Method:    await
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_CheckpointWriter_00024_await
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_CheckpointWriter__
+ * Method:    delete
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_CheckpointWriter_00024_delete
+  (JNIEnv *, jobject, jlong);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,357 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include "event_scanner.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/c/tf_status_helper.h"
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/event.pb.h"
+
+namespace {
+
+struct ScannedRecord {
+  double wall_time;
+  tensorflow::int64 step;
+  float simple_value;
+  std::string serialized_value;
+};
+
+// Reservoir sampling bucket that mirrors the behavior of the Scala `ReservoirBucket` (with `alwaysKeepLast` set to
+// `true`): the first `max_size` items are always kept and after that, each new item replaces a random item with
+// probability `max_size / num_items_seen`, or otherwise replaces the last item. A `max_size` of `0` keeps all items.
+class ReservoirBucket {
+ public:
+  explicit ReservoirBucket(int max_size) : max_size_(max_size), random_(0) {}
+
+  // Returns a pointer to the slot where the new item should be stored.
+  ScannedRecord* Add() {
+    ++num_items_seen_;
+    if (max_size_ == 0 || items_.size() < static_cast<size_t>(max_size_)) {
+      items_.emplace_back();
+      return &items_.back();
+    }
+    std::uniform_int_distribution<tensorflow::int64> distribution(0, num_items_seen_ - 1);
+    tensorflow::int64 r = distribution(random_);
+    if (r < max_size_) {
+      items_.erase(items_.begin() + r);
+      items_.emplace_back();
+    }
+    return &items_.back();
+  }
+
+  // Removes all items with step greater than or equal to `step` and scales the number of items seen accordingly, so
+  // that the sampling rate remains approximately correct.
+  void PurgeFrom(tensorflow::int64 step) {
+    size_t num_items = items_.size();
+    items_.erase(
+      std::remove_if(items_.begin(), items_.end(), [step](const ScannedRecord& r) { return r.step >= step; }),
+      items_.end());
+    if (num_items > 0)
+      num_items_seen_ = static_cast<tensorflow::int64>(std::round(
+        static_cast<double>(num_items_seen_) * items_.size() / num_items));
+  }
+
+  const std::vector<ScannedRecord>& items() const { return items_; }
+
+ private:
+  const int max_size_;
+  std::mt19937_64 random_;
+  tensorflow::int64 num_items_seen_ = 0;
+  std::vector<ScannedRecord> items_;
+};
+
+struct ScanOptions {
+  std::unordered_set<std::string> tags;
+  std::unordered_set<std::string> plugins;
+  int reservoir_size;
+  bool purge_orphaned_data;
+};
+
+struct RunResult {
+  std::vector<std::string> tags;
+  std::vector<std::string> plugins;
+  std::vector<ReservoirBucket> buckets;
+  tensorflow::Status status;
+};
+
+// Returns the plugin name for a summary value that carries no plugin metadata, based on the kind of the value.
+std::string DefaultPluginName(const tensorflow::Summary::Value& value) {
+  switch (value.value_case()) {
+    case tensorflow::Summary::Value::kSimpleValue: return "scalars";
+    case tensorflow::Summary::Value::kImage: return "images";
+    case tensorflow::Summary::Value::kAudio: return "audio";
+    case tensorflow::Summary::Value::kHisto: return "histograms";
+    default: return "";
+  }
+}
+
+// Returns the events files of a run, in the order in which they were written. A run is either a single events file or
+// a directory containing events files.
+tensorflow::Status EventFiles(const std::string& run_path, std::vector<std::string>* files) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  if (!env->IsDirectory(run_path).ok()) {
+    files->push_back(run_path);
+    return tensorflow::Status::OK();
+  }
+  std::vector<std::string> children;
+  TF_RETURN_IF_ERROR(env->GetChildren(run_path, &children));
+  for (const std::string& child : children)
+    if (child.find("tfevents") != std::string::npos)
+      files->push_back(tensorflow::io::JoinPath(run_path, child));
+  // Event file names contain the creation timestamp and so sorting them by name sorts them by creation time.
+  std::sort(files->begin(), files->end());
+  return tensorflow::Status::OK();
+}
+
+// Returns the version number in an event `file_version` field (e.g., `2` for "brain.Event:2"), or `-1` if it is
+// invalid, like `EventAccumulator` does.
+float ParseFileVersion(const std::string& file_version) {
+  static const char kPrefix[] = "brain.Event:";
+  size_t position = file_version.rfind(kPrefix);
+  std::string version =
+    position == std::string::npos ? file_version : file_version.substr(position + sizeof(kPrefix) - 1);
+  float value;
+  if (!tensorflow::strings::safe_strtof(version, &value)) return -1.0f;
+  return value;
+}
+
+void ScanRun(const std::string& run_path, const ScanOptions& options, RunResult* result) {
+  std::unordered_map<std::string, int> tag_indices;
+  // Plugin names are determined by the first value encountered for each tag, because summary writers only keep the
+  // summary metadata for that value. Tags that are filtered out are recorded with an index of `-1`.
+  auto tag_index = [&](const tensorflow::Summary::Value& value) {
+    auto it = tag_indices.find(value.tag());
+    if (it != tag_indices.end()) return it->second;
+    std::string plugin = value.has_metadata() && !value.metadata().plugin_data().plugin_name().empty()
+      ? value.metadata().plugin_data().plugin_name()
+      : DefaultPluginName(value);
+    int index = -1;
+    if ((options.tags.empty() || options.tags.count(value.tag()) > 0) &&
+        (options.plugins.empty() || options.plugins.count(plugin) > 0)) {
+      index = static_cast<int>(result->tags.size());
+      result->tags.push_back(value.tag());
+      result->plugins.push_back(plugin);
+      result->buckets.emplace_back(options.reservoir_size);
+    }
+    tag_indices.emplace(value.tag(), index);
+    return index;
+  };
+
+  std::vector<std::string> files;
+  result->status = EventFiles(run_path, &files);
+  if (!result->status.ok()) return;
+  // Orphaned data is purged using the same logic as `EventAccumulator`: files with version 2 or later purge everything
+  // after a `SessionLog.START` event, while older files purge the tags of summaries whose step is smaller than the most
+  // recent step.
+  float file_version = -1.0f;
+  tensorflow::int64 most_recent_step = -1;
+  tensorflow::Event event;
+  for (const std::string& file_path : files) {
+    std::unique_ptr<tensorflow::RandomAccessFile> file;
+    result->status = tensorflow::Env::Default()->NewRandomAccessFile(file_path, &file);
+    if (!result->status.ok()) return;
+    tensorflow::io::RecordReader reader(file.get());
+    tensorflow::uint64 offset = 0;
+    std::string record;
+    while (true) {
+      tensorflow::Status s = reader.ReadRecord(&offset, &record);
+      // Truncated records at the end of a file are expected while the file is still being written and are ignored.
+      if (s.code() == tensorflow::error::OUT_OF_RANGE || s.code() == tensorflow::error::DATA_LOSS) break;
+      if (!s.ok()) {
+        result->status = s;
+        return;
+      }
+      if (!event.ParseFromString(record)) continue;
+      if (event.what_case() == tensorflow::Event::kFileVersion) file_version = ParseFileVersion(event.file_version());
+      if (options.purge_orphaned_data) {
+        if (file_version >= 2) {
+          // A restart orphans all events with steps that are not smaller than the restart step.
+          if (event.has_session_log() && event.session_log().status() == tensorflow::SessionLog::START)
+            for (auto& bucket : result->buckets) bucket.PurgeFrom(event.step());
+        } else if (event.has_summary() && event.step() < most_recent_step) {
+          // An out-of-order step is likely caused by a restart, but only the tags of the summary are purged, because
+          // summaries with different tags may be written with unsynchronized steps.
+          for (const tensorflow::Summary::Value& value : event.summary().value()) {
+            int index = tag_index(value);
+            if (index >= 0) result->buckets[index].PurgeFrom(event.step());
+          }
+        } else {
+          most_recent_step = event.step();
+        }
+      }
+      if (!event.has_summary()) continue;
+      for (const tensorflow::Summary::Value& value : event.summary().value()) {
+        int index = tag_index(value);
+        if (index < 0) continue;
+        ReservoirBucket& bucket = result->buckets[index];
+        ScannedRecord* scanned = bucket.Add();
+        scanned->wall_time = event.wall_time();
+        scanned->step = event.step();
+        scanned->simple_value = value.value_case() == tensorflow::Summary::Value::kSimpleValue
+          ? value.simple_value()
+          : std::numeric_limits<float>::quiet_NaN();
+        // Scalar values are returned through `simple_value` and so their protos do not need to be serialized.
+        if (value.value_case() == tensorflow::Summary::Value::kSimpleValue)
+          scanned->serialized_value.clear();
+        else
+          value.SerializeToString(&scanned->serialized_value);
+      }
+    }
+  }
+}
+
+jobjectArray ToStringArray(JNIEnv* env, const std::vector<std::string>& strings) {
+  jclass string_class = env->FindClass("java/lang/String");
+  jobjectArray array = env->NewObjectArray(static_cast<jsize>(strings.size()), string_class, nullptr);
+  for (size_t i = 0; i < strings.size(); ++i) {
+    jstring string = env->NewStringUTF(strings[i].c_str());
+    env->SetObjectArrayElement(array, static_cast<jsize>(i), string);
+    env->DeleteLocalRef(string);
+  }
+  return array;
+}
+
+std::vector<std::string> FromStringArray(JNIEnv* env, jobjectArray array) {
+  std::vector<std::string> strings;
+  if (array == nullptr) return strings;
+  const int length = env->GetArrayLength(array);
+  strings.reserve(length);
+  for (int i = 0; i < length; ++i) {
+    jstring string = static_cast<jstring>(env->GetObjectArrayElement(array, i));
+    const char* c_string = env->GetStringUTFChars(string, nullptr);
+    strings.emplace_back(c_string);
+    env->ReleaseStringUTFChars(string, c_string);
+    env->DeleteLocalRef(string);
+  }
+  return strings;
+}
+
+}  // namespace
+
+JNIEXPORT jobjectArray JNICALL Java_org_platanios_tensorflow_jni_EventScanner_00024_scan(
+    JNIEnv* env, jobject object, jobjectArray run_paths, jobjectArray tags, jobjectArray plugins,
+    jint reservoir_size, jboolean purge_orphaned_data, jint num_threads) {
+  std::vector<std::string> c_run_paths = FromStringArray(env, run_paths);
+  std::vector<std::string> c_tags = FromStringArray(env, tags);
+  std::vector<std::string> c_plugins = FromStringArray(env, plugins);
+  ScanOptions options;
+  options.tags.insert(c_tags.begin(), c_tags.end());
+  options.plugins.insert(c_plugins.begin(), c_plugins.end());
+  options.reservoir_size = std::max(static_cast<int>(reservoir_size), 0);
+  options.purge_orphaned_data = static_cast<bool>(purge_orphaned_data);
+
+  // Each run is scanned independently and so runs can be scanned in parallel.
+  std::vector<RunResult> results(c_run_paths.size());
+  int c_num_threads = std::max(std::min(static_cast<int>(num_threads), static_cast<int>(c_run_paths.size())), 1);
+  if (c_num_threads == 1) {
+    for (size_t i = 0; i < c_run_paths.size(); ++i) ScanRun(c_run_paths[i], options, &results[i]);
+  } else {
+    tensorflow::thread::ThreadPool thread_pool(tensorflow::Env::Default(), "event_scanner", c_num_threads);
+    tensorflow::BlockingCounter counter(static_cast<int>(c_run_paths.size()));
+    for (size_t i = 0; i < c_run_paths.size(); ++i) {
+      thread_pool.Schedule([&c_run_paths, &options, &results, &counter, i]() {
+        ScanRun(c_run_paths[i], options, &results[i]);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  }
+
+  jclass scanned_events_class = env->FindClass("org/platanios/tensorflow/jni/ScannedEvents");
+  jmethodID scanned_events_constructor = env->GetStaticMethodID(
+      scanned_events_class, "apply",
+      "([Ljava/lang/String;[Ljava/lang/String;[I[J[D[F[[B)Lorg/platanios/tensorflow/jni/ScannedEvents;");
+  jclass byte_array_class = env->FindClass("[B");
+  jobjectArray scanned_events_array = env->NewObjectArray(
+    static_cast<jsize>(results.size()), scanned_events_class, nullptr);
+  for (size_t i = 0; i < results.size(); ++i) {
+    const RunResult& result = results[i];
+    if (!result.status.ok()) {
+      std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+      Set_TF_Status_from_Status(status.get(), result.status);
+      CHECK_STATUS(env, status.get(), nullptr);
+    }
+    size_t num_records = 0;
+    for (const ReservoirBucket& bucket : result.buckets) num_records += bucket.items().size();
+    std::vector<jint> tag_indices;
+    std::vector<jlong> steps;
+    std::vector<jdouble> wall_times;
+    std::vector<jfloat> simple_values;
+    tag_indices.reserve(num_records);
+    steps.reserve(num_records);
+    wall_times.reserve(num_records);
+    simple_values.reserve(num_records);
+    jobjectArray values = env->NewObjectArray(static_cast<jsize>(num_records), byte_array_class, nullptr);
+    jsize record_index = 0;
+    for (size_t tag = 0; tag < result.buckets.size(); ++tag) {
+      for (const ScannedRecord& record : result.buckets[tag].items()) {
+        tag_indices.push_back(static_cast<jint>(tag));
+        steps.push_back(static_cast<jlong>(record.step));
+        wall_times.push_back(static_cast<jdouble>(record.wall_time));
+        simple_values.push_back(static_cast<jfloat>(record.simple_value));
+        if (!record.serialized_value.empty()) {
+          jbyteArray value = env->NewByteArray(static_cast<jsize>(record.serialized_value.size()));
+          env->SetByteArrayRegion(
+            value, 0, static_cast<jsize>(record.serialized_value.size()),
+            reinterpret_cast<const jbyte*>(record.serialized_value.data()));
+          env->SetObjectArrayElement(values, record_index, value);
+          env->DeleteLocalRef(value);
+        }
+        ++record_index;
+      }
+    }
+    jintArray tag_indices_array = env->NewIntArray(static_cast<jsize>(num_records));
+    env->SetIntArrayRegion(tag_indices_array, 0, static_cast<jsize>(num_records), tag_indices.data());
+    jlongArray steps_array = env->NewLongArray(static_cast<jsize>(num_records));
+    env->SetLongArrayRegion(steps_array, 0, static_cast<jsize>(num_records), steps.data());
+    jdoubleArray wall_times_array = env->NewDoubleArray(static_cast<jsize>(num_records));
+    env->SetDoubleArrayRegion(wall_times_array, 0, static_cast<jsize>(num_records), wall_times.data());
+    jfloatArray simple_values_array = env->NewFloatArray(static_cast<jsize>(num_records));
+    env->SetFloatArrayRegion(simple_values_array, 0, static_cast<jsize>(num_records), simple_values.data());
+    jobjectArray tags_array = ToStringArray(env, result.tags);
+    jobjectArray plugins_array = ToStringArray(env, result.plugins);
+    jobject scanned_events = env->CallStaticObjectMethod(
+      scanned_events_class, scanned_events_constructor, tags_array, plugins_array, tag_indices_array, steps_array,
+      wall_times_array, simple_values_array, values);
+    env->SetObjectArrayElement(scanned_events_array, static_cast<jsize>(i), scanned_events);
+    // Many runs may be scanned at once and so we release the local references eagerly.
+    env->DeleteLocalRef(scanned_events);
+    env->DeleteLocalRef(values);
+    env->DeleteLocalRef(simple_values_array);
+    env->DeleteLocalRef(wall_times_array);
+    env->DeleteLocalRef(steps_array);
+    env->DeleteLocalRef(tag_indices_array);
+    env->DeleteLocalRef(plugins_array);
+    env->DeleteLocalRef(tags_array);
+  }
+  return scanned_events_array;
+}
@@ -0,0 +1,21 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class org_platanios_tensorflow_jni_EventScanner__ */
+
+#ifndef _Included_org_platanios_tensorflow_jni_EventScanner__
+#define _Included_org_platanios_tensorflow_jni_EventScanner__
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     org_platanios_tensorflow_jni_EventScanner__
+ * Method:    scan
+ * Signature: ([Ljava/lang/String;[Ljava/lang/String;[Ljava/lang/String;IZI)[Lorg/platanios/tensorflow/jni/ScannedEvents;
+ */
+JNIEXPORT jobjectArray JNICALL Java_org_platanios_tensorflow_jni_EventScanner_00024_scan
+  (JNIEnv *, jobject, jobjectArray, jobjectArray, jobjectArray, jint, jboolean, jint);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,211 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include "events_writer.h"
+#include "utilities.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/c/tf_status_helper.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/events_writer.h"
+
+namespace {
+
+// Wraps an `EventsWriter` so that it can be shared between the JVM threads that submit events and a background thread
+// that periodically flushes the events file. Events are framed (including the CRC32C checksums) by the underlying
+// record writer. Submitted events are only queued in memory while holding `mu_`, and they are written to the events
+// file, which is then flushed, while holding `writer_mu_` instead, so that submitting events never waits for the disk.
+// Errors that occur while flushing in the background are returned by the next call to `Write` or `Flush`.
+class BackgroundFlushingEventsWriter {
+ public:
+  BackgroundFlushingEventsWriter(const std::string& file_prefix, tensorflow::int64 flush_interval_millis)
+      : writer_(file_prefix), flush_interval_millis_(flush_interval_millis) {}
+
+  ~BackgroundFlushingEventsWriter() { Close().IgnoreError(); }
+
+  tensorflow::Status Init(const std::string& file_suffix) {
+    {
+      tensorflow::mutex_lock l(writer_mu_);
+      TF_RETURN_IF_ERROR(writer_.InitWithSuffix(file_suffix));
+    }
+    if (flush_interval_millis_ > 0) {
+      thread_.reset(tensorflow::Env::Default()->StartThread(
+        tensorflow::ThreadOptions(), "events_writer_flush", [this]() { FlushLoop(); }));
+    }
+    return tensorflow::Status::OK();
+  }
+
+  std::string FileName() {
+    tensorflow::mutex_lock l(writer_mu_);
+    return writer_.FileName();
+  }
+
+  // Returns the lock that must be held while calling `WriteLocked`, so that a batch of events can be written while
+  // acquiring the lock only once.
+  tensorflow::mutex* mu() LOCK_RETURNED(mu_) { return &mu_; }
+
+  tensorflow::Status WriteLocked(tensorflow::StringPiece serialized_event) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    TF_RETURN_IF_ERROR(status_);
+    pending_.emplace_back(serialized_event.data(), serialized_event.size());
+    return tensorflow::Status::OK();
+  }
+
+  // Without a background thread, queued events are written to the events file right away (but not flushed), so that
+  // they do not pile up in memory until the next explicit flush.
+  tensorflow::Status MaybeWritePending() LOCKS_EXCLUDED(mu_, writer_mu_) {
+    if (flush_interval_millis_ > 0) return tensorflow::Status::OK();
+    tensorflow::mutex_lock l(writer_mu_);
+    return WritePendingLocked(false);
+  }
+
+  tensorflow::Status Flush() LOCKS_EXCLUDED(mu_, writer_mu_) {
+    tensorflow::mutex_lock l(writer_mu_);
+    return WritePendingLocked(true);
+  }
+
+  tensorflow::Status Close() {
+    {
+      tensorflow::mutex_lock l(mu_);
+      if (closed_) return status_;
+      closed_ = true;
+      cv_.notify_all();
+    }
+    // Destroying the thread object joins the background thread.
+    thread_.reset();
+    tensorflow::mutex_lock writer_lock(writer_mu_);
+    WritePendingLocked(false).IgnoreError();
+    tensorflow::Status s = writer_.Close();
+    tensorflow::mutex_lock l(mu_);
+    status_.Update(s);
+    return status_;
+  }
+
+ private:
+  // Writes the queued events to the events file, and then flushes it if `flush` is true. Holding `writer_mu_` keeps
+  // batches of events in order, while `mu_` is only held to take the queued events.
+  tensorflow::Status WritePendingLocked(bool flush) EXCLUSIVE_LOCKS_REQUIRED(writer_mu_) LOCKS_EXCLUDED(mu_) {
+    std::vector<std::string> events;
+    {
+      tensorflow::mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(status_);
+      events.swap(pending_);
+    }
+    for (const std::string& event : events) writer_.WriteSerializedEvent(event);
+    tensorflow::Status s = flush ? writer_.Flush() : tensorflow::Status::OK();
+    tensorflow::mutex_lock l(mu_);
+    status_.Update(s);
+    return status_;
+  }
+
+  void FlushLoop() {
+    while (true) {
+      {
+        tensorflow::mutex_lock l(mu_);
+        if (!closed_) tensorflow::WaitForMilliseconds(&l, &cv_, flush_interval_millis_);
+        if (closed_) return;
+        if (!status_.ok()) continue;
+      }
+      Flush().IgnoreError();
+    }
+  }
+
+  // Lock order: `writer_mu_` before `mu_`.
+  tensorflow::mutex writer_mu_;
+  tensorflow::EventsWriter writer_ GUARDED_BY(writer_mu_);
+  tensorflow::mutex mu_;
+  tensorflow::condition_variable cv_;
+  std::vector<std::string> pending_ GUARDED_BY(mu_);
+  const tensorflow::int64 flush_interval_millis_;
+  bool closed_ GUARDED_BY(mu_) = false;
+  tensorflow::Status status_ GUARDED_BY(mu_);
+  std::unique_ptr<tensorflow::Thread> thread_;
+};
+
+}  // namespace
+
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_EventsWriter_00024_newEventsWriter(
+    JNIEnv* env, jobject object, jstring file_prefix, jstring file_suffix, jlong flush_interval_millis) {
+  const char* c_file_prefix = env->GetStringUTFChars(file_prefix, nullptr);
+  const char* c_file_suffix = env->GetStringUTFChars(file_suffix, nullptr);
+  std::unique_ptr<BackgroundFlushingEventsWriter> writer(new BackgroundFlushingEventsWriter(
+    std::string(c_file_prefix), static_cast<tensorflow::int64>(flush_interval_millis)));
+  tensorflow::Status s = writer->Init(std::string(c_file_suffix));
+  env->ReleaseStringUTFChars(file_suffix, c_file_suffix);
+  env->ReleaseStringUTFChars(file_prefix, c_file_prefix);
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), 0);
+  }
+  return reinterpret_cast<jlong>(writer.release());
+}
+
+JNIEXPORT jstring JNICALL Java_org_platanios_tensorflow_jni_EventsWriter_00024_fileName(
+    JNIEnv* env, jobject object, jlong writer_handle) {
+  REQUIRE_HANDLE(writer, BackgroundFlushingEventsWriter, writer_handle, nullptr);
+  return env->NewStringUTF(writer->FileName().c_str());
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_EventsWriter_00024_writeSerializedEvents(
+    JNIEnv* env, jobject object, jlong writer_handle, jobjectArray events) {
+  REQUIRE_HANDLE(writer, BackgroundFlushingEventsWriter, writer_handle, void());
+  const int num_events = env->GetArrayLength(events);
+  tensorflow::Status s;
+  {
+    tensorflow::mutex_lock l(*writer->mu());
+    for (int i = 0; i < num_events && s.ok(); ++i) {
+      jbyteArray event = static_cast<jbyteArray>(env->GetObjectArrayElement(events, i));
+      jsize event_length = env->GetArrayLength(event);
+      jbyte* event_bytes = env->GetByteArrayElements(event, nullptr);
+      s = writer->WriteLocked(tensorflow::StringPiece(reinterpret_cast<const char*>(event_bytes), event_length));
+      env->ReleaseByteArrayElements(event, event_bytes, JNI_ABORT);
+      env->DeleteLocalRef(event);
+    }
+  }
+  if (s.ok()) s = writer->MaybeWritePending();
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_EventsWriter_00024_flush(
+    JNIEnv* env, jobject object, jlong writer_handle) {
+  REQUIRE_HANDLE(writer, BackgroundFlushingEventsWriter, writer_handle, void());
+  tensorflow::Status s = writer->Flush();
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_EventsWriter_00024_delete(
+    JNIEnv* env, jobject object, jlong writer_handle) {
+  REQUIRE_HANDLE(writer, BackgroundFlushingEventsWriter, writer_handle, void());
+  tensorflow::Status s = writer->Close();
+  delete writer;
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+}
@@ -0,0 +1,53 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class org_platanios_tensorflow_jni_EventsWriter__ */
+
+#ifndef _Included_org_platanios_tensorflow_jni_EventsWriter__
+#define _Included_org_platanios_tensorflow_jni_EventsWriter__
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     org_platanios_tensorflow_jni_EventsWriter__
+ * Method:    newEventsWriter
+ * Signature: (Ljava/lang/String;Ljava/lang/String;J)J
+ */
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_EventsWriter_00024_newEventsWriter
+  (JNIEnv *, jobject, jstring, jstring, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_EventsWriter__
+ * Method:    fileName
+ * Signature: (J)Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL Java_org_platanios_tensorflow_jni_EventsWriter_00024_fileName
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_EventsWriter__
+ * Method:    writeSerializedEvents
+ * Signature: (J[[B)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_EventsWriter_00024_writeSerializedEvents
+  (JNIEnv *, jobject, jlong, jobjectArray);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_EventsWriter__
+ * Method:    flush
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_EventsWriter_00024_flush
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_EventsWriter__
+ * Method:    delete
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_EventsWriter_00024_delete
+  (JNIEnv *, jobject, jlong);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
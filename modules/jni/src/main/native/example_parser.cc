@@ -0,0 +1,244 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include "example_parser.h"
+#include "utilities.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/c/eager/c_api.h"
+#include "tensorflow/c/eager/c_api_internal.h"
+#include "tensorflow/c/record_reader.h"
+#include "tensorflow/c/tf_status_helper.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/example_proto_fast_parsing.h"
+
+namespace {
+
+// Parses batches of serialized `tf.Example` protos into dense and sparse feature tensors, using the fast example
+// parser (i.e., the same one used by the `ParseExample` op). Parsing of large batches is split across the threads of
+// the parser's thread pool.
+class ExampleParser {
+ public:
+  ExampleParser(tensorflow::example::FastParseExampleConfig config, int num_threads) : config_(std::move(config)) {
+    if (num_threads > 1)
+      thread_pool_.reset(new tensorflow::thread::ThreadPool(
+        tensorflow::Env::Default(), "example_parser", num_threads));
+  }
+
+  // Parses `serialized` and stores the resulting tensors in `outputs`, in the following order: dense values, sparse
+  // indices, sparse values, and sparse shapes.
+  tensorflow::Status Parse(
+      const std::vector<std::string>& serialized, std::vector<tensorflow::Tensor>* outputs) const {
+    tensorflow::example::Result result;
+    TF_RETURN_IF_ERROR(tensorflow::example::FastParseExample(
+      config_, serialized, {}, thread_pool_.get(), &result));
+    outputs->reserve(result.dense_values.size() + 3 * result.sparse_values.size());
+    for (auto& t : result.dense_values) outputs->push_back(std::move(t));
+    for (auto& t : result.sparse_indices) outputs->push_back(std::move(t));
+    for (auto& t : result.sparse_values) outputs->push_back(std::move(t));
+    for (auto& t : result.sparse_shapes) outputs->push_back(std::move(t));
+    return tensorflow::Status::OK();
+  }
+
+ private:
+  const tensorflow::example::FastParseExampleConfig config_;
+  std::unique_ptr<tensorflow::thread::ThreadPool> thread_pool_;
+};
+
+// Returns an error unless `dtype` is supported by the fast example parser, which aborts the process on any other type.
+tensorflow::Status CheckFeatureType(const std::string& feature_name, tensorflow::DataType dtype) {
+  if (dtype == tensorflow::DT_INT64 || dtype == tensorflow::DT_FLOAT || dtype == tensorflow::DT_STRING)
+    return tensorflow::Status::OK();
+  return tensorflow::errors::InvalidArgument(
+    "Feature '", feature_name, "' has unsupported type ", tensorflow::DataTypeString(dtype),
+    ". Only INT64, FLOAT32, and STRING features are supported.");
+}
+
+jlongArray ToTensorHandles(JNIEnv* env, const std::vector<tensorflow::Tensor>& tensors) {
+  std::vector<jlong> handles(tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i)
+    handles[i] = reinterpret_cast<jlong>(TFE_NewTensorHandle(tensors[i]));
+  jlongArray handles_array = env->NewLongArray(static_cast<jsize>(handles.size()));
+  env->SetLongArrayRegion(handles_array, 0, static_cast<jsize>(handles.size()), handles.data());
+  return handles_array;
+}
+
+}  // namespace
+
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_ExampleParser_00024_newExampleParser(
+    JNIEnv* env, jobject object, jobjectArray dense_names, jintArray dense_types, jobjectArray dense_shapes,
+    jlongArray dense_defaults, jobjectArray sparse_names, jintArray sparse_types, jint num_threads) {
+  const int num_dense = env->GetArrayLength(dense_names);
+  const int num_sparse = env->GetArrayLength(sparse_names);
+  if (env->GetArrayLength(dense_types) != num_dense || env->GetArrayLength(dense_shapes) != num_dense ||
+      env->GetArrayLength(dense_defaults) != num_dense || env->GetArrayLength(sparse_types) != num_sparse) {
+    throw_exception(env, tf_invalid_argument_exception, "All feature specification arrays must have matching lengths.");
+    return 0;
+  }
+  std::unique_ptr<TFE_TensorHandle*[]> defaults(new TFE_TensorHandle*[num_dense]);
+  jlong* dense_defaults_elements = env->GetLongArrayElements(dense_defaults, nullptr);
+  for (int i = 0; i < num_dense; ++i)
+    defaults[i] = reinterpret_cast<TFE_TensorHandle*>(dense_defaults_elements[i]);
+  env->ReleaseLongArrayElements(dense_defaults, dense_defaults_elements, JNI_ABORT);
+
+  tensorflow::example::FastParseExampleConfig config;
+  tensorflow::Status s;
+  jint* dense_types_elements = env->GetIntArrayElements(dense_types, nullptr);
+  for (int i = 0; i < num_dense && s.ok(); ++i) {
+    tensorflow::example::FastParseExampleConfig::Dense dense;
+    jstring name = static_cast<jstring>(env->GetObjectArrayElement(dense_names, i));
+    const char* c_name = env->GetStringUTFChars(name, nullptr);
+    dense.feature_name = std::string(c_name);
+    env->ReleaseStringUTFChars(name, c_name);
+    env->DeleteLocalRef(name);
+    dense.dtype = static_cast<tensorflow::DataType>(dense_types_elements[i]);
+    s = CheckFeatureType(dense.feature_name, dense.dtype);
+    if (!s.ok()) break;
+    jlongArray shape = static_cast<jlongArray>(env->GetObjectArrayElement(dense_shapes, i));
+    const int rank = env->GetArrayLength(shape);
+    std::vector<tensorflow::int64> dims(rank);
+    env->GetLongArrayRegion(shape, 0, rank, reinterpret_cast<jlong*>(dims.data()));
+    env->DeleteLocalRef(shape);
+    s = tensorflow::PartialTensorShape::MakePartialShape(dims.data(), rank, &dense.shape);
+    if (!s.ok()) break;
+    // Same as in the `ParseExample` op, an unknown first dimension denotes a variable-length feature, which is padded
+    // to the longest length in the batch.
+    dense.variable_length = rank > 0 && dims[0] == -1;
+    dense.elements_per_stride = 1;
+    for (int d = dense.variable_length ? 1 : 0; d < rank; ++d) {
+      if (dims[d] < 0) {
+        s = tensorflow::errors::InvalidArgument(
+          "Only the first dimension of dense feature '", dense.feature_name, "' may be unknown.");
+        break;
+      }
+      dense.elements_per_stride *= static_cast<std::size_t>(dims[d]);
+    }
+    if (!s.ok()) break;
+    if (defaults[i] != nullptr) {
+      const tensorflow::Tensor* default_value;
+      s = defaults[i]->handle->Tensor(&default_value);
+      if (!s.ok()) break;
+      dense.default_value = *default_value;
+    } else {
+      // An empty default value denotes a required feature.
+      dense.default_value = tensorflow::Tensor(dense.dtype, tensorflow::TensorShape({0}));
+    }
+    // The fast parser copies the default values without checking them, and so they are validated here in the same way
+    // as in the `ParseExample` op.
+    const tensorflow::int64 num_default_elements = dense.default_value.NumElements();
+    if (dense.default_value.dtype() != dense.dtype) {
+      s = tensorflow::errors::InvalidArgument(
+        "The default value of dense feature '", dense.feature_name, "' has type ",
+        tensorflow::DataTypeString(dense.default_value.dtype()), ", but the feature has type ",
+        tensorflow::DataTypeString(dense.dtype), ".");
+    } else if (dense.variable_length && num_default_elements != 1) {
+      s = tensorflow::errors::InvalidArgument(
+        "Dense feature '", dense.feature_name, "' has variable length and so its default value must be a scalar, ",
+        "which is used for padding, but it has ", num_default_elements, " elements.");
+    } else if (!dense.variable_length && num_default_elements != 0 &&
+               num_default_elements != static_cast<tensorflow::int64>(dense.elements_per_stride)) {
+      s = tensorflow::errors::InvalidArgument(
+        "The default value of dense feature '", dense.feature_name, "' has ", num_default_elements,
+        " elements, but the feature has ", dense.elements_per_stride, " elements.");
+    }
+    if (!s.ok()) break;
+    config.dense.push_back(std::move(dense));
+  }
+  env->ReleaseIntArrayElements(dense_types, dense_types_elements, JNI_ABORT);
+  jint* sparse_types_elements = env->GetIntArrayElements(sparse_types, nullptr);
+  for (int i = 0; i < num_sparse && s.ok(); ++i) {
+    tensorflow::example::FastParseExampleConfig::Sparse sparse;
+    jstring name = static_cast<jstring>(env->GetObjectArrayElement(sparse_names, i));
+    const char* c_name = env->GetStringUTFChars(name, nullptr);
+    sparse.feature_name = std::string(c_name);
+    env->ReleaseStringUTFChars(name, c_name);
+    env->DeleteLocalRef(name);
+    sparse.dtype = static_cast<tensorflow::DataType>(sparse_types_elements[i]);
+    s = CheckFeatureType(sparse.feature_name, sparse.dtype);
+    if (!s.ok()) break;
+    config.sparse.push_back(std::move(sparse));
+  }
+  env->ReleaseIntArrayElements(sparse_types, sparse_types_elements, JNI_ABORT);
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), 0);
+  }
+  return reinterpret_cast<jlong>(new ExampleParser(std::move(config), static_cast<int>(num_threads)));
+}
+
+JNIEXPORT jlongArray JNICALL Java_org_platanios_tensorflow_jni_ExampleParser_00024_parseRecords(
+    JNIEnv* env, jobject object, jlong parser_handle, jlong reader_handle, jint batch_size) {
+  REQUIRE_HANDLE(parser, ExampleParser, parser_handle, nullptr);
+  REQUIRE_HANDLE(reader, tensorflow::io::RecordReaderWrapper, reader_handle, nullptr);
+  if (batch_size <= 0) {
+    throw_exception(env, tf_invalid_argument_exception, "The batch size must be positive, but it was %d.", batch_size);
+    return nullptr;
+  }
+  std::vector<std::string> serialized;
+  serialized.reserve(batch_size);
+  std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+  while (serialized.size() < static_cast<size_t>(batch_size)) {
+    reader->GetNext(status.get());
+    // Truncated records at the end of the file are treated as the end of the file, same as in the Scala readers.
+    if (TF_GetCode(status.get()) == TF_OUT_OF_RANGE || TF_GetCode(status.get()) == TF_DATA_LOSS) break;
+    CHECK_STATUS(env, status.get(), nullptr);
+    serialized.push_back(reader->record());
+  }
+  if (serialized.empty()) return nullptr;
+  std::vector<tensorflow::Tensor> outputs;
+  tensorflow::Status s = parser->Parse(serialized, &outputs);
+  if (!s.ok()) {
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), nullptr);
+  }
+  return ToTensorHandles(env, outputs);
+}
+
+JNIEXPORT jlongArray JNICALL Java_org_platanios_tensorflow_jni_ExampleParser_00024_parseSerialized(
+    JNIEnv* env, jobject object, jlong parser_handle, jobjectArray records) {
+  REQUIRE_HANDLE(parser, ExampleParser, parser_handle, nullptr);
+  const int num_records = env->GetArrayLength(records);
+  std::vector<std::string> serialized(num_records);
+  for (int i = 0; i < num_records; ++i) {
+    jbyteArray record = static_cast<jbyteArray>(env->GetObjectArrayElement(records, i));
+    serialized[i].resize(env->GetArrayLength(record));
+    env->GetByteArrayRegion(
+      record, 0, static_cast<jsize>(serialized[i].size()), reinterpret_cast<jbyte*>(&serialized[i][0]));
+    env->DeleteLocalRef(record);
+  }
+  std::vector<tensorflow::Tensor> outputs;
+  tensorflow::Status s = parser->Parse(serialized, &outputs);
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), nullptr);
+  }
+  return ToTensorHandles(env, outputs);
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_ExampleParser_00024_delete(
+    JNIEnv* env, jobject object, jlong parser_handle) {
+  REQUIRE_HANDLE(parser, ExampleParser, parser_handle, void());
+  delete parser;
+}
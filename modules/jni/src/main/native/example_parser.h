@@ -0,0 +1,45 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class org_platanios_tensorflow_jni_ExampleParser__ */
+
+#ifndef _Included_org_platanios_tensorflow_jni_ExampleParser__
+#define _Included_org_platanios_tensorflow_jni_ExampleParser__
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     org_platanios_tensorflow_jni_ExampleParser__
+ * Method:    newExampleParser
+ * Signature: ([Ljava/lang/String;[I[[J[J[Ljava/lang/String;[II)J
+ */
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_ExampleParser_00024_newExampleParser
+  (JNIEnv *, jobject, jobjectArray, jintArray, jobjectArray, jlongArray, jobjectArray, jintArray, jint);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_ExampleParser__
+ * Method:    parseRecords
+ * Signature: (JJI)[J
+ */
+JNIEXPORT jlongArray JNICALL Java_org_platanios_tensorflow_jni_ExampleParser_00024_parseRecords
+  (JNIEnv *, jobject, jlong, jlong, jint);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_ExampleParser__
+ * Method:    parseSerialized
+ * Signature: (J[[B)[J
+ */
+JNIEXPORT jlongArray JNICALL Java_org_platanios_tensorflow_jni_ExampleParser_00024_parseSerialized
+  (JNIEnv *, jobject, jlong, jobjectArray);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_ExampleParser__
+ * Method:    delete
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_ExampleParser_00024_delete
+  (JNIEnv *, jobject, jlong);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -18,12 +18,68 @@
 
 #include <string.h>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 #include "tensorflow/c/tf_status_helper.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/platform/env.h"
 
+namespace {
+// Reads lines from the byte range `[start, end)` of a file. A line belongs to the range if its first byte lies in the
+// range, meaning that a line straddling `start` is skipped (it belongs to the previous range) and a line straddling
+// `end` is read in full. This allows multiple readers to process disjoint ranges of the same file in parallel, with
+// each line being read exactly once.
+struct LineRangeReader {
+  LineRangeReader(tensorflow::io::BufferedInputStream* stream, tensorflow::int64 end)
+      : stream(stream), end(end) {}
+
+  std::unique_ptr<tensorflow::io::BufferedInputStream> stream;
+  tensorflow::int64 end;
+};
+
+// Buffered input stream that can also read straight from its underlying file into caller-provided memory, bypassing
+// its own buffer. This is used for large reads into direct byte buffers, which would otherwise be copied twice.
+class FileBufferedInputStream : public tensorflow::io::BufferedInputStream {
+ public:
+  // Takes ownership of `file`.
+  FileBufferedInputStream(tensorflow::RandomAccessFile* file, size_t buffer_size)
+      : FileBufferedInputStream(
+          file, new tensorflow::io::RandomAccessInputStream(file, true /* owns_file */), buffer_size) {}
+
+  size_t buffer_size() const { return buffer_size_; }
+
+  // Reads up to `bytes_to_read` bytes into `data` and stores the number of bytes read in `bytes_read`. Returns an
+  // `OUT_OF_RANGE` error if fewer bytes were read because the end of the file was reached.
+  tensorflow::Status ReadDirect(tensorflow::int64 bytes_to_read, char* data, size_t* bytes_read) {
+    const tensorflow::int64 position = Tell();
+    tensorflow::StringPiece result;
+    tensorflow::Status s = file_->Read(
+      static_cast<tensorflow::uint64>(position), static_cast<size_t>(bytes_to_read), &result, data);
+    if (!s.ok() && s.code() != tensorflow::error::OUT_OF_RANGE) return s;
+    // Some file systems return views into their own memory instead of filling in the scratch space.
+    if (result.data() != data) memmove(data, result.data(), result.size());
+    *bytes_read = result.size();
+    // Any buffered data now lies behind the read position, and so the buffer is dropped and the underlying stream is
+    // moved past the bytes that were read, without reading anything.
+    TF_RETURN_IF_ERROR(Reset());
+    TF_RETURN_IF_ERROR(input_stream_->Seek(position + static_cast<tensorflow::int64>(result.size())));
+    return s;
+  }
+
+ private:
+  FileBufferedInputStream(
+      tensorflow::RandomAccessFile* file, tensorflow::io::RandomAccessInputStream* input_stream, size_t buffer_size)
+      : BufferedInputStream(input_stream, buffer_size, true /* owns_input_stream */),
+        file_(file), input_stream_(input_stream), buffer_size_(buffer_size) {}
+
+  tensorflow::RandomAccessFile* file_;                     // Owned by `input_stream_`.
+  tensorflow::io::RandomAccessInputStream* input_stream_;  // Owned by the base class.
+  const size_t buffer_size_;
+};
+}  // namespace
+
 JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_fileExists(
     JNIEnv* env, jobject object, jstring filename) {
   const char* c_filename = env->GetStringUTFChars(filename, nullptr);
@@ -63,6 +119,24 @@ JNIEXPORT jstring JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readFil
   return env->NewStringUTF(file_content.c_str());
 }
 
+JNIEXPORT jbyteArray JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readFileToBytes(
+    JNIEnv* env, jobject object, jstring filename) {
+  const char* c_filename = env->GetStringUTFChars(filename, nullptr);
+  std::string file_content;
+  tensorflow::Status s = tensorflow::ReadFileToString(
+    tensorflow::Env::Default(), std::string(c_filename), &file_content);
+  env->ReleaseStringUTFChars(filename, c_filename);
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), nullptr);
+  }
+  jbyteArray content = env->NewByteArray(static_cast<jsize>(file_content.size()));
+  env->SetByteArrayRegion(
+    content, 0, static_cast<jsize>(file_content.size()), reinterpret_cast<const jbyte*>(file_content.data()));
+  return content;
+}
+
 JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_writeStringToFile(
     JNIEnv* env, jobject object, jstring filename, jstring content) {
   const char* c_filename = env->GetStringUTFChars(filename, nullptr);
@@ -261,12 +335,11 @@ JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_newBuffer
     Set_TF_Status_from_Status(status.get(), s);
     CHECK_STATUS(env, status.get(), 0);
   }
-  std::unique_ptr<tensorflow::io::RandomAccessInputStream> input_stream(
-    new tensorflow::io::RandomAccessInputStream(file.release(), true /* owns_file */));
-  std::unique_ptr<tensorflow::io::BufferedInputStream> buffered_input_stream(
-    new tensorflow::io::BufferedInputStream(input_stream.release(), static_cast<size_t>(buffer_size),
-    true /* owns_input_stream */));
-  return reinterpret_cast<jlong>(buffered_input_stream.release());
+  // All functions below access the stream through a `BufferedInputStream` pointer, except for the direct byte buffer
+  // reads, and so the handle must point to that base class.
+  tensorflow::io::BufferedInputStream* buffered_input_stream =
+    new FileBufferedInputStream(file.release(), static_cast<size_t>(buffer_size));
+  return reinterpret_cast<jlong>(buffered_input_stream);
 }
 
 JNIEXPORT jstring JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readFromBufferedInputStream(
@@ -288,6 +361,74 @@ JNIEXPORT jstring JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readLin
   return env->NewStringUTF(buffered_input_stream->ReadLineAsString().c_str());
 }
 
+JNIEXPORT jint JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readFromBufferedInputStreamToArray(
+    JNIEnv* env, jobject object, jlong buffered_input_stream_handle, jbyteArray array, jint offset, jint num_bytes) {
+  REQUIRE_HANDLE(buffered_input_stream, tensorflow::io::BufferedInputStream, buffered_input_stream_handle, 0);
+  if (offset < 0 || num_bytes < 0 || offset > env->GetArrayLength(array) - num_bytes) {
+    throw_exception(
+      env, tf_invalid_argument_exception, "Invalid array region [%d, %d) for an array of length %d.",
+      offset, offset + num_bytes, env->GetArrayLength(array));
+    return 0;
+  }
+  std::string result;
+  tensorflow::Status s = buffered_input_stream->ReadNBytes(static_cast<tensorflow::int64>(num_bytes), &result);
+  if (!s.ok() && s.code() != tensorflow::error::OUT_OF_RANGE) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), 0);
+  }
+  env->SetByteArrayRegion(
+    array, offset, static_cast<jsize>(result.size()), reinterpret_cast<const jbyte*>(result.data()));
+  return static_cast<jint>(result.size());
+}
+
+JNIEXPORT jint JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readFromBufferedInputStreamToBuffer(
+    JNIEnv* env, jobject object, jlong buffered_input_stream_handle, jobject buffer, jint offset, jint num_bytes) {
+  REQUIRE_HANDLE(buffered_input_stream, tensorflow::io::BufferedInputStream, buffered_input_stream_handle, 0);
+  char* buffer_data = reinterpret_cast<char*>(env->GetDirectBufferAddress(buffer));
+  if (buffer_data == nullptr) {
+    throw_exception(env, tf_invalid_argument_exception, "The provided buffer must be a direct byte buffer.");
+    return 0;
+  }
+  jlong buffer_capacity = env->GetDirectBufferCapacity(buffer);
+  if (offset < 0 || num_bytes < 0 || offset > buffer_capacity - num_bytes) {
+    throw_exception(
+      env, tf_invalid_argument_exception, "Invalid buffer region [%d, %d) for a buffer with capacity %lld.",
+      offset, offset + num_bytes, static_cast<long long>(buffer_capacity));
+    return 0;
+  }
+  FileBufferedInputStream* stream = static_cast<FileBufferedInputStream*>(buffered_input_stream);
+  size_t bytes_read;
+  tensorflow::Status s;
+  if (static_cast<size_t>(num_bytes) >= stream->buffer_size()) {
+    // Reads that fill at least a whole stream buffer go straight from the file into the direct buffer.
+    s = stream->ReadDirect(static_cast<tensorflow::int64>(num_bytes), buffer_data + offset, &bytes_read);
+  } else {
+    // Smaller reads go through the stream buffer, which saves a file system read per call, at the cost of copying at
+    // most one stream buffer worth of data.
+    std::string result;
+    s = stream->ReadNBytes(static_cast<tensorflow::int64>(num_bytes), &result);
+    memcpy(buffer_data + offset, result.data(), result.size());
+    bytes_read = result.size();
+  }
+  if (!s.ok() && s.code() != tensorflow::error::OUT_OF_RANGE) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), 0);
+  }
+  return static_cast<jint>(bytes_read);
+}
+
+JNIEXPORT jbyteArray JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readLineAsBytesFromBufferedInputStream(
+    JNIEnv* env, jobject object, jlong buffered_input_stream_handle) {
+  REQUIRE_HANDLE(buffered_input_stream, tensorflow::io::BufferedInputStream, buffered_input_stream_handle, nullptr);
+  std::string line = buffered_input_stream->ReadLineAsString();
+  if (line.empty()) return nullptr;
+  jbyteArray result = env->NewByteArray(static_cast<jsize>(line.size()));
+  env->SetByteArrayRegion(result, 0, static_cast<jsize>(line.size()), reinterpret_cast<const jbyte*>(line.data()));
+  return result;
+}
+
 JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_tellBufferedInputStream(
     JNIEnv* env, jobject object, jlong buffered_input_stream_handle) {
   REQUIRE_HANDLE(buffered_input_stream, tensorflow::io::BufferedInputStream, buffered_input_stream_handle, 0);
@@ -311,6 +452,82 @@ JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_deleteBuff
   delete buffered_input_stream;
 }
 
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_newLineRangeReader(
+    JNIEnv* env, jobject object, jstring filename, jlong start, jlong end, jlong buffer_size) {
+  const char* c_filename = env->GetStringUTFChars(filename, nullptr);
+  std::unique_ptr<tensorflow::RandomAccessFile> file;
+  tensorflow::Status s = tensorflow::Env::Default()->NewRandomAccessFile(std::string(c_filename), &file);
+  env->ReleaseStringUTFChars(filename, c_filename);
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), 0);
+  }
+  std::unique_ptr<tensorflow::io::RandomAccessInputStream> input_stream(
+    new tensorflow::io::RandomAccessInputStream(file.release(), true /* owns_file */));
+  std::unique_ptr<LineRangeReader> reader(new LineRangeReader(
+    new tensorflow::io::BufferedInputStream(
+      input_stream.release(), static_cast<size_t>(buffer_size), true /* owns_input_stream */),
+    static_cast<tensorflow::int64>(end)));
+  if (start > 0) {
+    // Skip the remainder of the line that contains the byte right before the range start. If that byte is a new-line
+    // character, this only consumes that byte and the reader ends up exactly at the range start.
+    s = reader->stream->Seek(static_cast<tensorflow::int64>(start - 1));
+    if (s.ok()) {
+      std::string skipped;
+      s = reader->stream->ReadLine(&skipped);
+    }
+    if (!s.ok() && s.code() != tensorflow::error::OUT_OF_RANGE) {
+      std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+      Set_TF_Status_from_Status(status.get(), s);
+      CHECK_STATUS(env, status.get(), 0);
+    }
+  }
+  return reinterpret_cast<jlong>(reader.release());
+}
+
+JNIEXPORT jobject JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readLineBatch(
+    JNIEnv* env, jobject object, jlong reader_handle, jint max_lines, jint max_bytes) {
+  REQUIRE_HANDLE(reader, LineRangeReader, reader_handle, nullptr);
+  if (max_lines <= 0 || max_bytes <= 0) {
+    throw_exception(
+      env, tf_invalid_argument_exception,
+      "The maximum number of lines (%d) and bytes (%d) of a line batch must be positive.", max_lines, max_bytes);
+    return nullptr;
+  }
+  std::string data;
+  std::vector<jint> offsets {0};
+  std::string line;
+  tensorflow::Status s;
+  while (offsets.size() <= static_cast<size_t>(max_lines) && data.size() < static_cast<size_t>(max_bytes)) {
+    if (reader->end >= 0 && reader->stream->Tell() >= reader->end) break;
+    s = reader->stream->ReadLine(&line);
+    if (!s.ok()) break;
+    data.append(line);
+    offsets.push_back(static_cast<jint>(data.size()));
+  }
+  if (!s.ok() && s.code() != tensorflow::error::OUT_OF_RANGE) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), nullptr);
+  }
+  if (offsets.size() == 1) return nullptr;
+  jbyteArray data_array = env->NewByteArray(static_cast<jsize>(data.size()));
+  env->SetByteArrayRegion(data_array, 0, static_cast<jsize>(data.size()), reinterpret_cast<const jbyte*>(data.data()));
+  jintArray offsets_array = env->NewIntArray(static_cast<jsize>(offsets.size()));
+  env->SetIntArrayRegion(offsets_array, 0, static_cast<jsize>(offsets.size()), offsets.data());
+  jclass line_batch_class = env->FindClass("org/platanios/tensorflow/jni/LineBatch");
+  jmethodID line_batch_constructor = env->GetStaticMethodID(
+      line_batch_class, "apply", "([B[I)Lorg/platanios/tensorflow/jni/LineBatch;");
+  return env->CallStaticObjectMethod(line_batch_class, line_batch_constructor, data_array, offsets_array);
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_deleteLineRangeReader(
+    JNIEnv* env, jobject object, jlong reader_handle) {
+  REQUIRE_HANDLE(reader, LineRangeReader, reader_handle, void());
+  delete reader;
+}
+
 JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_newWritableFile(
     JNIEnv* env, jobject object, jstring filename, jstring mode) {
   const char* c_filename = env->GetStringUTFChars(filename, nullptr);
@@ -367,3 +584,44 @@ JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_deleteWrit
   }
   delete file;
 }
+
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_newReadOnlyMemoryRegion(
+    JNIEnv* env, jobject object, jstring filename) {
+  const char* c_filename = env->GetStringUTFChars(filename, nullptr);
+  std::unique_ptr<tensorflow::ReadOnlyMemoryRegion> region;
+  tensorflow::Status s = tensorflow::Env::Default()->NewReadOnlyMemoryRegionFromFile(std::string(c_filename), &region);
+  env->ReleaseStringUTFChars(filename, c_filename);
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), 0);
+  }
+  return reinterpret_cast<jlong>(region.release());
+}
+
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readOnlyMemoryRegionLength(
+    JNIEnv* env, jobject object, jlong region_handle) {
+  REQUIRE_HANDLE(region, tensorflow::ReadOnlyMemoryRegion, region_handle, 0);
+  return static_cast<jlong>(region->length());
+}
+
+JNIEXPORT jobject JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readOnlyMemoryRegionBuffer(
+    JNIEnv* env, jobject object, jlong region_handle, jlong offset, jint length) {
+  REQUIRE_HANDLE(region, tensorflow::ReadOnlyMemoryRegion, region_handle, nullptr);
+  jlong region_length = static_cast<jlong>(region->length());
+  if (offset < 0 || length < 0 || offset > region_length - length) {
+    throw_exception(
+      env, tf_invalid_argument_exception, "Invalid region [%lld, %lld) for a memory region of length %lld.",
+      static_cast<long long>(offset), static_cast<long long>(offset + length), static_cast<long long>(region_length));
+    return nullptr;
+  }
+  // The returned buffer points directly to the mapped memory and so it must not be used after the region is deleted.
+  char* data = const_cast<char*>(reinterpret_cast<const char*>(region->data()));
+  return env->NewDirectByteBuffer(data + offset, static_cast<jlong>(length));
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_deleteReadOnlyMemoryRegion(
+    JNIEnv* env, jobject object, jlong region_handle) {
+  REQUIRE_HANDLE(region, tensorflow::ReadOnlyMemoryRegion, region_handle, void());
+  delete region;
+}
@@ -31,6 +31,14 @@ JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_deleteFile
 JNIEXPORT jstring JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readFileToString
   (JNIEnv *, jobject, jstring);
 
+/*
+ * Class:     org_platanios_tensorflow_jni_FileIO__
+ * Method:    readFileToBytes
+ * Signature: (Ljava/lang/String;)[B
+ */
+JNIEXPORT jbyteArray JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readFileToBytes
+  (JNIEnv *, jobject, jstring);
+
 /*
  * Class:     org_platanios_tensorflow_jni_FileIO__
  * Method:    writeStringToFile
@@ -135,6 +143,30 @@ JNIEXPORT jstring JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readFro
 JNIEXPORT jstring JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readLineAsStringFromBufferedInputStream
   (JNIEnv *, jobject, jlong);
 
+/*
+ * Class:     org_platanios_tensorflow_jni_FileIO__
+ * Method:    readFromBufferedInputStreamToArray
+ * Signature: (J[BII)I
+ */
+JNIEXPORT jint JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readFromBufferedInputStreamToArray
+  (JNIEnv *, jobject, jlong, jbyteArray, jint, jint);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_FileIO__
+ * Method:    readFromBufferedInputStreamToBuffer
+ * Signature: (JLjava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readFromBufferedInputStreamToBuffer
+  (JNIEnv *, jobject, jlong, jobject, jint, jint);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_FileIO__
+ * Method:    readLineAsBytesFromBufferedInputStream
+ * Signature: (J)[B
+ */
+JNIEXPORT jbyteArray JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readLineAsBytesFromBufferedInputStream
+  (JNIEnv *, jobject, jlong);
+
 /*
  * Class:     org_platanios_tensorflow_jni_FileIO__
  * Method:    tellBufferedInputStream
@@ -159,6 +191,30 @@ JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_seekBuffer
 JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_deleteBufferedInputStream
   (JNIEnv *, jobject, jlong);
 
+/*
+ * Class:     org_platanios_tensorflow_jni_FileIO__
+ * Method:    newLineRangeReader
+ * Signature: (Ljava/lang/String;JJJ)J
+ */
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_newLineRangeReader
+  (JNIEnv *, jobject, jstring, jlong, jlong, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_FileIO__
+ * Method:    readLineBatch
+ * Signature: (JII)Lorg/platanios/tensorflow/jni/LineBatch;
+ */
+JNIEXPORT jobject JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readLineBatch
+  (JNIEnv *, jobject, jlong, jint, jint);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_FileIO__
+ * Method:    deleteLineRangeReader
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_deleteLineRangeReader
+  (JNIEnv *, jobject, jlong);
+
 /*
  * Class:     org_platanios_tensorflow_jni_FileIO__
  * Method:    newWritableFile
@@ -191,6 +247,38 @@ JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_flushWrita
 JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_deleteWritableFile
   (JNIEnv *, jobject, jlong);
 
+/*
+ * Class:     org_platanios_tensorflow_jni_FileIO__
+ * Method:    newReadOnlyMemoryRegion
+ * Signature: (Ljava/lang/String;)J
+ */
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_newReadOnlyMemoryRegion
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_FileIO__
+ * Method:    readOnlyMemoryRegionLength
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readOnlyMemoryRegionLength
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_FileIO__
+ * Method:    readOnlyMemoryRegionBuffer
+ * Signature: (JJI)Ljava/nio/ByteBuffer;
+ */
+JNIEXPORT jobject JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_readOnlyMemoryRegionBuffer
+  (JNIEnv *, jobject, jlong, jlong, jint);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_FileIO__
+ * Method:    deleteReadOnlyMemoryRegion
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_FileIO_00024_deleteReadOnlyMemoryRegion
+  (JNIEnv *, jobject, jlong);
+
 #ifdef __cplusplus
 }
 #endif
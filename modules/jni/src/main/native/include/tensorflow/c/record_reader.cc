@@ -16,8 +16,12 @@ limitations under the License.
 #include "tensorflow/c/record_reader.h"
 
 #include "tensorflow/c/tf_status_helper.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/raw_coding.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/snappy/snappy_inputbuffer.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/types.h"
@@ -28,7 +32,9 @@ class RandomAccessFile;
 
 namespace io {
 
-RecordReaderWrapper::RecordReaderWrapper() {}
+RecordReaderWrapper::RecordReaderWrapper()
+    : offset_(0), file_(nullptr), reader_(nullptr), snappy_input_(nullptr),
+      snappy_input_stale_(false), stale_truncated_(false), stale_file_size_(0) {}
 
 RecordReaderWrapper* RecordReaderWrapper::New(const string& filename, uint64 start_offset,
                                               const string& compression_type_string,
@@ -40,9 +46,20 @@ RecordReaderWrapper* RecordReaderWrapper::New(const string& filename, uint64 sta
     return nullptr;
   }
   RecordReaderWrapper* reader = new RecordReaderWrapper;
+  reader->filename_ = filename;
   reader->offset_ = start_offset;
   reader->file_ = file.release();
 
+  if (compression_type_string == "SNAPPY") {
+    s = reader->ResetSnappyInput();
+    if (!s.ok()) {
+      Set_TF_Status_from_Status(out_status, s);
+      delete reader;
+      return nullptr;
+    }
+    return reader;
+  }
+
   RecordReaderOptions options =
       RecordReaderOptions::CreateRecordReaderOptions(compression_type_string);
 
@@ -52,24 +69,92 @@ RecordReaderWrapper* RecordReaderWrapper::New(const string& filename, uint64 sta
 
 RecordReaderWrapper::~RecordReaderWrapper() {
   delete reader_;
+  delete snappy_input_;
   delete file_;
 }
 
 void RecordReaderWrapper::GetNext(TF_Status* status) {
-  if (reader_ == nullptr) {
+  if (reader_ == nullptr && snappy_input_ == nullptr) {
     Set_TF_Status_from_Status(status,
                               errors::FailedPrecondition("Reader is closed."));
     return;
   }
-  Status s = reader_->ReadRecord(&offset_, &record_);
+  Status s = snappy_input_ != nullptr ? ReadSnappyRecord() : reader_->ReadRecord(&offset_, &record_);
   Set_TF_Status_from_Status(status, s);
 }
 
+Status RecordReaderWrapper::ReadSnappyRecord() {
+  if (snappy_input_stale_ && stale_truncated_) {
+    // Recreating the input buffer requires decompressing the file up to the current offset again, and so that is
+    // avoided while a file that ended early has not grown since the failed read (e.g., when polling a file that is
+    // being written). Other failures, such as corrupted records, are reported again by reading the file again.
+    uint64 file_size;
+    if (Env::Default()->GetFileSize(filename_, &file_size).ok() && file_size == stale_file_size_)
+      return stale_status_;
+  }
+  bool truncated = false;
+  Status s = snappy_input_stale_ ? ResetSnappyInput() : Status::OK();
+  if (!s.ok()) {
+    truncated = errors::IsOutOfRange(s);
+  } else {
+    s = ReadSnappyRecordFromInput(&truncated);
+  }
+  if (!s.ok()) {
+    snappy_input_stale_ = true;
+    stale_truncated_ = truncated;
+    stale_status_ = s;
+    if (!Env::Default()->GetFileSize(filename_, &stale_file_size_).ok()) stale_file_size_ = kuint64max;
+  }
+  return s;
+}
+
+Status RecordReaderWrapper::ResetSnappyInput() {
+  delete snappy_input_;
+  // Incompressible blocks can end up slightly larger than their uncompressed size once compressed, and so the input
+  // buffer is made large enough to hold any such block.
+  snappy_input_ = new SnappyInputBuffer(file_, 2 * kSnappyRecordBlockBytes, kSnappyRecordBlockBytes);
+  snappy_input_stale_ = true;
+  if (offset_ > 0) TF_RETURN_IF_ERROR(snappy_input_->SkipNBytes(static_cast<int64>(offset_)));
+  snappy_input_stale_ = false;
+  return Status::OK();
+}
+
+Status RecordReaderWrapper::ReadSnappyRecordFromInput(bool* truncated) {
+  // Format of a single record:
+  //  uint64    length
+  //  uint32    masked crc of length
+  //  byte      data[length]
+  //  uint32    masked crc of data
+  string header;
+  Status s = snappy_input_->ReadNBytes(sizeof(uint64) + sizeof(uint32), &header);
+  *truncated = errors::IsOutOfRange(s);
+  if (*truncated && !header.empty())
+    return errors::DataLoss("Truncated record at offset ", offset_);
+  TF_RETURN_IF_ERROR(s);
+  if (crc32c::Unmask(core::DecodeFixed32(header.data() + sizeof(uint64))) !=
+      crc32c::Value(header.data(), sizeof(uint64)))
+    return errors::DataLoss("Corrupted record at offset ", offset_);
+  const uint64 length = core::DecodeFixed64(header.data());
+  s = snappy_input_->ReadNBytes(static_cast<int64>(length + sizeof(uint32)), &record_);
+  *truncated = errors::IsOutOfRange(s);
+  if (*truncated)
+    return errors::DataLoss("Truncated record at offset ", offset_);
+  TF_RETURN_IF_ERROR(s);
+  const uint32 masked_crc = core::DecodeFixed32(record_.data() + length);
+  record_.resize(length);
+  if (crc32c::Unmask(masked_crc) != crc32c::Value(record_.data(), length))
+    return errors::DataLoss("Corrupted record at offset ", offset_);
+  offset_ += sizeof(uint64) + sizeof(uint32) + length + sizeof(uint32);
+  return Status::OK();
+}
+
 void RecordReaderWrapper::Close() {
   delete reader_;
+  delete snappy_input_;
   delete file_;
   file_ = nullptr;
   reader_ = nullptr;
+  snappy_input_ = nullptr;
 }
 
 }  // namespace io
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_LIB_IO_RECORD_READER_WRAPPER_H_
 
 #include "tensorflow/c/c_api.h"
+#include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
@@ -28,10 +29,25 @@ class RandomAccessFile;
 namespace io {
 
 class RecordReader;
+class SnappyInputBuffer;
+
+// Maximum uncompressed size of the snappy blocks in snappy-compressed record
+// files. Writers must split their output into blocks of at most this size so
+// that readers can decompress each block into a buffer of the same size.
+constexpr size_t kSnappyRecordBlockBytes = 256 << 10;
 
 // A wrapper around io::RecordReader that is more easily used from within
 // Scala. An instance of this class is not safe for concurrent access
 // by multiple threads.
+//
+// In addition to the compression types supported by io::RecordReader, this
+// wrapper also supports "SNAPPY", in which case the whole file is expected to
+// be a stream of snappy blocks (as written by io::SnappyOutputBuffer) and
+// offsets refer to positions in the uncompressed stream.
+//
+// In both cases, the offset is not advanced when reading a record fails, and
+// so a record that was truncated (e.g., because it is still being written) can
+// be read by retrying once the rest of it has been written.
 class RecordReaderWrapper {
  public:
   // TODO(vrv): make this take a shared proto to configure
@@ -60,9 +76,30 @@ class RecordReaderWrapper {
  private:
   RecordReaderWrapper();
 
+  // Reads the next record from `snappy_input_`, recreating it first if a
+  // previous read failed.
+  Status ReadSnappyRecord();
+
+  // Reads the next record from `snappy_input_`. The snappy input buffer cannot
+  // be rewound and so it is left at an arbitrary position on failure.
+  // `truncated` is set if the read failed because the file ended early.
+  Status ReadSnappyRecordFromInput(bool* truncated);
+
+  // Recreates `snappy_input_` and skips to `offset_`.
+  Status ResetSnappyInput();
+
+  string filename_;
   uint64 offset_;
   RandomAccessFile* file_;    // Owned
   io::RecordReader* reader_;  // Owned
+  io::SnappyInputBuffer* snappy_input_;  // Owned
+  // Whether `snappy_input_` needs to be recreated before the next read, along
+  // with whether the read that failed hit the end of the file, the status it
+  // failed with, and the size of the file at the time.
+  bool snappy_input_stale_;
+  bool stale_truncated_;
+  Status stale_status_;
+  uint64 stale_file_size_;
   string record_;
   TF_DISALLOW_COPY_AND_ASSIGN(RecordReaderWrapper);
 };
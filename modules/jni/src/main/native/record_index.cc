@@ -0,0 +1,287 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include "record_index.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/c/tf_status_helper.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/raw_coding.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/inputbuffer.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace {
+
+// Record indexes are stored in sidecar files with the following format (all integers are little-endian):
+//   char[8]  magic ("TFRINDEX")
+//   uint64   number of records
+//   for each record:
+//     uint64 offset of the record (i.e., of its header) in the TFRecord file
+//     uint64 length of the record data
+const char kIndexMagic[] = "TFRINDEX";
+const size_t kIndexMagicSize = 8;
+const size_t kHeaderSize = tensorflow::io::RecordReader::kHeaderSize;
+const size_t kFooterSize = tensorflow::io::RecordReader::kFooterSize;
+
+// Reads that are separated by at most this many bytes are coalesced into a single read.
+const tensorflow::uint64 kMaxCoalescingGap = 256 * 1024;
+// Maximum size of a single coalesced read.
+const tensorflow::uint64 kMaxCoalescedReadSize = 16 * 1024 * 1024;
+
+struct RecordLocation {
+  tensorflow::uint64 offset;
+  tensorflow::uint64 length;
+};
+
+// Scans the (uncompressed) TFRecord file at `filename` and returns the locations of all records in it. Only the record
+// headers are read. A truncated record at the end of the file (e.g., one that is still being written) is ignored.
+tensorflow::Status ScanRecords(const std::string& filename, std::vector<RecordLocation>* records) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  tensorflow::uint64 file_size;
+  TF_RETURN_IF_ERROR(env->GetFileSize(filename, &file_size));
+  std::unique_ptr<tensorflow::RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file));
+  tensorflow::io::InputBuffer input(file.get(), 256 * 1024);
+  tensorflow::uint64 offset = 0;
+  char header[kHeaderSize];
+  while (offset + kHeaderSize <= file_size) {
+    TF_RETURN_IF_ERROR(input.Seek(static_cast<tensorflow::int64>(offset)));
+    size_t bytes_read;
+    TF_RETURN_IF_ERROR(input.ReadNBytes(kHeaderSize, header, &bytes_read));
+    const tensorflow::uint32 masked_crc = tensorflow::core::DecodeFixed32(header + sizeof(tensorflow::uint64));
+    if (tensorflow::crc32c::Unmask(masked_crc) != tensorflow::crc32c::Value(header, sizeof(tensorflow::uint64)))
+      return tensorflow::errors::DataLoss("Corrupted record header at offset ", offset, " in '", filename, "'.");
+    const tensorflow::uint64 length = tensorflow::core::DecodeFixed64(header);
+    const tensorflow::uint64 next_offset = offset + kHeaderSize + length + kFooterSize;
+    if (next_offset > file_size) break;
+    records->push_back({offset, length});
+    offset = next_offset;
+  }
+  return tensorflow::Status::OK();
+}
+
+tensorflow::Status ReadIndex(const std::string& index_filename, std::vector<RecordLocation>* records) {
+  std::string content;
+  TF_RETURN_IF_ERROR(tensorflow::ReadFileToString(tensorflow::Env::Default(), index_filename, &content));
+  if (content.size() < kIndexMagicSize + sizeof(tensorflow::uint64) ||
+      content.compare(0, kIndexMagicSize, kIndexMagic) != 0)
+    return tensorflow::errors::DataLoss("'", index_filename, "' is not a valid TFRecord index file.");
+  const tensorflow::uint64 num_records = tensorflow::core::DecodeFixed64(content.data() + kIndexMagicSize);
+  const size_t expected_size = kIndexMagicSize + sizeof(tensorflow::uint64) + num_records * 2 * sizeof(tensorflow::uint64);
+  if (content.size() != expected_size)
+    return tensorflow::errors::DataLoss("The TFRecord index file '", index_filename, "' is truncated.");
+  records->reserve(records->size() + num_records);
+  const char* data = content.data() + kIndexMagicSize + sizeof(tensorflow::uint64);
+  for (tensorflow::uint64 i = 0; i < num_records; ++i, data += 2 * sizeof(tensorflow::uint64))
+    records->push_back({
+      tensorflow::core::DecodeFixed64(data), tensorflow::core::DecodeFixed64(data + sizeof(tensorflow::uint64))});
+  return tensorflow::Status::OK();
+}
+
+// Reads records from a set of uncompressed TFRecord files using their indexes. Records are identified by a global
+// index, which spans all files in order. An instance of this class is safe for concurrent use by multiple threads.
+class IndexedRecordReader {
+ public:
+  tensorflow::Status AddFile(const std::string& filename, const std::string& index_filename) {
+    std::vector<RecordLocation> records;
+    TF_RETURN_IF_ERROR(ReadIndex(index_filename, &records));
+    std::unique_ptr<tensorflow::RandomAccessFile> file;
+    TF_RETURN_IF_ERROR(tensorflow::Env::Default()->NewRandomAccessFile(filename, &file));
+    files_.push_back(std::move(file));
+    filenames_.push_back(filename);
+    for (const RecordLocation& record : records)
+      locations_.push_back({files_.size() - 1, record});
+    return tensorflow::Status::OK();
+  }
+
+  tensorflow::uint64 num_records() const { return locations_.size(); }
+
+  // Reads the records with the provided global indices. Requests are sorted by file and offset, and nearby records are
+  // coalesced into a single read, so that random (e.g., shuffled) access patterns result in as few and as sequential
+  // reads as possible. The records are returned in the order in which they were requested.
+  tensorflow::Status Read(const std::vector<tensorflow::uint64>& indices, std::vector<std::string>* records) const {
+    for (tensorflow::uint64 index : indices)
+      if (index >= locations_.size())
+        return tensorflow::errors::OutOfRange(
+          "Record index ", index, " is out of range for ", locations_.size(), " records.");
+    std::vector<size_t> order(indices.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [this, &indices](size_t a, size_t b) {
+      const Location& la = locations_[indices[a]];
+      const Location& lb = locations_[indices[b]];
+      return la.file < lb.file || (la.file == lb.file && la.record.offset < lb.record.offset);
+    });
+    records->resize(indices.size());
+    std::string scratch;
+    size_t group_start = 0;
+    while (group_start < order.size()) {
+      // Extend the group of coalesced reads for as long as the next record is close enough to the current one.
+      const Location& first = locations_[indices[order[group_start]]];
+      tensorflow::uint64 read_start = first.record.offset;
+      tensorflow::uint64 read_end = RecordEnd(first.record);
+      size_t group_end = group_start + 1;
+      while (group_end < order.size()) {
+        const Location& next = locations_[indices[order[group_end]]];
+        if (next.file != first.file || next.record.offset > read_end + kMaxCoalescingGap ||
+            std::max(read_end, RecordEnd(next.record)) - read_start > kMaxCoalescedReadSize)
+          break;
+        read_end = std::max(read_end, RecordEnd(next.record));
+        ++group_end;
+      }
+      const size_t read_size = static_cast<size_t>(read_end - read_start);
+      scratch.resize(read_size);
+      tensorflow::StringPiece result;
+      TF_RETURN_IF_ERROR(files_[first.file]->Read(read_start, read_size, &result, &scratch[0]));
+      if (result.size() != read_size)
+        return tensorflow::errors::DataLoss("Unexpected end of file in '", filenames_[first.file], "'.");
+      for (size_t i = group_start; i < group_end; ++i) {
+        const RecordLocation& record = locations_[indices[order[i]]].record;
+        const char* data = result.data() + (record.offset - read_start) + kHeaderSize;
+        const tensorflow::uint32 masked_crc = tensorflow::core::DecodeFixed32(data + record.length);
+        if (tensorflow::crc32c::Unmask(masked_crc) != tensorflow::crc32c::Value(data, record.length))
+          return tensorflow::errors::DataLoss(
+            "Corrupted record at offset ", record.offset, " in '", filenames_[first.file], "'.");
+        (*records)[order[i]].assign(data, record.length);
+      }
+      group_start = group_end;
+    }
+    return tensorflow::Status::OK();
+  }
+
+ private:
+  struct Location {
+    size_t file;
+    RecordLocation record;
+  };
+
+  static tensorflow::uint64 RecordEnd(const RecordLocation& record) {
+    return record.offset + kHeaderSize + record.length + kFooterSize;
+  }
+
+  std::vector<std::unique_ptr<tensorflow::RandomAccessFile>> files_;
+  std::vector<std::string> filenames_;
+  std::vector<Location> locations_;
+};
+
+}  // namespace
+
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_RecordIndex_00024_buildIndex(
+    JNIEnv* env, jobject object, jstring filename, jstring index_filename) {
+  const char* c_filename = env->GetStringUTFChars(filename, nullptr);
+  const char* c_index_filename = env->GetStringUTFChars(index_filename, nullptr);
+  std::vector<RecordLocation> records;
+  tensorflow::Status s = ScanRecords(std::string(c_filename), &records);
+  if (s.ok()) {
+    std::string content(kIndexMagic, kIndexMagicSize);
+    content.reserve(kIndexMagicSize + (1 + 2 * records.size()) * sizeof(tensorflow::uint64));
+    tensorflow::core::PutFixed64(&content, static_cast<tensorflow::uint64>(records.size()));
+    for (const RecordLocation& record : records) {
+      tensorflow::core::PutFixed64(&content, record.offset);
+      tensorflow::core::PutFixed64(&content, record.length);
+    }
+    s = tensorflow::WriteStringToFile(tensorflow::Env::Default(), std::string(c_index_filename), content);
+  }
+  env->ReleaseStringUTFChars(index_filename, c_index_filename);
+  env->ReleaseStringUTFChars(filename, c_filename);
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), 0);
+  }
+  return static_cast<jlong>(records.size());
+}
+
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_RecordIndex_00024_newIndexedRecordReader(
+    JNIEnv* env, jobject object, jobjectArray filenames, jobjectArray index_filenames) {
+  const int num_files = env->GetArrayLength(filenames);
+  if (env->GetArrayLength(index_filenames) != num_files) {
+    throw_exception(
+      env, tf_invalid_argument_exception, "The number of index files (%d) must match the number of files (%d).",
+      env->GetArrayLength(index_filenames), num_files);
+    return 0;
+  }
+  std::unique_ptr<IndexedRecordReader> reader(new IndexedRecordReader());
+  tensorflow::Status s;
+  for (int i = 0; i < num_files && s.ok(); ++i) {
+    jstring filename = static_cast<jstring>(env->GetObjectArrayElement(filenames, i));
+    jstring index_filename = static_cast<jstring>(env->GetObjectArrayElement(index_filenames, i));
+    const char* c_filename = env->GetStringUTFChars(filename, nullptr);
+    const char* c_index_filename = env->GetStringUTFChars(index_filename, nullptr);
+    s = reader->AddFile(std::string(c_filename), std::string(c_index_filename));
+    env->ReleaseStringUTFChars(index_filename, c_index_filename);
+    env->ReleaseStringUTFChars(filename, c_filename);
+    env->DeleteLocalRef(index_filename);
+    env->DeleteLocalRef(filename);
+  }
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), 0);
+  }
+  return reinterpret_cast<jlong>(reader.release());
+}
+
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_RecordIndex_00024_numRecords(
+    JNIEnv* env, jobject object, jlong reader_handle) {
+  REQUIRE_HANDLE(reader, IndexedRecordReader, reader_handle, 0);
+  return static_cast<jlong>(reader->num_records());
+}
+
+JNIEXPORT jobjectArray JNICALL Java_org_platanios_tensorflow_jni_RecordIndex_00024_read(
+    JNIEnv* env, jobject object, jlong reader_handle, jlongArray indices) {
+  REQUIRE_HANDLE(reader, IndexedRecordReader, reader_handle, nullptr);
+  const int num_indices = env->GetArrayLength(indices);
+  std::vector<tensorflow::uint64> c_indices(num_indices);
+  jlong* indices_elements = env->GetLongArrayElements(indices, nullptr);
+  for (int i = 0; i < num_indices; ++i) {
+    if (indices_elements[i] < 0) {
+      env->ReleaseLongArrayElements(indices, indices_elements, JNI_ABORT);
+      throw_exception(env, tf_invalid_argument_exception, "Record indices must be non-negative.");
+      return nullptr;
+    }
+    c_indices[i] = static_cast<tensorflow::uint64>(indices_elements[i]);
+  }
+  env->ReleaseLongArrayElements(indices, indices_elements, JNI_ABORT);
+  std::vector<std::string> records;
+  tensorflow::Status s = reader->Read(c_indices, &records);
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), nullptr);
+  }
+  jobjectArray records_array = env->NewObjectArray(num_indices, env->FindClass("[B"), nullptr);
+  for (int i = 0; i < num_indices; ++i) {
+    jbyteArray record = env->NewByteArray(static_cast<jsize>(records[i].size()));
+    env->SetByteArrayRegion(
+      record, 0, static_cast<jsize>(records[i].size()), reinterpret_cast<const jbyte*>(records[i].data()));
+    env->SetObjectArrayElement(records_array, i, record);
+    env->DeleteLocalRef(record);
+  }
+  return records_array;
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_RecordIndex_00024_delete(
+    JNIEnv* env, jobject object, jlong reader_handle) {
+  REQUIRE_HANDLE(reader, IndexedRecordReader, reader_handle, void());
+  delete reader;
+}
@@ -0,0 +1,53 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class org_platanios_tensorflow_jni_RecordIndex__ */
+
+#ifndef _Included_org_platanios_tensorflow_jni_RecordIndex__
+#define _Included_org_platanios_tensorflow_jni_RecordIndex__
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     org_platanios_tensorflow_jni_RecordIndex__
+ * Method:    buildIndex
+ * Signature: (Ljava/lang/String;Ljava/lang/String;)J
+ */
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_RecordIndex_00024_buildIndex
+  (JNIEnv *, jobject, jstring, jstring);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_RecordIndex__
+ * Method:    newIndexedRecordReader
+ * Signature: ([Ljava/lang/String;[Ljava/lang/String;)J
+ */
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_RecordIndex_00024_newIndexedRecordReader
+  (JNIEnv *, jobject, jobjectArray, jobjectArray);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_RecordIndex__
+ * Method:    numRecords
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_RecordIndex_00024_numRecords
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_RecordIndex__
+ * Method:    read
+ * Signature: (J[J)[[B
+ */
+JNIEXPORT jobjectArray JNICALL Java_org_platanios_tensorflow_jni_RecordIndex_00024_read
+  (JNIEnv *, jobject, jlong, jlongArray);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_RecordIndex__
+ * Method:    delete
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_RecordIndex_00024_delete
+  (JNIEnv *, jobject, jlong);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -22,6 +22,20 @@
 #include "tensorflow/c/tf_status_helper.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 
+namespace {
+// Returns `true` if `compression_type` is supported by `tensorflow::io::RecordReader`. Snappy-compressed record files
+// can only be read using the record reader wrapper.
+bool checkRecordReaderCompressionType(JNIEnv* env, const char* compression_type) {
+  if (strcmp(compression_type, "SNAPPY") == 0) {
+    throw_exception(
+      env, tf_invalid_argument_exception,
+      "Compression type '%s' is only supported when using the record reader wrapper.", compression_type);
+    return false;
+  }
+  return true;
+}
+}  // namespace
+
 JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_RecordReader_00024_newRandomAccessFile(
     JNIEnv* env, jobject object, jstring filename) {
   const char* c_filename = env->GetStringUTFChars(filename, nullptr);
@@ -46,6 +60,10 @@ JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_RecordReader_00024_new
     JNIEnv* env, jobject object, jlong file_handle, jstring compression_type) {
   REQUIRE_HANDLE(file, tensorflow::RandomAccessFile, file_handle, 0);
   const char* c_compression_type = env->GetStringUTFChars(compression_type, nullptr);
+  if (!checkRecordReaderCompressionType(env, c_compression_type)) {
+    env->ReleaseStringUTFChars(compression_type, c_compression_type);
+    return 0;
+  }
   tensorflow::io::RecordReaderOptions options =
     tensorflow::io::RecordReaderOptions::CreateRecordReaderOptions(std::string(c_compression_type));
   auto* reader = new tensorflow::io::RecordReader(file, options);
@@ -81,6 +99,10 @@ JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_RecordReader_00024_new
     JNIEnv* env, jobject object, jlong file_handle, jstring compression_type) {
   REQUIRE_HANDLE(file, tensorflow::RandomAccessFile, file_handle, 0);
   const char* c_compression_type = env->GetStringUTFChars(compression_type, nullptr);
+  if (!checkRecordReaderCompressionType(env, c_compression_type)) {
+    env->ReleaseStringUTFChars(compression_type, c_compression_type);
+    return 0;
+  }
   tensorflow::io::RecordReaderOptions options =
     tensorflow::io::RecordReaderOptions::CreateRecordReaderOptions(std::string(c_compression_type));
   auto* reader = new tensorflow::io::SequentialRecordReader(file, options);
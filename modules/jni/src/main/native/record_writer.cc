@@ -0,0 +1,187 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include "record_writer.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "tensorflow/c/record_reader.h"
+#include "tensorflow/c/tf_status_helper.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/io/snappy/snappy_outputbuffer.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace {
+
+// Writer for TensorFlow record files that, in addition to the compression types supported by
+// `tensorflow::io::RecordWriter`, also supports "SNAPPY". Snappy-compressed files consist of the usual record framing
+// written through a `tensorflow::io::SnappyOutputBuffer`, and can be read using `tensorflow::io::RecordReaderWrapper`.
+class RecordWriter {
+ public:
+  static tensorflow::Status New(
+      const std::string& filename, const std::string& compression_type, bool append,
+      std::unique_ptr<RecordWriter>* writer) {
+    std::unique_ptr<tensorflow::WritableFile> file;
+    if (append) {
+      TF_RETURN_IF_ERROR(tensorflow::Env::Default()->NewAppendableFile(filename, &file));
+    } else {
+      TF_RETURN_IF_ERROR(tensorflow::Env::Default()->NewWritableFile(filename, &file));
+    }
+    writer->reset(new RecordWriter(std::move(file), compression_type));
+    return tensorflow::Status::OK();
+  }
+
+  ~RecordWriter() { Close().IgnoreError(); }
+
+  tensorflow::Status Write(tensorflow::StringPiece record) {
+    if (file_ == nullptr) return tensorflow::errors::FailedPrecondition("The record writer has already been closed.");
+    if (snappy_output_ == nullptr) return writer_->WriteRecord(record);
+    // Format of a single record:
+    //  uint64    length
+    //  uint32    masked crc of length
+    //  byte      data[length]
+    //  uint32    masked crc of data
+    char header[sizeof(tensorflow::uint64) + sizeof(tensorflow::uint32)];
+    char footer[sizeof(tensorflow::uint32)];
+    tensorflow::core::EncodeFixed64(header, record.size());
+    tensorflow::core::EncodeFixed32(
+      header + sizeof(tensorflow::uint64), MaskedCrc(header, sizeof(tensorflow::uint64)));
+    tensorflow::core::EncodeFixed32(footer, MaskedCrc(record.data(), record.size()));
+    TF_RETURN_IF_ERROR(snappy_output_->Write(tensorflow::StringPiece(header, sizeof(header))));
+    // Large records are written in pieces because the snappy output buffer compresses anything larger than its input
+    // buffer as a single block, which readers would then be unable to decompress.
+    for (size_t offset = 0; offset < record.size(); offset += tensorflow::io::kSnappyRecordBlockBytes) {
+      size_t length = std::min(tensorflow::io::kSnappyRecordBlockBytes, record.size() - offset);
+      TF_RETURN_IF_ERROR(snappy_output_->Write(tensorflow::StringPiece(record.data() + offset, length)));
+    }
+    return snappy_output_->Write(tensorflow::StringPiece(footer, sizeof(footer)));
+  }
+
+  tensorflow::Status Flush() {
+    if (file_ == nullptr) return tensorflow::errors::FailedPrecondition("The record writer has already been closed.");
+    if (snappy_output_ == nullptr) return writer_->Flush();
+    TF_RETURN_IF_ERROR(snappy_output_->Flush());
+    return file_->Flush();
+  }
+
+  tensorflow::Status Close() {
+    if (file_ == nullptr) return tensorflow::Status::OK();
+    tensorflow::Status s;
+    if (snappy_output_ == nullptr) {
+      s.Update(writer_->Close());
+    } else {
+      s.Update(snappy_output_->Flush());
+    }
+    writer_.reset();
+    snappy_output_.reset();
+    s.Update(file_->Close());
+    file_.reset();
+    return s;
+  }
+
+ private:
+  RecordWriter(std::unique_ptr<tensorflow::WritableFile> file, const std::string& compression_type)
+      : file_(std::move(file)) {
+    if (compression_type == "SNAPPY") {
+      snappy_output_.reset(new tensorflow::io::SnappyOutputBuffer(
+        file_.get(), static_cast<tensorflow::int32>(tensorflow::io::kSnappyRecordBlockBytes),
+        static_cast<tensorflow::int32>(2 * tensorflow::io::kSnappyRecordBlockBytes)));
+    } else {
+      writer_.reset(new tensorflow::io::RecordWriter(
+        file_.get(), tensorflow::io::RecordWriterOptions::CreateRecordWriterOptions(compression_type)));
+    }
+  }
+
+  static tensorflow::uint32 MaskedCrc(const char* data, size_t n) {
+    return tensorflow::crc32c::Mask(tensorflow::crc32c::Value(data, n));
+  }
+
+  std::unique_ptr<tensorflow::WritableFile> file_;
+  std::unique_ptr<tensorflow::io::RecordWriter> writer_;
+  std::unique_ptr<tensorflow::io::SnappyOutputBuffer> snappy_output_;
+};
+
+}  // namespace
+
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_RecordWriter_00024_newRecordWriter(
+    JNIEnv* env, jobject object, jstring filename, jstring compression_type, jboolean append) {
+  const char* c_filename = env->GetStringUTFChars(filename, nullptr);
+  const char* c_compression_type = env->GetStringUTFChars(compression_type, nullptr);
+  std::unique_ptr<RecordWriter> writer;
+  tensorflow::Status s = RecordWriter::New(
+    std::string(c_filename), std::string(c_compression_type), static_cast<bool>(append), &writer);
+  env->ReleaseStringUTFChars(filename, c_filename);
+  env->ReleaseStringUTFChars(compression_type, c_compression_type);
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), 0);
+  }
+  return reinterpret_cast<jlong>(writer.release());
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_RecordWriter_00024_write(
+    JNIEnv* env, jobject object, jlong writer_handle, jbyteArray record, jint offset, jint length) {
+  REQUIRE_HANDLE(writer, RecordWriter, writer_handle, void());
+  if (offset < 0 || length < 0 || offset > env->GetArrayLength(record) - length) {
+    throw_exception(
+      env, tf_invalid_argument_exception, "Invalid array region [%d, %d) for an array of length %d.",
+      offset, offset + length, env->GetArrayLength(record));
+    return;
+  }
+  jbyte* elements = env->GetByteArrayElements(record, nullptr);
+  tensorflow::Status s = writer->Write(
+    tensorflow::StringPiece(reinterpret_cast<const char*>(elements + offset), static_cast<size_t>(length)));
+  env->ReleaseByteArrayElements(record, elements, JNI_ABORT);
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_RecordWriter_00024_flush(
+    JNIEnv* env, jobject object, jlong writer_handle) {
+  REQUIRE_HANDLE(writer, RecordWriter, writer_handle, void());
+  tensorflow::Status s = writer->Flush();
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_RecordWriter_00024_close(
+    JNIEnv* env, jobject object, jlong writer_handle) {
+  REQUIRE_HANDLE(writer, RecordWriter, writer_handle, void());
+  tensorflow::Status s = writer->Close();
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_RecordWriter_00024_delete(
+    JNIEnv* env, jobject object, jlong writer_handle) {
+  REQUIRE_HANDLE(writer, RecordWriter, writer_handle, void());
+  delete writer;
+}
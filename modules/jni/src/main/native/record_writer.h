@@ -0,0 +1,53 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class org_platanios_tensorflow_jni_RecordWriter__ */
+
+#ifndef _Included_org_platanios_tensorflow_jni_RecordWriter__
+#define _Included_org_platanios_tensorflow_jni_RecordWriter__
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     org_platanios_tensorflow_jni_RecordWriter__
+ * Method:    newRecordWriter
+ * Signature: (Ljava/lang/String;Ljava/lang/String;Z)J
+ */
+JNIEXPORT jlong JNICALL Java_org_platanios_tensorflow_jni_RecordWriter_00024_newRecordWriter
+  (JNIEnv *, jobject, jstring, jstring, jboolean);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_RecordWriter__
+ * Method:    write
+ * Signature: (J[BII)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_RecordWriter_00024_write
+  (JNIEnv *, jobject, jlong, jbyteArray, jint, jint);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_RecordWriter__
+ * Method:    flush
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_RecordWriter_00024_flush
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_RecordWriter__
+ * Method:    close
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_RecordWriter_00024_close
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_RecordWriter__
+ * Method:    delete
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_RecordWriter_00024_delete
+  (JNIEnv *, jobject, jlong);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,669 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include "uring_file_system.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/c/tf_status_helper.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define URING_FILE_SYSTEM_SUPPORTED
+#endif
+#endif
+
+#ifdef URING_FILE_SYSTEM_SUPPORTED
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// These system call numbers are the same on all architectures, but may be missing from older C library headers.
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+
+namespace {
+
+// Number of consecutive failed waits for completions after which the reaper thread gives up and fails all pending
+// reads. The waits are retried with an exponential backoff, starting at 1 millisecond.
+const int kMaxReapFailures = 10;
+
+int io_uring_setup(unsigned entries, io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int io_uring_register(int ring_fd, unsigned opcode, const void* arg, unsigned num_args) {
+  return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, num_args));
+}
+
+// Options used to configure the io_uring file system.
+struct UringOptions {
+  // Number of submission queue entries, which bounds the number of reads in flight.
+  unsigned queue_depth;
+  // Number of bounce buffers registered with the kernel, which also bounds the number of reads in flight.
+  int num_buffers;
+  // Size of each registered buffer, in bytes. Reads larger than this are split into multiple requests.
+  size_t buffer_size;
+};
+
+// A single read request. Requests are submitted in groups and the submitting thread waits until all requests in its
+// group have completed.
+struct ReadRequest {
+  int fd;
+  tensorflow::uint64 offset;
+  size_t length;
+  char* destination;
+  // Number of outstanding requests in the group this request belongs to.
+  size_t* group_pending;
+  int buffer_index = -1;
+  struct iovec iov;
+  // Number of bytes read, or a negated error number.
+  tensorflow::int64 result = 0;
+};
+
+// Submission and completion queue pair shared by all files opened through a single file system instance.
+//
+// Reads are performed into a pool of buffers registered with the kernel (so that the kernel does not need to map the
+// destination pages on every request) and then copied into the caller's buffer. Any number of threads can submit reads
+// concurrently. A single background thread reaps completions and wakes up the submitting threads, and so the device
+// queue can be kept full even when each caller only issues one read at a time.
+class UringQueue {
+ public:
+  static tensorflow::Status New(const UringOptions& options, std::unique_ptr<UringQueue>* queue) {
+    std::unique_ptr<UringQueue> q(new UringQueue(options));
+    TF_RETURN_IF_ERROR(q->Initialize());
+    UringQueue* raw_queue = q.get();
+    q->reaper_.reset(tensorflow::Env::Default()->StartThread(
+      tensorflow::ThreadOptions(), "uring_reaper", [raw_queue]() { raw_queue->ReapLoop(); }));
+    *queue = std::move(q);
+    return tensorflow::Status::OK();
+  }
+
+  ~UringQueue() {
+    if (reaper_ != nullptr) {
+      {
+        // A no-op request with no associated read request tells the reaper thread to exit, unless it has already
+        // exited after failing.
+        tensorflow::mutex_lock l(mu_);
+        while (error_ == 0 && in_flight_ >= sq_entries_) cv_.wait(l);
+        if (error_ == 0) {
+          PushLocked(nullptr);
+          FlushLocked();
+        }
+      }
+      reaper_.reset();
+    }
+    if (buffers_registered_) io_uring_register(ring_fd_, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+    if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+    if (sq_ring_ != nullptr) munmap(sq_ring_, sq_ring_size_);
+    if (ring_fd_ >= 0) close(ring_fd_);
+    free(buffer_memory_);
+  }
+
+  size_t buffer_size() const { return options_.buffer_size; }
+
+  // Submits all of `requests` and blocks until they have all completed.
+  void SubmitAndWait(std::vector<ReadRequest>* requests) {
+    size_t pending = requests->size();
+    tensorflow::mutex_lock l(mu_);
+    for (ReadRequest& request : *requests) {
+      request.group_pending = &pending;
+      while (error_ == 0 && (free_buffers_.empty() || in_flight_ >= sq_entries_)) {
+        // Requests that have been queued but not submitted yet must be submitted before waiting, because they may be
+        // holding the buffers that this request is waiting for.
+        FlushLocked();
+        cv_.wait(l);
+      }
+      if (error_ != 0) {
+        // Completions are not reaped anymore, and so the request fails without being submitted.
+        request.result = -error_;
+        --pending;
+        continue;
+      }
+      request.buffer_index = free_buffers_.back();
+      free_buffers_.pop_back();
+      PushLocked(&request);
+    }
+    FlushLocked();
+    while (pending > 0) cv_.wait(l);
+  }
+
+ private:
+  explicit UringQueue(const UringOptions& options) : options_(options) {}
+
+  tensorflow::Status Initialize() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = io_uring_setup(options_.queue_depth, &params);
+    if (ring_fd_ < 0) return tensorflow::errors::Unavailable("io_uring_setup failed: ", strerror(errno));
+    sq_entries_ = params.sq_entries;
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+    single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+#endif
+    sq_ring_ = Map(sq_ring_size_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == nullptr) return tensorflow::errors::Unavailable("Failed to map the submission queue ring.");
+    cq_ring_ = single_mmap ? sq_ring_ : Map(cq_ring_size_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == nullptr) return tensorflow::errors::Unavailable("Failed to map the completion queue ring.");
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(Map(sqes_size_, IORING_OFF_SQES));
+    if (sqes_ == nullptr) return tensorflow::errors::Unavailable("Failed to map the submission queue entries.");
+
+    char* sq = static_cast<char*>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    unsigned* sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    for (unsigned i = 0; i < params.sq_entries; ++i) sq_array[i] = i;
+    char* cq = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t buffer_size = (options_.buffer_size + page_size - 1) / page_size * page_size;
+    if (posix_memalign(reinterpret_cast<void**>(&buffer_memory_), page_size, buffer_size * options_.num_buffers) != 0)
+      return tensorflow::errors::ResourceExhausted("Failed to allocate the io_uring buffers.");
+    std::vector<struct iovec> iovecs(options_.num_buffers);
+    for (int i = 0; i < options_.num_buffers; ++i) {
+      buffers_.push_back(buffer_memory_ + i * buffer_size);
+      iovecs[i].iov_base = buffers_.back();
+      iovecs[i].iov_len = options_.buffer_size;
+      free_buffers_.push_back(i);
+    }
+    // Registration can fail if the locked memory limit is too low, in which case plain vectored reads into the same
+    // buffers are used instead.
+    buffers_registered_ = io_uring_register(
+      ring_fd_, IORING_REGISTER_BUFFERS, iovecs.data(), static_cast<unsigned>(iovecs.size())) == 0;
+    if (!buffers_registered_)
+      LOG(WARNING) << "Failed to register the io_uring buffers (" << strerror(errno) << "). "
+                   << "Falling back to unregistered buffers.";
+    return tensorflow::Status::OK();
+  }
+
+  void* Map(size_t size, off_t offset) {
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+  }
+
+  // Adds a submission queue entry for `request` (or a no-op entry, if `request` is null), without submitting it.
+  void PushLocked(ReadRequest* request) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    io_uring_sqe* sqe = &sqes_[sq_tail_local_ & sq_mask_];
+    memset(sqe, 0, sizeof(*sqe));
+    if (request == nullptr) {
+      sqe->opcode = IORING_OP_NOP;
+    } else {
+      char* buffer = buffers_[request->buffer_index];
+      sqe->fd = request->fd;
+      sqe->off = request->offset;
+      if (buffers_registered_) {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->addr = reinterpret_cast<tensorflow::uint64>(buffer);
+        sqe->len = static_cast<tensorflow::uint32>(request->length);
+        sqe->buf_index = static_cast<tensorflow::uint16>(request->buffer_index);
+      } else {
+        sqe->opcode = IORING_OP_READV;
+        request->iov.iov_base = buffer;
+        request->iov.iov_len = request->length;
+        sqe->addr = reinterpret_cast<tensorflow::uint64>(&request->iov);
+        sqe->len = 1;
+      }
+    }
+    sqe->user_data = reinterpret_cast<tensorflow::uint64>(request);
+    ++sq_tail_local_;
+    ++in_flight_;
+    unsubmitted_.push_back(request);
+    if (request != nullptr) pending_.insert(request);
+  }
+
+  // Submits all entries added using `PushLocked` to the kernel.
+  void FlushLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (unsubmitted_.empty()) return;
+    __atomic_store_n(sq_tail_, sq_tail_local_, __ATOMIC_RELEASE);
+    size_t submitted = 0;
+    while (submitted < unsubmitted_.size()) {
+      int ret = io_uring_enter(ring_fd_, static_cast<unsigned>(unsubmitted_.size() - submitted), 0, 0);
+      if (ret >= 0) {
+        submitted += static_cast<size_t>(ret);
+      } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        // The remaining entries were not consumed by the kernel, and so they can be withdrawn and failed directly.
+        int error = errno;
+        LOG(ERROR) << "io_uring_enter failed: " << strerror(error);
+        size_t remaining = unsubmitted_.size() - submitted;
+        sq_tail_local_ -= static_cast<unsigned>(remaining);
+        __atomic_store_n(sq_tail_, sq_tail_local_, __ATOMIC_RELEASE);
+        for (size_t i = submitted; i < unsubmitted_.size(); ++i) {
+          ReadRequest* request = unsubmitted_[i];
+          --in_flight_;
+          if (request == nullptr) continue;
+          request->result = -error;
+          free_buffers_.push_back(request->buffer_index);
+          pending_.erase(request);
+          --*request->group_pending;
+        }
+        cv_.notify_all();
+        break;
+      }
+    }
+    unsubmitted_.clear();
+  }
+
+  // Fails all requests that have not completed yet and stops accepting new ones. This is only called by the reaper
+  // thread right before it exits, and so the failed requests are never touched again. Their buffers are not released,
+  // because the kernel may still write to them.
+  void FailLocked(int error) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    error_ = error;
+    sq_tail_local_ -= static_cast<unsigned>(unsubmitted_.size());
+    unsubmitted_.clear();
+    for (ReadRequest* request : pending_) {
+      request->result = -error;
+      --*request->group_pending;
+    }
+    pending_.clear();
+    in_flight_ = 0;
+    cv_.notify_all();
+  }
+
+  void ReapLoop() {
+    std::vector<ReadRequest*> completed;
+    int failures = 0;
+    bool stop = false;
+    while (!stop) {
+      int error = 0;
+      if (io_uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) error = errno;
+      // Only this thread consumes completions, and so the completion queue can be read without holding the lock. The
+      // buffers of completed requests are also not touched by any other thread until they are released below.
+      unsigned head = *cq_head_;
+      unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      for (; head != tail; ++head) {
+        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        ReadRequest* request = reinterpret_cast<ReadRequest*>(cqe.user_data);
+        if (request == nullptr) {
+          stop = true;
+        } else {
+          request->result = cqe.res;
+          if (cqe.res > 0) memcpy(request->destination, buffers_[request->buffer_index], static_cast<size_t>(cqe.res));
+        }
+        completed.push_back(request);
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+      if (!completed.empty()) {
+        tensorflow::mutex_lock l(mu_);
+        for (ReadRequest* request : completed) {
+          --in_flight_;
+          if (request == nullptr) continue;
+          free_buffers_.push_back(request->buffer_index);
+          pending_.erase(request);
+          --*request->group_pending;
+        }
+        completed.clear();
+        cv_.notify_all();
+      }
+      if (stop || error == 0) {
+        failures = 0;
+        continue;
+      }
+      // Failed waits are retried with an exponential backoff, in case the error is transient (e.g., `EAGAIN` when the
+      // kernel is short on memory), and the pending reads are failed once it persists.
+      if (++failures >= kMaxReapFailures) {
+        LOG(ERROR) << "io_uring_enter failed " << failures << " times in a row while waiting for completions ("
+                   << strerror(error) << "). Failing all pending reads.";
+        tensorflow::mutex_lock l(mu_);
+        FailLocked(error);
+        return;
+      }
+      if (failures == 1)
+        LOG(WARNING) << "io_uring_enter failed while waiting for completions (" << strerror(error) << "). Retrying.";
+      tensorflow::Env::Default()->SleepForMicroseconds(1000 << (failures - 1));
+    }
+  }
+
+  const UringOptions options_;
+
+  int ring_fd_ = -1;
+  void* sq_ring_ = nullptr;
+  void* cq_ring_ = nullptr;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  size_t cq_ring_size_ = 0;
+  size_t sqes_size_ = 0;
+  unsigned sq_entries_ = 0;
+  unsigned* sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+
+  char* buffer_memory_ = nullptr;
+  std::vector<char*> buffers_;
+  bool buffers_registered_ = false;
+
+  tensorflow::mutex mu_;
+  tensorflow::condition_variable cv_;
+  std::vector<int> free_buffers_ GUARDED_BY(mu_);
+  std::vector<ReadRequest*> unsubmitted_ GUARDED_BY(mu_);
+  // Requests that have been added but have not completed yet.
+  std::unordered_set<ReadRequest*> pending_ GUARDED_BY(mu_);
+  // Error that made the reaper thread exit, or zero while it is running.
+  int error_ GUARDED_BY(mu_) = 0;
+  unsigned sq_tail_local_ GUARDED_BY(mu_) = 0;
+  unsigned in_flight_ GUARDED_BY(mu_) = 0;
+  std::unique_ptr<tensorflow::Thread> reaper_;
+};
+
+class UringRandomAccessFile : public tensorflow::RandomAccessFile {
+ public:
+  UringRandomAccessFile(const std::string& filename, int fd, UringQueue* queue)
+      : filename_(filename), fd_(fd), queue_(queue) {}
+
+  ~UringRandomAccessFile() override { close(fd_); }
+
+  tensorflow::Status Read(
+      tensorflow::uint64 offset, size_t n, tensorflow::StringPiece* result, char* scratch) const override {
+    std::vector<ReadRequest> requests;
+    for (size_t position = 0; position < n; position += queue_->buffer_size()) {
+      ReadRequest request;
+      request.fd = fd_;
+      request.offset = offset + position;
+      request.length = std::min(queue_->buffer_size(), n - position);
+      request.destination = scratch + position;
+      requests.push_back(request);
+    }
+    queue_->SubmitAndWait(&requests);
+    tensorflow::Status s;
+    size_t num_read = 0;
+    for (const ReadRequest& request : requests) {
+      if (request.result < 0) {
+        s = tensorflow::errors::Internal("Failed to read '", filename_, "': ", strerror(static_cast<int>(-request.result)));
+        break;
+      }
+      num_read += static_cast<size_t>(request.result);
+      if (static_cast<size_t>(request.result) < request.length) {
+        // Short reads mostly happen at the end of the file, but the kernel is also allowed to return them elsewhere,
+        // and so the remainder of the request is read synchronously until the end of the file is reached.
+        size_t remaining = request.length - static_cast<size_t>(request.result);
+        while (remaining > 0) {
+          ssize_t r = pread(fd_, scratch + num_read, remaining, static_cast<off_t>(offset + num_read));
+          if (r < 0 && errno == EINTR) continue;
+          if (r < 0) {
+            s = tensorflow::errors::Internal("Failed to read '", filename_, "': ", strerror(errno));
+            break;
+          }
+          if (r == 0) break;
+          num_read += static_cast<size_t>(r);
+          remaining -= static_cast<size_t>(r);
+        }
+        if (!s.ok() || remaining > 0) break;
+      }
+    }
+    *result = tensorflow::StringPiece(scratch, num_read);
+    if (s.ok() && num_read < n) s = tensorflow::errors::OutOfRange("Read less bytes than requested.");
+    return s;
+  }
+
+ private:
+  const std::string filename_;
+  const int fd_;
+  UringQueue* queue_;
+};
+
+// File system that serves random access reads of local files through io_uring and delegates all other operations to
+// the local file system. Files are accessed using paths of the form `<scheme>:///path/to/file`.
+class UringFileSystem : public tensorflow::FileSystem {
+ public:
+  explicit UringFileSystem(const UringOptions& options) : options_(options) {
+    TF_CHECK_OK(tensorflow::Env::Default()->GetFileSystemForFile("", &local_));
+  }
+
+  tensorflow::Status NewRandomAccessFile(
+      const std::string& fname, std::unique_ptr<tensorflow::RandomAccessFile>* result) override {
+    UringQueue* queue;
+    TF_RETURN_IF_ERROR(GetQueue(&queue));
+    std::string filename = TranslateName(fname);
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      if (errno == ENOENT) return tensorflow::errors::NotFound(filename, ": ", strerror(errno));
+      return tensorflow::errors::Internal("Failed to open '", filename, "': ", strerror(errno));
+    }
+    result->reset(new UringRandomAccessFile(filename, fd, queue));
+    return tensorflow::Status::OK();
+  }
+
+  tensorflow::Status NewWritableFile(
+      const std::string& fname, std::unique_ptr<tensorflow::WritableFile>* result) override {
+    return local_->NewWritableFile(TranslateName(fname), result);
+  }
+
+  tensorflow::Status NewAppendableFile(
+      const std::string& fname, std::unique_ptr<tensorflow::WritableFile>* result) override {
+    return local_->NewAppendableFile(TranslateName(fname), result);
+  }
+
+  tensorflow::Status NewReadOnlyMemoryRegionFromFile(
+      const std::string& fname, std::unique_ptr<tensorflow::ReadOnlyMemoryRegion>* result) override {
+    return local_->NewReadOnlyMemoryRegionFromFile(TranslateName(fname), result);
+  }
+
+  tensorflow::Status FileExists(const std::string& fname) override {
+    return local_->FileExists(TranslateName(fname));
+  }
+
+  tensorflow::Status GetChildren(const std::string& dir, std::vector<std::string>* result) override {
+    return local_->GetChildren(TranslateName(dir), result);
+  }
+
+  tensorflow::Status GetMatchingPaths(const std::string& pattern, std::vector<std::string>* results) override {
+    tensorflow::StringPiece scheme, host, path;
+    tensorflow::io::ParseURI(pattern, &scheme, &host, &path);
+    TF_RETURN_IF_ERROR(local_->GetMatchingPaths(TranslateName(pattern), results));
+    for (std::string& result : *results) result = tensorflow::io::CreateURI(scheme, host, result);
+    return tensorflow::Status::OK();
+  }
+
+  tensorflow::Status Stat(const std::string& fname, tensorflow::FileStatistics* stat) override {
+    return local_->Stat(TranslateName(fname), stat);
+  }
+
+  tensorflow::Status DeleteFile(const std::string& fname) override {
+    return local_->DeleteFile(TranslateName(fname));
+  }
+
+  tensorflow::Status CreateDir(const std::string& dirname) override {
+    return local_->CreateDir(TranslateName(dirname));
+  }
+
+  tensorflow::Status DeleteDir(const std::string& dirname) override {
+    return local_->DeleteDir(TranslateName(dirname));
+  }
+
+  tensorflow::Status GetFileSize(const std::string& fname, tensorflow::uint64* file_size) override {
+    return local_->GetFileSize(TranslateName(fname), file_size);
+  }
+
+  tensorflow::Status RenameFile(const std::string& src, const std::string& target) override {
+    return local_->RenameFile(TranslateName(src), TranslateName(target));
+  }
+
+  tensorflow::Status IsDirectory(const std::string& fname) override {
+    return local_->IsDirectory(TranslateName(fname));
+  }
+
+ private:
+  // The queue is created lazily so that registering the file system is cheap when it ends up not being used.
+  tensorflow::Status GetQueue(UringQueue** queue) {
+    tensorflow::mutex_lock l(mu_);
+    if (queue_ == nullptr) TF_RETURN_IF_ERROR(UringQueue::New(options_, &queue_));
+    *queue = queue_.get();
+    return tensorflow::Status::OK();
+  }
+
+  const UringOptions options_;
+  tensorflow::FileSystem* local_;
+  tensorflow::mutex mu_;
+  std::unique_ptr<UringQueue> queue_ GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+#endif  // URING_FILE_SYSTEM_SUPPORTED
+
+JNIEXPORT jboolean JNICALL Java_org_platanios_tensorflow_jni_UringFileSystem_00024_isSupported(
+    JNIEnv* env, jobject object) {
+#ifdef URING_FILE_SYSTEM_SUPPORTED
+  // The kernel may still not support io_uring (or it may be disabled), and so we check by creating a small ring.
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = io_uring_setup(1, &params);
+  if (ring_fd < 0) return JNI_FALSE;
+  close(ring_fd);
+  return JNI_TRUE;
+#else
+  return JNI_FALSE;
+#endif
+}
+
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_UringFileSystem_00024_register(
+    JNIEnv* env, jobject object, jstring scheme, jint queue_depth, jint num_buffers, jint buffer_size) {
+#ifdef URING_FILE_SYSTEM_SUPPORTED
+  if (queue_depth <= 0 || num_buffers <= 0 || buffer_size <= 0) {
+    throw_exception(
+      env, tf_invalid_argument_exception,
+      "The queue depth, number of buffers, and buffer size must all be positive.");
+    return;
+  }
+  UringOptions options;
+  options.queue_depth = static_cast<unsigned>(queue_depth);
+  options.num_buffers = static_cast<int>(num_buffers);
+  options.buffer_size = static_cast<size_t>(buffer_size);
+  const char* c_scheme = env->GetStringUTFChars(scheme, nullptr);
+  tensorflow::Status s = tensorflow::Env::Default()->RegisterFileSystem(
+    std::string(c_scheme), [options]() -> tensorflow::FileSystem* { return new UringFileSystem(options); });
+  env->ReleaseStringUTFChars(scheme, c_scheme);
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), void());
+  }
+#else
+  throw_exception(env, tf_unimplemented_exception, "The io_uring file system is only supported on Linux.");
+#endif
+}
+
+JNIEXPORT jobject JNICALL Java_org_platanios_tensorflow_jni_UringFileSystem_00024_benchmarkRandomReads(
+    JNIEnv* env, jobject object, jstring path, jint block_size, jlong num_reads, jint num_threads, jlong seed) {
+  if (block_size <= 0 || num_reads <= 0 || num_threads <= 0) {
+    throw_exception(
+      env, tf_invalid_argument_exception,
+      "The block size, number of reads, and number of threads must all be positive.");
+    return nullptr;
+  }
+  const char* c_path = env->GetStringUTFChars(path, nullptr);
+  std::string filename(c_path);
+  env->ReleaseStringUTFChars(path, c_path);
+
+  // The file is opened through the environment, and so this benchmark can be used to compare any two file systems
+  // (e.g., `file:///path` against `uring:///path`).
+  tensorflow::Env* tf_env = tensorflow::Env::Default();
+  std::unique_ptr<tensorflow::RandomAccessFile> file;
+  tensorflow::uint64 file_size = 0;
+  tensorflow::Status s = tf_env->NewRandomAccessFile(filename, &file);
+  if (s.ok()) s = tf_env->GetFileSize(filename, &file_size);
+  if (s.ok() && file_size < static_cast<tensorflow::uint64>(block_size))
+    s = tensorflow::errors::InvalidArgument("The file '", filename, "' is smaller than the block size.");
+  if (!s.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), s);
+    CHECK_STATUS(env, status.get(), nullptr);
+  }
+
+  // Each thread issues reads of whole blocks at uniformly random block-aligned offsets, similar to fio's `randread`
+  // workload with one outstanding request per thread.
+  const tensorflow::uint64 num_blocks = file_size / static_cast<tensorflow::uint64>(block_size);
+  std::atomic<tensorflow::int64> num_bytes(0);
+  tensorflow::mutex mu;
+  tensorflow::Status benchmark_status;
+  const tensorflow::uint64 start_micros = tf_env->NowMicros();
+  {
+    tensorflow::thread::ThreadPool pool(tf_env, "random_read_benchmark", num_threads);
+    for (int t = 0; t < num_threads; ++t) {
+      const tensorflow::int64 thread_reads = num_reads / num_threads + (t < num_reads % num_threads ? 1 : 0);
+      pool.Schedule([&, t, thread_reads]() {
+        std::mt19937_64 rng(static_cast<tensorflow::uint64>(seed) + static_cast<tensorflow::uint64>(t));
+        std::uniform_int_distribution<tensorflow::uint64> block_distribution(0, num_blocks - 1);
+        std::unique_ptr<char[]> scratch(new char[block_size]);
+        tensorflow::StringPiece result;
+        for (tensorflow::int64 i = 0; i < thread_reads; ++i) {
+          tensorflow::uint64 offset = block_distribution(rng) * static_cast<tensorflow::uint64>(block_size);
+          tensorflow::Status read_status = file->Read(offset, static_cast<size_t>(block_size), &result, scratch.get());
+          if (!read_status.ok()) {
+            tensorflow::mutex_lock l(mu);
+            benchmark_status.Update(read_status);
+            return;
+          }
+          num_bytes += static_cast<tensorflow::int64>(result.size());
+        }
+      });
+    }
+  }
+  const double seconds = static_cast<double>(tf_env->NowMicros() - start_micros) / 1e6;
+  if (!benchmark_status.ok()) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(TF_NewStatus(), TF_DeleteStatus);
+    Set_TF_Status_from_Status(status.get(), benchmark_status);
+    CHECK_STATUS(env, status.get(), nullptr);
+  }
+
+  jclass result_class = env->FindClass("org/platanios/tensorflow/jni/RandomReadBenchmarkResult");
+  jmethodID result_constructor = env->GetStaticMethodID(
+      result_class, "apply", "(JJD)Lorg/platanios/tensorflow/jni/RandomReadBenchmarkResult;");
+  return env->CallStaticObjectMethod(
+    result_class, result_constructor, static_cast<jlong>(num_reads), static_cast<jlong>(num_bytes.load()),
+    static_cast<jdouble>(seconds));
+}
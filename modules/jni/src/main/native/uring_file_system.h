@@ -0,0 +1,37 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class org_platanios_tensorflow_jni_UringFileSystem__ */
+
+#ifndef _Included_org_platanios_tensorflow_jni_UringFileSystem__
+#define _Included_org_platanios_tensorflow_jni_UringFileSystem__
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     org_platanios_tensorflow_jni_UringFileSystem__
+ * Method:    isSupported
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_platanios_tensorflow_jni_UringFileSystem_00024_isSupported
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_UringFileSystem__
+ * Method:    register
+ * Signature: (Ljava/lang/String;III)V
+ */
+JNIEXPORT void JNICALL Java_org_platanios_tensorflow_jni_UringFileSystem_00024_register
+  (JNIEnv *, jobject, jstring, jint, jint, jint);
+
+/*
+ * Class:     org_platanios_tensorflow_jni_UringFileSystem__
+ * Method:    benchmarkRandomReads
+ * Signature: (Ljava/lang/String;IJIJ)Lorg/platanios/tensorflow/jni/RandomReadBenchmarkResult;
+ */
+JNIEXPORT jobject JNICALL Java_org_platanios_tensorflow_jni_UringFileSystem_00024_benchmarkRandomReads
+  (JNIEnv *, jobject, jstring, jint, jlong, jint, jlong);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
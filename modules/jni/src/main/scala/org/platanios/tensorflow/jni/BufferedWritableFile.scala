@@ -0,0 +1,32 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.jni
+
+import java.nio.ByteBuffer
+
+/**
+  * @author Emmanouil Antonios Platanios
+  */
+object BufferedWritableFile {
+  TensorFlow.load()
+
+  @native def newBufferedWritableFile(filename: String, mode: String, bufferSize: Long): Long
+  @native def appendArray(handle: Long, array: Array[Byte], offset: Int, length: Int): Unit
+  @native def appendBuffer(handle: Long, buffer: ByteBuffer, offset: Int, length: Int): Unit
+  @native def flush(handle: Long): Unit
+  @native def sync(handle: Long): Unit
+  @native def delete(handle: Long): Unit
+}
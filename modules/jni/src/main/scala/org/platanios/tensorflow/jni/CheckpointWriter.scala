@@ -0,0 +1,33 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.jni
+
+/**
+  * @author Emmanouil Antonios Platanios
+  */
+object CheckpointWriter {
+  TensorFlow.load()
+
+  @native def newCheckpointWriter(prefix: String, numShards: Int): Long
+  @native def addTensors(handle: Long, names: Array[String], tensorHandles: Array[Long]): Unit
+  @native def start(handle: Long): Unit
+  @native def progress(handle: Long): CheckpointWriterProgress
+  @native def await(handle: Long): Unit
+  @native def delete(handle: Long): Unit
+}
+
+case class CheckpointWriterProgress(
+    numTensorsWritten: Long, numTensors: Long, numBytesWritten: Long, numBytes: Long, isDone: Boolean)
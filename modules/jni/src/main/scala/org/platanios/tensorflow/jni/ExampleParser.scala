@@ -0,0 +1,37 @@
+/* Copyright 2017-19, Emmanouil Antonios Platanios. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package org.platanios.tensorflow.jni
+
+/**
+  * @author Emmanouil Antonios Platanios
+  */
+object ExampleParser {
+  TensorFlow.load()
+
+  @native def newExampleParser(
+      denseNames: Array[String],
+      denseTypes: Array[Int],
+      denseShapes: Array[Array[Long]],
+      denseDefaults: Array[Long],
+      sparseNames: Array[String],
+      sparseTypes: Array[Int],
+      numThreads: Int
+  ): Long
+
+  @native def parseRecords(handle: Long, recordReaderWrapperHandle: Long, batchSize: Int): Array[Long]
+  @native def parseSerialized(handle: Long, records: Array[Array[Byte]]): Array[Long]
+  @native def delete(handle: Long): Unit
+}
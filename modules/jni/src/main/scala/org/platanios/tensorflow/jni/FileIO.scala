@@ -15,10 +15,13 @@
 
 package org.platanios.tensorflow.jni
 
+import java.nio.ByteBuffer
+
 /**
   * @author Emmanouil Antonios Platanios
   */
 case class FileStatistics(length: Long, lastModifiedTime: Long, isDirectory: Boolean)
+case class LineBatch(data: Array[Byte], offsets: Array[Int])
 
 object FileIO {
   TensorFlow.load()
@@ -26,6 +29,7 @@ object FileIO {
   @native def fileExists(filename: String): Unit
   @native def deleteFile(filename: String): Unit
   @native def readFileToString(filename: String): String
+  @native def readFileToBytes(filename: String): Array[Byte]
   @native def writeStringToFile(filename: String, content: String): Unit
   @native def getChildren(filename: String): Array[String]
   @native def getMatchingFiles(filename: String): Array[String]
@@ -40,12 +44,24 @@ object FileIO {
   @native def newBufferedInputStream(filename: String, bufferSize: Long): Long
   @native def readFromBufferedInputStream(handle: Long, numBytes: Long): String
   @native def readLineAsStringFromBufferedInputStream(handle: Long): String
+  @native def readFromBufferedInputStreamToArray(handle: Long, array: Array[Byte], offset: Int, numBytes: Int): Int
+  @native def readFromBufferedInputStreamToBuffer(handle: Long, buffer: ByteBuffer, offset: Int, numBytes: Int): Int
+  @native def readLineAsBytesFromBufferedInputStream(handle: Long): Array[Byte]
   @native def tellBufferedInputStream(handle: Long): Long
   @native def seekBufferedInputStream(handle: Long, position: Long): Unit
   @native def deleteBufferedInputStream(handle: Long): Unit
 
+  @native def newLineRangeReader(filename: String, start: Long, end: Long, bufferSize: Long): Long
+  @native def readLineBatch(handle: Long, maxLines: Int, maxBytes: Int): LineBatch
+  @native def deleteLineRangeReader(handle: Long): Unit
+
   @native def newWritableFile(filename: String, mode: String): Long
   @native def appendToWritableFile(handle: Long, content: String): Unit
   @native def flushWritableFile(handle: Long): Unit
   @native def deleteWritableFile(handle: Long): Unit
+
+  @native def newReadOnlyMemoryRegion(filename: String): Long
+  @native def readOnlyMemoryRegionLength(handle: Long): Long
+  @native def readOnlyMemoryRegionBuffer(handle: Long, offset: Long, length: Int): ByteBuffer
+  @native def deleteReadOnlyMemoryRegion(handle: Long): Unit
 }